@@ -65,6 +65,7 @@ namespace neogfx
         virtual std::optional<size_u32> dpi_override() const = 0;
         virtual bool turbo() const = 0;
         virtual bool nest() const = 0;
+        virtual std::optional<std::string> profile() const = 0;
     };
 
     class i_app : public i_property_owner, public neolib::i_application, public i_action_container, public i_service
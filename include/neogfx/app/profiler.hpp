@@ -0,0 +1,119 @@
+// profiler.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+
+namespace neogfx
+{
+    struct profiler_sample
+    {
+        char const* name;
+        char const* category;
+        std::uint64_t begin;
+        std::uint64_t end;
+    };
+
+    // Frame profiler. Zones are recorded into fixed size per-thread ring buffers (written only by their own thread,
+    // so recording takes no locks) and can be exported as Chrome trace event JSON (chrome://tracing, Perfetto).
+    // Each ring slot is guarded by a sequence number so that exporting while threads are still recording skips
+    // slots being overwritten rather than reading torn samples.
+    // When the profiler is disabled a scoped_profiler_zone costs a single relaxed atomic load.
+    class profiler
+    {
+    public:
+        struct failed_to_export : std::runtime_error { failed_to_export(std::string const& aPath) : std::runtime_error("neogfx::profiler::failed_to_export: " + aPath) {} };
+    public:
+        static constexpr std::size_t DEFAULT_THREAD_BUFFER_CAPACITY = 65536u;
+    private:
+        struct slot
+        {
+            // 2 * index + 1 while sample index is being written, 2 * index + 2 once it is complete.
+            std::atomic<std::uint64_t> sequence = 0u;
+            std::atomic<char const*> name = nullptr;
+            std::atomic<char const*> category = nullptr;
+            std::atomic<std::uint64_t> begin = 0u;
+            std::atomic<std::uint64_t> end = 0u;
+        };
+        struct thread_buffer
+        {
+            std::uint32_t thread;
+            std::uint64_t capacity;
+            std::unique_ptr<slot[]> slots;
+            std::atomic<std::uint64_t> head = 0u;
+            std::atomic<std::uint64_t> tail = 0u;
+        };
+    private:
+        profiler();
+    public:
+        static profiler& instance();
+    public:
+        static bool enabled() noexcept
+        {
+            return sEnabled.load(std::memory_order_relaxed);
+        }
+        void enable(std::size_t aThreadBufferCapacity = DEFAULT_THREAD_BUFFER_CAPACITY);
+        void disable();
+        void clear();
+    public:
+        static std::uint64_t now() noexcept
+        {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+        void record(char const* aName, char const* aCategory, std::uint64_t aBegin, std::uint64_t aEnd) noexcept;
+    public:
+        std::vector<std::pair<std::uint32_t, profiler_sample>> samples() const;
+        void export_chrome_trace(std::ostream& aStream) const;
+        void export_chrome_trace(std::string const& aPath) const;
+    private:
+        thread_buffer* this_thread_buffer() noexcept;
+    private:
+        static inline std::atomic<bool> sEnabled;
+        mutable std::mutex iMutex;
+        std::size_t iThreadBufferCapacity;
+        std::vector<std::unique_ptr<thread_buffer>> iThreadBuffers;
+    };
+
+    class scoped_profiler_zone
+    {
+    public:
+        scoped_profiler_zone(char const* aName, char const* aCategory = "neogfx") noexcept :
+            iName{ profiler::enabled() ? aName : nullptr },
+            iCategory{ aCategory },
+            iBegin{ iName != nullptr ? profiler::now() : 0u }
+        {
+        }
+        ~scoped_profiler_zone()
+        {
+            if (iName != nullptr)
+                profiler::instance().record(iName, iCategory, iBegin, profiler::now());
+        }
+    private:
+        char const* iName;
+        char const* iCategory;
+        std::uint64_t iBegin;
+    };
+}
@@ -0,0 +1,151 @@
+// fenwick_tree.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+#include <vector>
+
+namespace neogfx
+{
+    // Binary indexed (Fenwick) tree over a sequence of non-negative values: updating a value, summing a prefix of
+    // the sequence and finding the value whose running total covers a given key are all O(log n). Inserting or
+    // erasing values rebuilds the tree in O(n). T must be value initializable to zero and support + and -.
+    template <typename T>
+    class fenwick_tree
+    {
+    public:
+        typedef T value_type;
+        typedef std::size_t size_type;
+    public:
+        fenwick_tree() = default;
+        template <typename Iter>
+        fenwick_tree(Iter aFirst, Iter aLast) :
+            iValues{ aFirst, aLast }
+        {
+            rebuild();
+        }
+    public:
+        bool empty() const
+        {
+            return iValues.empty();
+        }
+        size_type size() const
+        {
+            return iValues.size();
+        }
+        value_type const& operator[](size_type aIndex) const
+        {
+            return iValues[aIndex];
+        }
+        // Sum of the first aCount values.
+        value_type prefix_sum(size_type aCount) const
+        {
+            value_type result{};
+            for (auto i = aCount; i > 0u; i -= lowest_bit(i))
+                result = result + iTree[i - 1u];
+            return result;
+        }
+        value_type total() const
+        {
+            return prefix_sum(size());
+        }
+        // Index of the value whose range of running totals, as projected by aProjection, contains aKey; that is the
+        // number of leading values whose projected running total is not greater than aKey (size() if aKey is at or
+        // beyond the projected total).
+        template <typename Key, typename Projection>
+        size_type find(Key const& aKey, Projection aProjection) const
+        {
+            size_type position = 0u;
+            value_type sum{};
+            for (auto step = highest_bit(size()); step > 0u; step >>= 1u)
+            {
+                if (position + step > size())
+                    continue;
+                auto const next = sum + iTree[position + step - 1u];
+                if (!(aKey < aProjection(next)))
+                {
+                    position += step;
+                    sum = next;
+                }
+            }
+            return position;
+        }
+    public:
+        void clear()
+        {
+            iValues.clear();
+            iTree.clear();
+        }
+        template <typename Iter>
+        void assign(Iter aFirst, Iter aLast)
+        {
+            iValues.assign(aFirst, aLast);
+            rebuild();
+        }
+        void set(size_type aIndex, value_type const& aValue)
+        {
+            value_type const delta = aValue - iValues[aIndex];
+            iValues[aIndex] = aValue;
+            for (auto i = aIndex + 1u; i <= size(); i += lowest_bit(i))
+                iTree[i - 1u] = iTree[i - 1u] + delta;
+        }
+        // Replaces aCount values from aIndex with [aFirst, aLast); O(log n) per value if the number of values is
+        // unchanged, otherwise O(n).
+        template <typename Iter>
+        void replace(size_type aIndex, size_type aCount, Iter aFirst, Iter aLast)
+        {
+            if (static_cast<size_type>(std::distance(aFirst, aLast)) == aCount)
+            {
+                for (auto i = aIndex; aFirst != aLast; ++i, ++aFirst)
+                    set(i, *aFirst);
+                return;
+            }
+            iValues.erase(std::next(iValues.begin(), aIndex), std::next(iValues.begin(), aIndex + aCount));
+            iValues.insert(std::next(iValues.begin(), aIndex), aFirst, aLast);
+            rebuild();
+        }
+    private:
+        void rebuild()
+        {
+            iTree = iValues;
+            for (size_type i = 1u; i <= size(); ++i)
+            {
+                auto const parent = i + lowest_bit(i);
+                if (parent <= size())
+                    iTree[parent - 1u] = iTree[parent - 1u] + iTree[i - 1u];
+            }
+        }
+        static size_type lowest_bit(size_type aValue)
+        {
+            return aValue & (~aValue + 1u);
+        }
+        static size_type highest_bit(size_type aValue)
+        {
+            size_type result = aValue;
+            while (result & (result - 1u))
+                result &= (result - 1u);
+            return result;
+        }
+    private:
+        std::vector<value_type> iValues;
+        std::vector<value_type> iTree;
+    };
+}
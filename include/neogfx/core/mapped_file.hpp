@@ -0,0 +1,54 @@
+// mapped_file.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+#include <string_view>
+
+namespace neogfx
+{
+    // Read-only memory mapping of a whole file. On POSIX systems the file can still be truncated by another process
+    // while it is mapped and touching a page past the new end raises SIGBUS, so readers should clamp to
+    // current_size() before reading the mapping or use read(), which copies without touching it.
+    class mapped_file
+    {
+    public:
+        struct failed_to_open : std::runtime_error { failed_to_open(std::string const& aPath) : std::runtime_error("neogfx::mapped_file::failed_to_open: " + aPath) {} };
+        struct failed_to_map : std::runtime_error { failed_to_map(std::string const& aPath) : std::runtime_error("neogfx::mapped_file::failed_to_map: " + aPath) {} };
+    private:
+        struct native_mapping;
+    public:
+        mapped_file(std::string const& aPath);
+        ~mapped_file();
+    public:
+        std::string const& path() const;
+        std::uint64_t size() const;
+        char const* data() const;
+        std::string_view bytes() const;
+        std::uint64_t current_size() const;
+        std::string read(std::uint64_t aOffset, std::uint64_t aLength) const;
+    private:
+        std::string iPath;
+        std::unique_ptr<native_mapping> iMapping;
+        char const* iData = nullptr;
+        std::uint64_t iSize = 0u;
+    };
+}
@@ -0,0 +1,82 @@
+// mapped_text.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+
+#include <neogfx/core/mapped_file.hpp>
+
+namespace neogfx
+{
+    // Read-only memory mapped (UTF-8) text file. A background thread indexes the file's lines, recording the offset
+    // of every LINE_INDEX_STRIDE-th line start (a few bytes per hundred lines even for multi-gigabyte files); other
+    // lines, and lines beyond those indexed so far, are found by scanning forward from the nearest indexed line.
+    // If the file is truncated while it is mapped, reads are clamped to its current size.
+    class mapped_text
+    {
+    public:
+        using failed_to_open = mapped_file::failed_to_open;
+        using failed_to_map = mapped_file::failed_to_map;
+    public:
+        static constexpr std::uint64_t LINE_INDEX_STRIDE = 64u;
+        static constexpr std::uint64_t INDEX_CHUNK_SIZE = 4u * 1024u * 1024u;
+    public:
+        mapped_text(std::string const& aPath);
+        ~mapped_text();
+    public:
+        std::string const& path() const;
+        std::uint64_t size() const;
+        std::string_view bytes() const;
+        std::string_view bytes(std::uint64_t aFirst, std::uint64_t aLast) const;
+        // A copy of the bytes [aFirst, aLast) read from the file rather than the mapping.
+        std::string copy(std::uint64_t aFirst, std::uint64_t aLast) const;
+    public:
+        bool indexed() const;
+        std::uint64_t indexed_lines() const;
+        std::uint64_t estimated_lines() const;
+        // Offset of the start of line aLine (size() if there is no such line).
+        std::uint64_t line_start(std::uint64_t aLine) const;
+        // Offset of the end of line aLine, excluding its line terminator.
+        std::uint64_t line_end(std::uint64_t aLine) const;
+        std::uint64_t line_at(std::uint64_t aOffset) const;
+        // Searches the mapped bytes directly (nothing is decoded or copied).
+        std::optional<std::uint64_t> find(std::string_view aText, std::uint64_t aFrom = 0u) const;
+    private:
+        std::uint64_t available() const;
+        std::uint64_t skip_lines(std::uint64_t aOffset, std::uint64_t aLines) const;
+        void build_index(std::stop_token aStopToken);
+    private:
+        mapped_file iFile;
+        char const* iData = nullptr;
+        std::uint64_t iSize = 0u;
+        mutable std::mutex iIndexMutex;
+        std::vector<std::uint64_t> iLineIndex;
+        std::uint64_t iIndexedLines = 1u;
+        std::uint64_t iIndexedBytes = 0u;
+        std::atomic<bool> iIndexed = false;
+        std::jthread iIndexer;
+    };
+}
@@ -189,11 +189,13 @@ namespace neogfx
         void generate_code(i_shader_program const& aProgram, shader_language aLanguage, i_string& aOutput) const override;
     public:
         void clear_glyph() final;
-        void set_first_glyph(i_rendering_context const& aContext, glyph_text const& aText, glyph_char const& aGlyphChar) final;
+        void set_first_glyph(i_rendering_context const& aContext, glyph_text const& aText, glyph_char const& aGlyphChar, bool aOutline) final;
     private:
         cache_uniform(uGlyphRenderOutput)
         cache_uniform(uGlyphSubpixel)
         cache_uniform(uGlyphSubpixelFormat)
+        cache_uniform(uGlyphDistanceField)
+        cache_uniform(uGlyphDistanceFieldEdge)
         cache_uniform(uGlyphEnabled)
     };
 
@@ -22,6 +22,7 @@
 #include <neogfx/neogfx.hpp>
 
 #include <unordered_set>
+#include <boost/unordered/unordered_flat_map.hpp>
 
 #include <neogfx/gfx/shader_array.hpp>
 #include <neogfx/gfx/gradient.hpp>
@@ -96,6 +97,109 @@ namespace neogfx
         std::shared_ptr<shader_array<float>> iSampler;
     };
 
+    // Fixed capacity cache of sampler/filter slots keyed by a hashed fingerprint of the gradient attributes they
+    // were generated from; the full key is kept to verify hits. Slots are linked into an intrusive least recently
+    // used list so that both a hit and an eviction are O(1). Slots never move so references to their values remain
+    // valid (an evicted slot's value is reused for the new key).
+    template <typename Key, typename Value>
+    class gradient_cache
+    {
+    public:
+        struct entry
+        {
+            std::uint64_t fingerprint;
+            Key key;
+            Value value;
+            std::uint32_t previous;
+            std::uint32_t next;
+        };
+    private:
+        static constexpr std::uint32_t NoEntry = ~0u;
+    public:
+        gradient_cache(std::vector<Value>&& aValues)
+        {
+            iEntries.reserve(aValues.size());
+            for (auto& value : aValues)
+                iEntries.push_back(entry{ 0u, Key{}, std::move(value), NoEntry, NoEntry });
+            iIndex.reserve(iEntries.size());
+        }
+    public:
+        // Returns the entry for aFingerprint, marking it most recently used, if its key matches.
+        template <typename KeyEqual>
+        entry* find(std::uint64_t aFingerprint, KeyEqual aKeyEqual)
+        {
+            auto existing = iIndex.find(aFingerprint);
+            if (existing == iIndex.end())
+                return nullptr;
+            auto& e = iEntries[existing->second];
+            if (!aKeyEqual(e.key))
+                return nullptr;
+            unlink(existing->second);
+            link_back(existing->second);
+            return &e;
+        }
+        // Returns the entry to (re)generate for aFingerprint: an unused entry if there is one, otherwise the entry
+        // with the same fingerprint (a hash collision) or the least recently used entry. The caller sets its key
+        // and value.
+        entry& allocate(std::uint64_t aFingerprint)
+        {
+            std::uint32_t index;
+            auto existing = iIndex.find(aFingerprint);
+            if (existing != iIndex.end())
+            {
+                index = existing->second;
+                unlink(index);
+            }
+            else
+            {
+                if (iUsed < iEntries.size())
+                    index = iUsed++;
+                else
+                {
+                    index = iFirst;
+                    unlink(index);
+                    iIndex.erase(iEntries[index].fingerprint);
+                }
+                iIndex.emplace(aFingerprint, index);
+            }
+            iEntries[index].fingerprint = aFingerprint;
+            link_back(index);
+            return iEntries[index];
+        }
+    private:
+        void unlink(std::uint32_t aIndex)
+        {
+            auto& e = iEntries[aIndex];
+            if (e.previous != NoEntry)
+                iEntries[e.previous].next = e.next;
+            else
+                iFirst = e.next;
+            if (e.next != NoEntry)
+                iEntries[e.next].previous = e.previous;
+            else
+                iLast = e.previous;
+            e.previous = NoEntry;
+            e.next = NoEntry;
+        }
+        void link_back(std::uint32_t aIndex)
+        {
+            auto& e = iEntries[aIndex];
+            e.previous = iLast;
+            e.next = NoEntry;
+            if (iLast != NoEntry)
+                iEntries[iLast].next = aIndex;
+            else
+                iFirst = aIndex;
+            iLast = aIndex;
+        }
+    private:
+        std::vector<entry> iEntries;
+        boost::unordered_flat_map<std::uint64_t, std::uint32_t> iIndex;
+        std::uint32_t iUsed = 0u;
+        std::uint32_t iFirst = NoEntry;
+        std::uint32_t iLast = NoEntry;
+    };
+
     class gradient_manager : public i_gradient_manager
     {
         friend class gradient_object;
@@ -104,8 +208,8 @@ namespace neogfx
         using gradient_pointer = ref_ptr<i_gradient>;
         using gradient_list = neolib::jar<gradient_pointer>;
         using sampler_key_t = std::pair<gradient::color_stop_list, gradient::alpha_stop_list>;
-        using sampler_map_t = std::map<sampler_key_t, gradient_sampler> ;
-        using filter_map_t = std::map<scalar, gradient_filter>;
+        using sampler_cache_t = gradient_cache<sampler_key_t, gradient_sampler>;
+        using filter_cache_t = gradient_cache<scalar, gradient_filter>;
         // constants
     public:
         static constexpr std::uint32_t MaxSamplers = 1024;
@@ -143,17 +247,13 @@ namespace neogfx
         void do_create_gradient(neolib::i_vector<sRGB_color::abstract_type> const& aColors, gradient_direction aDirection, neolib::i_ref_ptr<i_gradient>& aResult) override;
     private:
         shader_array<avec4u8>& samplers();
-        std::vector<gradient_sampler>& free_samplers();
-        std::vector<gradient_filter>& free_filters();
+        sampler_cache_t& sampler_cache();
+        filter_cache_t& filter_cache();
         void cleanup();
     private:
         gradient_list iGradients;
         std::optional<shader_array<avec4u8>> iSamplers;
-        sampler_map_t iAllocatedSamplers;
-        std::optional<std::vector<gradient_sampler>> iFreeSamplers;
-        std::deque<sampler_map_t::const_iterator> iSamplerQueue;
-        filter_map_t iAllocatedFilters;
-        std::optional<std::vector<gradient_filter>> iFreeFilters;
-        std::deque<filter_map_t::const_iterator> iFilterQueue;
+        std::optional<sampler_cache_t> iSamplerCache;
+        std::optional<filter_cache_t> iFilterCache;
     };
 }
\ No newline at end of file
@@ -209,6 +209,7 @@ namespace neogfx
         multiline_glyph_text to_multiline_glyph_text(std::u32string const& aText, dimension aMaxWidth, alignment aAlignment = alignment::Left) const override;
         multiline_glyph_text to_multiline_glyph_text(std::u32string const& aText, font const& aFont, dimension aMaxWidth, alignment aAlignment = alignment::Left) const override;
         multiline_glyph_text to_multiline_glyph_text(glyph_text const& aText, dimension aMaxWidth, alignment aAlignment = alignment::Left) const override;
+        multiline_glyph_text to_multiline_glyph_text(glyph_text const& aText, line_breaker const& aLineBreaker, dimension aMaxWidth, alignment aAlignment = alignment::Left, line_breaking aLineBreaking = line_breaking::Greedy) const override;
         size text_extent(char const* aTextBegin, char const* aTextEnd) const override;
         size text_extent(char const* aTextBegin, char const* aTextEnd, font const& aFont) const override;
         size text_extent(char const* aTextBegin, char const* aTextEnd, std::function<font(string::size_type)> aFontSelector) const override;
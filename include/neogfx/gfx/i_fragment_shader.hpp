@@ -79,7 +79,7 @@ namespace neogfx
         typedef i_glyph_shader abstract_type;
     public:
         virtual void clear_glyph() = 0;
-        virtual void set_first_glyph(i_rendering_context const& aContext, glyph_text const& aText, glyph_char const& aGlyphChar) = 0;
+        virtual void set_first_glyph(i_rendering_context const& aContext, glyph_text const& aText, glyph_char const& aGlyphChar, bool aOutline) = 0;
     };
 
     class i_stipple_shader : public i_fragment_shader
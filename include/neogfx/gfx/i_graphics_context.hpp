@@ -39,6 +39,7 @@
 #include <neogfx/gfx/path.hpp>
 #include <neogfx/gfx/pen.hpp>
 #include <neogfx/gfx/text/font.hpp>
+#include <neogfx/gfx/text/line_breaker.hpp>
 #include <neogfx/gfx/primitives.hpp>
 #include <neogfx/gfx/i_render_target.hpp>
 #include <neogfx/gfx/i_rendering_context.hpp>
@@ -163,6 +164,7 @@ namespace neogfx
         struct unattached : std::logic_error { unattached() : std::logic_error("neogfx::i_graphics_context::unattached") {} };
         struct no_tab_stops : std::logic_error { no_tab_stops() : std::logic_error("neogfx::i_graphics_context::no_tab_stops") {} };
         struct password_not_set : std::logic_error { password_not_set() : std::logic_error("neogfx::i_graphics_context::password_not_set") {} };
+        struct no_source_texture : std::logic_error { no_source_texture() : std::logic_error("neogfx::i_graphics_context::no_source_texture") {} };
         // construction
     public:
         virtual ~i_graphics_context() = default;
@@ -304,6 +306,7 @@ namespace neogfx
         virtual multiline_glyph_text to_multiline_glyph_text(std::u32string const& aText, dimension aMaxWidth, alignment aAlignment = alignment::Left) const = 0;
         virtual multiline_glyph_text to_multiline_glyph_text(std::u32string const& aText, font const& aFont, dimension aMaxWidth, alignment aAlignment = alignment::Left) const = 0;
         virtual multiline_glyph_text to_multiline_glyph_text(glyph_text const& aText, dimension aMaxWidth, alignment aAlignment = alignment::Left) const = 0;
+        virtual multiline_glyph_text to_multiline_glyph_text(glyph_text const& aText, line_breaker const& aLineBreaker, dimension aMaxWidth, alignment aAlignment = alignment::Left, line_breaking aLineBreaking = line_breaking::Greedy) const = 0;
         virtual size text_extent(char const* aTextBegin, char const* aTextEnd) const = 0;
         virtual size text_extent(char const* aTextBegin, char const* aTextEnd, font const& aFont) const = 0;
         virtual size text_extent(char const* aTextBegin, char const* aTextEnd, std::function<font(string::size_type)> aFontSelector) const = 0;
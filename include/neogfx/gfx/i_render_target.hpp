@@ -67,6 +67,8 @@ namespace neogfx
         virtual void* target_handle() const = 0;
         virtual void* target_device_handle() const = 0;
         virtual pixel_format_t pixel_format() const = 0;
+        // Whether target_texture() is available; targets without one can't be used as the source of a blit or filter.
+        virtual bool has_target_texture() const = 0;
         virtual const i_texture& target_texture() const = 0;
         virtual point target_origin() const = 0;
         virtual size target_extents() const = 0;
@@ -0,0 +1,57 @@
+// region.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+#include <neogfx/core/geometrical.hpp>
+
+namespace neogfx
+{
+    // A list of disjoint rectangles built up from dirty rects. An incoming rect is merged with an existing
+    // one only when the pixels wasted by the merged bounding rect cost less than keeping a separate rect
+    // (which costs a scissored render pass); otherwise it is kept separate. Overlapping rects are always
+    // merged so that no pixel is repainted twice.
+    class region
+    {
+    public:
+        static constexpr dimension DEFAULT_RECT_COST = 128.0 * 128.0;
+        static constexpr std::size_t DEFAULT_MAX_RECTS = 8u;
+    public:
+        region(dimension aRectCost = DEFAULT_RECT_COST, std::size_t aMaxRects = DEFAULT_MAX_RECTS);
+    public:
+        bool empty() const;
+        vector<rect> const& rects() const;
+        rect bounding_rect() const;
+        dimension area() const;
+        bool intersects(rect const& aRect) const;
+    public:
+        void add(rect const& aRect);
+        void clear();
+    private:
+        static dimension area(rect const& aRect);
+        dimension merge_waste(rect const& aFirst, rect const& aSecond) const;
+        void merge_cheapest_pair();
+    private:
+        dimension iRectCost;
+        std::size_t iMaxRects;
+        vector<rect> iRects;
+    };
+}
@@ -90,6 +90,11 @@ namespace neogfx
             iRenderQueueContext{ *this }
         {
         }
+    public:
+        bool has_target_texture() const override
+        {
+            return true;
+        }
     public:
         neogfx::viewport viewport() const final
         {
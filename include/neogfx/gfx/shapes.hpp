@@ -81,10 +81,27 @@ namespace neogfx
         calc_rect_vertices(result, aRect, aType, aTransformation);
         return result;
     };
+    // Maximum distance, in device pixels, between a tessellated arc's chords and the true arc.
+    constexpr dimension DEFAULT_MAX_CHORD_ERROR = 0.25;
+
+    std::uint32_t arc_segments(dimension aRadius, angle aArc, dimension aMaxChordError = DEFAULT_MAX_CHORD_ERROR, dimension aDpiScaleFactor = 1.0);
+    // Unit radius arc points (segment count + 1) centred on the origin starting at angle zero, cached per (segment count, arc);
+    // the returned reference is only valid until the next call.
+    std::vector<vec2> const& unit_arc(std::uint32_t aArcSegments, angle aArc);
+    // As above but rotated to start at aStartAngle; the rotation is applied to the cached arc so start angle is not part of the key.
+    std::vector<vec2> const& unit_arc(std::uint32_t aArcSegments, angle aStartAngle, angle aArc);
+
+    template <typename Vertex>
+    void calc_arc_vertices(std::vector<Vertex>& aResult, const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const point& aOrigin, mesh_type aType, std::uint32_t aArcSegments = 0, dimension aDpiScaleFactor = 1.0);
+    template <typename Vertex>
+    void calc_circle_vertices(std::vector<Vertex>& aResult, const point& aCenter, dimension aRadius, angle aStartAngle, mesh_type aType, std::uint32_t aArcSegments = 0, dimension aDpiScaleFactor = 1.0);
+    template <typename Vertex>
+    void calc_rounded_rect_vertices(std::vector<Vertex>& aResult, const rect& aRect, dimension aRadius, mesh_type aType, std::uint32_t aArcSegments = 0, dimension aDpiScaleFactor = 1.0);
+
     template <typename Vertex>
-    std::vector<Vertex> arc_vertices(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const point& aOrigin, mesh_type aType, std::uint32_t aArcSegments = 0);
+    std::vector<Vertex> arc_vertices(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const point& aOrigin, mesh_type aType, std::uint32_t aArcSegments = 0, dimension aDpiScaleFactor = 1.0);
     template <typename Vertex>
-    std::vector<Vertex> circle_vertices(const point& aCenter, dimension aRadius, angle aStartAngle, mesh_type aType, std::uint32_t aArcSegments = 0);
+    std::vector<Vertex> circle_vertices(const point& aCenter, dimension aRadius, angle aStartAngle, mesh_type aType, std::uint32_t aArcSegments = 0, dimension aDpiScaleFactor = 1.0);
     template <typename Vertex>
-    std::vector<Vertex> rounded_rect_vertices(const rect& aRect, dimension aRadius, mesh_type aType, std::uint32_t aArcSegments = 0);
+    std::vector<Vertex> rounded_rect_vertices(const rect& aRect, dimension aRadius, mesh_type aType, std::uint32_t aArcSegments = 0, dimension aDpiScaleFactor = 1.0);
 }
\ No newline at end of file
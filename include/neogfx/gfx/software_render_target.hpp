@@ -0,0 +1,96 @@
+// software_render_target.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+#include <neogfx/core/device_metrics.hpp>
+#include <neogfx/gfx/render_target.hpp>
+
+namespace neogfx
+{
+    class software_raster;
+    class software_glyph_cache;
+
+    // A CPU rasterized render target for headless rendering (tests, thumbnails, servers); graphics contexts
+    // created on it rasterize their queue into a premultiplied RGBA8 buffer without touching the GPU. It is a
+    // surface with no target texture so it can't be the source of a blit or filter.
+    class software_render_target : public render_target<>
+    {
+    public:
+        struct no_target_texture : std::logic_error { no_target_texture() : std::logic_error("neogfx::software_render_target::no_target_texture") {} };
+        struct failed_to_save_image : std::runtime_error { failed_to_save_image(std::string const& aPath) : std::runtime_error("neogfx::software_render_target::failed_to_save_image: " + aPath) {} };
+    public:
+        software_render_target(size const& aExtents, dimension aDpi = STANDARD_DPI_PPI, neogfx::color_space aColorSpace = neogfx::color_space::sRGB);
+        ~software_render_target();
+    public:
+        render_target_type target_type() const final;
+        void* target_handle() const final;
+        void* target_device_handle() const final;
+        pixel_format_t pixel_format() const final;
+        bool has_target_texture() const final;
+        const i_texture& target_texture() const final;
+        point target_origin() const final;
+        size target_extents() const final;
+    public:
+        neogfx::logical_coordinate_system logical_coordinate_system() const final;
+        void set_logical_coordinate_system(neogfx::logical_coordinate_system aSystem) const final;
+        neogfx::logical_coordinates logical_coordinates() const final;
+        void set_logical_coordinates(const neogfx::logical_coordinates& aCoordinates) const final;
+    public:
+        neogfx::viewport apply_viewport() const final;
+    public:
+        bool target_active() const final;
+        void activate_target() const final;
+        void deactivate_target() const final;
+        bool target_in_use() const final;
+        void target_add_ref() const final;
+        void target_release() const final;
+    public:
+        neogfx::color_space color_space() const final;
+        color read_pixel(const point& aPosition, bool aCreateCache = true) const final;
+    public:
+        std::unique_ptr<i_rendering_context> create_rendering_context(blending_mode aBlendingMode = blending_mode::Default) const final;
+    public:
+        dimension horizontal_dpi() const final;
+        dimension vertical_dpi() const final;
+        dimension ppi() const final;
+        bool metrics_available() const final;
+        size extents() const final;
+        dimension em_size() const final;
+    public:
+        void resize(size const& aExtents);
+        void clear(color const& aColor);
+        // Straight (non-premultiplied) RGBA8 rows, top row first.
+        std::vector<std::uint8_t> to_rgba() const;
+        void save_png(std::string const& aPath) const;
+        software_raster& raster() const;
+        software_glyph_cache& glyph_cache() const;
+    private:
+        std::unique_ptr<software_raster> iRaster;
+        std::unique_ptr<software_glyph_cache> iGlyphCache;
+        dimension iDpi;
+        neogfx::color_space iColorSpace;
+        mutable neogfx::logical_coordinate_system iLogicalCoordinateSystem;
+        mutable std::optional<neogfx::logical_coordinates> iLogicalCoordinates;
+        mutable bool iActive = false;
+        mutable std::uint32_t iTargetUseCount = 0u;
+    };
+}
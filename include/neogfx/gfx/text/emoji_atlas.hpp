@@ -21,7 +21,8 @@
 
 #include <neogfx/neogfx.hpp>
 
-#include <map>
+#include <array>
+#include <optional>
 
 #include <neogfx/gfx/i_texture_manager.hpp>
 #include <neogfx/gfx/i_texture_atlas.hpp>
@@ -29,13 +30,52 @@
 
 namespace neogfx
 {
+    class mapped_file;
+
+    // Emoji are found with an index, generated from emoji.zip and memory mapped (emoji.idx alongside it) rather
+    // than built by scanning the zip on each startup. The index is a trie of code point sequences: nodes whose
+    // edges (sorted by code point) are contiguous and emoji image files, for each emoji node, sorted by size.
     class emoji_atlas : public i_emoji_atlas
     {
     private:
-        typedef std::map<dimension, std::string> sets;
-        typedef std::map<std::u32string, sets> emojis;
+        typedef std::array<std::uint64_t, 4u> code_point_bits;
+        typedef std::uint32_t node_index;
+        struct index_header
+        {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t byteOrderMark;
+            std::uint64_t zipSize;
+            std::int64_t zipWriteTime;
+            std::uint32_t nodeCount;
+            std::uint32_t edgeCount;
+            std::uint32_t fileCount;
+            std::uint32_t pathBytes;
+        };
+        struct index_node
+        {
+            std::uint32_t firstEdge;
+            std::uint32_t edgeCount;
+            std::uint32_t firstFile;
+            std::uint32_t fileCount;
+        };
+        struct index_edge
+        {
+            std::uint32_t codePoint;
+            node_index child;
+        };
+        struct index_file
+        {
+            double size;
+            std::uint32_t pathOffset;
+            std::uint32_t pathLength;
+        };
+    public:
+        static constexpr std::uint32_t INDEX_VERSION = 1u;
+        static constexpr std::uint32_t INDEX_BYTE_ORDER_MARK = 0x01020304u;
     public:
         emoji_atlas();
+        ~emoji_atlas();
     public:
         bool is_emoji(char32_t aCodePoint) const final;
         bool is_emoji(const std::u32string& aCodePoints) const final;
@@ -43,10 +83,31 @@ namespace neogfx
         emoji_id emoji(char32_t aCodePoint, dimension aDesiredSize = 64.0) const final;
         emoji_id emoji(const std::u32string& aCodePoints, dimension aDesiredSize = 64.0) const final;
         const i_texture& emoji_texture(emoji_id aId) const final;
+    public:
+        // Generates the index of an emoji zip (as done by the atlas when its index is missing or out of date);
+        // allows packaging to ship a prebuilt index.
+        static bool build_index(std::string const& aZipPath, std::string const& aIndexPath);
+    private:
+        static std::vector<char> generate_index(std::string const& aZipPath);
+        bool use_index(char const* aData, std::size_t aSize);
+        bool current_index(index_header const& aHeader) const;
+        std::optional<node_index> find(char32_t const* aFirst, char32_t const* aLast) const;
+        std::string_view file_path(index_file const& aFile) const;
+        void index_single_code_point_emojis();
     private:
         const std::string kFilePath;
         std::unique_ptr<i_texture_atlas> iTextureAtlas;
-        emojis iEmojis;
-        mutable std::map<std::u32string, std::optional<emoji_id>> iEmojiMap;
+        std::unique_ptr<mapped_file> iIndexFile;
+        std::vector<char> iIndexData;
+        index_node const* iNodes = nullptr;
+        index_edge const* iEdges = nullptr;
+        index_file const* iFiles = nullptr;
+        char const* iPaths = nullptr;
+        std::uint32_t iNodeCount = 0u;
+        mutable std::vector<std::optional<emoji_id>> iEmojiIds;
+        // Two-stage bit set of single code point emoji: one entry per 256 code points indexing the block of bits
+        // for those code points (block 0 is empty).
+        std::vector<std::uint16_t> iSingleEmojiBlocks;
+        std::vector<code_point_bits> iSingleEmojiBits;
     };
 }
\ No newline at end of file
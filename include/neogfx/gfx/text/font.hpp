@@ -45,6 +45,7 @@ namespace neogfx
         BelowAscenderLine   = 0x00000040,
         AboveBaseline       = 0x00000040,
         Strike              = 0x00000100,
+        DistanceField       = 0x00000200, // glyphs rendered from signed distance fields shared by all sizes of the face
         Emulated            = 0x80000000,
         BoldItalic          = Bold | Italic,
         BoldItalicUnderline = Bold | Italic | Underline,
@@ -102,6 +103,7 @@ declare_enum_string(neogfx::font_style, Subscript)
 declare_enum_string(neogfx::font_style, BelowAscenderLine)
 declare_enum_string(neogfx::font_style, AboveBaseline)
 declare_enum_string(neogfx::font_style, Strike)
+declare_enum_string(neogfx::font_style, DistanceField)
 declare_enum_string(neogfx::font_style, Emulated)
 declare_enum_string(neogfx::font_style, BoldItalic)
 declare_enum_string(neogfx::font_style, BoldItalicUnderline)
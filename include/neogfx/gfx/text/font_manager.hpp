@@ -21,6 +21,7 @@
 
 #include <neogfx/neogfx.hpp>
 
+#include <atomic>
 #include <unordered_map>
 #include <set>
 
@@ -36,6 +37,8 @@ typedef struct FT_LibraryRec_* FT_Library;
 namespace neogfx
 {
     class native_font;
+    class glyph_rasterizer;
+    class persistent_glyph_cache;
 
     class fallback_font_info : public i_fallback_font_info
     {
@@ -60,6 +63,7 @@ namespace neogfx
         struct error_initializing_font_library : std::runtime_error { error_initializing_font_library() : std::runtime_error("neogfx::font_manager::error_initializing_font_library") {} };
         struct no_matching_font_found : std::runtime_error { no_matching_font_found() : std::runtime_error("neogfx::font_manager::no_matching_font_found") {} };
         struct failed_to_allocate_glyph_space : std::runtime_error { failed_to_allocate_glyph_space() : std::runtime_error("neogfx::font_manager::failed_to_allocate_glyph_space") {} };
+        struct persistent_glyph_cache_already_enabled : std::logic_error { persistent_glyph_cache_already_enabled() : std::logic_error("neogfx::font_manager::persistent_glyph_cache_already_enabled") {} };
     public:
         font_manager();
         ~font_manager();
@@ -94,8 +98,15 @@ namespace neogfx
     public:
         const i_texture_atlas& glyph_atlas() const final;
         i_texture_atlas& glyph_atlas() final;
+        const i_texture_atlas& distance_field_atlas() const final;
+        i_texture_atlas& distance_field_atlas() final;
         const i_emoji_atlas& emoji_atlas() const final;
         i_emoji_atlas& emoji_atlas() final;
+        void upload_rasterized_glyphs() final;
+    public:
+        void enable_persistent_glyph_cache(i_string const& aPath) final;
+        bool persistent_glyph_cache_enabled() const final;
+        void save_persistent_glyph_cache() final;
     protected:
         void add_ref(font_id aId, long aCount = 1) final;
         void release(font_id aId, long aCount = 1) final;
@@ -107,6 +118,9 @@ namespace neogfx
     private:
         i_native_font_face& add_font(const ref_ptr<i_native_font_face>& aNewFont);
         void cleanup();
+        std::shared_ptr<glyph_rasterizer> rasterizer();
+        // Null unless the persistent glyph cache is enabled; may be called from any thread.
+        persistent_glyph_cache* persistent_cache() const;
     private:
         mutable std::unordered_map<system_font_role, optional<font_info>> iDefaultSystemFontInfo;
         mutable std::optional<fallback_font_info> iDefaultFallbackFontInfo;
@@ -117,6 +131,11 @@ namespace neogfx
         id_cache iIdCache;
         std::unique_ptr<i_glyph_text_factory> iGlyphTextFactory;
         texture_atlas iGlyphAtlas;
+        texture_atlas iDistanceFieldAtlas;
         neogfx::emoji_atlas iEmojiAtlas;
+        // Declared before the rasterizer as its workers use the cache.
+        std::unique_ptr<persistent_glyph_cache> iPersistentGlyphCache;
+        std::atomic<persistent_glyph_cache*> iActivePersistentGlyphCache = nullptr;
+        std::shared_ptr<glyph_rasterizer> iGlyphRasterizer;
     };
 }
\ No newline at end of file
@@ -29,9 +29,12 @@ namespace neogfx
     {
     public:
         glyph(const i_sub_texture& aTexture, bool aSubpixel, const glyph_metrics& aMetrics, glyph_pixel_mode aPixelMode);
+        glyph(const i_sub_texture& aDistanceFieldTexture, const glyph_metrics& aMetrics, scalar aScale);
         ~glyph();
     public:
         const i_sub_texture& texture() const final;
+        neogfx::size extents() const final;
+        bool distance_field() const final;
         bool has_outline_texture() const final;
         const i_sub_texture& outline_texture() const final;
         void set_outline_texture(const i_sub_texture& aOutlineTexture) final;
@@ -44,5 +47,7 @@ namespace neogfx
         bool iSubpixel;
         glyph_metrics iMetrics;
         glyph_pixel_mode iPixelMode;
+        bool iDistanceField;
+        scalar iScale;
     };
 }
\ No newline at end of file
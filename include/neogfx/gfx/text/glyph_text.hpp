@@ -612,6 +612,16 @@ namespace neogfx
         function_type iSelectorFunction;
     };
     
+    struct shaping_cache_statistics
+    {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t evictions;
+        std::size_t entries;
+        std::size_t memoryUsage;
+        std::size_t memoryLimit;
+    };
+
     class i_glyph_text_factory
     {
     public:
@@ -621,6 +631,13 @@ namespace neogfx
         virtual glyph_text create_glyph_text(font const& aFont) = 0;
         virtual glyph_text to_glyph_text(i_graphics_context const& aContext, char32_t const* aUtf32Begin, char32_t const* aUtf32End, i_font_selector const& aFontSelector, bool aAlignBaselines = true) = 0;
         virtual glyph_text to_glyph_text(i_graphics_context const& aContext, char const* aUtf8Begin, char const* aUtf8End, i_font_selector const& aFontSelector, bool aAlignBaselines = true) = 0;
+        // Segments and shapes text into the shaping cache so that a subsequent to_glyph_text() of the same text is
+        // a cache hit; may be called concurrently from worker threads. The font selector must be thread safe.
+        virtual void preshape(i_graphics_context const& aContext, char32_t const* aUtf32Begin, char32_t const* aUtf32End, i_font_selector const& aFontSelector) = 0;
+    public:
+        virtual shaping_cache_statistics cache_statistics() const = 0;
+        virtual void set_cache_memory_limit(std::size_t aMemoryLimit) = 0;
+        virtual void clear_cache() = 0;
     public:
         glyph_text to_glyph_text(i_graphics_context const& aContext, char32_t const* aUtf32Begin, char32_t const* aUtf32End, std::function<font(std::size_t)> aFontSelector, bool aAlignBaselines = true)
         {
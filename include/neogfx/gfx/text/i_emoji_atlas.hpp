@@ -25,6 +25,7 @@
 
 namespace neogfx
 {
+    // Emoji are sequences of code points not below U+0100 (keycap and Latin-1 symbol emoji aren't atlas emoji).
     class i_emoji_atlas
     {
     public:
@@ -95,8 +95,19 @@ namespace neogfx
     public:
         virtual const i_texture_atlas& glyph_atlas() const = 0;
         virtual i_texture_atlas& glyph_atlas() = 0;
+        virtual const i_texture_atlas& distance_field_atlas() const = 0;
+        virtual i_texture_atlas& distance_field_atlas() = 0;
         virtual const i_emoji_atlas& emoji_atlas() const = 0;
         virtual i_emoji_atlas& emoji_atlas() = 0;
+        // Adds glyphs rasterized in the background to the glyph atlas; called once per frame.
+        virtual void upload_rasterized_glyphs() = 0;
+    public:
+        // Opt-in on-disk cache of rasterized glyphs, shared by application runs, that spares FreeType rendering the
+        // same glyphs at every startup. Glyphs rasterized during a run are written to the cache file when
+        // save_persistent_glyph_cache() is called and when the font manager is destroyed.
+        virtual void enable_persistent_glyph_cache(i_string const& aPath) = 0;
+        virtual bool persistent_glyph_cache_enabled() const = 0;
+        virtual void save_persistent_glyph_cache() = 0;
     public:
         bool has_font(std::string const& aFamily, std::string const& aStyle) const
         {
@@ -49,10 +49,16 @@ namespace neogfx
     {
     public:
         struct no_outline_texture : std::logic_error { no_outline_texture() : std::logic_error{ "neogfx::i_glyph::no_outline_texture" } {} };
+    public:
+        // Distance (in reference size pixels) either side of a distance field glyph's edge covered by its texture.
+        static constexpr scalar DISTANCE_FIELD_SPREAD = 8.0;
     public:
         virtual ~i_glyph() = default;
     public:
         virtual const i_sub_texture& texture() const = 0;
+        // Extents of the rendered glyph; for a distance field glyph its texture's extents scaled to the font's size.
+        virtual neogfx::size extents() const = 0;
+        virtual bool distance_field() const = 0;
         virtual bool has_outline_texture() const = 0;
         virtual const i_sub_texture& outline_texture() const = 0;
         virtual void set_outline_texture(const i_sub_texture& aOutlineTexture) = 0;
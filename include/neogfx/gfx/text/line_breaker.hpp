@@ -0,0 +1,72 @@
+// line_breaker.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+#include <neogfx/gfx/text/glyph_text.hpp>
+
+namespace neogfx
+{
+    enum class line_breaking : std::uint32_t
+    {
+        Greedy,     // Fill each line in turn (UI text).
+        Optimal     // Minimize the raggedness of the whole paragraph, Knuth-Plass style (documents).
+    };
+
+    // Breaks the paragraphs of a glyph text into lines of a maximum width. Glyph advances are prefix summed and the
+    // break opportunities of each glyph precomputed on construction so the text can be broken again at a new width
+    // (e.g. whilst resizing) without rescanning its glyphs: greedy breaking costs O(lines log n). Keep one with its
+    // glyph text and pass both to i_graphics_context::to_multiline_glyph_text() to wrap the text at each width.
+    class line_breaker
+    {
+    public:
+        typedef glyph_text::size_type size_type;
+        struct paragraph
+        {
+            size_type begin;
+            size_type end;
+        };
+        typedef std::vector<paragraph> paragraphs_t;
+        struct line
+        {
+            size_type begin;
+            size_type end;
+        };
+        typedef std::vector<line> lines_t;
+    public:
+        line_breaker(glyph_text const& aText);
+    public:
+        paragraphs_t const& paragraphs() const;
+        // Appends the lines of a paragraph; a maximum width (in device units) of zero means no wrapping.
+        void break_lines(paragraph const& aParagraph, dimension aMaxWidth, line_breaking aLineBreaking, lines_t& aLines) const;
+    private:
+        dimension width(size_type aBegin, size_type aEnd) const;
+        void break_greedy(size_type aBegin, size_type aEnd, dimension aMaxWidth, lines_t& aLines) const;
+        void break_optimal(paragraph const& aParagraph, dimension aMaxWidth, lines_t& aLines) const;
+    private:
+        paragraphs_t iParagraphs;
+        // Total advance of the glyphs before each glyph (and of all glyphs).
+        std::vector<double> iAdvances;
+        // Where a line overflowing at each glyph ends and the next begins (as word_break).
+        std::vector<std::pair<size_type, size_type>> iBreaks;
+        std::vector<bool> iWhitespace;
+    };
+}
@@ -21,6 +21,13 @@
 
 #include <neogfx/neogfx.hpp>
 
+#include <array>
+#include <map>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NEOGFX_TEXT_CATEGORY_SSE2
+#include <emmintrin.h>
+#endif
+
 #include <neogfx/gfx/text/glyph_text.hpp>
 #include "i_emoji_atlas.hpp"
 
@@ -2187,24 +2194,65 @@ namespace neogfx
 			{ 0x100001, text_category::Unknown },
 			{ 0x10FFFD, text_category::LTR }, 
 		};
+
+        // Two-stage lookup table built (once) from text_category_MAP: the first stage maps each block of BLOCK_SIZE
+        // code points to one of the (deduplicated) blocks of categories making up the second stage.
+        class text_category_table
+        {
+        public:
+            static constexpr char32_t CODE_POINTS = 0x110000u;
+            static constexpr char32_t BLOCK_SIZE = 0x100u;
+        private:
+            typedef std::array<text_category, BLOCK_SIZE> block;
+        public:
+            text_category_table()
+            {
+                std::map<block, std::uint16_t> uniqueBlocks;
+                auto range = std::begin(text_category_MAP);
+                block categories;
+                for (char32_t blockStart = 0u; blockStart < CODE_POINTS; blockStart += BLOCK_SIZE)
+                {
+                    for (char32_t ch = blockStart; ch < blockStart + BLOCK_SIZE; ++ch)
+                    {
+                        while (std::next(range) != std::end(text_category_MAP) && std::next(range)->first <= ch)
+                            ++range;
+                        categories[ch - blockStart] = range->second;
+                    }
+                    if (blockStart == (0xFE0Eu & ~(BLOCK_SIZE - 1u)))
+                        categories[0xFE0Eu - blockStart] = categories[0xFE0Fu - blockStart] = text_category::Control;
+                    auto const existing = uniqueBlocks.try_emplace(categories, static_cast<std::uint16_t>(iBlocks.size())).first;
+                    if (existing->second == iBlocks.size())
+                        iBlocks.push_back(categories);
+                    iStage1[blockStart / BLOCK_SIZE] = existing->second;
+                }
+            }
+        public:
+            text_category operator[](char32_t aCodePoint) const
+            {
+                if (aCodePoint >= CODE_POINTS)
+                    return text_category::Unknown;
+                return iBlocks[iStage1[aCodePoint / BLOCK_SIZE]][aCodePoint % BLOCK_SIZE];
+            }
+            // Categories of U+0000 to U+00FF.
+            text_category const* latin1() const
+            {
+                return iBlocks[iStage1[0]].data();
+            }
+        private:
+            std::array<std::uint16_t, CODE_POINTS / BLOCK_SIZE> iStage1;
+            std::vector<block> iBlocks;
+        };
+
+        inline text_category_table const& text_categories()
+        {
+            static text_category_table const sTable;
+            return sTable;
+        }
     }
 
 	inline text_category get_text_category(char32_t aCharacter)
 	{
-		char32_t ch = aCharacter;
-		if (ch == 0xFE0F || ch == 0xFE0E)
-			return text_category::Control;
-		const detail::text_category_MAP_VALUE_TYPE* rangeStart = std::lower_bound(
-			&detail::text_category_MAP[0],
-			&detail::text_category_MAP[0] + sizeof(detail::text_category_MAP) / sizeof(detail::text_category_MAP[0]),
-			detail::text_category_MAP_VALUE_TYPE(ch, text_category::Unknown),
-			[](const detail::text_category_MAP_VALUE_TYPE& lhs, const detail::text_category_MAP_VALUE_TYPE& rhs) -> bool
-			{
-				return lhs.first < rhs.first;
-			});
-		if (rangeStart != &detail::text_category_MAP[0] && ch < rangeStart->first)
-			--rangeStart;
-		return rangeStart->second;
+		return detail::text_categories()[aCharacter];
 	}
 
 	inline text_category get_text_category(char aCharacter)
@@ -2235,6 +2283,43 @@ namespace neogfx
         return get_text_category(aEmojiAtlas, &aCodePoint, &aCodePoint + 1);
     }
 
+    // Number of leading code points in [aFirst, aLast) that are ASCII.
+    inline std::size_t ascii_prefix_length(const char32_t* aFirst, const char32_t* aLast)
+    {
+        auto next = aFirst;
+#ifdef NEOGFX_TEXT_CATEGORY_SSE2
+        __m128i const nonAscii = _mm_set1_epi32(~0x7F);
+        __m128i const zero = _mm_setzero_si128();
+        for (; aLast - next >= 8; next += 8)
+        {
+            __m128i const lo = _mm_loadu_si128(reinterpret_cast<__m128i const*>(next));
+            __m128i const hi = _mm_loadu_si128(reinterpret_cast<__m128i const*>(next + 4));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(_mm_or_si128(lo, hi), nonAscii), zero)) != 0xFFFF)
+                break;
+        }
+#endif
+        while (next != aLast && *next < 0x80u)
+            ++next;
+        return static_cast<std::size_t>(next - aFirst);
+    }
+
+    // Categorizes each code point of [aFirst, aLast) as get_text_category(aEmojiAtlas, ...) would; aCategories must
+    // have room for aLast - aFirst categories. Runs of ASCII (which is never emoji) are looked up directly.
+    inline void get_text_categories(const i_emoji_atlas& aEmojiAtlas, const char32_t* aFirst, const char32_t* aLast, text_category* aCategories)
+    {
+        auto const latin1 = detail::text_categories().latin1();
+        while (aFirst != aLast)
+        {
+            for (auto const asciiEnd = aFirst + ascii_prefix_length(aFirst, aLast); aFirst != asciiEnd; ++aFirst)
+                *aCategories++ = latin1[*aFirst];
+            if (aFirst != aLast)
+            {
+                *aCategories++ = get_text_category(aEmojiAtlas, aFirst, aLast);
+                ++aFirst;
+            }
+        }
+    }
+
     inline text_direction get_text_direction(const i_emoji_atlas& aEmojiAtlas, const char32_t* aCodePoint, const char32_t* aCodePointEnd, std::optional<text_direction> aLineDirection = std::nullopt, std::optional<text_direction> aCurrentDirection = std::nullopt)
     {
         if (aCodePoint != aCodePointEnd)
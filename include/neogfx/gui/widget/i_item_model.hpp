@@ -297,6 +297,11 @@ namespace neogfx
         virtual ~i_item_model() = default;
     public:
         virtual bool is_tree() const = 0;
+        // True if cells are fetched on demand rather than held by the model (see virtual_item_model).
+        virtual bool is_virtual() const = 0;
+        // True if cell_data() may be called concurrently from several threads (whilst the model isn't being changed);
+        // presentation models only filter a model's rows in parallel if it is.
+        virtual bool thread_safe_cell_data() const = 0;
         virtual std::uint32_t rows() const = 0;
         virtual std::uint32_t columns() const = 0;
         virtual std::uint32_t columns(item_model_index const& aIndex) const = 0;
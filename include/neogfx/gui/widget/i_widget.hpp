@@ -126,6 +126,9 @@ namespace neogfx
         virtual widget_list::iterator last() = 0;
         virtual widget_list::const_iterator find(const i_widget& aChild, bool aThrowIfNotFound = true) const = 0;
         virtual widget_list::iterator find(const i_widget& aChild, bool aThrowIfNotFound = true) = 0;
+        virtual bool has_child_spatial_index() const = 0;
+        virtual void enable_child_spatial_index(bool aEnable) = 0;
+        virtual void child_geometry_changed(const i_widget& aChild) = 0;
     public:
         virtual void bring_child_to_front(const i_widget& aChild) = 0;
         virtual void send_child_to_back(const i_widget& aChild) = 0;
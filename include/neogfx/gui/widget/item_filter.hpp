@@ -0,0 +1,77 @@
+// item_filter.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+#include <bitset>
+#include <locale>
+#include <regex>
+#include <string_view>
+
+#include <neogfx/gui/widget/i_item_presentation_model.hpp>
+
+namespace neogfx
+{
+    // A filter search key compiled for matching cell text: a prefix (compared a character at a time rather than by
+    // case folding a copy of each value), a glob (anchored; '*' matches any run of characters, '?' any one character
+    // and "[...]" any one byte of a set, "[!...]" or "[^...]" any byte not in it, with '\' quoting the character
+    // following, also within a set) or a regular expression (ECMAScript, searched for). Matching is thread safe.
+    class item_filter
+    {
+    public:
+        typedef i_item_presentation_model::filter_search_type filter_search_type;
+        typedef i_item_presentation_model::case_sensitivity case_sensitivity;
+    private:
+        struct glob_token
+        {
+            enum kind_e : std::uint8_t
+            {
+                AnyRun,
+                AnyCharacter,
+                Set
+            } kind;
+            std::bitset<256> set;
+            bool operator==(glob_token const& aOther) const { return kind == aOther.kind && set == aOther.set; }
+        };
+    public:
+        item_filter(std::string_view const& aKey, filter_search_type aSearchType, case_sensitivity aCaseSensitivity);
+    public:
+        // True if the filter matches every value: its key is empty or is not a valid regular expression.
+        bool empty() const;
+        bool matches(std::string_view const& aValue) const;
+        // True if every value this filter matches is matched by aPrevious so that replacing aPrevious with it need only
+        // test the values aPrevious matched (e.g. a prefix being typed).
+        bool narrows(item_filter const& aPrevious) const;
+    private:
+        void compile_glob(std::string_view const& aKey);
+        bool compile_glob_set(std::string_view::const_iterator& aNext, std::string_view::const_iterator aEnd, std::bitset<256>& aSet) const;
+        void fold_glob_set(std::bitset<256>& aSet) const;
+        bool matches_glob(std::string_view const& aValue) const;
+    private:
+        filter_search_type iSearchType;
+        case_sensitivity iCaseSensitivity;
+        std::locale iLocale;
+        std::ctype<char> const* iCtype;
+        std::string iKey;
+        std::vector<glob_token> iGlob;
+        std::optional<std::regex> iRegex;
+    };
+}
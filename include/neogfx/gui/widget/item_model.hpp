@@ -254,6 +254,16 @@ namespace neogfx
         {
             return container_traits::is_tree;
         }
+        bool is_virtual() const final
+        {
+            return false;
+        }
+        // Cells are only read from the item container; a model overriding cell_data() with something that isn't
+        // safe to call concurrently must override this too.
+        bool thread_safe_cell_data() const override
+        {
+            return true;
+        }
         std::uint32_t rows() const final
         {
             return static_cast<std::uint32_t>(iItems.size());
@@ -0,0 +1,74 @@
+// item_prefix_index.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+#include <locale>
+#include <string_view>
+
+#include <neogfx/gui/widget/i_item_model.hpp>
+
+namespace neogfx
+{
+    // Case folded cell text of item model columns sorted for finding the rows beginning with a prefix in O(log n + k),
+    // e.g. for type-ahead. Columns are indexed on request and then kept up to date as rows are added, removed and
+    // changed: the text of each row is updated as it changes but adding or removing a row (which renumbers those after
+    // it) only marks the sorted entries stale, to be rebuilt by the next find.
+    class item_prefix_index
+    {
+    public:
+        typedef item_model_index::row_type row_type;
+        typedef item_model_index::column_type column_type;
+    private:
+        struct entry
+        {
+            std::string key;
+            row_type row;
+            bool operator<(entry const& aOther) const { return std::tie(key, row) < std::tie(aOther.key, aOther.row); }
+        };
+        struct column_index
+        {
+            // Indexed by row.
+            std::vector<std::string> keys;
+            std::vector<entry> entries;
+            bool stale = false;
+        };
+    public:
+        item_prefix_index();
+    public:
+        bool indexed(column_type aColumn) const;
+        void index(i_item_model const& aModel, column_type aColumn);
+        void clear();
+        void row_inserted(i_item_model const& aModel, row_type aRow);
+        void row_removed(row_type aRow);
+        void cell_changed(i_item_model const& aModel, item_model_index const& aIndex);
+    public:
+        // Appends the rows whose text in an indexed column begins with aPrefix (ignoring case) in text order.
+        void find(column_type aColumn, std::string_view const& aPrefix, std::vector<row_type>& aRows);
+    private:
+        std::string make_key(i_item_model const& aModel, item_model_index const& aIndex) const;
+        static void sort(column_index& aColumn);
+    private:
+        std::locale iLocale;
+        std::ctype<char> const* iCtype;
+        std::vector<std::optional<column_index>> iColumns;
+    };
+}
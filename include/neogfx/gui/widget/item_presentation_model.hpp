@@ -23,6 +23,8 @@
 
 #include <vector>
 #include <deque>
+#include <numeric>
+#include <execution>
 #include <boost/algorithm/string.hpp>
 
 #include <neolib/core/vecarray.hpp>
@@ -37,6 +39,9 @@
 #include <neogfx/gui/widget/spin_box.hpp>
 #include <neogfx/gui/widget/item_model.hpp>
 #include <neogfx/gui/widget/i_item_presentation_model.hpp>
+#include <neogfx/gui/widget/item_sort_keys.hpp>
+#include <neogfx/gui/widget/item_filter.hpp>
+#include <neogfx/gui/widget/item_prefix_index.hpp>
 #include <neogfx/gui/widget/i_skin_manager.hpp>
 
 namespace neogfx
@@ -126,6 +131,8 @@ namespace neogfx
         using typename base_type::no_item_model;
         using typename base_type::bad_index;
         using typename base_type::no_mapped_row;
+    public:
+        static constexpr item_presentation_model_index::row_type VIRTUAL_MEASURED_ROWS = 1000u;
     public:
         basic_item_presentation_model(bool aSortable = false) : iItemModel{ nullptr }, iSortable{ aSortable }, iAlternatingRowColor{ false }
         {
@@ -222,26 +229,51 @@ namespace neogfx
                         iColumns.clear();
                         for (item_model_index::column_type col = 0; col < item_model().columns(); ++col)
                             iColumns.emplace_back(col);
-                        iRows.clear();
-                        for (item_model_index::row_type row = 0; row < item_model().rows(); ++row)
-                            item_added(item_model_index{ row });
+                        populate_rows();
                     }
 
                     ItemModelChanged(item_model());
                 };
                 iItemModelSink.clear();
                 iItemModel = &aItemModel;
+                iSortKeys.clear();
+                iPrefixIndex.clear();
+                iFilterNarrowable = false;
                 iItemModelSink += item_model().column_info_changed([this](item_model_index::column_type aColumnIndex) { item_model_column_info_changed(aColumnIndex); });
-                iItemModelSink += item_model().item_added([this](const item_model_index& aItemIndex) { item_added(aItemIndex); });
-                iItemModelSink += item_model().item_changed([this](const item_model_index& aItemIndex) { item_changed(aItemIndex); });
-                iItemModelSink += item_model().item_removing([this](const item_model_index& aItemIndex) { item_removing(aItemIndex); });
+                iItemModelSink += item_model().item_added([this](const item_model_index& aItemIndex)
+                {
+                    iSortKeys.row_inserted(aItemIndex.row());
+                    iPrefixIndex.row_inserted(item_model(), aItemIndex.row());
+                    iFilterNarrowable = false;
+                    item_added(aItemIndex);
+                });
+                iItemModelSink += item_model().item_changed([this](const item_model_index& aItemIndex)
+                {
+                    iSortKeys.cell_changed(aItemIndex);
+                    iPrefixIndex.cell_changed(item_model(), aItemIndex);
+                    iFilterNarrowable = false;
+                    item_changed(aItemIndex);
+                });
+                iItemModelSink += item_model().item_removing([this](const item_model_index& aItemIndex)
+                {
+                    iSortKeys.row_removed(aItemIndex.row());
+                    iPrefixIndex.row_removed(aItemIndex.row());
+                    iFilterNarrowable = false;
+                    item_removing(aItemIndex);
+                });
                 iItemModelSink += item_model().item_removed([this](const item_model_index& aItemIndex) { item_removed(aItemIndex); });
                 iItemModelSink += item_model().cleared([this]()
                 {  
-                    iRows.clear();
+                    iSortKeys.clear();
+                    iPrefixIndex.clear();
+                    iFilterNarrowable = false;
+                    // A virtual model is cleared when reset so may have rows again.
+                    populate_rows();
                     reset_maps();
                     reset_meta();
                     reset_sort();
+                    if (!iRows.empty() && !iFilters.empty())
+                        execute_filter();
                     ItemModelChanged(item_model());
                 });
                 iItemModelSink += item_model().destroying([this]() 
@@ -249,6 +281,9 @@ namespace neogfx
                     iItemModel = nullptr;
                     iColumns.clear(); 
                     iRows.clear(); 
+                    iSortKeys.clear();
+                    iPrefixIndex.clear();
+                    iFilterNarrowable = false;
                     reset_maps();
                     reset_meta();
                     reset_sort();
@@ -316,7 +351,9 @@ namespace neogfx
             auto& cellWidths = column(aColumnIndex).cellWidths;
             if (!cellWidths.empty())
                 return units_converter(aUnitsContext).from_device_units(cellWidths.rbegin()->first) + (aExtendIntoPadding ? cell_padding(aUnitsContext).size().cx : 0.0);
-            for (item_presentation_model_index::row_type row = 0u; row < rows(); ++row)
+            // The cells of a virtual model are measured only as far as a sample of rows (and those since shown).
+            auto const measuredRows = uniform_row_heights() ? std::min<item_presentation_model_index::row_type>(rows(), VIRTUAL_MEASURED_ROWS) : rows();
+            for (item_presentation_model_index::row_type row = 0u; row < measuredRows; ++row)
                 cell_extents(item_presentation_model_index{ row, aColumnIndex }, aUnitsContext);
             return units_converter(aUnitsContext).from_device_units(cellWidths.rbegin()->first) + (aExtendIntoPadding ? cell_padding(aUnitsContext).size().cx : 0.0);
         }
@@ -570,6 +607,9 @@ namespace neogfx
     public:
         dimension item_height(item_presentation_model_index const& aIndex, i_units_context const& aUnitsContext) const final
         {
+            if (uniform_row_heights())
+                return units_converter(aUnitsContext).from_device_units(size{ 0.0, std::ceil(default_font().height()) }).cy +
+                    cell_padding(aUnitsContext).size().cy + cell_spacing(aUnitsContext).cy;
             dimension height = 0.0;
             for (std::uint32_t col = 0; col < row(aIndex).cells.size(); ++col)
             {
@@ -598,6 +638,8 @@ namespace neogfx
         {
             if (iTotalHeight != std::nullopt)
                 return *iTotalHeight;
+            if (uniform_row_heights())
+                return *(iTotalHeight = rows() * item_height(item_presentation_model_index{}, aUnitsContext));
             i_scrollbar::value_type height = 0.0;
             for (item_presentation_model_index::row_type row = 0; row < rows(); ++row)
                 height += item_height(item_presentation_model_index(row, 0), aUnitsContext);
@@ -606,6 +648,8 @@ namespace neogfx
         }
         double item_position(item_presentation_model_index const& aIndex, i_units_context const& aUnitsContext) const final
         {
+            if (uniform_row_heights())
+                return aIndex.row() * item_height(aIndex, aUnitsContext);
             if (iPositions[aIndex.row()] == std::nullopt)
             {
                 auto pred = [](const optional_position& lhs, const optional_position& rhs) -> bool
@@ -635,6 +679,12 @@ namespace neogfx
         {
             if (rows() == 0)
                 return std::pair<item_presentation_model_index::row_type, coordinate>{ 0u, 0.0 };
+            if (uniform_row_heights())
+            {
+                auto const height = item_height(item_presentation_model_index{}, aUnitsContext);
+                auto const row = static_cast<item_presentation_model_index::row_type>(std::clamp(std::floor(aPosition / height), 0.0, rows() - 1.0));
+                return std::pair<item_presentation_model_index::row_type, coordinate>{ row, static_cast<coordinate>(row * height - aPosition) };
+            }
             auto pred = [](const optional_position& lhs, const optional_position& rhs) -> bool
             {
                 if (lhs == std::nullopt && rhs == std::nullopt)
@@ -991,21 +1041,39 @@ namespace neogfx
         optional_item_presentation_model_index find_item(i_filter_search_key const& aFilterSearchKey, item_presentation_model_index::column_type aColumnIndex = 0, 
             filter_search_type aFilterSearchType = filter_search_type::Prefix, case_sensitivity aCaseSensitivity = case_sensitivity::CaseInsensitive) const final
         {
-            for (item_presentation_model_index::row_type row = 0; row < rows(); ++row)
+            item_filter const matcher{ aFilterSearchKey.to_std_string_view(), aFilterSearchType, aCaseSensitivity };
+            if (matcher.empty())
+                return optional_item_presentation_model_index{};
+            if (aFilterSearchType == filter_search_type::Prefix)
             {
-                auto modelIndex = to_item_model_index(item_presentation_model_index{ row, aColumnIndex });
-                auto const& origValue = item_model().cell_data(modelIndex).to_std_string();
-                auto const& value = aCaseSensitivity == case_sensitivity::CaseSensitive ? origValue : boost::to_upper_copy(origValue);
-                auto const& origKey = aFilterSearchKey.to_std_string();
-                auto const& key = aCaseSensitivity == case_sensitivity::CaseSensitive ? origKey : boost::to_upper_copy(origKey);
-                if (key.empty())
-                    continue;
-                switch (aFilterSearchType)
+                // Look up the column's prefix index (built on first use) for the rows beginning with the key ignoring
+                // case and return the first shown (and matching case if need be).
+                auto const modelColumn = model_column(aColumnIndex);
+                if (!iPrefixIndex.indexed(modelColumn))
+                    iPrefixIndex.index(item_model(), modelColumn);
+                thread_local std::vector<item_model_index::row_type> candidates;
+                candidates.clear();
+                iPrefixIndex.find(modelColumn, aFilterSearchKey.to_std_string_view(), candidates);
+                optional_item_presentation_model_index result;
+                for (auto candidate : candidates)
                 {
-                case filter_search_type::Prefix:
-                    if (value.size() >= key.size() && value.substr(0, key.size()) == key)
-                        return from_item_model_index(modelIndex);
+                    item_model_index const modelIndex{ candidate, modelColumn };
+                    if (!has_item_model_index(modelIndex))
+                        continue;
+                    auto const index = from_item_model_index(modelIndex);
+                    if (result && result->row() <= index.row())
+                        continue;
+                    if (aCaseSensitivity == case_sensitivity::CaseSensitive && !matcher.matches(item_model().cell_data(modelIndex).to_std_string()))
+                        continue;
+                    result = index;
                 }
+                return result;
+            }
+            for (item_presentation_model_index::row_type row = 0; row < rows(); ++row)
+            {
+                auto modelIndex = to_item_model_index(item_presentation_model_index{ row, aColumnIndex });
+                if (matcher.matches(item_model().cell_data(modelIndex).to_std_string()))
+                    return from_item_model_index(modelIndex);
             }
             return optional_item_presentation_model_index{};
         }
@@ -1022,7 +1090,7 @@ namespace neogfx
                 return optional_filter{};
         }
         void filter_by(item_presentation_model_index::column_type aColumnIndex, i_filter_search_key const& aFilterSearchKey, 
-            filter_search_type aFilterSearchType = filter_search_type::Value, case_sensitivity aCaseSensitivity = case_sensitivity::CaseInsensitive) final
+            filter_search_type aFilterSearchType = filter_search_type::Prefix, case_sensitivity aCaseSensitivity = case_sensitivity::CaseInsensitive) final
         {
             iFilters.push_back(filter{ aColumnIndex, aFilterSearchKey, aFilterSearchType, aCaseSensitivity });
             for (auto i = iFilters.begin(); i != std::prev(iFilters.end()); ++i)
@@ -1070,33 +1138,32 @@ namespace neogfx
                 return;
             }
             ItemsSorting();
-            auto sortPredicate = [&](const typename container_type::value_type& aLhs, const typename container_type::value_type& aRhs) -> bool
+            // Compare the sort keys of the cells (extracted and case folded once and kept until the cells change)
+            // rather than the cells themselves.
+            item_sort_keys::sort_columns sortColumns;
+            for (auto const& sortBy : iSortOrder)
+                sortColumns.emplace_back(model_column(sortBy.first), sortBy.second);
+            iSortKeys.prepare(item_model(), sortColumns);
+            if constexpr (container_traits::is_flat)
             {
-                for (std::size_t i = 0; i < iSortOrder.size(); ++i)
+                // Stable sort row positions (in parallel; comparing keys is thread safe) then move the rows into place.
+                std::vector<std::size_t> order(iRows.size());
+                std::iota(order.begin(), order.end(), 0u);
+                std::stable_sort(std::execution::par, order.begin(), order.end(), [&](std::size_t aLhs, std::size_t aRhs)
                 {
-                    auto col = iSortOrder[i].first;
-                    auto const& v1 = item_model().cell_data(item_model_index{ aLhs.value, model_column(col) });
-                    auto const& v2 = item_model().cell_data(item_model_index{ aRhs.value, model_column(col) });
-                    if (std::holds_alternative<string>(v1) && std::holds_alternative<string>(v2))
-                    {
-                        string s1 = boost::to_upper_copy(std::get<string>(v1).to_std_string());
-                        string s2 = boost::to_upper_copy(std::get<string>(v2).to_std_string());
-                        if (s1 < s2)
-                            return iSortOrder[i].second == sort_direction::Ascending;
-                        else if (s2 < s1)
-                            return iSortOrder[i].second == sort_direction::Descending;
-                    }
-                    if (v1 < v2)
-                        return iSortOrder[i].second == sort_direction::Ascending;
-                    else if (v2 < v1)
-                        return iSortOrder[i].second == sort_direction::Descending;
-                }
-                return false;
-            };
-            if constexpr (container_traits::is_flat)
-                std::sort(iRows.begin(), iRows.end(), sortPredicate);
+                    return iSortKeys.less(iRows[aLhs].value, iRows[aRhs].value, sortColumns);
+                });
+                container_type sorted{ iRows.get_allocator() };
+                sorted.reserve(iRows.size());
+                for (auto position : order)
+                    sorted.push_back(std::move(iRows[position]));
+                iRows = std::move(sorted);
+            }
             else
-                iRows.sort(sortPredicate);
+                iRows.sort([&](const typename container_type::value_type& aLhs, const typename container_type::value_type& aRhs) -> bool
+                {
+                    return iSortKeys.less(aLhs.value, aRhs.value, sortColumns);
+                });
             reset_row_map();
             reset_position_meta(0);
             ItemsSorted();
@@ -1107,40 +1174,97 @@ namespace neogfx
                 scoped_item_update siu{ *this };
                 neolib::scoped_flag sf2{ iFiltering };
                 ItemsFiltering();
-                iRows.clear();
-                for (item_model_index::row_type row = 0; row < item_model().rows(); ++row)
+                std::vector<std::pair<item_model_index::column_type, item_filter>> matchers;
+                for (auto const& filter : iFilters)
                 {
-                    bool matches = true;
-                    for (auto const& filter : iFilters)
+                    item_filter matcher{ std::get<1>(filter).to_std_string_view(), std::get<2>(filter), std::get<3>(filter) };
+                    if (!matcher.empty())
+                        matchers.emplace_back(model_column(std::get<0>(filter)), std::move(matcher));
+                }
+                // If each filter is only narrowed (e.g. a prefix key being typed) and the model hasn't changed since
+                // the rows were last filtered then only the rows shown need testing again.
+                bool const narrowing = iFilterNarrowable && std::all_of(iFilterMatchers.begin(), iFilterMatchers.end(), [&](auto const& aPrevious)
+                {
+                    return std::any_of(matchers.begin(), matchers.end(), [&](auto const& aMatcher)
                     {
-                        auto const& origValue = item_model().cell_data(item_model_index{ row, model_column(std::get<0>(filter)) }).to_std_string();
-                        auto const& value = (std::get<3>(filter) == case_sensitivity::CaseSensitive ? origValue : boost::to_upper_copy(origValue));
-                        auto const& origKey = std::get<1>(filter).to_std_string();
-                        auto const& key = (std::get<3>(filter) == case_sensitivity::CaseSensitive ? origKey : boost::to_upper_copy(origKey));
-                        if (key.empty())
-                            continue;
-                        switch (std::get<2>(filter))
-                        {
-                        case filter_search_type::Prefix:
-                            if (value.size() < key.size() || value.substr(0, key.size()) != key)
-                                matches = false;
-                            break;
-                        case filter_search_type::Glob:
-                            // todo
-                            break;
-                        case filter_search_type::Regex:
-                            // todo
-                            break;
-                        }
-                    }
-                    if (matches)
-                        item_added(item_model_index{ row });
+                        return aMatcher.first == aPrevious.first && aMatcher.second.narrows(aPrevious.second);
+                    });
+                });
+                std::vector<item_model_index::row_type> candidates;
+                if (narrowing)
+                {
+                    candidates.reserve(iRows.size());
+                    for (auto const& row : iRows)
+                        candidates.push_back(row.value);
+                    std::sort(candidates.begin(), candidates.end());
+                }
+                else
+                {
+                    candidates.resize(item_model().rows());
+                    std::iota(candidates.begin(), candidates.end(), 0u);
+                }
+                std::vector<std::uint8_t> matches(candidates.size(), true);
+                if (!matchers.empty())
+                {
+                    // Test the rows in chunks, in parallel if there is more than one and the model's cell data can be
+                    // read concurrently (matching is thread safe).
+                    std::size_t constexpr chunkSize = 4096u;
+                    std::vector<std::size_t> chunks((candidates.size() + chunkSize - 1u) / chunkSize);
+                    std::iota(chunks.begin(), chunks.end(), 0u);
+                    auto const test_chunk = [&](std::size_t aChunk)
+                    {
+                        auto const end = std::min(candidates.size(), (aChunk + 1u) * chunkSize);
+                        for (auto candidate = aChunk * chunkSize; candidate < end; ++candidate)
+                            for (auto const& matcher : matchers)
+                                if (!matcher.second.matches(item_model().cell_data(item_model_index{ candidates[candidate], matcher.first }).to_std_string()))
+                                {
+                                    matches[candidate] = false;
+                                    break;
+                                }
+                    };
+                    if (chunks.size() > 1u && item_model().thread_safe_cell_data())
+                        std::for_each(std::execution::par, chunks.begin(), chunks.end(), test_chunk);
+                    else
+                        std::for_each(chunks.begin(), chunks.end(), test_chunk);
+                }
+                iRows.clear();
+                if constexpr (container_traits::is_flat)
+                {
+                    // Install the rows in one go; the maps and meta are reset at the end of the update.
+                    iRows.reserve(static_cast<std::size_t>(std::count(matches.begin(), matches.end(), true)));
+                    for (std::size_t candidate = 0u; candidate < candidates.size(); ++candidate)
+                        if (matches[candidate])
+                            iRows.push_back(row_type{ candidates[candidate] });
+                }
+                else
+                {
+                    for (std::size_t candidate = 0u; candidate < candidates.size(); ++candidate)
+                        if (matches[candidate])
+                            item_added(item_model_index{ candidates[candidate] });
                 }
+                iFilterMatchers = std::move(matchers);
+                iFilterNarrowable = true;
             }
             ItemsFiltered();
             execute_sort();
         }
     private:
+        void populate_rows()
+        {
+            iRows.clear();
+            if constexpr (container_traits::is_flat)
+            {
+                // Install the rows in one go rather than a row at a time.
+                iRows.reserve(item_model().rows());
+                for (item_model_index::row_type row = 0; row < item_model().rows(); ++row)
+                    iRows.push_back(row_type{ row });
+            }
+            else
+            {
+                for (item_model_index::row_type row = 0; row < item_model().rows(); ++row)
+                    item_added(item_model_index{ row });
+            }
+        }
         void item_model_column_info_changed(item_model_index::column_type aColumnIndex)
         {
             reset_column_map(false);
@@ -1183,8 +1307,10 @@ namespace neogfx
             if (!updating())
             {
                 reset_position_meta(aItemIndex.row());
-                execute_sort();
+                // Notified before sorting so that listeners (e.g. the selection model) shift their rows for the new
+                // row before saving them to restore after the sort.
                 ItemAdded(from_item_model_index(aItemIndex, true));
+                execute_sort();
             }
         }
         void item_changed(const item_model_index& aItemIndex)
@@ -1337,13 +1463,18 @@ namespace neogfx
         {
             return iColumnMap;
         }
+        // Rows of a virtual model are all a single line high so that positions are calculated rather than cached.
+        bool uniform_row_heights() const
+        {
+            return has_item_model() && item_model().is_virtual();
+        }
         void reset_meta() const
         {
             reset_cell_meta();
             reset_column_meta();
             reset_position_meta(0);
 
-            if (attached())
+            if (attached() && !uniform_row_heights())
                 for (item_presentation_model_index::row_type row = 0; row < rows(); ++row)
                     for (item_presentation_model_index::column_type col = 0; col < iColumns.size(); ++col)
                         cell_extents(item_presentation_model_index{row, col}, attachment());
@@ -1356,6 +1487,9 @@ namespace neogfx
                 {
                     if (aColumn != std::nullopt && col != *aColumn)
                         continue;
+                    // Cell meta not yet allocated has nothing to reset.
+                    if (col >= this->row(row).cells.size())
+                        break;
                     item_presentation_model_index const index{ row, col };
                     cell_meta(index).text = std::nullopt;
                     cache_cell_meta_extents(index, std::nullopt);
@@ -1374,6 +1508,11 @@ namespace neogfx
         void reset_position_meta(item_presentation_model_index::row_type aFromRow) const
         {
             iTotalHeight = std::nullopt;
+            if (uniform_row_heights())
+            {
+                iPositions.clear();
+                return;
+            }
             iPositions.resize(rows());
             for (std::size_t i = aFromRow; i < iPositions.size(); ++i)
                 iPositions[i] = std::nullopt;
@@ -1459,7 +1598,11 @@ namespace neogfx
         mutable neolib::segmented_array<optional_position, 256> iPositions;
         bool iAlternatingRowColor;
         std::deque<sort_by_param> iSortOrder;
+        item_sort_keys iSortKeys;
         std::vector<filter> iFilters;
+        std::vector<std::pair<item_model_index::column_type, item_filter>> iFilterMatchers;
+        bool iFilterNarrowable = false;
+        mutable item_prefix_index iPrefixIndex;
         sink iSink;
         std::uint32_t iUpdating = 0u;
         bool iFiltering = false;
@@ -44,7 +44,10 @@ namespace neogfx
         typedef Alloc allocator_type;
     private:
         using concrete_item_selection = neolib::map<item_presentation_model_index, selection_area, std::less<item_presentation_model_index>, allocator_type>;
-        typedef std::deque<std::pair<item_presentation_model_index, item_selection_operation>> operation_queue_t;
+        typedef std::deque<std::tuple<item_presentation_model_index, item_presentation_model_index, item_selection_operation>> operation_queue_t;
+        typedef item_presentation_model_index::row_type row_type;
+        typedef std::vector<std::pair<row_type, row_type>> row_ranges;
+        typedef std::map<item_model_index::row_type, item_model_index::row_type> model_row_ranges;
     public:
         basic_item_selection_model(item_selection_mode aMode = item_selection_mode::SingleSelection) :
             iModel{ nullptr },
@@ -98,7 +101,9 @@ namespace neogfx
             iSink += presentation_model().item_model_changed([this](const i_item_model&)
             {
                 iCurrentIndex = std::nullopt;
-                reindex();
+                iPreviousSelection.clear();
+                iSelection.clear();
+                iRows = presentation_model().rows();
             });
             iSink += presentation_model().item_added([this](item_presentation_model_index const& aIndex)
             {
@@ -107,7 +112,10 @@ namespace neogfx
                     if (current_index().row() >= aIndex.row())
                         iCurrentIndex->set_row(current_index().row() + 1u);
                 }
-                reindex();
+                // Not if the row is already accounted for by a restored selection.
+                if (presentation_model().rows() != iRows)
+                    insert_rows(aIndex.row(), 1u);
+                iRows = presentation_model().rows();
             });
             iSink += presentation_model().item_removing([this](item_presentation_model_index const& aIndex)
             {
@@ -120,25 +128,41 @@ namespace neogfx
                     else if (current_index().row() == aIndex.row() && aIndex.row() == presentation_model().rows() - 1u)
                         iCurrentIndex->set_row(aIndex.row() - 1u);
                 }
-                reindex();
+                remove_rows(aIndex.row(), 1u);
+                iRows = presentation_model().rows() - 1u;
             });
             iSink += presentation_model().item_expanded([this](item_presentation_model_index const& aIndex)
             {
                 if (has_current_index() && current_index().row() > aIndex.row())
                     iCurrentIndex = std::nullopt;
-                reindex();
+                if (presentation_model().rows() > iRows)
+                    insert_rows(aIndex.row() + 1u, presentation_model().rows() - iRows);
+                iRows = presentation_model().rows();
             });
             iSink += presentation_model().item_collapsed([this](item_presentation_model_index const& aIndex)
             {
                 if (has_current_index() && current_index().row() > aIndex.row())
                     iCurrentIndex = std::nullopt;
-                reindex();
+                if (presentation_model().rows() < iRows)
+                    remove_rows(aIndex.row() + 1u, iRows - presentation_model().rows());
+                iRows = presentation_model().rows();
+            });
+            iSink += presentation_model().items_updated([this]()
+            {
+                // Rows added or removed during an update aren't notified so drop any selected rows no longer present.
+                if (!iFilterPending && presentation_model().rows() < iRows)
+                    remove_rows(presentation_model().rows(), iRows - presentation_model().rows());
+                if (!iFilterPending)
+                    iRows = presentation_model().rows();
             });
             iSink += presentation_model().items_sorting([this]()
             {
                 neolib::scoped_flag sf{ iSorting };
                 iSavedModelIndex = has_current_index() ? presentation_model().to_item_model_index(current_index()) : optional_item_model_index{};
                 clear_current_index();
+                // A sort at the end of filtering keeps the selection saved before filtering.
+                if (!iFilterPending)
+                    save_selection(true);
             });
             iSink += presentation_model().items_sorted([this]()
             {
@@ -146,13 +170,16 @@ namespace neogfx
                 if (iSavedModelIndex != std::nullopt)
                     set_current_index(presentation_model().from_item_model_index(*iSavedModelIndex));
                 iSavedModelIndex = std::nullopt;
-                reindex();
+                if (!iFilterPending)
+                    restore_selection();
             });
             iSink += presentation_model().items_filtering([this]()
             {
                 neolib::scoped_flag sf{ iFiltering };
                 iSavedModelIndex = has_current_index() ? presentation_model().to_item_model_index(current_index()) : optional_item_model_index{};
                 clear_current_index();
+                save_selection(false);
+                iFilterPending = true;
             });
             iSink += presentation_model().items_filtered([this]()
             {
@@ -162,7 +189,8 @@ namespace neogfx
                 else if (presentation_model().rows() >= 1)
                     set_current_index(item_presentation_model_index{ 0u, 0u });
                 iSavedModelIndex = std::nullopt;
-                reindex();
+                iFilterPending = false;
+                restore_selection();
             });
             iSink += neolib::destroying(presentation_model(), [this]()
             {
@@ -170,9 +198,17 @@ namespace neogfx
                 iModel = nullptr;
                 iCurrentIndex = std::nullopt;
                 iSavedModelIndex = std::nullopt;
+                iSavedSelection.clear();
+                iSavedAllRows = false;
+                iFilterPending = false;
+                iPreviousSelection = {};
                 iSelection = {};
+                iRows = 0u;
                 PresentationModelRemoved(*oldModel);
             });
+            iPreviousSelection.clear();
+            iSelection.clear();
+            iRows = presentation_model().rows();
 
             if (oldModel == nullptr)
                 PresentationModelAdded(presentation_model());
@@ -339,7 +375,7 @@ namespace neogfx
         }
         bool is_selected(item_presentation_model_index const& aIndex) const override
         {
-            return (presentation_model().cell_meta(aIndex).selection & item_cell_selection_flags::Selected) == item_cell_selection_flags::Selected;
+            return find_rows(iSelection, aIndex.row()) != iSelection.end() && is_selectable(aIndex);
         }    
         bool is_selectable(item_presentation_model_index const& aIndex) const override
         {
@@ -347,148 +383,74 @@ namespace neogfx
         }
         void clear_selection() override
         {
-            for (item_presentation_model_index::row_type row = 0; row < presentation_model().rows(); ++row)
-                for (item_presentation_model_index::column_type column = 0; column < presentation_model().columns(); ++column)
-                    presentation_model().cell_meta(item_presentation_model_index{ row, column }).selection &= ~item_cell_selection_flags::Selected;
             iPreviousSelection = iSelection;
             iSelection.clear();
             SelectionChanged(iSelection, iPreviousSelection);
             iPreviousSelection.clear();
         }
-        void select(item_presentation_model_index const& aIndex, item_selection_operation aOperation) override
+        void select_all() override
         {
-            if (aOperation == item_selection_operation::None)
+            if (mode() != item_selection_mode::MultipleSelection && mode() != item_selection_mode::ExtendedSelection)
                 return;
+            if (presentation_model().rows() != 0u && presentation_model().columns() != 0u)
+                select(item_presentation_model_index{ 0u, 0u },
+                    item_presentation_model_index{ presentation_model().rows() - 1u, presentation_model().columns() - 1u }, item_selection_operation::ClearAndSelect);
+        }
+        void select(item_presentation_model_index const& aIndex, item_selection_operation aOperation) override
+        {
             if ((aOperation & (item_selection_operation::Toggle | item_selection_operation::Select)) != item_selection_operation::None &&
                 !is_selectable(aIndex))
                 return;
+            select(aIndex, aIndex, aOperation);
+        }
+        void select(item_presentation_model_index const& aFirst, item_presentation_model_index const& aLast, item_selection_operation aOperation) override
+        {
+            if (aOperation == item_selection_operation::None)
+                return;
             if (iNotifying && (aOperation & item_selection_operation::Queued) != item_selection_operation::Queued)
                 aOperation |= item_selection_operation::Queued;
             if ((aOperation & item_selection_operation::Queued) == item_selection_operation::Queued)
             {
-                iOperationQueue.push_back(std::make_pair(aIndex, aOperation));
+                iOperationQueue.emplace_back(aFirst, aLast, aOperation);
                 return;
             }
             if ((aOperation & item_selection_operation::CurrentIndex) == item_selection_operation::CurrentIndex)
             {
                 if ((aOperation & item_selection_operation::Select) == item_selection_operation::Select)
-                    set_current_index(aIndex);
+                    set_current_index(aLast);
                 else
                     clear_current_index();
             }
             if (mode() == item_selection_mode::NoSelection)
                 aOperation = item_selection_operation::Clear;
             // todo: cell and column
-            static auto find = [](item_presentation_model_index const& aIndex, concrete_item_selection& aSelection)
+            // The selection is a set of disjoint row ranges so selecting, deselecting and testing rows is O(log n)
+            // whatever the number of rows.
+            auto const rows = presentation_model().rows();
+            auto const firstRow = std::min(aFirst.row(), aLast.row());
+            auto const lastRow = std::min(std::max(aFirst.row(), aLast.row()), rows != 0u ? rows - 1u : 0u);
+            bool const clear = (aOperation & item_selection_operation::Clear) == item_selection_operation::Clear;
+            bool const rowsCurrentlySelected = find_rows(iSelection, firstRow) != iSelection.end();
+            bool const select = firstRow < rows && ((aOperation & item_selection_operation::Select) == item_selection_operation::Select ||
+                ((aOperation & item_selection_operation::Toggle) == item_selection_operation::Toggle && !rowsCurrentlySelected));
+            bool const deselect = (aOperation & item_selection_operation::Deselect) == item_selection_operation::Deselect ||
+                ((aOperation & item_selection_operation::Toggle) == item_selection_operation::Toggle && rowsCurrentlySelected);
+            auto update = [&](concrete_item_selection& aSelection)
             {
-                if (aSelection.empty())
-                    return aSelection.end();
-                auto iterExisting = aSelection.lower_bound(aIndex.with_column(0u));
-                if (iterExisting == aSelection.end())
-                    iterExisting = std::prev(iterExisting);
-                if (iterExisting != aSelection.begin())
-                {
-                    auto previous = std::prev(iterExisting);
-                    if (previous->second().topLeft.row() <= aIndex.row() &&
-                        previous->second().bottomRight.row() >= aIndex.row())
-                        return previous;
-                }
-                if (iterExisting->second().topLeft.row() <= aIndex.row() &&
-                    iterExisting->second().bottomRight.row() >= aIndex.row())
-                    return iterExisting;
-                return aSelection.end();
-            };
-            static auto find_adjacent = [](item_presentation_model_index const& aIndex, concrete_item_selection& aSelection)
-            {
-                if (aSelection.empty())
-                    return aSelection.end();
-                auto iterExisting = find(aIndex.with_row(aIndex.row() - 1u), aSelection);
-                if (iterExisting != aSelection.end())
-                    return iterExisting;
-                return find(aIndex.with_row(aIndex.row() + 1u), aSelection);
-            };
-            auto update = [&, this](concrete_item_selection& aSelection, bool aUpdateCells)
-            {
-                bool const clear = (aOperation & item_selection_operation::Clear) == item_selection_operation::Clear;
-                bool const rowCurrentlySelected = aIndex.row() < presentation_model().rows() && (presentation_model().cell_meta(aIndex.with_column(0u)).selection & item_cell_selection_flags::Selected) ==
-                    item_cell_selection_flags::Selected;
-                bool const select = (aOperation & item_selection_operation::Select) == item_selection_operation::Select ||
-                    ((aOperation & item_selection_operation::Toggle) == item_selection_operation::Toggle && !rowCurrentlySelected);
-                bool const deselect = (aOperation & item_selection_operation::Deselect) == item_selection_operation::Deselect ||
-                    ((aOperation & item_selection_operation::Toggle) == item_selection_operation::Toggle && rowCurrentlySelected);
                 if (clear)
-                {
-                    if (aUpdateCells)
-                    {
-                        struct selection_clearer : i_item_presentation_model::i_meta_visitor
-                        {
-                            void visit(i_item_presentation_model::cell_meta_type& aMeta) override
-                            {
-                                aMeta.selection &= ~item_cell_selection_flags::Selected;
-                            }
-                        } selectionClearer;
-                        presentation_model().accept(selectionClearer, true);
-                    }
                     aSelection.clear();
-                }
                 if (select)
-                {
-                    if (find(aIndex, aSelection) == aSelection.end())
-                    {
-                        auto iterAdjacent = find_adjacent(aIndex, aSelection);
-                        if (iterAdjacent == aSelection.end())
-                            aSelection.emplace(aIndex.with_column(0u), selection_area{ aIndex.with_column(0u), aIndex.with_column(presentation_model().columns() - 1u) });
-                        else
-                        {
-                            auto& adjacent = *iterAdjacent;
-                            if (adjacent.second().bottomRight.row() == aIndex.row() - 1u)
-                                adjacent.second().bottomRight = aIndex.with_column(presentation_model().columns() - 1u);
-                            else
-                            {
-                                aSelection.emplace(aIndex.with_column(0u), selection_area{ aIndex.with_column(0u), adjacent.second().bottomRight });
-                                aSelection.erase(iterAdjacent);
-                            }
-                        }
-                    }
-                    if (aUpdateCells)
-                        for (auto& cellIndex : *this)
-                            if (cellIndex.row() == aIndex.row() && is_selectable(cellIndex))
-                                presentation_model().cell_meta(cellIndex).selection |= item_cell_selection_flags::Selected;
-                }
+                    select_rows(aSelection, firstRow, lastRow);
                 else if (deselect)
-                {
-                    if (aUpdateCells)
-                        for (auto& cellIndex : *this)
-                            if (cellIndex.row() == aIndex.row())
-                                presentation_model().cell_meta(cellIndex).selection &= ~item_cell_selection_flags::Selected;
-                    auto iterExisting = find(aIndex, aSelection);
-                    if (iterExisting != aSelection.end())
-                    {
-                        auto& existing = *iterExisting;
-                        if (existing.second().topLeft.row() == existing.second().bottomRight.row())
-                            aSelection.erase(iterExisting);
-                        else if (existing.second().topLeft.row() == aIndex.row())
-                        {
-                            aSelection.emplace(aIndex.with_row(aIndex.row() + 1u).with_column(0u), selection_area{ aIndex.with_row(aIndex.row() + 1u).with_column(0u), existing.second().bottomRight });
-                            aSelection.erase(iterExisting);
-                        }
-                        else if (existing.second().bottomRight.row() == aIndex.row())
-                            existing.second().bottomRight.set_row(aIndex.row() - 1u);
-                        else
-                        {
-                            aSelection.emplace(aIndex.with_row(aIndex.row() + 1u).with_column(0u), selection_area{ aIndex.with_row(aIndex.row() + 1u).with_column(0u), existing.second().bottomRight });
-                            existing.second().bottomRight.set_row(aIndex.row() - 1u);
-                        }
-                    }
-                }
+                    deselect_rows(aSelection, firstRow, lastRow);
             };
-            update(iSelection, true);
+            update(iSelection);
             if ((aOperation & item_selection_operation::Internal) != item_selection_operation::Internal)
             {
                 neolib::scoped_flag sf{ iNotifying };
                 SelectionChanged(iSelection, iPreviousSelection);
             }
-            update(iPreviousSelection, false);
+            update(iPreviousSelection);
             if ((aOperation & item_selection_operation::Internal) != item_selection_operation::Internal)
                 process_queue();
         }
@@ -529,14 +491,162 @@ namespace neogfx
                 CurrentIndexChanged(iCurrentIndex, previousIndex);
             }
         }
-        void reindex()
+        selection_area row_area(row_type aFirstRow, row_type aLastRow) const
+        {
+            return selection_area{ item_presentation_model_index{ aFirstRow, 0u }, item_presentation_model_index{ aLastRow, presentation_model().columns() - 1u } };
+        }
+        static typename concrete_item_selection::const_iterator find_rows(concrete_item_selection const& aSelection, row_type aRow)
+        {
+            auto existing = aSelection.lower_bound(item_presentation_model_index{ aRow, 0u });
+            if (existing != aSelection.end() && existing->first().row() == aRow)
+                return existing;
+            if (existing == aSelection.begin())
+                return aSelection.end();
+            --existing;
+            if (existing->second().bottomRight.row() >= aRow)
+                return existing;
+            return aSelection.end();
+        }
+        void select_rows(concrete_item_selection& aSelection, row_type aFirstRow, row_type aLastRow) const
+        {
+            // Merge with the ranges overlapping or adjoining.
+            auto next = aSelection.lower_bound(item_presentation_model_index{ aFirstRow, 0u });
+            if (next != aSelection.begin() && std::prev(next)->second().bottomRight.row() + 1u >= aFirstRow)
+                --next;
+            while (next != aSelection.end() && next->first().row() <= aLastRow + 1u)
+            {
+                aFirstRow = std::min(aFirstRow, next->second().topLeft.row());
+                aLastRow = std::max(aLastRow, next->second().bottomRight.row());
+                auto const merged = next++;
+                aSelection.erase(merged);
+            }
+            aSelection.emplace(item_presentation_model_index{ aFirstRow, 0u }, row_area(aFirstRow, aLastRow));
+        }
+        void deselect_rows(concrete_item_selection& aSelection, row_type aFirstRow, row_type aLastRow) const
+        {
+            // Remove the ranges overlapping keeping any parts outside.
+            auto next = aSelection.lower_bound(item_presentation_model_index{ aFirstRow, 0u });
+            if (next != aSelection.begin() && std::prev(next)->second().bottomRight.row() >= aFirstRow)
+                --next;
+            while (next != aSelection.end() && next->first().row() <= aLastRow)
+            {
+                auto const top = next->second().topLeft.row();
+                auto const bottom = next->second().bottomRight.row();
+                auto const removed = next++;
+                aSelection.erase(removed);
+                if (top < aFirstRow)
+                    aSelection.emplace(item_presentation_model_index{ top, 0u }, row_area(top, aFirstRow - 1u));
+                if (bottom > aLastRow)
+                    aSelection.emplace(item_presentation_model_index{ aLastRow + 1u, 0u }, row_area(aLastRow + 1u, bottom));
+            }
+        }
+        void insert_rows(row_type aRow, row_type aCount)
+        {
+            // Only the ranges from the row inserted on move (a range it falls within is split).
+            for (auto* selection : { &iSelection, &iPreviousSelection })
+            {
+                row_ranges moved;
+                auto next = selection->lower_bound(item_presentation_model_index{ aRow, 0u });
+                if (next != selection->begin() && std::prev(next)->second().bottomRight.row() >= aRow)
+                    --next;
+                while (next != selection->end())
+                {
+                    auto const top = next->second().topLeft.row();
+                    auto const bottom = next->second().bottomRight.row();
+                    auto const removed = next++;
+                    selection->erase(removed);
+                    if (top < aRow)
+                    {
+                        moved.emplace_back(top, aRow - 1u);
+                        moved.emplace_back(aRow + aCount, bottom + aCount);
+                    }
+                    else
+                        moved.emplace_back(top + aCount, bottom + aCount);
+                }
+                for (auto const& range : moved)
+                    selection->emplace(item_presentation_model_index{ range.first, 0u }, row_area(range.first, range.second));
+            }
+        }
+        void remove_rows(row_type aRow, row_type aCount)
+        {
+            // Only the ranges from the rows removed on move (merging any the removal leaves adjoining).
+            for (auto* selection : { &iSelection, &iPreviousSelection })
+            {
+                row_ranges moved;
+                auto next = selection->lower_bound(item_presentation_model_index{ aRow, 0u });
+                if (next != selection->begin() && std::prev(next)->second().bottomRight.row() >= aRow)
+                    --next;
+                while (next != selection->end())
+                {
+                    auto const top = next->second().topLeft.row();
+                    auto const bottom = next->second().bottomRight.row();
+                    auto const removed = next++;
+                    selection->erase(removed);
+                    if (top < aRow)
+                        moved.emplace_back(top, std::min(bottom, aRow - 1u));
+                    if (bottom >= aRow + aCount)
+                        moved.emplace_back(std::max(top, aRow + aCount) - aCount, bottom - aCount);
+                }
+                for (auto const& range : moved)
+                    select_rows(*selection, range.first, range.second);
+            }
+        }
+        void save_selection(bool aSorting)
+        {
+            // Saved as runs of item model rows, merged as they are found. A sort keeps the same rows so if all of
+            // them are selected nothing need be saved.
+            iSavedSelection.clear();
+            auto const rows = presentation_model().rows();
+            iSavedAllRows = aSorting && rows != 0u && iSelection.size() == 1u &&
+                iSelection.begin()->second().topLeft.row() == 0u && iSelection.begin()->second().bottomRight.row() >= rows - 1u;
+            if (iSavedAllRows)
+                return;
+            for (auto const& part : iSelection)
+                for (auto row = part.second().topLeft.row(); row <= part.second().bottomRight.row() && row < rows; ++row)
+                    save_row(presentation_model().to_item_model_index(item_presentation_model_index{ row }).row());
+        }
+        void save_row(item_model_index::row_type aModelRow)
+        {
+            auto next = iSavedSelection.upper_bound(aModelRow);
+            if (next != iSavedSelection.begin() && std::prev(next)->second + 1u >= aModelRow)
+            {
+                auto const previous = std::prev(next);
+                previous->second = std::max(previous->second, aModelRow);
+                if (next != iSavedSelection.end() && next->first == previous->second + 1u)
+                {
+                    previous->second = next->second;
+                    iSavedSelection.erase(next);
+                }
+            }
+            else if (next != iSavedSelection.end() && next->first == aModelRow + 1u)
+            {
+                auto const last = next->second;
+                iSavedSelection.erase(next);
+                iSavedSelection.emplace(aModelRow, last);
+            }
+            else
+                iSavedSelection.emplace(aModelRow, aModelRow);
+        }
+        void restore_selection()
         {
-            iPreviousSelection.clear();
             iSelection.clear();
-            for (item_presentation_model_index::row_type row = 0; row < presentation_model().rows(); ++row)
-                for (item_presentation_model_index::column_type column = 0; column < presentation_model().columns(); ++column)
-                    if ((presentation_model().cell_meta(item_presentation_model_index{ row, column }).selection & item_cell_selection_flags::Selected) == item_cell_selection_flags::Selected)
-                        select(item_presentation_model_index{ row, column }, item_selection_operation::Select | item_selection_operation::Internal);
+            if (iSavedAllRows)
+            {
+                if (presentation_model().rows() != 0u)
+                    select_rows(iSelection, 0u, presentation_model().rows() - 1u);
+            }
+            else
+                for (auto const& run : iSavedSelection)
+                    for (auto modelRow = run.first; modelRow <= run.second; ++modelRow)
+                        if (presentation_model().has_item_model_index(item_model_index{ modelRow }))
+                        {
+                            auto const row = presentation_model().from_item_model_index(item_model_index{ modelRow }, true).row();
+                            select_rows(iSelection, row, row);
+                        }
+            iSavedSelection.clear();
+            iSavedAllRows = false;
+            iPreviousSelection = iSelection;
+            iRows = presentation_model().rows();
         }
         void process_queue()
         {
@@ -545,9 +655,9 @@ namespace neogfx
             neolib::scoped_flag sf{ iInQueue };
             while (!iOperationQueue.empty())
             {
-                auto next = iOperationQueue.front();
+                auto const [first, last, operation] = iOperationQueue.front();
                 iOperationQueue.pop_front();
-                select(next.first, next.second & ~item_selection_operation::Queued);
+                select(first, last, operation & ~item_selection_operation::Queued);
             }
         }
     private:
@@ -557,6 +667,10 @@ namespace neogfx
         optional_item_model_index iSavedModelIndex;
         concrete_item_selection iPreviousSelection;
         concrete_item_selection iSelection;
+        row_type iRows = 0u;
+        model_row_ranges iSavedSelection;
+        bool iSavedAllRows = false;
+        bool iFilterPending = false;
         bool iSorting;
         bool iFiltering;
         bool iNotifying;
@@ -0,0 +1,77 @@
+// item_sort_keys.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+#include <locale>
+
+#include <neogfx/gui/widget/i_item_model.hpp>
+#include <neogfx/gui/widget/i_item_presentation_model.hpp>
+
+namespace neogfx
+{
+    // Sort keys of item model columns, extracted once (strings case folded) into a compact array per column and kept
+    // until the cells change, so that sorting compares keys rather than fetching (and folding) cell data through the
+    // item model for each comparison. Keys are indexed by model row and compare as the cell data with strings
+    // ordered case insensitively first.
+    class item_sort_keys
+    {
+    public:
+        typedef item_model_index::row_type row_type;
+        typedef item_model_index::column_type column_type;
+        typedef i_item_presentation_model::sort_direction sort_direction;
+        typedef std::pair<column_type, sort_direction> sort_column;
+        typedef std::vector<sort_column> sort_columns;
+    private:
+        struct key
+        {
+            std::uint32_t alternative;
+            std::uint32_t length;
+            std::size_t offset;
+        };
+        struct column_keys
+        {
+            bool extracted = false;
+            std::vector<key> keys;
+            // Each string cell as folded then as is.
+            std::string text;
+            std::vector<item_cell_data> values;
+            std::size_t staleBytes = 0u;
+        };
+        static constexpr std::uint32_t UNEXTRACTED = ~0u;
+        static constexpr std::uint32_t NOT_TEXT = ~0u;
+    public:
+        void clear();
+        void row_inserted(row_type aRow);
+        void row_removed(row_type aRow);
+        void cell_changed(item_model_index const& aIndex);
+    public:
+        // Extracts the keys of the sort columns not already held.
+        void prepare(i_item_model const& aModel, sort_columns const& aSortColumns);
+        // Compares prepared keys; thread safe so can be used by a parallel sort.
+        bool less(row_type aLhs, row_type aRhs, sort_columns const& aSortColumns) const;
+    private:
+        void extract(i_item_model const& aModel, column_type aColumn, row_type aRow, std::ctype<char> const& aCtype, column_keys& aKeys);
+        int compare(column_keys const& aKeys, row_type aLhs, row_type aRhs) const;
+    private:
+        std::vector<column_keys> iColumns;
+    };
+}
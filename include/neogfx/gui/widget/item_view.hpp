@@ -187,6 +187,8 @@ namespace neogfx
         item_selection_operation to_selection_operation(key_modifier aKeyModifier) const;
         void select(item_presentation_model_index const& aItemIndex, key_modifier aKeyModifier);
         void select(item_presentation_model_index const& aItemIndex, item_selection_operation aSelectionOperation = item_selection_operation::ClearAndSelect);
+        void save_selection_anchor();
+        void restore_selection_anchor();
     private:
         sink iSink;
         sink iModelSink;
@@ -210,6 +212,8 @@ namespace neogfx
         optional_item_presentation_model_index iClickedItem;
         optional_item_presentation_model_index iClickedCheckBox;
         optional_item_model_index iSavedModelIndex;
+        optional_item_presentation_model_index iSelectionAnchor;
+        optional_item_model_index iSavedSelectionAnchor;
         basic_size<i_scrollbar::value_type> iOldPositionForScrollbarVisibility;
         std::optional<drag_drop_item> iDragDropItem;
     };
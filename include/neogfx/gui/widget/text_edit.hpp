@@ -26,6 +26,8 @@
 #include <neolib/core/gap_vector.hpp>
 #include <neolib/core/jar.hpp>
 
+#include <neogfx/core/fenwick_tree.hpp>
+#include <neogfx/core/mapped_text.hpp>
 #include <neogfx/app/i_clipboard.hpp>
 #include <neogfx/gfx/text/glyph_text.hpp>
 #include <neogfx/gui/window/context_menu.hpp>
@@ -495,31 +497,60 @@ namespace neogfx
             }
         };
 
+        // Paragraph extents; a paragraph's offsets and y position are the running totals of the extents of the
+        // paragraphs before it (see iParagraphIndex).
+        struct paragraph_extents
+        {
+            document_text::difference_type text;
+            document_glyphs::difference_type glyphs;
+            dimension height;
+
+            paragraph_extents operator+(paragraph_extents const& rhs) const
+            {
+                return { text + rhs.text, glyphs + rhs.glyphs, height + rhs.height };
+            }
+            paragraph_extents operator-(paragraph_extents const& rhs) const
+            {
+                return { text - rhs.text, glyphs - rhs.glyphs, height - rhs.height };
+            }
+        };
+        using paragraph_index = fenwick_tree<paragraph_extents>;
+
         struct glyph_paragraph
         {
             using column_breaks = neolib::vecarray<document_glyphs::difference_type, 4, -1>;
             using line_breaks = neolib::vecarray<document_glyphs::difference_type, 8, -1>;
             struct height_map_entry
             {
-                document_glyphs::difference_type glyphIndex;
+                document_glyphs::difference_type glyphIndex; // relative to the paragraph's first glyph
                 dimension height;
             };
             using height_map = neolib::vecarray<height_map_entry, 8, -1>;
 
             text_edit* owner;
-            document_span span;
-            coordinate ypos;
+            std::size_t index;
             mutable height_map heightMap;
             column_breaks columnBreaks;
             line_breaks lineBreaks;
+            bool laidOut = false; // lines are laid out lazily; until then the paragraph's height is an estimate
 
+            document_span span() const
+            {
+                auto const offset = owner->iParagraphIndex.prefix_sum(index);
+                auto const& extents = owner->iParagraphIndex[index];
+                return { offset.text, offset.text + extents.text, offset.glyphs, offset.glyphs + extents.glyphs };
+            }
+            coordinate ypos() const
+            {
+                return owner->iParagraphYOffset + owner->iParagraphIndex.prefix_sum(index).height;
+            }
             document_text::difference_type text_begin_index() const
             {
-                return span.textFirst;
+                return owner->iParagraphIndex.prefix_sum(index).text;
             }
             document_text::difference_type text_end_index() const
             {
-                return span.textLast;
+                return text_begin_index() + owner->iParagraphIndex[index].text;
             }
             document_text::const_iterator text_begin() const
             {
@@ -531,11 +562,11 @@ namespace neogfx
             }
             document_glyphs::difference_type glyph_begin_index() const
             {
-                return span.glyphsFirst;
+                return owner->iParagraphIndex.prefix_sum(index).glyphs;
             }
             document_glyphs::difference_type glyph_end_index() const
             {
-                return span.glyphsLast;
+                return glyph_begin_index() + owner->iParagraphIndex[index].glyphs;
             }
             document_glyphs::const_iterator glyph_begin() const
             {
@@ -622,7 +653,7 @@ namespace neogfx
             }
             paragraph_line_span paragraph_span() const
             {
-                paragraph_line_span result = { paragraphIndex, paragraph().span, span };
+                paragraph_line_span result = { paragraphIndex, paragraph().span(), span };
                 if (glyph_end() != owner->glyphs().end() && is_line_breaking_whitespace(*glyph_end()))
                     ++result.lineSpan.glyphsLast;
                 return result;
@@ -633,7 +664,7 @@ namespace neogfx
             }
             coordinate ypos() const
             {
-                return offset.y + paragraph().ypos;
+                return offset.y + paragraph().ypos();
             }
         };
         using glyph_lines = neolib::vecarray<glyph_line, 8, -1>;
@@ -673,6 +704,7 @@ namespace neogfx
     public:
         struct not_implemented : std::logic_error { not_implemented() : std::logic_error("neogfx::text_edit::not_implemented") {} };
         struct bad_column_index : std::logic_error { bad_column_index() : std::logic_error("neogfx::text_edit::bad_column_index") {} };
+        struct not_mapped : std::logic_error { not_mapped() : std::logic_error("neogfx::text_edit::not_mapped") {} };
 
         // text_edit
     public:
@@ -741,6 +773,8 @@ namespace neogfx
         using framed_scrollable_widget::update_scrollbar_visibility;
         bool update_scrollbar_visibility(usv_stage_e aStage) override;
         void scroll_page_updated() override;
+    protected:
+        void scrollbar_updated(i_scrollbar const& aScrollbar, i_scrollbar::update_reason_e aReason) override;
     public:
         color frame_color() const override;
         // i_clipboard
@@ -783,6 +817,8 @@ namespace neogfx
         void set_read_only(bool aReadOnly = true);
         bool word_wrap() const;
         void set_word_wrap(bool aWordWrap = true);
+        bool parallel_shaping() const;
+        void set_parallel_shaping(bool aParallelShaping = true);
         std::uint32_t grow_lines() const;
         void set_grow_lines(std::uint32_t aGrowLines = 5u);
         bool password() const;
@@ -845,6 +881,14 @@ namespace neogfx
         void set_column(std::size_t aColumnIndex, const column_info& aColumn);
         const style& column_style(std::size_t aColumnIndex) const;
         const style& column_style(const column_info& aColumn) const;
+    public:
+        // Read-only large document mode: the file is memory mapped and only the lines in (and around) the viewport
+        // are decoded, shaped and laid out. Whilst mapped, text() and text positions refer to that window of lines.
+        void open_mapped(std::string const& aPath);
+        void close_mapped();
+        bool is_mapped() const;
+        neogfx::mapped_text const& mapped_document() const;
+        bool find_mapped(std::string const& aText);
     public:
         bool has_page_rect() const;
         rect page_rect() const;
@@ -889,13 +933,28 @@ namespace neogfx
         std::optional<glyph_lines::const_iterator> previous_line(std::optional<glyph_lines::const_iterator> const& aFrom) const;
         void refresh_paragraph(document_text::const_iterator aWhere, ptrdiff_t aDelta);
         void refresh_columns();
+        void refresh_edited_lines();
         void refresh_lines();
+        void invalidate_lines();
+        void estimate_paragraph_heights(std::size_t aFirst, std::size_t aLast, dimension aAvailableWidth);
+        void layout_lines(dimension aAvailableWidth, dimension aAvailableHeight);
+        void layout_visible_paragraphs(dimension aAvailableWidth, dimension aAvailableHeight);
+        void layout_deferred_lines();
+        void layout_paragraph(glyph_paragraph& aParagraph, dimension aAvailableWidth);
+        void line_added(dimension aWidth);
+        void lines_removed(glyph_lines::const_iterator aFirst, glyph_lines::const_iterator aLast);
+        dimension lines_max_width();
+        void update_mapped_window(bool aForce = false);
+        void load_mapped_window(std::uint64_t aFirstLine, std::uint64_t aLastLine);
+        std::pair<std::uint64_t, std::uint64_t> to_mapped(position_type aPosition) const;
+        position_type from_mapped(std::pair<std::uint64_t, std::uint64_t> const& aLineColumn) const;
         void animate();
         void update_cursor();
         void make_cursor_visible(bool aForcePreviewScroll = false);
         std::pair<document_glyphs::difference_type, bool> glyph_hit_test(const point& aPosition, bool aAdjustForScrollPosition = true) const;
         void make_visible(position_info const& aGlyphPosition, point const& aPreview = {});
         style glyph_style(document_glyphs::const_iterator aGlyphChar, const document_column& aColumn) const;
+        neogfx::font paragraph_font(document_text::const_iterator aParagraph, std::vector<std::u32string::difference_type> const& aColumnDelimiters, std::u32string::size_type aSourceIndex, neogfx::font const& aDefaultFont) const;
         void draw_glyphs(i_graphics_context& aGc, const point& aPosition, const glyph_column& aColumn, glyph_lines::const_iterator aLine) const;
         void draw_cursor(i_graphics_context& aGc) const;
         rect cursor_rect() const;
@@ -925,8 +984,22 @@ namespace neogfx
         mutable std::optional<string> iUtf8TextCache;
         mutable std::optional<document_glyphs> iGlyphs;
         glyph_paragraphs iGlyphParagraphs;
+        paragraph_index iParagraphIndex;
+        coordinate iParagraphYOffset = 0.0;
         glyph_columns iGlyphColumns;
         optional_size iTextExtents;
+        std::optional<dimension> iLineLayoutWidth;
+        // The widest line and how many lines are that wide; rescanned only when the last of them is removed.
+        std::optional<dimension> iLinesMaxWidth = 0.0;
+        std::size_t iLinesAtMaxWidth = 0u;
+        std::size_t iParagraphsAwaitingLayout = 0u;
+        std::size_t iLayoutPendingFirst = 0u;
+        std::size_t iLayoutPendingLast = 0u;
+        bool iParagraphHeightsEstimated = false;
+        std::unique_ptr<neogfx::mapped_text> iMappedText;
+        std::pair<std::uint64_t, std::uint64_t> iMappedWindow;
+        std::uint64_t iMappedLines = 0u;
+        bool iUpdatingMappedWindow = false;
         std::uint64_t iCursorAnimationStartTime;
         neogfx::size_hint iSizeHint;
         mutable std::optional<std::pair<neogfx::font, size>> iHintedSize;
@@ -947,6 +1020,7 @@ namespace neogfx
         define_property(property_category::other, bool, ReadOnly, read_only, false)
         define_property(property_category::other, bool, WordWrap, word_wrap, (iCaps & text_edit_caps::MultiLine) == text_edit_caps::MultiLine)
         define_property(property_category::other, std::uint32_t, GrowLines, grow_lines, 5u)
+        define_property(property_category::other, bool, ParallelShaping, parallel_shaping, true)
         define_property(property_category::other, bool, Password, password, false)
         define_property(property_category::other, string, PasswordMask, password_mask)
     };
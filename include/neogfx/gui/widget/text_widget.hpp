@@ -74,10 +74,15 @@ namespace neogfx
     private:
         void init();
         const glyph_text_t& glyph_text() const;
+        dimension wrap_width() const;
         void reset_cache();
     private:
         string iText;
         mutable glyph_text_t iGlyphText;
+        // Multi-line text is shaped once and only re-wrapped when its wrap width changes.
+        mutable std::optional<neogfx::glyph_text> iShapedText;
+        mutable std::optional<line_breaker> iLineBreaker;
+        mutable std::optional<dimension> iWrapWidth;
         mutable std::optional<texture> iCacheTexture;
         mutable optional_size iTextExtent;
         size_hint iSizeHint;
@@ -0,0 +1,186 @@
+// virtual_item_model.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+#include <list>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include <neogfx/core/object.hpp>
+#include <neogfx/gui/widget/item_model.hpp>
+
+namespace neogfx
+{
+    // Supplies the rows of a virtual item model a page at a time, e.g. from a database cursor or a memory mapped file.
+    // Pages are fetched on the prefetch thread as well as on the threads reading cells so fetching must be thread safe.
+    class i_item_page_provider
+    {
+    public:
+        typedef item_model_index::row_type row_type;
+        typedef item_model_index::column_type column_type;
+    public:
+        virtual ~i_item_page_provider() = default;
+    public:
+        virtual row_type rows() const = 0;
+        virtual column_type columns() const = 0;
+        virtual std::string column_name(column_type aColumnIndex) const = 0;
+        // Appends the cells (a row at a time, columns() cells per row) of rows [aFirstRow, aFirstRow + aRowCount).
+        virtual void fetch(row_type aFirstRow, row_type aRowCount, std::vector<item_cell_data>& aCells) const = 0;
+    };
+
+    // A read only flat item model whose cells are held by a provider and fetched on demand in pages kept in an LRU cache,
+    // so that a dataset of millions of rows can be shown without first being loaded. Reading a cell queues the pages
+    // either side of its page for prefetching on a background thread so that scrolling seldom waits for a fetch.
+    // A cell reference remains valid until the reading thread has read cells of two other pages. The provider's data
+    // changing is signalled with invalidate() (cells) or reset() (rows).
+    class virtual_item_model : public object<reference_counted<i_item_model>>
+    {
+        typedef object<reference_counted<i_item_model>> base_type;
+    public:
+        define_declared_event(ColumnInfoChanged, column_info_changed, item_model_index::column_type)
+        define_declared_event(ItemAdded, item_added, const item_model_index&)
+        define_declared_event(ItemChanged, item_changed, const item_model_index&)
+        define_declared_event(ItemRemoving, item_removing, const item_model_index&)
+        define_declared_event(ItemRemoved, item_removed, const item_model_index&)
+        define_declared_event(Cleared, cleared)
+    public:
+        typedef item_model_index::row_type row_type;
+        // For basic_item_presentation_model<virtual_item_model>.
+        typedef item_flat_container_traits<item_model_index::row_type, item_cell_data, 0> container_traits;
+    public:
+        struct read_only : std::logic_error { read_only() : std::logic_error("neogfx::virtual_item_model::read_only") {} };
+    public:
+        static constexpr row_type DEFAULT_PAGE_ROWS = 256u;
+        static constexpr std::size_t DEFAULT_CACHED_PAGES = 64u;
+    private:
+        typedef row_type page_index;
+        struct page
+        {
+            std::vector<item_cell_data> cells;
+        };
+        typedef std::shared_ptr<page const> page_ptr;
+        typedef std::list<std::pair<page_index, page_ptr>> page_list;
+        struct column_info
+        {
+            string name;
+            item_cell_info defaultDataInfo = {};
+        };
+    public:
+        virtual_item_model(i_item_page_provider const& aProvider, row_type aPageRows = DEFAULT_PAGE_ROWS, std::size_t aCachedPages = DEFAULT_CACHED_PAGES);
+        ~virtual_item_model();
+    public:
+        i_item_page_provider const& provider() const;
+        // Discards the cached cells of rows [aFirstRow, aFirstRow + aRowCount) and notifies that they have changed.
+        void invalidate(row_type aFirstRow, row_type aRowCount);
+        // Discards all cached cells and rereads the number of rows and columns from the provider.
+        void reset();
+        // Queues the pages of rows [aFirstRow, aFirstRow + aRowCount) for fetching in the background.
+        void prefetch(row_type aFirstRow, row_type aRowCount) const;
+    public:
+        bool is_tree() const final;
+        bool is_virtual() const final;
+        bool thread_safe_cell_data() const final;
+        std::uint32_t rows() const final;
+        std::uint32_t columns() const final;
+        std::uint32_t columns(item_model_index const& aIndex) const final;
+        i_string const& column_name(item_model_index::column_type aColumnIndex) const final;
+        using i_item_model::set_column_name;
+        void set_column_name(item_model_index::column_type aColumnIndex, i_string const& aName) final;
+        item_data_type column_data_type(item_model_index::column_type aColumnIndex) const final;
+        void set_column_data_type(item_model_index::column_type aColumnIndex, item_data_type aType) final;
+        item_cell_data const& column_min_value(item_model_index::column_type aColumnIndex) const final;
+        void set_column_min_value(item_model_index::column_type aColumnIndex, item_cell_data const& aValue) final;
+        item_cell_data const& column_max_value(item_model_index::column_type aColumnIndex) const final;
+        void set_column_max_value(item_model_index::column_type aColumnIndex, item_cell_data const& aValue) final;
+        item_cell_data const& column_step_value(item_model_index::column_type aColumnIndex) const final;
+        void set_column_step_value(item_model_index::column_type aColumnIndex, item_cell_data const& aValue) final;
+    public:
+        iterator index_to_iterator(item_model_index const& aIndex) final;
+        const_iterator index_to_iterator(item_model_index const& aIndex) const final;
+        item_model_index iterator_to_index(const_iterator aPosition) const final;
+        iterator begin() final;
+        const_iterator begin() const final;
+        iterator end() final;
+        const_iterator end() const final;
+        iterator sbegin() final;
+        const_iterator sbegin() const final;
+        iterator send() final;
+        const_iterator send() const final;
+        bool has_children(const_iterator aParent) const final;
+        bool has_children(item_model_index const& aParentIndex) const final;
+        bool has_parent(const_iterator aChild) const final;
+        bool has_parent(item_model_index const& aChildIndex) const final;
+        iterator parent(const_iterator aChild) final;
+        const_iterator parent(const_iterator aChild) const final;
+        item_model_index parent(item_model_index const& aChildIndex) const final;
+        iterator sbegin(const_iterator aParent) final;
+        const_iterator sbegin(const_iterator aParent) const final;
+        iterator send(const_iterator aParent) final;
+        const_iterator send(const_iterator aParent) const final;
+    public:
+        bool empty() const final;
+        void reserve(std::uint32_t aItemCount) final;
+        std::uint32_t capacity() const final;
+        iterator insert_item(const_iterator aPosition, item_cell_data const& aCellData) final;
+        iterator insert_item(item_model_index const& aIndex, item_cell_data const& aCellData) final;
+        iterator append_item(const_iterator aParent, item_cell_data const& aCellData) final;
+        iterator append_item(item_model_index const& aIndex, item_cell_data const& aCellData) final;
+        void clear() final;
+        iterator erase(const_iterator aPosition) final;
+        iterator erase(item_model_index const& aIndex) final;
+        void insert_cell_data(const_iterator aPosition, item_model_index::column_type aColumnIndex, item_cell_data const& aCellData) final;
+        void insert_cell_data(item_model_index const& aIndex, item_cell_data const& aCellData) final;
+        void update_cell_data(const_iterator aPosition, item_model_index::column_type aColumnIndex, item_cell_data const& aCellData) final;
+        void update_cell_data(item_model_index const& aIndex, item_cell_data const& aCellData) final;
+    public:
+        item_cell_info const& cell_info(item_model_index const& aIndex) const final;
+        item_cell_data const& cell_data(item_model_index const& aIndex) const final;
+    private:
+        column_info const& column(item_model_index::column_type aColumnIndex) const;
+        column_info& column(item_model_index::column_type aColumnIndex);
+        page_ptr cached_page(page_index aPage) const;
+        page_ptr fetch_page(page_index aPage) const;
+        void queue_prefetch(page_index aFirstPage, page_index aLastPage) const;
+        void work(std::stop_token aStopToken) const;
+    private:
+        i_item_page_provider const& iProvider;
+        row_type const iPageRows;
+        std::size_t const iCachedPages;
+        row_type iRows;
+        std::vector<column_info> iColumns;
+        mutable std::mutex iMutex;
+        mutable page_list iPages;
+        mutable std::unordered_map<page_index, page_list::iterator> iPageIndex;
+        mutable std::deque<page_index> iPrefetchQueue;
+        mutable std::unordered_set<page_index> iPrefetchQueuePages;
+        mutable std::condition_variable_any iPrefetchQueued;
+        // Changed by invalidate() and reset() (to a value no model has had) so that pages fetched before are neither
+        // cached nor read again from a thread's last read page.
+        std::atomic<std::uint64_t> iGeneration;
+        mutable std::jthread iPrefetcher;
+    };
+}
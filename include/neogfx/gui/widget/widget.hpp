@@ -29,6 +29,7 @@
 #include <neogfx/gfx/text/i_font_manager.hpp>
 #include <neogfx/gui/layout/layout_item.hpp>
 #include <neogfx/gui/widget/i_widget.hpp>
+#include <neogfx/gui/widget/widget_spatial_index.hpp>
 
 namespace neogfx
 {
@@ -131,6 +132,9 @@ namespace neogfx
         widget_list::iterator last() final;
         widget_list::const_iterator find(const i_widget& aChild, bool aThrowIfNotFound = true) const final;
         widget_list::iterator find(const i_widget& aChild, bool aThrowIfNotFound = true) final;
+        bool has_child_spatial_index() const final;
+        void enable_child_spatial_index(bool aEnable) final;
+        void child_geometry_changed(const i_widget& aChild) final;
     public:
         void bring_child_to_front(const i_widget& aChild) override;
         void send_child_to_back(const i_widget& aChild) override;
@@ -348,6 +352,10 @@ namespace neogfx
         using base_type::has_alternate_base_color;
         using base_type::alternate_base_color;
         using base_type::set_alternate_base_color;
+    private:
+        template <typename Visitor>
+        void visit_children_in(rect const& aArea, Visitor aVisitor) const;
+        void update_child_spatial_index() const;
 
         // state
     private:
@@ -392,6 +400,8 @@ namespace neogfx
         mutable std::optional<device_metrics_proxy> iDeviceMetrics;
         widget_list iChildren;
         widget_map iChildMap;
+        mutable std::optional<widget_spatial_index> iChildSpatialIndex;
+        mutable std::vector<i_widget const*> iChildSpatialIndexPending;
         bool iAddingChild;
         i_widget* iLinkBefore;
         i_widget* iLinkAfter;
@@ -23,6 +23,7 @@
 #include <neolib/core/scoped.hpp>
 #include <neolib/app/i_shared_thread_local.hpp>
 #include <neogfx/app/i_app.hpp>
+#include <neogfx/app/profiler.hpp>
 #include <neogfx/gfx/graphics_context.hpp>
 #include <neogfx/gui/widget/widget.hpp>
 #include <neogfx/gui/layout/i_async_layout.hpp>
@@ -375,6 +376,8 @@ namespace neogfx
             oldParent->remove(*child, true);
         iChildren.push_back(child);
         iChildMap[&*child] = iChildren.size() - 1u;
+        if (iChildSpatialIndex)
+            iChildSpatialIndexPending.push_back(&*child);
         child->set_parent(*this);
         child->set_singular(false);
         if (widget::has_root())
@@ -391,6 +394,11 @@ namespace neogfx
             return;
         auto const pos = posIter->second;
         iChildMap.erase(posIter);
+        if (iChildSpatialIndex)
+        {
+            iChildSpatialIndex->remove(aChild);
+            std::erase(iChildSpatialIndexPending, &aChild);
+        }
         auto const existing = std::next(iChildren.begin(), pos);
         if (existing == iChildren.end())
             return;
@@ -491,6 +499,72 @@ namespace neogfx
         return std::next(iChildren.begin(), pos->second);
     }
 
+    template <WidgetInterface Interface>
+    inline bool widget<Interface>::has_child_spatial_index() const
+    {
+        return iChildSpatialIndex.has_value();
+    }
+
+    template <WidgetInterface Interface>
+    inline void widget<Interface>::enable_child_spatial_index(bool aEnable)
+    {
+        if (aEnable == has_child_spatial_index())
+            return;
+        iChildSpatialIndexPending.clear();
+        if (aEnable)
+        {
+            iChildSpatialIndex.emplace();
+            for (auto const& child : iChildren)
+                iChildSpatialIndexPending.push_back(&*child);
+        }
+        else
+            iChildSpatialIndex = std::nullopt;
+    }
+
+    template <WidgetInterface Interface>
+    inline void widget<Interface>::child_geometry_changed(const i_widget& aChild)
+    {
+        if (iChildSpatialIndex)
+            iChildSpatialIndexPending.push_back(&aChild);
+    }
+
+    template <WidgetInterface Interface>
+    inline void widget<Interface>::update_child_spatial_index() const
+    {
+        if (iChildSpatialIndexPending.empty())
+            return;
+        std::sort(iChildSpatialIndexPending.begin(), iChildSpatialIndexPending.end());
+        iChildSpatialIndexPending.erase(std::unique(iChildSpatialIndexPending.begin(), iChildSpatialIndexPending.end()), iChildSpatialIndexPending.end());
+        for (auto child : iChildSpatialIndexPending)
+            if (iChildMap.find(child) != iChildMap.end())
+                iChildSpatialIndex->insert(*child, to_client_coordinates(child->non_client_rect()), child->is_root());
+        iChildSpatialIndexPending.clear();
+    }
+
+    template <WidgetInterface Interface>
+    template <typename Visitor>
+    inline void widget<Interface>::visit_children_in(rect const& aArea, Visitor aVisitor) const
+    {
+        // Children are visited in reverse child order; without a spatial index every child is a candidate.
+        if (iChildSpatialIndex)
+        {
+            update_child_spatial_index();
+            std::vector<i_widget const*> candidates;
+            iChildSpatialIndex->query(aArea, candidates);
+            std::sort(candidates.begin(), candidates.end(), [&](i_widget const* aLhs, i_widget const* aRhs)
+                {
+                    return iChildMap.find(aLhs)->second > iChildMap.find(aRhs)->second;
+                });
+            for (auto child : candidates)
+                aVisitor(*child);
+        }
+        else
+        {
+            for (auto iterChild = iChildren.rbegin(); iterChild != iChildren.rend(); ++iterChild)
+                aVisitor(**iterChild);
+        }
+    }
+
     template <WidgetInterface Interface>
     inline void widget<Interface>::bring_child_to_front(const i_widget& aChild)
     {
@@ -782,6 +856,7 @@ namespace neogfx
             {
                 layout_items_started();
                 scoped_layout_items layoutItems;
+                scoped_profiler_zone layoutZone{ typeid(*this).name(), "layout" };
                 if (widget::is_root() && size_policy() != size_constraint::Manual)
                 {
                     size desiredSize = self.extents();
@@ -926,6 +1001,8 @@ namespace neogfx
         }
         if (widget::is_root())
             widget::root().surface().move_surface(self.position());
+        if (has_parent())
+            parent().child_geometry_changed(*this);
         PositionChanged();
     }
 
@@ -975,6 +1052,9 @@ namespace neogfx
             widget::root().surface().resize_surface(self.extents());
 
         update(true);
+
+        if (has_parent())
+            parent().child_geometry_changed(*this);
         
         SizeChanged();
         
@@ -1012,12 +1092,34 @@ namespace neogfx
         if (client_rect().contains(aPosition))
         {
             i_widget const* hitWidget = nullptr;
-            for (auto const& child : children())
-                if (child->visible() && to_client_coordinates(child->non_client_rect()).contains(aPosition))
+            if (iChildSpatialIndex)
+            {
+                update_child_spatial_index();
+                thread_local std::vector<i_widget const*> candidates;
+                candidates.clear();
+                iChildSpatialIndex->query(aPosition, candidates);
+                std::size_t hitWidgetPos = 0u;
+                for (auto child : candidates)
                 {
-                    if (hitWidget == nullptr || child->layer() > hitWidget->layer())
-                        hitWidget = &*child;
+                    if (!child->visible())
+                        continue;
+                    auto const childPos = iChildMap.find(child)->second;
+                    if (hitWidget == nullptr || child->layer() > hitWidget->layer() || (child->layer() == hitWidget->layer() && childPos < hitWidgetPos))
+                    {
+                        hitWidget = child;
+                        hitWidgetPos = childPos;
+                    }
                 }
+            }
+            else
+            {
+                for (auto const& child : children())
+                    if (child->visible() && to_client_coordinates(child->non_client_rect()).contains(aPosition))
+                    {
+                        if (hitWidget == nullptr || child->layer() > hitWidget->layer())
+                            hitWidget = &*child;
+                    }
+            }
             if (hitWidget)
             {
                 auto const hitWidgetOrigin = to_client_coordinates(hitWidget->origin());
@@ -1299,6 +1401,8 @@ namespace neogfx
         if (!requires_update())
             return;
 
+        scoped_profiler_zone renderZone{ typeid(*this).name(), "render" };
+
         scoped_render_widget srw{ aGc, self };
 
         scoped_units su{ *this, units::Pixels };
@@ -1346,16 +1450,15 @@ namespace neogfx
 
         paint_non_client(aGc);
 
-        for (auto iterChild = iChildren.rbegin(); iterChild != iChildren.rend(); ++iterChild)
-        {
-            auto const& childWidget = **iterChild;
-            if ((childWidget.widget_type() & neogfx::widget_type::Client) == neogfx::widget_type::Client)
-                continue;
-            rect intersection = nonClientClipRect.intersection(childWidget.non_client_rect() - self.origin());
-            if (intersection.empty() && !childWidget.is_root())
-                continue;
-            childWidget.render_ex(aGc);
-        }
+        visit_children_in(nonClientClipRect, [&](i_widget const& aChildWidget)
+            {
+                if ((aChildWidget.widget_type() & neogfx::widget_type::Client) == neogfx::widget_type::Client)
+                    return;
+                rect intersection = nonClientClipRect.intersection(aChildWidget.non_client_rect() - self.origin());
+                if (intersection.empty() && !aChildWidget.is_root())
+                    return;
+                aChildWidget.render_ex(aGc);
+            });
 
         PaintedNonClient(aGc);
     }
@@ -1396,16 +1499,15 @@ namespace neogfx
         for (auto& layer : widgetLayers)
             layer.second().clear();
 
-        for (auto iterChild = iChildren.rbegin(); iterChild != iChildren.rend(); ++iterChild)
-        {
-            auto const& childWidget = **iterChild;
-            if ((childWidget.widget_type() & neogfx::widget_type::NonClient) == neogfx::widget_type::NonClient)
-                continue;
-            rect intersection = clipRect.intersection(to_client_coordinates(childWidget.non_client_rect()));
-            if (intersection.empty() && !childWidget.is_root())
-                continue;
-            widgetLayers[childWidget.render_layer()].push_back(&childWidget);
-        }
+        visit_children_in(clipRect, [&](i_widget const& aChildWidget)
+            {
+                if ((aChildWidget.widget_type() & neogfx::widget_type::NonClient) == neogfx::widget_type::NonClient)
+                    return;
+                rect intersection = clipRect.intersection(to_client_coordinates(aChildWidget.non_client_rect()));
+                if (intersection.empty() && !aChildWidget.is_root())
+                    return;
+                widgetLayers[aChildWidget.render_layer()].push_back(&aChildWidget);
+            });
 
         for (auto const& layer : widgetLayers)
         {
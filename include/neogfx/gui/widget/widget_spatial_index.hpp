@@ -0,0 +1,167 @@
+// widget_spatial_index.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <boost/unordered/unordered_flat_map.hpp>
+
+#include <neogfx/core/geometrical.hpp>
+
+namespace neogfx
+{
+    class i_widget;
+
+    // Uniform grid of child widget rects (relative to the parent's origin) used by containers with many
+    // children to find the children intersecting a clip rect or containing a point without visiting them all.
+    // Children spanning too many cells, and children that must always be rendered (nested roots), are kept in a
+    // separate list that every query visits.
+    class widget_spatial_index
+    {
+    public:
+        static constexpr scalar DEFAULT_CELL_SIZE = 128.0;
+        static constexpr std::int32_t MAX_CELLS_PER_CHILD = 64;
+    private:
+        typedef std::uint64_t cell_key;
+        struct entry
+        {
+            neogfx::rect rect;
+            std::int32_t x0;
+            std::int32_t y0;
+            std::int32_t x1;
+            std::int32_t y1;
+            bool oversized;
+            bool always;
+        };
+    public:
+        widget_spatial_index(scalar aCellSize = DEFAULT_CELL_SIZE) :
+            iCellSize{ aCellSize }
+        {
+        }
+    public:
+        std::size_t size() const
+        {
+            return iEntries.size();
+        }
+        void clear()
+        {
+            iEntries.clear();
+            iCells.clear();
+            iOversized.clear();
+        }
+        void insert(i_widget const& aChild, rect const& aRect, bool aAlwaysInclude = false)
+        {
+            remove(aChild);
+            entry e{ aRect };
+            e.always = aAlwaysInclude;
+            e.x0 = cell(aRect.left());
+            e.y0 = cell(aRect.top());
+            e.x1 = cell(aRect.right());
+            e.y1 = cell(aRect.bottom());
+            e.oversized = aAlwaysInclude || (static_cast<std::int64_t>(e.x1 - e.x0 + 1) * (e.y1 - e.y0 + 1) > MAX_CELLS_PER_CHILD);
+            if (e.oversized)
+                iOversized.push_back(&aChild);
+            else
+                for (auto y = e.y0; y <= e.y1; ++y)
+                    for (auto x = e.x0; x <= e.x1; ++x)
+                        iCells[key(x, y)].push_back(&aChild);
+            iEntries.emplace(&aChild, e);
+        }
+        void remove(i_widget const& aChild)
+        {
+            auto existing = iEntries.find(&aChild);
+            if (existing == iEntries.end())
+                return;
+            auto const& e = existing->second;
+            if (e.oversized)
+                std::erase(iOversized, &aChild);
+            else
+                for (auto y = e.y0; y <= e.y1; ++y)
+                    for (auto x = e.x0; x <= e.x1; ++x)
+                    {
+                        auto c = iCells.find(key(x, y));
+                        if (c == iCells.end())
+                            continue;
+                        std::erase(c->second, &aChild);
+                        if (c->second.empty())
+                            iCells.erase(c);
+                    }
+            iEntries.erase(existing);
+        }
+        // Appends the children whose rect intersects aArea (plus any always included children), each once and in
+        // no particular order.
+        void query(rect const& aArea, std::vector<i_widget const*>& aResult) const
+        {
+            auto const start = aResult.size();
+            auto const x0 = cell(aArea.left());
+            auto const y0 = cell(aArea.top());
+            auto const x1 = cell(aArea.right());
+            auto const y1 = cell(aArea.bottom());
+            if (static_cast<std::int64_t>(x1 - x0 + 1) * (y1 - y0 + 1) > static_cast<std::int64_t>(iCells.size()))
+            {
+                for (auto const& c : iCells)
+                    aResult.insert(aResult.end(), c.second.begin(), c.second.end());
+            }
+            else
+            {
+                for (auto y = y0; y <= y1; ++y)
+                    for (auto x = x0; x <= x1; ++x)
+                    {
+                        auto c = iCells.find(key(x, y));
+                        if (c != iCells.end())
+                            aResult.insert(aResult.end(), c->second.begin(), c->second.end());
+                    }
+            }
+            aResult.insert(aResult.end(), iOversized.begin(), iOversized.end());
+            std::sort(std::next(aResult.begin(), start), aResult.end());
+            aResult.erase(std::unique(std::next(aResult.begin(), start), aResult.end()), aResult.end());
+            aResult.erase(std::remove_if(std::next(aResult.begin(), start), aResult.end(), [&](i_widget const* aChild)
+                {
+                    auto const& e = iEntries.find(aChild)->second;
+                    return !e.always && e.rect.intersection(aArea).empty();
+                }), aResult.end());
+        }
+        // Appends the children whose rect contains aPoint.
+        void query(point const& aPoint, std::vector<i_widget const*>& aResult) const
+        {
+            auto c = iCells.find(key(cell(aPoint.x), cell(aPoint.y)));
+            if (c != iCells.end())
+                for (auto child : c->second)
+                    if (iEntries.find(child)->second.rect.contains(aPoint))
+                        aResult.push_back(child);
+            for (auto child : iOversized)
+                if (iEntries.find(child)->second.rect.contains(aPoint))
+                    aResult.push_back(child);
+        }
+    private:
+        std::int32_t cell(scalar aCoordinate) const
+        {
+            return static_cast<std::int32_t>(std::floor(aCoordinate / iCellSize));
+        }
+        static cell_key key(std::int32_t aX, std::int32_t aY)
+        {
+            return (static_cast<cell_key>(static_cast<std::uint32_t>(aX)) << 32u) | static_cast<std::uint32_t>(aY);
+        }
+    private:
+        scalar iCellSize;
+        boost::unordered_flat_map<i_widget const*, entry> iEntries;
+        boost::unordered_flat_map<cell_key, std::vector<i_widget const*>> iCells;
+        std::vector<i_widget const*> iOversized;
+    };
+}
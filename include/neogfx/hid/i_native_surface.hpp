@@ -46,11 +46,14 @@ namespace neogfx
         virtual std::uint64_t frame_counter() const = 0;
         virtual double fps() const = 0;
         virtual double potential_fps() const = 0;
+        virtual std::uint64_t pixels_repainted() const = 0;
+        virtual double average_pixels_repainted() const = 0;
     public:
         virtual void invalidate(const rect& aInvalidatedRect) = 0;
         virtual bool has_invalidated_areas() const = 0;
         virtual i_vector<rect> const& invalidated_areas() const = 0;
         virtual rect const& invalidated_area() const = 0;
+        virtual void select_invalidated_area(std::optional<std::size_t> const& aIndex) const = 0;
         virtual void validate() = 0;
         virtual bool can_render() const = 0;
         virtual void render(bool aOOBRequest = false) = 0;
@@ -34,6 +34,7 @@
 #include <neogfx/gfx/i_gradient_manager.hpp>
 #include <neogfx/gfx/text/i_emoticon_translator.hpp>
 #include <neogfx/app/app.hpp>
+#include <neogfx/app/profiler.hpp>
 #include <neogfx/hid/surface_manager.hpp>
 #include <neogfx/hid/i_hid_devices.hpp>
 #include <neogfx/app/resource_manager.hpp>
@@ -68,6 +69,7 @@ namespace neogfx
             ("directx", "use DirectX (ANGLE) renderer")
             ("software", "use software renderer")
             ("turbo", "use turbo mode")
+            ("profile", boost::program_options::value<std::string>(), "record a frame profile and write it to the given file as a Chrome trace on exit")
             ("double-buffer", "enable window double buffering");
         boost::program_options::store(boost::program_options::parse_command_line(argc, argv, description), iOptions);
         if (options().count("vulkan") + options().count("directx") + options().count("software") > 1)
@@ -152,6 +154,13 @@ namespace neogfx
         return options().count("nest") == 1;
     }
 
+    std::optional<std::string> program_options::profile() const
+    {
+        if (options().count("profile") == 1)
+            return options()["profile"].as<std::string>();
+        return std::optional<std::string>{};
+    }
+
     namespace
     {
         std::atomic<app*> sFirstInstance;
@@ -297,6 +306,9 @@ namespace neogfx
 
         if (program_options().turbo())
             neolib::service<neolib::i_power>().enable_turbo_mode();
+
+        if (program_options().profile())
+            profiler::instance().enable();
         
         service<i_emoticon_translator>();
 
@@ -404,6 +416,8 @@ namespace neogfx
                         neolib::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
                 }
             }
+            if (program_options().profile())
+                profiler::instance().export_chrome_trace(*program_options().profile());
             return *iQuitResultCode;
         }
         catch (std::exception& e)
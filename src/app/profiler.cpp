@@ -0,0 +1,196 @@
+// profiler.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+
+#include <fstream>
+#include <iomanip>
+
+#include <neogfx/app/profiler.hpp>
+
+namespace neogfx
+{
+    namespace
+    {
+        void write_json_string(std::ostream& aStream, char const* aString)
+        {
+            aStream << '"';
+            for (auto ch = aString; *ch != '\0'; ++ch)
+            {
+                switch (*ch)
+                {
+                case '"':
+                    aStream << "\\\"";
+                    break;
+                case '\\':
+                    aStream << "\\\\";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(*ch) >= 0x20u)
+                        aStream << *ch;
+                    break;
+                }
+            }
+            aStream << '"';
+        }
+    }
+
+    profiler::profiler() :
+        iThreadBufferCapacity{ DEFAULT_THREAD_BUFFER_CAPACITY }
+    {
+    }
+
+    profiler& profiler::instance()
+    {
+        static profiler sInstance;
+        return sInstance;
+    }
+
+    void profiler::enable(std::size_t aThreadBufferCapacity)
+    {
+        {
+            std::scoped_lock lock{ iMutex };
+            iThreadBufferCapacity = std::max<std::size_t>(aThreadBufferCapacity, 1u);
+        }
+        sEnabled.store(true, std::memory_order_relaxed);
+    }
+
+    void profiler::disable()
+    {
+        sEnabled.store(false, std::memory_order_relaxed);
+    }
+
+    void profiler::clear()
+    {
+        // Writers own head; clearing just moves the reader's tail up to it.
+        std::scoped_lock lock{ iMutex };
+        for (auto& buffer : iThreadBuffers)
+            buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+
+    void profiler::record(char const* aName, char const* aCategory, std::uint64_t aBegin, std::uint64_t aEnd) noexcept
+    {
+        auto const buffer = this_thread_buffer();
+        if (buffer == nullptr)
+            return;
+        auto const head = buffer->head.load(std::memory_order_relaxed);
+        auto& slot = buffer->slots[head % buffer->capacity];
+        slot.sequence.store(head * 2u + 1u, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(aName, std::memory_order_relaxed);
+        slot.category.store(aCategory, std::memory_order_relaxed);
+        slot.begin.store(aBegin, std::memory_order_relaxed);
+        slot.end.store(aEnd, std::memory_order_relaxed);
+        slot.sequence.store(head * 2u + 2u, std::memory_order_release);
+        buffer->head.store(head + 1u, std::memory_order_release);
+    }
+
+    std::vector<std::pair<std::uint32_t, profiler_sample>> profiler::samples() const
+    {
+        std::vector<std::pair<std::uint32_t, profiler_sample>> result;
+        std::scoped_lock lock{ iMutex };
+        for (auto const& buffer : iThreadBuffers)
+        {
+            auto const head = buffer->head.load(std::memory_order_acquire);
+            auto const capacity = buffer->capacity;
+            auto const tail = std::max(buffer->tail.load(std::memory_order_relaxed), head > capacity ? head - capacity : 0u);
+            for (auto index = tail; index != head; ++index)
+            {
+                // The owning thread may be overwriting the oldest slots as we go; skip any slot whose sequence
+                // number changes (or no longer belongs to this index) while it is copied.
+                auto const& slot = buffer->slots[index % capacity];
+                auto const sequence = slot.sequence.load(std::memory_order_acquire);
+                if (sequence != index * 2u + 2u)
+                    continue;
+                profiler_sample const sample{
+                    slot.name.load(std::memory_order_relaxed),
+                    slot.category.load(std::memory_order_relaxed),
+                    slot.begin.load(std::memory_order_relaxed),
+                    slot.end.load(std::memory_order_relaxed) };
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+                    continue;
+                result.emplace_back(buffer->thread, sample);
+            }
+        }
+        return result;
+    }
+
+    void profiler::export_chrome_trace(std::ostream& aStream) const
+    {
+        auto const allSamples = samples();
+        std::uint64_t epoch = std::numeric_limits<std::uint64_t>::max();
+        for (auto const& sample : allSamples)
+            epoch = std::min(epoch, sample.second.begin);
+        aStream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        // Microseconds to the nanosecond (the default six significant digits lose resolution after a second).
+        auto const oldFlags = aStream.flags();
+        auto const oldPrecision = aStream.precision();
+        aStream << std::fixed << std::setprecision(3);
+        bool first = true;
+        for (auto const& sample : allSamples)
+        {
+            if (!first)
+                aStream << ",";
+            first = false;
+            aStream << "\n{\"name\":";
+            write_json_string(aStream, sample.second.name);
+            aStream << ",\"cat\":";
+            write_json_string(aStream, sample.second.category);
+            aStream << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << sample.first <<
+                ",\"ts\":" << (sample.second.begin - epoch) / 1000.0 <<
+                ",\"dur\":" << (sample.second.end - sample.second.begin) / 1000.0 << "}";
+        }
+        aStream.flags(oldFlags);
+        aStream.precision(oldPrecision);
+        aStream << "\n]}" << std::endl;
+    }
+
+    void profiler::export_chrome_trace(std::string const& aPath) const
+    {
+        std::ofstream output{ aPath };
+        if (!output)
+            throw failed_to_export(aPath);
+        export_chrome_trace(output);
+        if (!output)
+            throw failed_to_export(aPath);
+    }
+
+    profiler::thread_buffer* profiler::this_thread_buffer() noexcept
+    {
+        thread_local thread_buffer* tBuffer = nullptr;
+        if (tBuffer == nullptr)
+        {
+            try
+            {
+                std::scoped_lock lock{ iMutex };
+                auto buffer = std::make_unique<thread_buffer>();
+                buffer->thread = static_cast<std::uint32_t>(iThreadBuffers.size() + 1u);
+                buffer->capacity = static_cast<std::uint64_t>(iThreadBufferCapacity);
+                buffer->slots = std::make_unique<slot[]>(iThreadBufferCapacity);
+                tBuffer = iThreadBuffers.emplace_back(std::move(buffer)).get();
+            }
+            catch (...)
+            {
+                return nullptr;
+            }
+        }
+        return tBuffer;
+    }
+}
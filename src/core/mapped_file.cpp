@@ -0,0 +1,178 @@
+// mapped_file.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+
+#include <filesystem>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <neogfx/core/mapped_file.hpp>
+
+namespace neogfx
+{
+#ifdef _WIN32
+    struct mapped_file::native_mapping
+    {
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+        void const* view = nullptr;
+
+        ~native_mapping()
+        {
+            if (view != nullptr)
+                ::UnmapViewOfFile(view);
+            if (mapping != nullptr)
+                ::CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE)
+                ::CloseHandle(file);
+        }
+    };
+#else
+    struct mapped_file::native_mapping
+    {
+        int file = -1;
+        void* view = nullptr;
+        std::size_t size = 0u;
+
+        ~native_mapping()
+        {
+            if (view != nullptr)
+                ::munmap(view, size);
+            if (file != -1)
+                ::close(file);
+        }
+    };
+#endif
+
+    mapped_file::mapped_file(std::string const& aPath) :
+        iPath{ aPath }, iMapping{ std::make_unique<native_mapping>() }
+    {
+        std::filesystem::path const path{ std::u8string{ aPath.begin(), aPath.end() } };
+#ifdef _WIN32
+        iMapping->file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER fileSize;
+        if (iMapping->file == INVALID_HANDLE_VALUE || !::GetFileSizeEx(iMapping->file, &fileSize))
+            throw failed_to_open(aPath);
+        iSize = static_cast<std::uint64_t>(fileSize.QuadPart);
+        if (iSize != 0u)
+        {
+            iMapping->mapping = ::CreateFileMappingW(iMapping->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (iMapping->mapping != nullptr)
+                iMapping->view = ::MapViewOfFile(iMapping->mapping, FILE_MAP_READ, 0, 0, 0);
+            if (iMapping->view == nullptr)
+                throw failed_to_map(aPath);
+            iData = static_cast<char const*>(iMapping->view);
+        }
+#else
+        iMapping->file = ::open(path.c_str(), O_RDONLY);
+        struct stat fileStatus;
+        if (iMapping->file == -1 || ::fstat(iMapping->file, &fileStatus) != 0)
+            throw failed_to_open(aPath);
+        iSize = static_cast<std::uint64_t>(fileStatus.st_size);
+        if (iSize != 0u)
+        {
+            iMapping->view = ::mmap(nullptr, static_cast<std::size_t>(iSize), PROT_READ, MAP_PRIVATE, iMapping->file, 0);
+            if (iMapping->view == MAP_FAILED)
+            {
+                iMapping->view = nullptr;
+                throw failed_to_map(aPath);
+            }
+            iMapping->size = static_cast<std::size_t>(iSize);
+            iData = static_cast<char const*>(iMapping->view);
+        }
+#endif
+    }
+
+    mapped_file::~mapped_file()
+    {
+    }
+
+    std::string const& mapped_file::path() const
+    {
+        return iPath;
+    }
+
+    std::uint64_t mapped_file::size() const
+    {
+        return iSize;
+    }
+
+    char const* mapped_file::data() const
+    {
+        return iData;
+    }
+
+    std::string_view mapped_file::bytes() const
+    {
+        return std::string_view{ iData, static_cast<std::size_t>(iSize) };
+    }
+
+    std::uint64_t mapped_file::current_size() const
+    {
+#ifdef _WIN32
+        // Windows won't truncate a file while it has a mapped view.
+        return iSize;
+#else
+        struct stat fileStatus;
+        if (::fstat(iMapping->file, &fileStatus) != 0)
+            return 0u;
+        return std::min(iSize, static_cast<std::uint64_t>(fileStatus.st_size));
+#endif
+    }
+
+    std::string mapped_file::read(std::uint64_t aOffset, std::uint64_t aLength) const
+    {
+        aOffset = std::min(aOffset, iSize);
+        aLength = std::min(aLength, iSize - aOffset);
+        std::string result(static_cast<std::size_t>(aLength), '\0');
+        std::size_t done = 0u;
+        while (done < result.size())
+        {
+            auto const remaining = result.size() - done;
+#ifdef _WIN32
+            OVERLAPPED position = {};
+            ULARGE_INTEGER offset;
+            offset.QuadPart = aOffset + done;
+            position.Offset = offset.LowPart;
+            position.OffsetHigh = offset.HighPart;
+            DWORD bytesRead = 0;
+            if (!::ReadFile(iMapping->file, result.data() + done, static_cast<DWORD>(std::min<std::size_t>(remaining, 1u << 30)), &bytesRead, &position) || bytesRead == 0)
+                break;
+#else
+            auto const bytesRead = ::pread(iMapping->file, result.data() + done, remaining, static_cast<off_t>(aOffset + done));
+            if (bytesRead <= 0)
+                break;
+#endif
+            done += static_cast<std::size_t>(bytesRead);
+        }
+        // Short if the file has been truncated.
+        result.resize(done);
+        return result;
+    }
+}
@@ -0,0 +1,191 @@
+// mapped_text.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+
+#include <cstring>
+#include <functional>
+
+#include <neogfx/core/mapped_text.hpp>
+
+namespace neogfx
+{
+    mapped_text::mapped_text(std::string const& aPath) :
+        iFile{ aPath }, iData{ iFile.data() }, iSize{ iFile.size() }, iLineIndex{ 0u }
+    {
+        iIndexer = std::jthread{ [this](std::stop_token aStopToken) { build_index(aStopToken); } };
+    }
+
+    mapped_text::~mapped_text()
+    {
+        // The indexer reads the mapping so must finish before it is unmapped.
+        iIndexer.request_stop();
+        if (iIndexer.joinable())
+            iIndexer.join();
+    }
+
+    std::string const& mapped_text::path() const
+    {
+        return iFile.path();
+    }
+
+    std::uint64_t mapped_text::size() const
+    {
+        return iSize;
+    }
+
+    std::string_view mapped_text::bytes() const
+    {
+        return std::string_view{ iData, static_cast<std::size_t>(iSize) };
+    }
+
+    std::string_view mapped_text::bytes(std::uint64_t aFirst, std::uint64_t aLast) const
+    {
+        aLast = std::min(aLast, available());
+        aFirst = std::min(aFirst, aLast);
+        return std::string_view{ iData + aFirst, static_cast<std::size_t>(aLast - aFirst) };
+    }
+
+    std::string mapped_text::copy(std::uint64_t aFirst, std::uint64_t aLast) const
+    {
+        aLast = std::min(aLast, iSize);
+        aFirst = std::min(aFirst, aLast);
+        return iFile.read(aFirst, aLast - aFirst);
+    }
+
+    bool mapped_text::indexed() const
+    {
+        return iIndexed.load(std::memory_order_acquire);
+    }
+
+    std::uint64_t mapped_text::indexed_lines() const
+    {
+        std::scoped_lock lock{ iIndexMutex };
+        return iIndexedLines;
+    }
+
+    std::uint64_t mapped_text::estimated_lines() const
+    {
+        std::scoped_lock lock{ iIndexMutex };
+        if (indexed() || iIndexedBytes == 0u)
+            return iIndexedLines;
+        return std::max(iIndexedLines, static_cast<std::uint64_t>(static_cast<double>(iIndexedLines) * iSize / iIndexedBytes));
+    }
+
+    std::uint64_t mapped_text::line_start(std::uint64_t aLine) const
+    {
+        std::uint64_t indexedLine;
+        std::uint64_t offset;
+        {
+            std::scoped_lock lock{ iIndexMutex };
+            auto const entry = std::min<std::uint64_t>(aLine / LINE_INDEX_STRIDE, iLineIndex.size() - 1u);
+            indexedLine = entry * LINE_INDEX_STRIDE;
+            offset = iLineIndex[entry];
+        }
+        return skip_lines(offset, aLine - indexedLine);
+    }
+
+    std::uint64_t mapped_text::line_end(std::uint64_t aLine) const
+    {
+        auto const start = line_start(aLine);
+        auto end = std::min(line_start(aLine + 1u), available());
+        if (end > start && iData[end - 1u] == '\n')
+            --end;
+        if (end > start && iData[end - 1u] == '\r')
+            --end;
+        return end;
+    }
+
+    std::uint64_t mapped_text::line_at(std::uint64_t aOffset) const
+    {
+        std::uint64_t indexedLine;
+        std::uint64_t offset;
+        {
+            std::scoped_lock lock{ iIndexMutex };
+            auto const entry = static_cast<std::uint64_t>(std::distance(iLineIndex.begin(), std::upper_bound(iLineIndex.begin(), iLineIndex.end(), aOffset)) - 1);
+            indexedLine = entry * LINE_INDEX_STRIDE;
+            offset = iLineIndex[entry];
+        }
+        aOffset = std::min(aOffset, available());
+        offset = std::min(offset, aOffset);
+        return indexedLine + static_cast<std::uint64_t>(std::count(iData + offset, iData + aOffset, '\n'));
+    }
+
+    std::optional<std::uint64_t> mapped_text::find(std::string_view aText, std::uint64_t aFrom) const
+    {
+        auto const size = available();
+        if (aText.empty() || aFrom >= size)
+            return {};
+        auto const first = iData + aFrom;
+        auto const last = iData + size;
+        auto const match = std::search(first, last, std::boyer_moore_horspool_searcher{ aText.begin(), aText.end() });
+        if (match == last)
+            return {};
+        return static_cast<std::uint64_t>(match - iData);
+    }
+
+    std::uint64_t mapped_text::available() const
+    {
+        return iFile.current_size();
+    }
+
+    std::uint64_t mapped_text::skip_lines(std::uint64_t aOffset, std::uint64_t aLines) const
+    {
+        auto const size = available();
+        if (aOffset >= size)
+            return iSize;
+        for (; aLines > 0u; --aLines)
+        {
+            auto const next = static_cast<char const*>(std::memchr(iData + aOffset, '\n', static_cast<std::size_t>(size - aOffset)));
+            if (next == nullptr || next + 1 == iData + size)
+                return iSize;
+            aOffset = static_cast<std::uint64_t>(next + 1 - iData);
+        }
+        return aOffset;
+    }
+
+    void mapped_text::build_index(std::stop_token aStopToken)
+    {
+        std::vector<std::uint64_t> chunkIndex;
+        std::uint64_t line = 0u;
+        for (std::uint64_t chunk = 0u; chunk < iSize; chunk += INDEX_CHUNK_SIZE)
+        {
+            if (aStopToken.stop_requested())
+                return;
+            // Stop at the end of the file if it has been truncated since it was mapped.
+            auto const chunkEnd = std::min(chunk + INDEX_CHUNK_SIZE, available());
+            if (chunkEnd <= chunk)
+                break;
+            chunkIndex.clear();
+            for (auto next = iData + chunk; (next = static_cast<char const*>(std::memchr(next, '\n', iData + chunkEnd - next))) != nullptr;)
+            {
+                ++next;
+                if (next == iData + iSize)
+                    break;
+                if (++line % LINE_INDEX_STRIDE == 0u)
+                    chunkIndex.push_back(static_cast<std::uint64_t>(next - iData));
+            }
+            std::scoped_lock lock{ iIndexMutex };
+            iLineIndex.insert(iLineIndex.end(), chunkIndex.begin(), chunkIndex.end());
+            iIndexedLines = line + 1u;
+            iIndexedBytes = chunkEnd;
+        }
+        iIndexed.store(true, std::memory_order_release);
+    }
+}
@@ -20,6 +20,7 @@
 #include <neogfx/neogfx.hpp>
 
 #include <neogfx/core/async_thread.hpp>
+#include <neogfx/app/profiler.hpp>
 #include <neogfx/game/ecs.hpp>
 #include <neogfx/game/game_world.hpp>
 #include <neogfx/game/clock.hpp>
@@ -58,6 +59,9 @@ namespace neogfx::game
     {
         if (!can_apply())
             throw cannot_apply();
+
+        scoped_profiler_zone applyZone{ "animator", "ecs" };
+
         if (!ecs().component_instantiated<animation_filter>())
             return false;
         if (paused())
@@ -20,6 +20,7 @@
 #include <neogfx/neogfx.hpp>
 
 #include <neogfx/core/async_thread.hpp>
+#include <neogfx/app/profiler.hpp>
 #include <neogfx/game/ecs.hpp>
 #include <neogfx/game/ecs_helpers.hpp>
 #include <neogfx/game/simple_physics.hpp>
@@ -77,6 +78,9 @@ namespace neogfx::game
     {
         if (!this->can_apply())
             throw cannot_apply();
+
+        scoped_profiler_zone applyZone{ "collision_detector", "ecs" };
+
         if (!this->components_available())
             return false;
         if (this->paused())
@@ -20,6 +20,7 @@
 #include <neogfx/neogfx.hpp>
 
 #include <neogfx/core/async_thread.hpp>
+#include <neogfx/app/profiler.hpp>
 #include <neogfx/game/ecs.hpp>
 #include <neogfx/game/mesh_render_cache.hpp>
 #include <neogfx/game/simple_physics.hpp>
@@ -72,6 +73,9 @@ namespace neogfx::game
     {
         if (!this->can_apply())
             throw cannot_apply();
+
+        scoped_profiler_zone applyZone{ "simple_physics", "ecs" };
+
         if (this->paused())
             return false;
 
@@ -19,11 +19,62 @@
 
 #include <neogfx/neogfx.hpp>
 
+#include <list>
+#include <map>
+
 #include <neogfx/game/rectangle.hpp>
 #include <neogfx/game/text_mesh.hpp>
 
 namespace neogfx::game
 {
+    namespace
+    {
+        // The shaped text and line breaker of each text mesh are kept so that an update that only changes the mesh's
+        // extents re-wraps the text rather than shaping it again.
+        struct shaped_text
+        {
+            string text;
+            font_id font;
+            dimension ppi;
+            glyph_text glyphText;
+            line_breaker lineBreaker;
+        };
+
+        std::size_t constexpr SHAPED_TEXT_CACHE_CAPACITY = 256u;
+
+        shaped_text const& shape_text(i_ecs const& aEcs, entity_id aEntity, i_graphics_context const& aGc, string const& aText, neogfx::font const& aFont)
+        {
+            // Least recently used first out so that more text meshes than the cache holds don't empty it every frame.
+            using cache_key = std::pair<i_ecs const*, entity_id>;
+            using cache_list = std::list<std::pair<cache_key, shaped_text>>;
+            thread_local cache_list tCache;
+            thread_local std::map<cache_key, cache_list::iterator> tCacheIndex;
+            auto const key = std::make_pair(&aEcs, aEntity);
+            auto const existing = tCacheIndex.find(key);
+            if (existing != tCacheIndex.end())
+            {
+                tCache.splice(tCache.begin(), tCache, existing->second);
+                auto& cached = existing->second->second;
+                if (cached.text == aText && cached.font == aFont.id() && cached.ppi == aGc.ppi())
+                    return cached;
+                auto glyphText = aGc.to_glyph_text(aText, aFont);
+                line_breaker lineBreaker{ glyphText };
+                cached = shaped_text{ aText, aFont.id(), aGc.ppi(), std::move(glyphText), std::move(lineBreaker) };
+                return cached;
+            }
+            auto glyphText = aGc.to_glyph_text(aText, aFont);
+            line_breaker lineBreaker{ glyphText };
+            tCache.emplace_front(key, shaped_text{ aText, aFont.id(), aGc.ppi(), std::move(glyphText), std::move(lineBreaker) });
+            tCacheIndex[key] = tCache.begin();
+            while (tCache.size() > SHAPED_TEXT_CACHE_CAPACITY)
+            {
+                tCacheIndex.erase(tCache.back().first);
+                tCache.pop_back();
+            }
+            return tCache.front().second;
+        }
+    }
+
     namespace shape
     {
         text::text(i_ecs& aEcs, i_graphics_context const& aGc, i_string const& aText, const neogfx::font& aFont, const neogfx::text_format& aTextFormat, neogfx::alignment aAlignment) :
@@ -74,7 +125,8 @@ namespace neogfx::game
         mr.patches = patches{};
         
         neogfx::font font = service<i_font_manager>().font_from_id(aData.font->id.cookie());
-        auto multilineGlyphText = aGc.to_multiline_glyph_text(aData.text, font, aData.extents.x, aData.alignment);
+        auto const& shaped = shape_text(aEcs, aEntity, aGc, aData.text, font);
+        auto multilineGlyphText = aGc.to_multiline_glyph_text(shaped.glyphText, shaped.lineBreaker, aData.extents.x, aData.alignment);
 
         bool const renderToPatch = (aData.textEffect != text_effect_type::None || aData.renderToPatch);
 
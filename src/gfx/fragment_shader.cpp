@@ -243,15 +243,27 @@ namespace neogfx
         uGlyphEnabled = false;
     }
 
-    void standard_glyph_shader::set_first_glyph(i_rendering_context const& aContext, glyph_text const& aText, glyph_char const& aGlyphChar)
+    void standard_glyph_shader::set_first_glyph(i_rendering_context const& aContext, glyph_text const& aText, glyph_char const& aGlyphChar, bool aOutline)
     {
         enable();
-        bool subpixelRender = subpixel(aGlyphChar) && aText.glyph(aGlyphChar).subpixel();
+        auto const& theGlyph = aText.glyph(aGlyphChar);
+        bool subpixelRender = subpixel(aGlyphChar) && theGlyph.subpixel();
         if (subpixelRender)
             aContext.render_target().target_texture().bind(static_cast<std::uint32_t>(reserved_texture_unit::RenderTarget));
         uGlyphRenderOutput = sampler2DMS{ static_cast<std::uint32_t>(reserved_texture_unit::RenderTarget) };
-        uGlyphSubpixel = aText.glyph(aGlyphChar).subpixel();
+        uGlyphSubpixel = theGlyph.subpixel();
         uGlyphSubpixelFormat = subpixelRender ? aContext.subpixel_format() : subpixel_format::None;
+        uGlyphDistanceField = theGlyph.distance_field();
+        // Distance field texels are 0.5 on the glyph's edge falling to 0.0 DISTANCE_FIELD_SPREAD (reference size)
+        // pixels outside it; an outline moves the edge out by the outline's radius.
+        scalar edge = 0.5;
+        if (theGlyph.distance_field() && aOutline && theGlyph.texture().extents().cy != 0.0)
+        {
+            auto const scale = theGlyph.extents().cy / theGlyph.texture().extents().cy;
+            auto const radius = aText.glyph_font(aGlyphChar).native_font_face().outline().radius;
+            edge = std::max(0.0, 0.5 * (1.0 - radius / (scale * i_glyph::DISTANCE_FIELD_SPREAD)));
+        }
+        uGlyphDistanceFieldEdge = static_cast<float>(edge);
         uGlyphEnabled = true;
     }
 
@@ -19,6 +19,8 @@
 
 #include <neogfx/neogfx.hpp>
 
+#include <bit>
+
 #include <neogfx/gfx/i_graphics_context.hpp>
 #include <neogfx/gfx/gradient_manager.hpp>
 
@@ -563,6 +565,129 @@ namespace neogfx
         std::function<void()> iFixer = [&]() { fix(); };
     };
 
+    namespace
+    {
+        void hash_combine(std::uint64_t& aSeed, std::uint64_t aValue)
+        {
+            aSeed ^= aValue + 0x9e3779b97f4a7c15ull + (aSeed << 6u) + (aSeed >> 2u);
+        }
+
+        std::uint64_t sampler_fingerprint(i_gradient const& aGradient)
+        {
+            std::uint64_t result = aGradient.color_stops().size();
+            hash_combine(result, aGradient.alpha_stops().size());
+            for (auto const& stop : aGradient.color_stops())
+            {
+                hash_combine(result, std::bit_cast<std::uint64_t>(stop.first()));
+                for (std::size_t component = 0u; component < 4u; ++component)
+                    hash_combine(result, std::bit_cast<std::uint64_t>(static_cast<double>(stop.second()[component])));
+            }
+            for (auto const& stop : aGradient.alpha_stops())
+            {
+                hash_combine(result, std::bit_cast<std::uint64_t>(stop.first()));
+                hash_combine(result, stop.second());
+            }
+            return result;
+        }
+
+        template <typename StopList1, typename StopList2>
+        bool same_stops(StopList1 const& aLeft, StopList2 const& aRight)
+        {
+            return std::equal(aLeft.begin(), aLeft.end(), aRight.begin(), aRight.end(), [](auto const& aLeftStop, auto const& aRightStop)
+            {
+                return aLeftStop.first() == aRightStop.first() && aLeftStop.second() == aRightStop.second();
+            });
+        }
+
+        // Fills aOutput[channel][0, aTexels) with the piecewise linear interpolation of the stops sampled at
+        // positions x / (aTexels - 1) (the same as i_gradient::at(x, 0, aTexels - 1)); positions before the first
+        // stop, or after the last, take that stop's value. Each span between two stops is filled as one ramp so the
+        // inner loop is branch free and vectorizes.
+        template <std::size_t Channels>
+        void interpolate_stops(std::vector<float> const& aPositions, std::vector<std::array<float, Channels>> const& aValues,
+            std::uint32_t aTexels, std::array<std::array<float, i_gradient::MaxStops>, Channels>& aOutput)
+        {
+            std::size_t const stopCount = aPositions.size();
+            float const step = aTexels > 1u ? 1.0f / static_cast<float>(aTexels - 1u) : 0.0f;
+            auto fill = [&](std::uint32_t aFrom, std::uint32_t aTo, std::array<float, Channels> const& aValue)
+            {
+                for (std::size_t channel = 0u; channel < Channels; ++channel)
+                    std::fill(aOutput[channel].begin() + aFrom, aOutput[channel].begin() + aTo, aValue[channel]);
+            };
+            std::uint32_t x = 0u;
+            while (x < aTexels && x * step <= aPositions[0])
+                ++x;
+            fill(0u, x, aValues[0]);
+            for (std::size_t stop = 0u; stop + 1u < stopCount; ++stop)
+            {
+                std::uint32_t end = x;
+                while (end < aTexels && end * step <= aPositions[stop + 1u])
+                    ++end;
+                float const left = aPositions[stop];
+                float const width = aPositions[stop + 1u] - left;
+                float const scale = width > 0.0f ? step / width : 0.0f;
+                float const offset = width > 0.0f ? -left / width : 0.0f;
+                for (std::size_t channel = 0u; channel < Channels; ++channel)
+                {
+                    float const base = aValues[stop][channel];
+                    float const delta = aValues[stop + 1u][channel] - base;
+                    float* const output = aOutput[channel].data();
+                    for (std::uint32_t texel = x; texel < end; ++texel)
+                        output[texel] = base + delta * (static_cast<float>(texel) * scale + offset);
+                }
+                x = end;
+            }
+            fill(x, aTexels, aValues[stopCount - 1u]);
+        }
+
+        void generate_sampler_row(i_gradient const& aGradient, std::uint32_t aTexels, avec4u8* aOutput)
+        {
+            thread_local std::vector<float> colorPositions;
+            thread_local std::vector<std::array<float, 4u>> colorValues;
+            thread_local std::vector<float> alphaPositions;
+            thread_local std::vector<std::array<float, 1u>> alphaValues;
+            thread_local std::array<std::array<float, i_gradient::MaxStops>, 4u> colors;
+            thread_local std::array<std::array<float, i_gradient::MaxStops>, 1u> alphas;
+            colorPositions.clear();
+            colorValues.clear();
+            alphaPositions.clear();
+            alphaValues.clear();
+            for (auto const& stop : aGradient.color_stops())
+            {
+                colorPositions.push_back(static_cast<float>(stop.first()));
+                colorValues.push_back({
+                    static_cast<float>(stop.second()[0]), static_cast<float>(stop.second()[1]),
+                    static_cast<float>(stop.second()[2]), static_cast<float>(stop.second()[3]) });
+            }
+            for (auto const& stop : aGradient.alpha_stops())
+            {
+                alphaPositions.push_back(static_cast<float>(stop.first()));
+                alphaValues.push_back({ static_cast<float>(stop.second()) });
+            }
+            if (colorPositions.empty())
+            {
+                colorPositions.push_back(0.0f);
+                colorValues.push_back({ 0.0f, 0.0f, 0.0f, 1.0f });
+            }
+            if (alphaPositions.empty())
+            {
+                alphaPositions.push_back(0.0f);
+                alphaValues.push_back({ 255.0f });
+            }
+            interpolate_stops(colorPositions, colorValues, aTexels, colors);
+            interpolate_stops(alphaPositions, alphaValues, aTexels, alphas);
+            for (std::uint32_t x = 0u; x < aTexels; ++x)
+            {
+                float const alpha = colors[3][x] * std::floor(alphas[0][x]) / 255.0f;
+                aOutput[x] = avec4u8{
+                    static_cast<std::uint8_t>(colors[0][x] * 255.0f),
+                    static_cast<std::uint8_t>(colors[1][x] * 255.0f),
+                    static_cast<std::uint8_t>(colors[2][x] * 255.0f),
+                    static_cast<std::uint8_t>(alpha * 255.0f) };
+            }
+        }
+    }
+
     gradient_manager::gradient_manager()
     {
     }
@@ -574,66 +699,41 @@ namespace neogfx
 
     i_gradient_sampler const& gradient_manager::sampler(i_gradient const& aGradient)
     {
-        thread_local std::pair<gradient::color_stop_list, gradient::alpha_stop_list> key;
-        key.first = aGradient.color_stops();
-        key.second = aGradient.alpha_stops();
-        auto allocated = iAllocatedSamplers.find(key);
-        if (allocated == iAllocatedSamplers.end())
+        auto const fingerprint = sampler_fingerprint(aGradient);
+        auto existing = sampler_cache().find(fingerprint, [&](sampler_key_t const& aKey)
         {
-            if (!free_samplers().empty())
-            {
-                allocated = iAllocatedSamplers.insert(std::make_pair(key, free_samplers().back())).first;
-                free_samplers().pop_back();
-            }
-            else
-            {
-                allocated = iAllocatedSamplers.insert(std::make_pair(key, iSamplerQueue.front()->second)).first;
-                iAllocatedSamplers.erase(iSamplerQueue.front());
-                iSamplerQueue.pop_front();
-            }
-            allocated->second.release_all();
+            return same_stops(aKey.first, aGradient.color_stops()) && same_stops(aKey.second, aGradient.alpha_stops());
+        });
+        if (existing == nullptr)
+        {
+            auto& allocated = sampler_cache().allocate(fingerprint);
+            allocated.key.first = aGradient.color_stops();
+            allocated.key.second = aGradient.alpha_stops();
+            allocated.value.release_all();
             avec4u8 colorValues[i_gradient::MaxStops];
             auto const cx = static_cast<std::uint32_t>(samplers().data().extents().cx);
-            for (std::uint32_t x = 0u; x < cx; ++x)
-            {
-                auto const color = aGradient.at(x, 0u, cx - 1u);
-                colorValues[x] = avec4u8{ color.red(), color.green(), color.blue(), color.alpha() };
-            }
-            samplers().data().set_pixels(rect{ basic_point<std::uint32_t>{ 0u, allocated->second.sampler_row() }, size_u32{ i_gradient::MaxStops, 1u } }, &colorValues[0]);
-        }
-        auto existingQueueEntry = std::find(iSamplerQueue.begin(), iSamplerQueue.end(), allocated);
-        if (existingQueueEntry != iSamplerQueue.end())
-            iSamplerQueue.erase(existingQueueEntry);
-        iSamplerQueue.push_back(allocated);
-        allocated->second.add_ref(aGradient.id());
-        return allocated->second;
+            generate_sampler_row(aGradient, cx, &colorValues[0]);
+            samplers().data().set_pixels(rect{ basic_point<std::uint32_t>{ 0u, allocated.value.sampler_row() }, size_u32{ i_gradient::MaxStops, 1u } }, &colorValues[0]);
+            existing = &allocated;
+        }
+        existing->value.add_ref(aGradient.id());
+        return existing->value;
     }
 
     i_gradient_filter const& gradient_manager::filter(i_gradient const& aGradient)
     {
-        scalar const key{ aGradient.smoothness()};
-        auto allocated = iAllocatedFilters.find(key);
-        if (allocated == iAllocatedFilters.end())
+        scalar const key{ aGradient.smoothness() };
+        auto const fingerprint = std::bit_cast<std::uint64_t>(key);
+        auto existing = filter_cache().find(fingerprint, [&](scalar aKey) { return aKey == key; });
+        if (existing == nullptr)
         {
-            if (!free_filters().empty())
-            {
-                allocated = iAllocatedFilters.insert(std::make_pair(key, free_filters().back())).first;
-                free_filters().pop_back();
-            }
-            else
-            {
-                allocated = iAllocatedFilters.insert(std::make_pair(key, iFilterQueue.front()->second)).first;
-                iAllocatedFilters.erase(iFilterQueue.front());
-                iFilterQueue.pop_front();
-            }
+            auto& allocated = filter_cache().allocate(fingerprint);
+            allocated.key = key;
             auto const filterValues = static_gaussian_filter<float, GRADIENT_FILTER_SIZE>(static_cast<float>(aGradient.smoothness() * 10.0));
-            allocated->second.sampler().data().set_pixels(rect{ point{}, size_u32{ GRADIENT_FILTER_SIZE, 1u } }, &filterValues[0]);
+            allocated.value.sampler().data().set_pixels(rect{ point{}, size_u32{ GRADIENT_FILTER_SIZE, 1u } }, &filterValues[0]);
+            existing = &allocated;
         }
-        auto existingQueueEntry = std::find(iFilterQueue.begin(), iFilterQueue.end(), allocated);
-        if (existingQueueEntry != iFilterQueue.end())
-            iFilterQueue.erase(existingQueueEntry);
-        iFilterQueue.push_back(allocated);
-        return allocated->second;
+        return existing->value;
     }
 
     void gradient_manager::add_ref(gradient_id aId, long aCount)
@@ -748,26 +848,23 @@ namespace neogfx
         return *iSamplers;
     }
 
-    std::vector<gradient_sampler>& gradient_manager::free_samplers()
+    gradient_manager::sampler_cache_t& gradient_manager::sampler_cache()
     {
-        if (iFreeSamplers == std::nullopt)
+        if (iSamplerCache == std::nullopt)
         {
-            iFreeSamplers.emplace();
+            std::vector<gradient_sampler> samplerRows;
             for (std::uint32_t row = 0; row < MaxSamplers; ++row)
-                free_samplers().emplace_back(samplers(), row);
+                samplerRows.emplace_back(samplers(), row);
+            iSamplerCache.emplace(std::move(samplerRows));
         }
-        return *iFreeSamplers;
+        return *iSamplerCache;
     }
 
-    std::vector<gradient_filter>& gradient_manager::free_filters()
+    gradient_manager::filter_cache_t& gradient_manager::filter_cache()
     {
-        if (iFreeFilters == std::nullopt)
-        {
-            iFreeFilters.emplace();
-            for (std::uint32_t filter = 0; filter < MaxFilters; ++filter)
-                free_filters().emplace_back();
-        }
-        return *iFreeFilters;
+        if (iFilterCache == std::nullopt)
+            iFilterCache.emplace(std::vector<gradient_filter>(MaxFilters));
+        return *iFilterCache;
     }
 
     void gradient_manager::cleanup()
@@ -96,6 +96,13 @@ namespace neogfx
         return slb.range();
     }
 
+    inline const i_texture& source_texture(i_graphics_context& aSource)
+    {
+        if (!aSource.render_target().has_target_texture())
+            throw i_graphics_context::no_source_texture();
+        return aSource.render_target().target_texture();
+    }
+
     inline void apply_stipple(graphics_context& aGc, pen const& aPen, std::optional<scoped_stipple>& aScopedStipple)
     {
         switch (aPen.style())
@@ -1177,7 +1184,9 @@ namespace neogfx
                 render_target().target_type() == render_target_type::Surface ? 
                     point{ 0.0, 0.0, aZpos ? *aZpos : 0.0 } : 
                     point{ -iRenderTarget.target_texture().bleed_guard() }, 
-                iRenderTarget.target_texture().storage_extents() }, aColor);
+                iRenderTarget.has_target_texture() ?
+                    iRenderTarget.target_texture().storage_extents() :
+                    iRenderTarget.target_extents() }, aColor);
     }
 
     void graphics_context::clear_depth_buffer()
@@ -1212,7 +1221,7 @@ namespace neogfx
 
     void graphics_context::blit(rect const& aDestinationRect, i_graphics_context& aSource, rect const& aSourceRect, neogfx::blending_mode aBlendingMode)
     {
-        blit(aDestinationRect, aSource.render_target().target_texture(), aSourceRect, aBlendingMode);
+        blit(aDestinationRect, source_texture(aSource), aSourceRect, aBlendingMode);
     }
 
     void blur(std::int32_t aPass, i_graphics_context& aDestination, rect const& aDestinationRect, i_graphics_context& aSource, rect const& aSourceRect, blurring_algorithm aAlgorithm, scalar aParameter1, scalar aParameter2)
@@ -1233,7 +1242,7 @@ namespace neogfx
                 {},
                 {},
                 {},
-                to_ecs_component(aSource.render_target().target_texture()),
+                to_ecs_component(source_texture(aSource)),
                 shader_effect::Filter
             },
             optional_mat44{},
@@ -1284,7 +1293,7 @@ namespace neogfx
                 {},
                 {},
                 {},
-                to_ecs_component(aSource.render_target().target_texture()),
+                to_ecs_component(source_texture(aSource)),
                 shader_effect::Filter
             },
             optional_mat44{},
@@ -1313,7 +1322,7 @@ namespace neogfx
                 {},
                 {},
                 {},
-                to_ecs_component(aSource.render_target().target_texture()),
+                to_ecs_component(source_texture(aSource)),
                 shader_effect::Filter
             },
             optional_mat44{},
@@ -1461,83 +1470,43 @@ namespace neogfx
     }
 
     multiline_glyph_text graphics_context::to_multiline_glyph_text(glyph_text const& aText, dimension aMaxWidth, alignment aAlignment) const
+    {
+        return to_multiline_glyph_text(aText, line_breaker{ aText }, aMaxWidth, aAlignment);
+    }
+
+    multiline_glyph_text graphics_context::to_multiline_glyph_text(glyph_text const& aText, line_breaker const& aLineBreaker, dimension aMaxWidth, alignment aAlignment, line_breaking aLineBreaking) const
     {
         multiline_glyph_text result{ aText.clone() };
-        using line_t = std::pair<glyph_text::iterator, glyph_text::iterator>;
-        using lines_t = std::vector<line_t>;
-        thread_local lines_t lines;
-        lines.clear();
-        std::array<glyph_char, 2> delimeters = { glyph_char{ '\r', {}, text_category::Whitespace }, glyph_char{ '\n', {}, text_category::Whitespace } };
-        neolib::tokens(result.glyphText.begin(), result.glyphText.end(), delimeters.begin(), delimeters.end(), lines, 0, false);
+        thread_local line_breaker::lines_t lines;
+        auto const& paragraphs = aLineBreaker.paragraphs();
+        dimension const maxWidth = (aMaxWidth == 0 ? 0.0 : to_device_units(size(aMaxWidth, 0.0)).cx);
         vec3 pos;
         dimension maxLineWidth = 0.0;
-        for (lines_t::const_iterator i = lines.begin(); i != lines.end(); ++i)
+        for (auto i = paragraphs.begin(); i != paragraphs.end(); ++i)
         {
-            auto const& line = (logical_coordinates().is_gui_orientation() ? *i : *(lines.rbegin() + (i - lines.begin())));
-            glyph_text::iterator lineStart = line.first;
-            glyph_text::iterator lineEnd = line.second;
-            if (lineStart != lineEnd)
+            auto const& paragraph = (logical_coordinates().is_gui_orientation() ? *i : *(paragraphs.rbegin() + (i - paragraphs.begin())));
+            if (paragraph.begin == paragraph.end)
             {
-                if (aMaxWidth == 0)
-                {
-                    auto const& glyphs = std::ranges::subrange(lineStart, lineEnd);
-                    result.lines.push_back(multiline_glyph_text::line{
-                        {}, {},
-                        std::distance(result.glyphText.begin(), lineStart), std::distance(result.glyphText.begin(), lineEnd) });
-                    auto const& firstGlyph = *glyphs.begin();
-                    auto const xAdjust = static_cast<float>(-firstGlyph.cell[0].x);
-                    for (auto& glyph : glyphs)
-                        glyph.cell += vec2f{ xAdjust, static_cast<float>(pos.y) };
-                    size lineExtent = from_device_units(result.glyphText.extents(lineStart, lineEnd));
-                    maxLineWidth = std::max(maxLineWidth, lineExtent.cx);
-                    pos.y += lineExtent.cy;
-                }
-                else
-                {
-                    dimension maxWidth = to_device_units(size(aMaxWidth, 0.0)).cx;
-                    glyph_text::iterator next = lineStart;
-                    while (next != line.second)
-                    {
-                        bool gotLine = false;
-                        if (next->cell[1].x - lineStart->cell[0].x > maxWidth)
-                        {
-                            if (next != lineStart)
-                            {
-                                auto wordBreak = word_break(lineStart, next, result.glyphText.end());
-                                if (wordBreak.first != lineStart)
-                                {
-                                    lineEnd = wordBreak.first;
-                                    next = wordBreak.second;
-                                }
-                                else
-                                    lineEnd = next;
-                            }
-                            else
-                                ++next;
-                            gotLine = true;
-                        }
-                        else
-                            ++next;
-                        if (gotLine || next == line.second)
-                        {
-                            auto const& glyphs = std::ranges::subrange(lineStart, lineEnd);
-                            result.lines.push_back(multiline_glyph_text::line{
-                                {}, {},
-                                std::distance(result.glyphText.begin(), lineStart), std::distance(result.glyphText.begin(), lineEnd) });
-                            auto const xAdjust = static_cast<float>(-lineStart->cell[0].x);
-                            for (auto& glyph : glyphs)
-                                glyph.cell += vec2f{ xAdjust, static_cast<float>(pos.y) };
-                            size lineExtent = from_device_units(result.glyphText.extents(lineStart, lineEnd));
-                            maxLineWidth = std::max(maxLineWidth, lineExtent.cx);
-                            pos.y += lineExtent.cy;
-                            lineStart = next;
-                            lineEnd = line.second;
-                        }
-                    }
-                }
-            }
-            else
                 pos.y += aText.major_font().height();
+                continue;
+            }
+            lines.clear();
+            aLineBreaker.break_lines(paragraph, maxWidth, aLineBreaking, lines);
+            for (auto const& line : lines)
+            {
+                auto const lineStart = std::next(result.glyphText.begin(), line.begin);
+                auto const lineEnd = std::next(result.glyphText.begin(), line.end);
+                auto const& glyphs = std::ranges::subrange(lineStart, lineEnd);
+                result.lines.push_back(multiline_glyph_text::line{
+                    {}, {},
+                    static_cast<glyph_text::difference_type>(line.begin), static_cast<glyph_text::difference_type>(line.end) });
+                auto const xAdjust = static_cast<float>(-lineStart->cell[0].x);
+                for (auto& glyph : glyphs)
+                    glyph.cell += vec2f{ xAdjust, static_cast<float>(pos.y) };
+                size lineExtent = from_device_units(result.glyphText.extents(lineStart, lineEnd));
+                maxLineWidth = std::max(maxLineWidth, lineExtent.cx);
+                pos.y += lineExtent.cy;
+            }
         }
 
         std::optional<vec3> min;
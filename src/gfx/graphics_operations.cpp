@@ -129,6 +129,11 @@ namespace neogfx
             const i_glyph& rightGlyph = rhsText.glyph(rhs);
             if (leftGlyph.subpixel() != rightGlyph.subpixel())
                 return false;
+            if (leftGlyph.distance_field() != rightGlyph.distance_field())
+                return false;
+            // distance field glyphs' outline thresholds depend on their font
+            if (leftGlyph.distance_field() && lhsText.glyph_font(lhs) != rhsText.glyph_font(rhs))
+                return false;
             return true;
         };
 
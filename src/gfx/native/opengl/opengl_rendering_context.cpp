@@ -23,6 +23,7 @@
 #include <neolib/app/i_power.hpp>
 
 #include <neogfx/app/i_basic_services.hpp>
+#include <neogfx/app/profiler.hpp>
 #include <neogfx/hid/i_surface_manager.hpp>
 #include <neogfx/gfx/text/glyph_text.hpp>
 #include <neogfx/gfx/text/i_emoji_atlas.hpp>
@@ -526,6 +527,16 @@ namespace neogfx
         if (queueSize == 0u)
             return;
 
+        scoped_profiler_zone flushZone{ "flush", "flush" };
+
+        static std::array<std::string, graphics_operation::DrawMesh + 1> const sBatchZoneNames = []()
+        {
+            std::array<std::string, graphics_operation::DrawMesh + 1> result;
+            for (std::size_t opType = 0u; opType < result.size(); ++opType)
+                result[opType] = graphics_operation::to_string(static_cast<graphics_operation::operation_type>(opType));
+            return result;
+        }();
+
         std::optional<scoped_render_target> srt;
 
         if (!render_target().target_active())
@@ -547,6 +558,7 @@ namespace neogfx
             auto const opType = static_cast<graphics_operation::operation_type>((**opBatch.cbegin()).index());
             batches.emplace_back(opType, std::distance(batchStart, batchEnd));
             batchStart = batchEnd;
+            scoped_profiler_zone batchZone{ sBatchZoneNames[opType].c_str(), "flush" };
             switch (opType)
             {
             case graphics_operation::SetViewport:
@@ -2646,7 +2658,7 @@ namespace neogfx
                         if (updateGlyphShader)
                         {
                             updateGlyphShader = false;
-                            rendering_engine().default_shader_program().glyph_shader().set_first_glyph(*this, glyphText, glyphChar);
+                            rendering_engine().default_shader_program().glyph_shader().set_first_glyph(*this, glyphText, glyphChar, stage == draw_glyphs_stage::GlyphOutline);
                         }
 
                         bool const subpixelRender = subpixel(glyphChar) && theGlyph.subpixel();
@@ -2762,6 +2774,7 @@ namespace neogfx
                             if (drawOp.appearance->smart_underline() &&
                                 !is_whitespace(glyphChar) && !is_emoji(glyphChar) &&
                                 (glyphFont.style() & font_style::EmulatedItalic) != font_style::EmulatedItalic &&
+                                !glyphText.glyph(glyphChar).distance_field() &&
                                 logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGui)
                             {
                                 auto const& theGlyph = glyphText.glyph(glyphChar);
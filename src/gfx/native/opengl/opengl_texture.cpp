@@ -19,6 +19,7 @@
 
 #include <neogfx/neogfx.hpp>
 
+#include <neogfx/app/profiler.hpp>
 #include <neogfx/gfx/i_texture_manager.hpp>
 #include <neogfx/gfx/i_rendering_engine.hpp>
 #include "opengl_error.hpp"
@@ -355,6 +356,7 @@ namespace neogfx
                     }
                 }
 
+                scoped_profiler_zone uploadZone{ "texture_upload", "texture" };
                 glCheck(glTexImage2D(target, 0, internalformat,
                     static_cast<GLsizei>(iStorageSize.cx), static_cast<GLsizei>(iStorageSize.cy),
                     0, format, type, data.data()));
@@ -588,6 +590,7 @@ namespace neogfx
         auto const adjustedRect = aRect + (sampling() != texture_sampling::Data ? point{ bleed_guard(), bleed_guard() } : point{ 0.0, 0.0 });
         if (sampling() != texture_sampling::Multisample)
         {
+            scoped_profiler_zone uploadZone{ "texture_upload", "texture" };
             GLint previousPackAlignment;
             GLint previousPackRowLength;
             glCheck(glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousPackAlignment));
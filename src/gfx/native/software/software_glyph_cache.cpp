@@ -0,0 +1,122 @@
+// software_glyph_cache.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+
+#include <neogfx/gfx/text/i_glyph.hpp>
+#include "../../text/native/native_font_face.hpp"
+#include "software_glyph_cache.hpp"
+
+namespace neogfx
+{
+    namespace
+    {
+        // Bitmap rows are stored bottom row first; subpixel bitmaps are reduced to their average coverage.
+        std::shared_ptr<software_mask const> from_bitmap(native_font_face::glyph_bitmap const& aBitmap)
+        {
+            auto result = std::make_shared<software_mask>();
+            result->width = static_cast<std::int32_t>(aBitmap.extents.cx);
+            result->height = static_cast<std::int32_t>(aBitmap.extents.cy);
+            auto const width = static_cast<std::size_t>(result->width);
+            auto const height = static_cast<std::size_t>(result->height);
+            std::size_t const bytesPerPixel = aBitmap.pixelMode == glyph_pixel_mode::LCD ? 4u : 1u;
+            if (aBitmap.data.size() < width * height * bytesPerPixel)
+                return {};
+            result->coverage.resize(width * height);
+            for (std::size_t y = 0u; y < height; ++y)
+            {
+                auto const source = aBitmap.data.data() + (height - 1u - y) * width * bytesPerPixel;
+                auto const destination = result->coverage.data() + y * width;
+                if (bytesPerPixel == 1u)
+                    std::copy(source, source + width, destination);
+                else
+                    for (std::size_t x = 0u; x < width; ++x)
+                        destination[x] = static_cast<std::uint8_t>(
+                            (static_cast<std::uint32_t>(source[x * 4u]) + source[x * 4u + 1u] + source[x * 4u + 2u]) / 3u);
+            }
+            return result;
+        }
+
+        // Distance field texels are 0.5 on the glyph's edge falling to 0.0 DISTANCE_FIELD_SPREAD pixels outside it;
+        // the field is sampled bilinearly at each box pixel and thresholded with a one pixel wide ramp.
+        std::shared_ptr<software_mask const> from_distance_field(native_font_face::glyph_bitmap const& aBitmap, std::int32_t aWidth, std::int32_t aHeight)
+        {
+            auto const sourceWidth = static_cast<std::int32_t>(aBitmap.extents.cx);
+            auto const sourceHeight = static_cast<std::int32_t>(aBitmap.extents.cy);
+            if (aWidth <= 0 || aHeight <= 0 || sourceWidth <= 0 || sourceHeight <= 0 ||
+                aBitmap.data.size() < static_cast<std::size_t>(sourceWidth) * static_cast<std::size_t>(sourceHeight))
+                return {};
+            auto result = std::make_shared<software_mask>();
+            result->width = aWidth;
+            result->height = aHeight;
+            result->coverage.resize(static_cast<std::size_t>(aWidth) * static_cast<std::size_t>(aHeight));
+            float const scaleX = static_cast<float>(sourceWidth) / static_cast<float>(aWidth);
+            float const scaleY = static_cast<float>(sourceHeight) / static_cast<float>(aHeight);
+            float const ramp = std::max(0.5f / static_cast<float>(i_glyph::DISTANCE_FIELD_SPREAD) * std::max(scaleX, scaleY), 1.0f / 255.0f);
+            auto const texel = [&](std::int32_t aX, std::int32_t aY)
+            {
+                aX = std::clamp(aX, 0, sourceWidth - 1);
+                aY = std::clamp(aY, 0, sourceHeight - 1);
+                return static_cast<float>(aBitmap.data[static_cast<std::size_t>(sourceHeight - 1 - aY) * static_cast<std::size_t>(sourceWidth) + static_cast<std::size_t>(aX)]) / 255.0f;
+            };
+            for (std::int32_t y = 0; y < aHeight; ++y)
+            {
+                float const v = (static_cast<float>(y) + 0.5f) * scaleY - 0.5f;
+                auto const y0 = static_cast<std::int32_t>(std::floor(v));
+                float const fy = v - static_cast<float>(y0);
+                for (std::int32_t x = 0; x < aWidth; ++x)
+                {
+                    float const u = (static_cast<float>(x) + 0.5f) * scaleX - 0.5f;
+                    auto const x0 = static_cast<std::int32_t>(std::floor(u));
+                    float const fx = u - static_cast<float>(x0);
+                    float const distance =
+                        (texel(x0, y0) * (1.0f - fx) + texel(x0 + 1, y0) * fx) * (1.0f - fy) +
+                        (texel(x0, y0 + 1) * (1.0f - fx) + texel(x0 + 1, y0 + 1) * fx) * fy;
+                    float const coverage = std::clamp((distance - 0.5f) / ramp + 0.5f, 0.0f, 1.0f);
+                    result->coverage[static_cast<std::size_t>(y) * static_cast<std::size_t>(aWidth) + static_cast<std::size_t>(x)] =
+                        static_cast<std::uint8_t>(coverage * 255.0f + 0.5f);
+                }
+            }
+            return result;
+        }
+    }
+
+    std::shared_ptr<software_mask const> software_glyph_cache::mask(i_native_font_face& aFace, glyph_index_t aGlyphIndex, std::int32_t aWidth, std::int32_t aHeight)
+    {
+        auto const& face = static_cast<native_font_face const&>(aFace);
+        bool const distanceField = face.distance_field();
+        auto const key = std::make_tuple(static_cast<void const*>(&aFace), aGlyphIndex, distanceField ? aWidth : 0, distanceField ? aHeight : 0);
+        auto existing = iMasks.find(key);
+        if (existing != iMasks.end())
+            return existing->second.mask;
+        if (iMasks.size() >= CAPACITY)
+            iMasks.clear();
+        std::shared_ptr<software_mask const> result;
+        auto const rasterized = face.rasterizing_face().rasterize(aGlyphIndex);
+        if (rasterized)
+            result = distanceField ? from_distance_field(rasterized->bitmap, aWidth, aHeight) : from_bitmap(rasterized->bitmap);
+        iMasks.emplace(key, entry{ ref_ptr<i_native_font_face>{ aFace }, result });
+        return result;
+    }
+
+    void software_glyph_cache::clear()
+    {
+        iMasks.clear();
+    }
+}
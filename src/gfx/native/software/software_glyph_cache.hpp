@@ -0,0 +1,54 @@
+// software_glyph_cache.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+#include <map>
+#include <tuple>
+#include <memory>
+
+#include "../../text/native/i_native_font_face.hpp"
+#include "software_raster.hpp"
+
+namespace neogfx
+{
+    // Glyph coverage masks rasterized on the CPU from FreeType bitmaps (never read back from a glyph atlas); owned
+    // by the render target so masks are reused across flushes. Faces with cached masks are kept alive by the cache.
+    class software_glyph_cache
+    {
+    public:
+        typedef i_native_font_face::glyph_index_t glyph_index_t;
+    public:
+        static constexpr std::size_t CAPACITY = 4096u;
+    public:
+        // The mask of a glyph drawn into an aWidth by aHeight box; distance field glyphs are resampled to the box,
+        // other glyphs are their bitmap. Null if the glyph has no bitmap.
+        std::shared_ptr<software_mask const> mask(i_native_font_face& aFace, glyph_index_t aGlyphIndex, std::int32_t aWidth, std::int32_t aHeight);
+        void clear();
+    private:
+        struct entry
+        {
+            ref_ptr<i_native_font_face> face;
+            std::shared_ptr<software_mask const> mask;
+        };
+        std::map<std::tuple<void const*, glyph_index_t, std::int32_t, std::int32_t>, entry> iMasks;
+    };
+}
@@ -0,0 +1,625 @@
+// software_raster.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+
+#include <cmath>
+#include <execution>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NEOGFX_SOFTWARE_RASTER_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "software_raster.hpp"
+
+namespace neogfx
+{
+    namespace
+    {
+        inline float clamp01(float aValue)
+        {
+            return aValue < 0.0f ? 0.0f : aValue > 1.0f ? 1.0f : aValue;
+        }
+
+        inline software_rgba lut_at(software_gradient_lut const& aLut, float aPosition)
+        {
+            auto const n = clamp01(aPosition) * static_cast<float>(SOFTWARE_GRADIENT_LUT_SIZE - 1u);
+            auto const i = static_cast<std::size_t>(n);
+            auto const j = std::min(i + 1u, SOFTWARE_GRADIENT_LUT_SIZE - 1u);
+            auto const f = n - static_cast<float>(i);
+            auto const& c0 = aLut[i];
+            auto const& c1 = aLut[j];
+            return software_rgba{ c0.r + (c1.r - c0.r) * f, c0.g + (c1.g - c0.g) * f, c0.b + (c1.b - c0.b) * f, c0.a + (c1.a - c0.a) * f };
+        }
+
+        // Signed-area coverage accumulation: each edge deposits the area it covers to its right
+        // into a per-row delta buffer; a running sum along the row yields exact pixel coverage.
+        class coverage_accumulator
+        {
+        public:
+            void reset(std::int32_t aWidth, std::int32_t aHeight)
+            {
+                iWidth = aWidth;
+                iHeight = aHeight;
+                iStride = aWidth + 2;
+                iDeltas.assign(static_cast<std::size_t>(iStride) * static_cast<std::size_t>(aHeight), 0.0f);
+            }
+            // Segment in local coordinates; portions left of the region collapse onto x = 0, portions right of it are discarded.
+            void add(software_point aP0, software_point aP1)
+            {
+                if (aP0.y == aP1.y)
+                    return;
+                auto const w = static_cast<float>(iWidth);
+                auto const split = [&](float aX, software_point const& aA, software_point const& aB)
+                {
+                    float const t = (aX - aA.x) / (aB.x - aA.x);
+                    return software_point{ aX, aA.y + (aB.y - aA.y) * t };
+                };
+                std::array<software_point, 4> points{ aP0 };
+                std::size_t count = 1u;
+                std::array<float, 2> crossings = { 0.0f, w };
+                if (aP1.x < aP0.x)
+                    std::swap(crossings[0], crossings[1]);
+                for (auto x : crossings)
+                    if ((aP0.x < x && aP1.x > x) || (aP0.x > x && aP1.x < x))
+                        points[count++] = split(x, aP0, aP1);
+                points[count++] = aP1;
+                for (std::size_t i = 0u; i + 1u < count; ++i)
+                {
+                    auto a = points[i];
+                    auto b = points[i + 1u];
+                    float const mid = (a.x + b.x) * 0.5f;
+                    if (mid >= w)
+                        continue;
+                    if (mid <= 0.0f)
+                        a.x = b.x = 0.0f;
+                    a.x = std::clamp(a.x, 0.0f, w);
+                    b.x = std::clamp(b.x, 0.0f, w);
+                    line(a, b);
+                }
+            }
+            float const* row(std::int32_t aY) const
+            {
+                return &iDeltas[static_cast<std::size_t>(aY) * static_cast<std::size_t>(iStride)];
+            }
+        private:
+            void line(software_point aP0, software_point aP1)
+            {
+                if (aP0.y == aP1.y)
+                    return;
+                float direction = 1.0f;
+                if (aP0.y > aP1.y)
+                {
+                    direction = -1.0f;
+                    std::swap(aP0, aP1);
+                }
+                if (aP1.y <= 0.0f || aP0.y >= static_cast<float>(iHeight))
+                    return;
+                float const dxdy = (aP1.x - aP0.x) / (aP1.y - aP0.y);
+                float x = aP0.x;
+                if (aP0.y < 0.0f)
+                    x = std::clamp(x - aP0.y * dxdy, 0.0f, static_cast<float>(iWidth));
+                std::int32_t const yStart = std::max(0, static_cast<std::int32_t>(aP0.y));
+                std::int32_t const yEnd = std::min(iHeight, static_cast<std::int32_t>(std::ceil(aP1.y)));
+                for (std::int32_t y = yStart; y < yEnd; ++y)
+                {
+                    float* const deltas = &iDeltas[static_cast<std::size_t>(y) * static_cast<std::size_t>(iStride)];
+                    float const dy = std::min(static_cast<float>(y + 1), aP1.y) - std::max(static_cast<float>(y), aP0.y);
+                    float const xNext = std::clamp(x + dxdy * dy, 0.0f, static_cast<float>(iWidth));
+                    float const d = dy * direction;
+                    float const x0 = std::min(x, xNext);
+                    float const x1 = std::max(x, xNext);
+                    float const x0Floor = std::floor(x0);
+                    std::int32_t const x0i = static_cast<std::int32_t>(x0Floor);
+                    float const x1Ceil = std::ceil(x1);
+                    std::int32_t const x1i = static_cast<std::int32_t>(x1Ceil);
+                    if (x1i <= x0i + 1)
+                    {
+                        float const xmf = 0.5f * (x + xNext) - x0Floor;
+                        deltas[x0i] += d - d * xmf;
+                        deltas[x0i + 1] += d * xmf;
+                    }
+                    else
+                    {
+                        float const s = 1.0f / (x1 - x0);
+                        float const x0f = x0 - x0Floor;
+                        float const a0 = 0.5f * s * (1.0f - x0f) * (1.0f - x0f);
+                        float const x1f = x1 - x1Ceil + 1.0f;
+                        float const am = 0.5f * s * x1f * x1f;
+                        deltas[x0i] += d * a0;
+                        if (x1i == x0i + 2)
+                            deltas[x0i + 1] += d * (1.0f - a0 - am);
+                        else
+                        {
+                            float const a1 = s * (1.5f - x0f);
+                            deltas[x0i + 1] += d * (a1 - a0);
+                            for (std::int32_t xi = x0i + 2; xi < x1i - 1; ++xi)
+                                deltas[xi] += d * s;
+                            float const a2 = a1 + static_cast<float>(x1i - x0i - 3) * s;
+                            deltas[x1i - 1] += d * (1.0f - a2 - am);
+                        }
+                        deltas[x1i] += d * am;
+                    }
+                    x = xNext;
+                }
+            }
+        private:
+            std::int32_t iWidth = 0;
+            std::int32_t iHeight = 0;
+            std::int32_t iStride = 0;
+            std::vector<float> iDeltas;
+        };
+
+        struct tile_scratch
+        {
+            coverage_accumulator accumulator;
+            std::vector<float> coverage;
+            std::vector<software_rgba> shade;
+        };
+
+        inline software_box segment_bounds(std::vector<software_segment> const& aSegments)
+        {
+            if (aSegments.empty())
+                return software_box{};
+            float minX = aSegments[0].p0.x, minY = aSegments[0].p0.y, maxX = minX, maxY = minY;
+            for (auto const& s : aSegments)
+                for (auto const& p : { s.p0, s.p1 })
+                {
+                    minX = std::min(minX, p.x);
+                    minY = std::min(minY, p.y);
+                    maxX = std::max(maxX, p.x);
+                    maxY = std::max(maxY, p.y);
+                }
+            return software_box{
+                static_cast<std::int32_t>(std::floor(minX)), static_cast<std::int32_t>(std::floor(minY)),
+                static_cast<std::int32_t>(std::ceil(maxX)) + 1, static_cast<std::int32_t>(std::ceil(maxY)) + 1 };
+        }
+    }
+
+    software_pixel to_software_pixel(software_rgba const& aColor)
+    {
+        auto const c = [](float aValue) { return static_cast<std::uint32_t>(clamp01(aValue) * 255.0f + 0.5f); };
+        return c(aColor.r) | (c(aColor.g) << 8u) | (c(aColor.b) << 16u) | (c(aColor.a) << 24u);
+    }
+
+    software_rgba from_software_pixel(software_pixel aPixel)
+    {
+        constexpr float scale = 1.0f / 255.0f;
+        return software_rgba{
+            static_cast<float>(aPixel & 0xFFu) * scale,
+            static_cast<float>((aPixel >> 8u) & 0xFFu) * scale,
+            static_cast<float>((aPixel >> 16u) & 0xFFu) * scale,
+            static_cast<float>((aPixel >> 24u) & 0xFFu) * scale };
+    }
+
+    software_rgba premultiplied(float aRed, float aGreen, float aBlue, float aAlpha)
+    {
+        return software_rgba{ aRed * aAlpha, aGreen * aAlpha, aBlue * aAlpha, aAlpha };
+    }
+
+    void software_fill_span(software_pixel* aDestination, std::int32_t aCount, software_pixel aValue)
+    {
+        std::int32_t i = 0;
+#ifdef NEOGFX_SOFTWARE_RASTER_SSE2
+        __m128i const value = _mm_set1_epi32(static_cast<int>(aValue));
+        for (; i + 4 <= aCount; i += 4)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(aDestination + i), value);
+#endif
+        for (; i < aCount; ++i)
+            aDestination[i] = aValue;
+    }
+
+    void software_blend_span(software_pixel* aDestination, std::int32_t aCount, software_rgba const& aSource, float aCoverage)
+    {
+        software_rgba const source{ aSource.r * aCoverage, aSource.g * aCoverage, aSource.b * aCoverage, aSource.a * aCoverage };
+        if (source.a >= 1.0f)
+        {
+            software_fill_span(aDestination, aCount, to_software_pixel(source));
+            return;
+        }
+        if (source.a <= 0.0f && source.r <= 0.0f && source.g <= 0.0f && source.b <= 0.0f)
+            return;
+        std::int32_t i = 0;
+#ifdef NEOGFX_SOFTWARE_RASTER_SSE2
+        // dst = src + dst * (1 - srcA), four pixels at a time in 16-bit fixed point.
+        software_pixel const sourcePixel = to_software_pixel(source);
+        std::uint16_t const inverseAlpha = static_cast<std::uint16_t>(255u - (sourcePixel >> 24u));
+        __m128i const zero = _mm_setzero_si128();
+        __m128i const src = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(sourcePixel)), zero);
+        __m128i const inv = _mm_set1_epi16(static_cast<short>(inverseAlpha));
+        __m128i const bias = _mm_set1_epi16(128);
+        for (; i + 4 <= aCount; i += 4)
+        {
+            __m128i const dst = _mm_loadu_si128(reinterpret_cast<__m128i const*>(aDestination + i));
+            __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), inv);
+            __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), inv);
+            lo = _mm_add_epi16(lo, bias);
+            hi = _mm_add_epi16(hi, bias);
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+            lo = _mm_add_epi16(lo, src);
+            hi = _mm_add_epi16(hi, src);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(aDestination + i), _mm_packus_epi16(lo, hi));
+        }
+#endif
+        for (; i < aCount; ++i)
+        {
+            auto const d = from_software_pixel(aDestination[i]);
+            float const inverse = 1.0f - source.a;
+            aDestination[i] = to_software_pixel(software_rgba{
+                source.r + d.r * inverse, source.g + d.g * inverse, source.b + d.b * inverse, source.a + d.a * inverse });
+        }
+    }
+
+    void software_blend_span(software_pixel* aDestination, std::int32_t aCount, software_rgba const* aSource, float const* aCoverage, software_blend aBlend)
+    {
+        for (std::int32_t i = 0; i < aCount; ++i)
+        {
+            float const coverage = aCoverage[i];
+            if (coverage <= 0.0f)
+                continue;
+            auto const& s = aSource[i];
+            auto const d = from_software_pixel(aDestination[i]);
+            if (aBlend == software_blend::Copy)
+            {
+                float const inverse = 1.0f - coverage;
+                aDestination[i] = to_software_pixel(software_rgba{
+                    s.r * coverage + d.r * inverse, s.g * coverage + d.g * inverse, s.b * coverage + d.b * inverse, s.a * coverage + d.a * inverse });
+            }
+            else
+            {
+                float const inverse = 1.0f - s.a * coverage;
+                aDestination[i] = to_software_pixel(software_rgba{
+                    s.r * coverage + d.r * inverse, s.g * coverage + d.g * inverse, s.b * coverage + d.b * inverse, s.a * coverage + d.a * inverse });
+            }
+        }
+    }
+
+    software_paint::software_paint() :
+        iPaint{ solid{} }
+    {
+    }
+
+    software_paint::software_paint(software_rgba const& aColor) :
+        iPaint{ solid{ aColor } }
+    {
+    }
+
+    software_paint::software_paint(gradient const& aGradient) :
+        iPaint{ aGradient }
+    {
+    }
+
+    software_paint::software_paint(texture const& aTexture) :
+        iPaint{ aTexture }
+    {
+    }
+
+    bool software_paint::is_solid() const
+    {
+        return std::holds_alternative<solid>(iPaint);
+    }
+
+    software_rgba const& software_paint::solid_color() const
+    {
+        return std::get<solid>(iPaint).color;
+    }
+
+    void software_paint::shade(std::int32_t aX, std::int32_t aY, std::int32_t aCount, software_rgba* aOutput) const
+    {
+        if (std::holds_alternative<solid>(iPaint))
+        {
+            std::fill(aOutput, aOutput + aCount, std::get<solid>(iPaint).color);
+            return;
+        }
+        float const y = static_cast<float>(aY) + 0.5f;
+        if (std::holds_alternative<gradient>(iPaint))
+        {
+            auto const& g = std::get<gradient>(iPaint);
+            for (std::int32_t i = 0; i < aCount; ++i)
+            {
+                float const x = static_cast<float>(aX + i) + 0.5f;
+                float const dx = x - g.origin.x;
+                float const dy = y - g.origin.y;
+                float position = 0.0f;
+                switch (g.kind)
+                {
+                case gradient_kind::Linear:
+                    position = dx * g.axis.x + dy * g.axis.y;
+                    break;
+                case gradient_kind::Rectangular:
+                    position = 1.0f - std::max(std::abs(dx) * g.axis.x, std::abs(dy) * g.axis.y);
+                    break;
+                case gradient_kind::Radial:
+                    position = std::sqrt((dx * g.axis.x) * (dx * g.axis.x) + (dy * g.axis.y) * (dy * g.axis.y));
+                    break;
+                }
+                aOutput[i] = lut_at(*g.lut, position);
+            }
+            return;
+        }
+        auto const& t = std::get<texture>(iPaint);
+        auto const& texels = *t.texels;
+        constexpr float scale = 1.0f / 255.0f;
+        for (std::int32_t i = 0; i < aCount; ++i)
+        {
+            float const x = static_cast<float>(aX + i) + 0.5f;
+            auto const u = std::clamp(static_cast<std::int32_t>(std::floor(x * t.scale.x + t.offset.x)), 0, texels.width - 1);
+            auto const v = std::clamp(static_cast<std::int32_t>(std::floor(y * t.scale.y + t.offset.y)), 0, texels.height - 1);
+            auto const texel = texels.texels[static_cast<std::size_t>(v) * static_cast<std::size_t>(texels.width) + static_cast<std::size_t>(u)];
+            auto texelColor = premultiplied(
+                static_cast<float>(texel & 0xFFu) * scale,
+                static_cast<float>((texel >> 8u) & 0xFFu) * scale,
+                static_cast<float>((texel >> 16u) & 0xFFu) * scale,
+                static_cast<float>((texel >> 24u) & 0xFFu) * scale);
+            if (t.tint)
+            {
+                texelColor.r *= t.tint->r;
+                texelColor.g *= t.tint->g;
+                texelColor.b *= t.tint->b;
+                texelColor.a *= t.tint->a;
+            }
+            aOutput[i] = texelColor;
+        }
+    }
+
+    void software_display_list::clear()
+    {
+        iCommands.clear();
+    }
+
+    bool software_display_list::empty() const
+    {
+        return iCommands.empty();
+    }
+
+    std::vector<software_command> const& software_display_list::commands() const
+    {
+        return iCommands;
+    }
+
+    void software_display_list::fill(std::vector<contour> const& aContours, software_box const& aClip, software_paint const& aPaint, float aOpacity, software_blend aBlend, bool aAntiAliased)
+    {
+        software_command command;
+        for (auto const& c : aContours)
+        {
+            if (c.size() < 3u)
+                continue;
+            for (std::size_t i = 0u; i < c.size(); ++i)
+                command.segments.push_back(software_segment{ c[i], c[(i + 1u) % c.size()] });
+        }
+        if (command.segments.empty())
+            return;
+        command.bounds = segment_bounds(command.segments).intersection(aClip);
+        if (command.bounds.empty())
+            return;
+        command.clip = aClip;
+        command.paint = aPaint;
+        command.opacity = aOpacity;
+        command.blend = aBlend;
+        command.antiAliased = aAntiAliased;
+        iCommands.push_back(std::move(command));
+    }
+
+    void software_display_list::fill(contour const& aContour, software_box const& aClip, software_paint const& aPaint, float aOpacity, software_blend aBlend, bool aAntiAliased)
+    {
+        fill(std::vector<contour>{ aContour }, aClip, aPaint, aOpacity, aBlend, aAntiAliased);
+    }
+
+    void software_display_list::fill_rect(software_box const& aRect, software_box const& aClip, software_paint const& aPaint, float aOpacity, software_blend aBlend)
+    {
+        auto const x0 = static_cast<float>(aRect.x0);
+        auto const y0 = static_cast<float>(aRect.y0);
+        auto const x1 = static_cast<float>(aRect.x1);
+        auto const y1 = static_cast<float>(aRect.y1);
+        fill(contour{ { x0, y0 }, { x1, y0 }, { x1, y1 }, { x0, y1 } }, aClip, aPaint, aOpacity, aBlend, false);
+    }
+
+    void software_display_list::fill_mask(std::shared_ptr<software_mask const> aMask, std::int32_t aX, std::int32_t aY, software_box const& aClip, software_paint const& aPaint, float aOpacity)
+    {
+        if (!aMask || aMask->width <= 0 || aMask->height <= 0)
+            return;
+        software_command command;
+        command.bounds = software_box{ aX, aY, aX + aMask->width, aY + aMask->height }.intersection(aClip);
+        if (command.bounds.empty())
+            return;
+        command.clip = aClip;
+        command.paint = aPaint;
+        command.opacity = aOpacity;
+        command.mask = std::move(aMask);
+        command.maskX = aX;
+        command.maskY = aY;
+        iCommands.push_back(std::move(command));
+    }
+
+    software_raster::software_raster(std::int32_t aWidth, std::int32_t aHeight) :
+        iWidth{ 0 }, iHeight{ 0 }
+    {
+        resize(aWidth, aHeight);
+    }
+
+    std::int32_t software_raster::width() const
+    {
+        return iWidth;
+    }
+
+    std::int32_t software_raster::height() const
+    {
+        return iHeight;
+    }
+
+    software_box software_raster::bounds() const
+    {
+        return software_box{ 0, 0, iWidth, iHeight };
+    }
+
+    void software_raster::resize(std::int32_t aWidth, std::int32_t aHeight)
+    {
+        if (aWidth < 0 || aHeight < 0)
+            throw bad_extents();
+        iWidth = aWidth;
+        iHeight = aHeight;
+        iPixels.assign(static_cast<std::size_t>(aWidth) * static_cast<std::size_t>(aHeight), 0u);
+    }
+
+    software_pixel const* software_raster::pixels() const
+    {
+        return iPixels.data();
+    }
+
+    software_pixel* software_raster::pixels()
+    {
+        return iPixels.data();
+    }
+
+    software_pixel software_raster::pixel(std::int32_t aX, std::int32_t aY) const
+    {
+        return iPixels[static_cast<std::size_t>(aY) * static_cast<std::size_t>(iWidth) + static_cast<std::size_t>(aX)];
+    }
+
+    std::vector<std::uint8_t> software_raster::to_rgba() const
+    {
+        std::vector<std::uint8_t> result(iPixels.size() * 4u);
+        for (std::size_t i = 0u; i < iPixels.size(); ++i)
+        {
+            auto const p = from_software_pixel(iPixels[i]);
+            float const inverseAlpha = (p.a > 0.0f ? 1.0f / p.a : 0.0f);
+            result[i * 4u + 0u] = static_cast<std::uint8_t>(clamp01(p.r * inverseAlpha) * 255.0f + 0.5f);
+            result[i * 4u + 1u] = static_cast<std::uint8_t>(clamp01(p.g * inverseAlpha) * 255.0f + 0.5f);
+            result[i * 4u + 2u] = static_cast<std::uint8_t>(clamp01(p.b * inverseAlpha) * 255.0f + 0.5f);
+            result[i * 4u + 3u] = static_cast<std::uint8_t>(iPixels[i] >> 24u);
+        }
+        return result;
+    }
+
+    void software_raster::clear(software_rgba const& aColor)
+    {
+        clear(aColor, bounds());
+    }
+
+    void software_raster::clear(software_rgba const& aColor, software_box const& aRect)
+    {
+        auto const r = aRect.intersection(bounds());
+        auto const value = to_software_pixel(aColor);
+        for (std::int32_t y = r.y0; y < r.y1; ++y)
+            software_fill_span(&iPixels[static_cast<std::size_t>(y) * static_cast<std::size_t>(iWidth) + static_cast<std::size_t>(r.x0)], r.x1 - r.x0, value);
+    }
+
+    void software_raster::render(software_display_list const& aDisplayList, std::int32_t aTileSize, bool aParallel)
+    {
+        if (aDisplayList.empty() || iWidth == 0 || iHeight == 0)
+            return;
+        std::vector<software_box> tiles;
+        for (std::int32_t y = 0; y < iHeight; y += aTileSize)
+            for (std::int32_t x = 0; x < iWidth; x += aTileSize)
+                tiles.push_back(software_box{ x, y, std::min(x + aTileSize, iWidth), std::min(y + aTileSize, iHeight) });
+        auto const renderTile = [&](software_box const& aTile) { render_tile(aDisplayList, aTile); };
+        if (aParallel && tiles.size() > 1u)
+            std::for_each(std::execution::par, tiles.begin(), tiles.end(), renderTile);
+        else
+            std::for_each(tiles.begin(), tiles.end(), renderTile);
+    }
+
+    void software_raster::render_tile(software_display_list const& aDisplayList, software_box const& aTile)
+    {
+        thread_local tile_scratch tScratch;
+        for (auto const& command : aDisplayList.commands())
+        {
+            auto const region = command.bounds.intersection(aTile);
+            if (region.empty())
+                continue;
+            std::int32_t const regionWidth = region.x1 - region.x0;
+            std::int32_t const regionHeight = region.y1 - region.y0;
+            bool const solid = command.paint.is_solid();
+            software_rgba solidColor;
+            if (solid)
+            {
+                solidColor = command.paint.solid_color();
+                solidColor.r *= command.opacity;
+                solidColor.g *= command.opacity;
+                solidColor.b *= command.opacity;
+                solidColor.a *= command.opacity;
+            }
+            tScratch.coverage.resize(static_cast<std::size_t>(regionWidth));
+            tScratch.shade.resize(static_cast<std::size_t>(regionWidth));
+            if (!command.mask)
+            {
+                tScratch.accumulator.reset(regionWidth, regionHeight);
+                auto const ox = static_cast<float>(region.x0);
+                auto const oy = static_cast<float>(region.y0);
+                for (auto const& s : command.segments)
+                    tScratch.accumulator.add(software_point{ s.p0.x - ox, s.p0.y - oy }, software_point{ s.p1.x - ox, s.p1.y - oy });
+            }
+            for (std::int32_t y = 0; y < regionHeight; ++y)
+            {
+                auto const deviceY = region.y0 + y;
+                software_pixel* const destination = &iPixels[static_cast<std::size_t>(deviceY) * static_cast<std::size_t>(iWidth) + static_cast<std::size_t>(region.x0)];
+                float* const coverage = tScratch.coverage.data();
+                if (!command.mask)
+                {
+                    float const* const deltas = tScratch.accumulator.row(y);
+                    float accumulated = 0.0f;
+                    for (std::int32_t x = 0; x < regionWidth; ++x)
+                    {
+                        accumulated += deltas[x];
+                        float const c = std::min(std::abs(accumulated), 1.0f);
+                        coverage[x] = command.antiAliased ? c : (c >= 0.5f ? 1.0f : 0.0f);
+                    }
+                }
+                else
+                {
+                    auto const& mask = *command.mask;
+                    std::uint8_t const* const maskRow = &mask.coverage[static_cast<std::size_t>(deviceY - command.maskY) * static_cast<std::size_t>(mask.width)];
+                    for (std::int32_t x = 0; x < regionWidth; ++x)
+                        coverage[x] = static_cast<float>(maskRow[region.x0 + x - command.maskX]) * (1.0f / 255.0f);
+                }
+                if (solid && command.blend == software_blend::SourceOver)
+                {
+                    // Coalesce runs of identical coverage so that interiors go through the SIMD span path.
+                    for (std::int32_t x = 0; x < regionWidth;)
+                    {
+                        std::int32_t end = x + 1;
+                        while (end < regionWidth && coverage[end] == coverage[x])
+                            ++end;
+                        if (coverage[x] > 0.0f)
+                            software_blend_span(destination + x, end - x, solidColor, coverage[x]);
+                        x = end;
+                    }
+                    continue;
+                }
+                if (solid)
+                    std::fill(tScratch.shade.begin(), tScratch.shade.end(), solidColor);
+                else
+                {
+                    command.paint.shade(region.x0, deviceY, regionWidth, tScratch.shade.data());
+                    if (command.opacity != 1.0f)
+                        for (auto& s : tScratch.shade)
+                        {
+                            s.r *= command.opacity;
+                            s.g *= command.opacity;
+                            s.b *= command.opacity;
+                            s.a *= command.opacity;
+                        }
+                }
+                software_blend_span(destination, regionWidth, tScratch.shade.data(), coverage, command.blend);
+            }
+        }
+    }
+}
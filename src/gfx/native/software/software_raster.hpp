@@ -0,0 +1,217 @@
+// software_raster.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+#include <cstdint>
+#include <vector>
+#include <array>
+#include <memory>
+#include <optional>
+#include <variant>
+#include <algorithm>
+#include <stdexcept>
+
+namespace neogfx
+{
+    // Premultiplied RGBA8 pixel; red in the least significant byte.
+    typedef std::uint32_t software_pixel;
+
+    struct software_point
+    {
+        float x;
+        float y;
+    };
+
+    struct software_segment
+    {
+        software_point p0;
+        software_point p1;
+    };
+
+    // Premultiplied color.
+    struct software_rgba
+    {
+        float r = 0.0f;
+        float g = 0.0f;
+        float b = 0.0f;
+        float a = 0.0f;
+    };
+
+    // Half-open integer device rectangle.
+    struct software_box
+    {
+        std::int32_t x0 = 0;
+        std::int32_t y0 = 0;
+        std::int32_t x1 = 0;
+        std::int32_t y1 = 0;
+
+        bool empty() const
+        {
+            return x1 <= x0 || y1 <= y0;
+        }
+        software_box intersection(software_box const& aOther) const
+        {
+            software_box result{ std::max(x0, aOther.x0), std::max(y0, aOther.y0), std::min(x1, aOther.x1), std::min(y1, aOther.y1) };
+            if (result.empty())
+                return software_box{};
+            return result;
+        }
+    };
+
+    enum class software_blend : std::uint32_t
+    {
+        SourceOver,
+        Copy
+    };
+
+    constexpr std::size_t SOFTWARE_GRADIENT_LUT_SIZE = 256u;
+    typedef std::array<software_rgba, SOFTWARE_GRADIENT_LUT_SIZE> software_gradient_lut;
+
+    // Straight (non-premultiplied) RGBA8 texels sampled by texture paints; row 0 is the top row.
+    struct software_texels
+    {
+        std::int32_t width = 0;
+        std::int32_t height = 0;
+        std::vector<std::uint32_t> texels;
+    };
+
+    class software_paint
+    {
+    public:
+        enum class gradient_kind : std::uint32_t
+        {
+            Linear,
+            Rectangular,
+            Radial
+        };
+        struct solid
+        {
+            software_rgba color;
+        };
+        struct gradient
+        {
+            std::shared_ptr<software_gradient_lut const> lut;
+            gradient_kind kind;
+            software_point origin;
+            // Linear: position = dot(p - origin, axis); Rectangular/Radial: axis holds reciprocal half extents/radii.
+            software_point axis;
+        };
+        struct texture
+        {
+            std::shared_ptr<software_texels const> texels;
+            // Device to texel mapping: u = x * scale.x + offset.x, v = y * scale.y + offset.y.
+            software_point scale;
+            software_point offset;
+            std::optional<software_rgba> tint;
+        };
+    public:
+        software_paint();
+        software_paint(software_rgba const& aColor);
+        software_paint(gradient const& aGradient);
+        software_paint(texture const& aTexture);
+    public:
+        bool is_solid() const;
+        software_rgba const& solid_color() const;
+        void shade(std::int32_t aX, std::int32_t aY, std::int32_t aCount, software_rgba* aOutput) const;
+    private:
+        std::variant<solid, gradient, texture> iPaint;
+    };
+
+    // Per-pixel coverage mask (e.g. a rasterized glyph); row 0 is the top row.
+    struct software_mask
+    {
+        std::int32_t width = 0;
+        std::int32_t height = 0;
+        std::vector<std::uint8_t> coverage;
+    };
+
+    struct software_command
+    {
+        software_box bounds;
+        software_box clip;
+        software_paint paint;
+        float opacity = 1.0f;
+        software_blend blend = software_blend::SourceOver;
+        bool antiAliased = true;
+        std::vector<software_segment> segments;
+        std::shared_ptr<software_mask const> mask;
+        std::int32_t maskX = 0;
+        std::int32_t maskY = 0;
+    };
+
+    class software_display_list
+    {
+    public:
+        typedef std::vector<software_point> contour;
+    public:
+        void clear();
+        bool empty() const;
+        std::vector<software_command> const& commands() const;
+    public:
+        // Contours are implicitly closed and filled with the non-zero winding rule.
+        void fill(std::vector<contour> const& aContours, software_box const& aClip, software_paint const& aPaint, float aOpacity = 1.0f, software_blend aBlend = software_blend::SourceOver, bool aAntiAliased = true);
+        void fill(contour const& aContour, software_box const& aClip, software_paint const& aPaint, float aOpacity = 1.0f, software_blend aBlend = software_blend::SourceOver, bool aAntiAliased = true);
+        void fill_rect(software_box const& aRect, software_box const& aClip, software_paint const& aPaint, float aOpacity = 1.0f, software_blend aBlend = software_blend::SourceOver);
+        void fill_mask(std::shared_ptr<software_mask const> aMask, std::int32_t aX, std::int32_t aY, software_box const& aClip, software_paint const& aPaint, float aOpacity = 1.0f);
+    private:
+        std::vector<software_command> iCommands;
+    };
+
+    class software_raster
+    {
+    public:
+        struct bad_extents : std::invalid_argument { bad_extents() : std::invalid_argument("neogfx::software_raster::bad_extents") {} };
+    public:
+        static constexpr std::int32_t DEFAULT_TILE_SIZE = 64;
+    public:
+        software_raster(std::int32_t aWidth = 0, std::int32_t aHeight = 0);
+    public:
+        std::int32_t width() const;
+        std::int32_t height() const;
+        software_box bounds() const;
+        void resize(std::int32_t aWidth, std::int32_t aHeight);
+        software_pixel const* pixels() const;
+        software_pixel* pixels();
+        software_pixel pixel(std::int32_t aX, std::int32_t aY) const;
+        // Returns straight (non-premultiplied) RGBA8 rows, top row first.
+        std::vector<std::uint8_t> to_rgba() const;
+    public:
+        void clear(software_rgba const& aColor);
+        void clear(software_rgba const& aColor, software_box const& aRect);
+        // Renders a display list; tiles are rasterized in parallel, commands within a tile in order.
+        void render(software_display_list const& aDisplayList, std::int32_t aTileSize = DEFAULT_TILE_SIZE, bool aParallel = true);
+    private:
+        void render_tile(software_display_list const& aDisplayList, software_box const& aTile);
+    private:
+        std::int32_t iWidth;
+        std::int32_t iHeight;
+        std::vector<software_pixel> iPixels;
+    };
+
+    software_pixel to_software_pixel(software_rgba const& aColor);
+    software_rgba from_software_pixel(software_pixel aPixel);
+    software_rgba premultiplied(float aRed, float aGreen, float aBlue, float aAlpha);
+    // Span primitives; the solid variants use SSE2 where available.
+    void software_fill_span(software_pixel* aDestination, std::int32_t aCount, software_pixel aValue);
+    void software_blend_span(software_pixel* aDestination, std::int32_t aCount, software_rgba const& aSource, float aCoverage);
+    void software_blend_span(software_pixel* aDestination, std::int32_t aCount, software_rgba const* aSource, float const* aCoverage, software_blend aBlend);
+}
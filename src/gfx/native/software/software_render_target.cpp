@@ -0,0 +1,254 @@
+// software_render_target.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+
+#include <png.h>
+
+#include <neogfx/gfx/software_render_target.hpp>
+#include "software_raster.hpp"
+#include "software_glyph_cache.hpp"
+#include "software_rendering_context.hpp"
+
+namespace neogfx
+{
+    software_render_target::software_render_target(size const& aExtents, dimension aDpi, neogfx::color_space aColorSpace) :
+        iRaster{ std::make_unique<software_raster>(static_cast<std::int32_t>(std::ceil(aExtents.cx)), static_cast<std::int32_t>(std::ceil(aExtents.cy))) },
+        iGlyphCache{ std::make_unique<software_glyph_cache>() },
+        iDpi{ aDpi },
+        iColorSpace{ aColorSpace },
+        iLogicalCoordinateSystem{ neogfx::logical_coordinate_system::AutomaticGui }
+    {
+    }
+
+    software_render_target::~software_render_target()
+    {
+        TargetDestroying();
+    }
+
+    render_target_type software_render_target::target_type() const
+    {
+        return render_target_type::Surface;
+    }
+
+    void* software_render_target::target_handle() const
+    {
+        return iRaster->pixels();
+    }
+
+    void* software_render_target::target_device_handle() const
+    {
+        return nullptr;
+    }
+
+    pixel_format_t software_render_target::pixel_format() const
+    {
+        return 0;
+    }
+
+    bool software_render_target::has_target_texture() const
+    {
+        return false;
+    }
+
+    const i_texture& software_render_target::target_texture() const
+    {
+        throw no_target_texture();
+    }
+
+    point software_render_target::target_origin() const
+    {
+        return point{};
+    }
+
+    size software_render_target::target_extents() const
+    {
+        return extents();
+    }
+
+    neogfx::logical_coordinate_system software_render_target::logical_coordinate_system() const
+    {
+        return iLogicalCoordinateSystem;
+    }
+
+    void software_render_target::set_logical_coordinate_system(neogfx::logical_coordinate_system aSystem) const
+    {
+        iLogicalCoordinateSystem = aSystem;
+    }
+
+    logical_coordinates software_render_target::logical_coordinates() const
+    {
+        if (iLogicalCoordinates.has_value())
+            return iLogicalCoordinates.value();
+
+        switch (iLogicalCoordinateSystem)
+        {
+        case neogfx::logical_coordinate_system::AutomaticGui:
+            return neogfx::logical_coordinates{
+                viewport().bottom_left().as<scalar>().to_vec2(),
+                viewport().top_right().as<scalar>().to_vec2() };
+        case neogfx::logical_coordinate_system::AutomaticGame:
+            return neogfx::logical_coordinates{
+                to_game_rect(viewport(), target_extents().cy).bottom_left().as<scalar>().to_vec2(),
+                to_game_rect(viewport(), target_extents().cy).top_right().as<scalar>().to_vec2() };
+        }
+        throw logical_coordinates_not_specified();
+    }
+
+    void software_render_target::set_logical_coordinates(const neogfx::logical_coordinates& aCoordinates) const
+    {
+        iLogicalCoordinates = aCoordinates;
+    }
+
+    viewport software_render_target::apply_viewport() const
+    {
+        // The rasterizer always addresses the whole buffer; viewports only affect logical coordinates.
+        return viewport();
+    }
+
+    bool software_render_target::target_active() const
+    {
+        return iActive;
+    }
+
+    void software_render_target::activate_target() const
+    {
+        if (iActive)
+            return;
+        TargetActivating();
+        iActive = true;
+        TargetActivated();
+    }
+
+    void software_render_target::deactivate_target() const
+    {
+        if (!iActive)
+            return;
+        TargetDeactivating();
+        iActive = false;
+        TargetDeactivated();
+    }
+
+    bool software_render_target::target_in_use() const
+    {
+        return iTargetUseCount != 0u;
+    }
+
+    void software_render_target::target_add_ref() const
+    {
+        ++iTargetUseCount;
+    }
+
+    void software_render_target::target_release() const
+    {
+        --iTargetUseCount;
+    }
+
+    color_space software_render_target::color_space() const
+    {
+        return iColorSpace;
+    }
+
+    color software_render_target::read_pixel(const point& aPosition, bool) const
+    {
+        auto const x = static_cast<std::int32_t>(aPosition.x);
+        auto const y = static_cast<std::int32_t>(aPosition.y);
+        if (x < 0 || y < 0 || x >= iRaster->width() || y >= iRaster->height())
+            return color{};
+        auto const rgba = from_software_pixel(iRaster->pixel(x, y));
+        if (rgba.a == 0.0f)
+            return color{ 0, 0, 0, 0 };
+        return color{ rgba.r / rgba.a, rgba.g / rgba.a, rgba.b / rgba.a, rgba.a };
+    }
+
+    std::unique_ptr<i_rendering_context> software_render_target::create_rendering_context(blending_mode aBlendingMode) const
+    {
+        return std::unique_ptr<i_rendering_context>(new software_rendering_context{ *this, aBlendingMode });
+    }
+
+    dimension software_render_target::horizontal_dpi() const
+    {
+        return iDpi;
+    }
+
+    dimension software_render_target::vertical_dpi() const
+    {
+        return iDpi;
+    }
+
+    dimension software_render_target::ppi() const
+    {
+        return iDpi;
+    }
+
+    bool software_render_target::metrics_available() const
+    {
+        return true;
+    }
+
+    size software_render_target::extents() const
+    {
+        return size{ static_cast<dimension>(iRaster->width()), static_cast<dimension>(iRaster->height()) };
+    }
+
+    dimension software_render_target::em_size() const
+    {
+        return 0.0;
+    }
+
+    void software_render_target::resize(size const& aExtents)
+    {
+        iRaster->resize(static_cast<std::int32_t>(std::ceil(aExtents.cx)), static_cast<std::int32_t>(std::ceil(aExtents.cy)));
+    }
+
+    void software_render_target::clear(color const& aColor)
+    {
+        iRaster->clear(premultiplied(aColor.red<float>(), aColor.green<float>(), aColor.blue<float>(), aColor.alpha<float>()));
+    }
+
+    std::vector<std::uint8_t> software_render_target::to_rgba() const
+    {
+        return iRaster->to_rgba();
+    }
+
+    void software_render_target::save_png(std::string const& aPath) const
+    {
+        auto const data = to_rgba();
+        png_image image = {};
+        image.version = PNG_IMAGE_VERSION;
+        image.width = static_cast<png_uint_32>(iRaster->width());
+        image.height = static_cast<png_uint_32>(iRaster->height());
+        image.format = PNG_FORMAT_RGBA;
+        if (png_image_write_to_file(&image, aPath.c_str(), 0, data.data(), 0, nullptr) == 0)
+        {
+            png_image_free(&image);
+            throw failed_to_save_image(aPath);
+        }
+    }
+
+    software_raster& software_render_target::raster() const
+    {
+        return *iRaster;
+    }
+
+    software_glyph_cache& software_render_target::glyph_cache() const
+    {
+        return *iGlyphCache;
+    }
+}
@@ -0,0 +1,1226 @@
+// software_rendering_context.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+
+#include <array>
+#include <atomic>
+#include <boost/math/constants/constants.hpp>
+
+#include <neogfx/gfx/text/glyph_text.hpp>
+#include <neogfx/gfx/text/i_emoji_atlas.hpp>
+#include <neogfx/gfx/text/i_font_manager.hpp>
+#include <neogfx/gfx/shapes.hpp>
+#include "../../text/native/i_native_font_face.hpp"
+#include "software_glyph_cache.hpp"
+#include "software_rendering_context.hpp"
+
+namespace neogfx
+{
+    namespace
+    {
+        typedef software_display_list::contour contour;
+
+        float signed_area(contour const& aContour)
+        {
+            float area = 0.0f;
+            for (std::size_t i = 0u; i < aContour.size(); ++i)
+            {
+                auto const& p0 = aContour[i];
+                auto const& p1 = aContour[(i + 1u) % aContour.size()];
+                area += p0.x * p1.y - p1.x * p0.y;
+            }
+            return area * 0.5f;
+        }
+
+        // Makes the contour's signed area non-negative so that contours combined in one command share a winding direction.
+        void orient(contour& aContour)
+        {
+            if (signed_area(aContour) < 0.0f)
+                std::reverse(aContour.begin(), aContour.end());
+        }
+
+        contour without_duplicates(contour const& aContour, bool aClosed)
+        {
+            contour result;
+            result.reserve(aContour.size());
+            for (auto const& p : aContour)
+                if (result.empty() || std::abs(p.x - result.back().x) > 1.0e-4f || std::abs(p.y - result.back().y) > 1.0e-4f)
+                    result.push_back(p);
+            if (aClosed && result.size() > 1u && std::abs(result.front().x - result.back().x) <= 1.0e-4f && std::abs(result.front().y - result.back().y) <= 1.0e-4f)
+                result.pop_back();
+            return result;
+        }
+
+        software_point normal(software_point const& aFrom, software_point const& aTo)
+        {
+            float const dx = aTo.x - aFrom.x;
+            float const dy = aTo.y - aFrom.y;
+            float const length = std::sqrt(dx * dx + dy * dy);
+            if (length == 0.0f)
+                return software_point{};
+            return software_point{ dy / length, -dx / length };
+        }
+
+        // Offsets a closed, positively oriented contour along its outward normals using mitred joins (limited to 4x).
+        contour offset_contour(contour const& aContour, float aDistance)
+        {
+            contour result;
+            result.reserve(aContour.size());
+            auto const n = aContour.size();
+            for (std::size_t i = 0u; i < n; ++i)
+            {
+                auto const& previous = aContour[(i + n - 1u) % n];
+                auto const& current = aContour[i];
+                auto const& next = aContour[(i + 1u) % n];
+                auto const n1 = normal(previous, current);
+                auto const n2 = normal(current, next);
+                software_point m{ n1.x + n2.x, n1.y + n2.y };
+                float const length = std::sqrt(m.x * m.x + m.y * m.y);
+                if (length < 1.0e-6f)
+                    m = n1;
+                else
+                    m = software_point{ m.x / length, m.y / length };
+                float const cosine = std::max(m.x * n1.x + m.y * n1.y, 0.25f);
+                result.push_back(software_point{ current.x + m.x * aDistance / cosine, current.y + m.y * aDistance / cosine });
+            }
+            return result;
+        }
+
+        contour segment_quad(software_point const& aFrom, software_point const& aTo, float aHalfWidth)
+        {
+            auto const n = normal(aFrom, aTo);
+            contour result{
+                software_point{ aFrom.x + n.x * aHalfWidth, aFrom.y + n.y * aHalfWidth },
+                software_point{ aTo.x + n.x * aHalfWidth, aTo.y + n.y * aHalfWidth },
+                software_point{ aTo.x - n.x * aHalfWidth, aTo.y - n.y * aHalfWidth },
+                software_point{ aFrom.x - n.x * aHalfWidth, aFrom.y - n.y * aHalfWidth } };
+            orient(result);
+            return result;
+        }
+
+        contour disc(software_point const& aCenter, float aRadius, dimension aDpiScaleFactor)
+        {
+            contour result;
+            auto const& arc = unit_arc(arc_segments(aRadius, boost::math::constants::two_pi<angle>(), DEFAULT_MAX_CHORD_ERROR, aDpiScaleFactor), boost::math::constants::two_pi<angle>());
+            result.reserve(arc.size());
+            for (auto const& p : arc)
+                result.push_back(software_point{ aCenter.x + static_cast<float>(p.x) * aRadius, aCenter.y + static_cast<float>(p.y) * aRadius });
+            orient(result);
+            return result;
+        }
+
+        software_box contour_bounds(std::vector<contour> const& aContours)
+        {
+            float minX = std::numeric_limits<float>::max();
+            float minY = minX;
+            float maxX = std::numeric_limits<float>::lowest();
+            float maxY = maxX;
+            for (auto const& c : aContours)
+                for (auto const& p : c)
+                {
+                    minX = std::min(minX, p.x);
+                    minY = std::min(minY, p.y);
+                    maxX = std::max(maxX, p.x);
+                    maxY = std::max(maxY, p.y);
+                }
+            if (minX > maxX)
+                return software_box{};
+            return software_box{
+                static_cast<std::int32_t>(std::floor(minX)), static_cast<std::int32_t>(std::floor(minY)),
+                static_cast<std::int32_t>(std::ceil(maxX)), static_cast<std::int32_t>(std::ceil(maxY)) };
+        }
+
+        software_rgba to_software_rgba(color const& aColor, double aAlpha = 1.0)
+        {
+            return premultiplied(aColor.red<float>(), aColor.green<float>(), aColor.blue<float>(), static_cast<float>(aColor.alpha<float>() * aAlpha));
+        }
+
+        enum class unsupported_operation : std::uint32_t
+        {
+            DrawPath,
+            DrawEntities,
+            TexturedMesh,
+            COUNT
+        };
+
+        // Operations the software backend can't render are skipped; each kind is reported once so that one drawn
+        // every frame doesn't flood the log.
+        void report_unsupported(unsupported_operation aOperation)
+        {
+            static std::array<std::atomic<bool>, static_cast<std::size_t>(unsupported_operation::COUNT)> sReported = {};
+            if (sReported[static_cast<std::size_t>(aOperation)].exchange(true))
+                return;
+            static char const* const sNames[] = { "draw_path (GPU path buffers)", "draw_entities (ECS scenes)", "textured meshes" };
+            service<debug::logger>() << neolib::logger::severity::Debug << "neogfx: warning: software rendering context: " <<
+                sNames[static_cast<std::size_t>(aOperation)] << " not supported; skipped" << std::endl;
+        }
+
+        std::uint32_t to_texel(color const& aColor)
+        {
+            return static_cast<std::uint32_t>(aColor.red()) |
+                (static_cast<std::uint32_t>(aColor.green()) << 8u) |
+                (static_cast<std::uint32_t>(aColor.blue()) << 16u) |
+                (static_cast<std::uint32_t>(aColor.alpha()) << 24u);
+        }
+    }
+
+    software_rendering_context::software_rendering_context(const software_render_target& aTarget, neogfx::blending_mode aBlendingMode) :
+        iTarget{ aTarget },
+        iInFlush{ false }
+    {
+        set_blending_mode(aBlendingMode);
+        set_smoothing_mode(neogfx::smoothing_mode::AntiAlias);
+        set_gain(vec4{ 1.0, 1.0, 1.0, 1.0 });
+
+        iSink += render_target().target_deactivating([&]()
+            {
+                flush();
+            });
+
+        iTarget.begin_rendering();
+    }
+
+    software_rendering_context::software_rendering_context(const software_rendering_context& aOther) :
+        iTarget{ aOther.iTarget },
+        iInFlush{ false },
+        iFastState{ aOther.iFastState },
+        iSlowState{ aOther.iSlowState },
+        iOffset{ aOther.iOffset }
+    {
+        iSink += render_target().target_deactivating([&]()
+            {
+                flush();
+            });
+
+        iTarget.begin_rendering();
+    }
+
+    software_rendering_context::~software_rendering_context()
+    {
+        iTarget.end_rendering();
+    }
+
+    std::unique_ptr<i_rendering_context> software_rendering_context::clone() const
+    {
+        return std::unique_ptr<i_rendering_context>(new software_rendering_context(*this));
+    }
+
+    i_rendering_engine& software_rendering_context::rendering_engine() const
+    {
+        // Not used for rendering; only looked up for callers that ask for it.
+        return service<i_rendering_engine>();
+    }
+
+    const i_render_target& software_rendering_context::render_target() const
+    {
+        return iTarget;
+    }
+
+    rect software_rendering_context::rendering_area(bool aConsiderScissor) const
+    {
+        if (iFastState.clipRegion == std::nullopt || !aConsiderScissor)
+            return rect{ render_target().target_origin(), render_target().target_extents() };
+        else
+            return *iFastState.clipRegion;
+    }
+
+    i_rendering_queue& software_rendering_context::queue() const
+    {
+        return iTarget.rendering_queue();
+    }
+
+    i_optimised_rendering_queue const& software_rendering_context::optimised_queue() const
+    {
+        return iTarget.optimised_rendering_queue();
+    }
+
+    void software_rendering_context::enqueue(const graphics_operation::operation& aOperation)
+    {
+        queue().push_back(aOperation);
+        for (auto filter : iFilters)
+            if (!filter->enqueue_graphics_operation(queue().back()))
+            {
+                queue().pop_back();
+                return;
+            }
+    }
+
+    void software_rendering_context::flush()
+    {
+        if (iInFlush)
+            return;
+
+        neolib::scoped_flag sf{ iInFlush };
+
+        auto const& optimisedQueue = optimised_queue();
+
+        if (optimisedQueue.empty())
+            return;
+
+        for (auto const& qbi : optimisedQueue)
+        {
+            update_state(qbi);
+            auto const& op = *qbi;
+            switch (static_cast<graphics_operation::operation_type>(op.index()))
+            {
+            case graphics_operation::SetViewport:
+                {
+                    auto const& setViewport = static_variant_cast<const graphics_operation::set_viewport&>(op);
+                    if (setViewport.viewport)
+                        render_target().set_viewport(setViewport.viewport.value().as<std::int32_t>());
+                    else
+                        render_target().set_viewport(rect{ render_target().target_origin(), render_target().extents() }.as<std::int32_t>());
+                }
+                break;
+            case graphics_operation::Clear:
+                clear(static_variant_cast<const graphics_operation::clear&>(op).color);
+                break;
+            case graphics_operation::SetGradient:
+                iGradient = static_variant_cast<const graphics_operation::set_gradient&>(op).gradient;
+                break;
+            case graphics_operation::ClearGradient:
+                iGradient = std::nullopt;
+                break;
+            case graphics_operation::SetPixel:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::set_pixel&>(op);
+                    set_pixel(args.point, args.color);
+                }
+                break;
+            case graphics_operation::Blit:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::blit&>(op);
+                    blit(args.destinationRect, *args.texture, args.sourceRect, args.blendingMode);
+                }
+                break;
+            case graphics_operation::DrawPixel:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_pixel&>(op);
+                    draw_pixel(args.point, args.color);
+                }
+                break;
+            case graphics_operation::DrawLine:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_line&>(op);
+                    draw_line(args.from, args.to, args.pen);
+                }
+                break;
+            case graphics_operation::DrawTriangle:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_triangle&>(op);
+                    draw_triangle(args.p0, args.p1, args.p2, args.pen, args.fill);
+                }
+                break;
+            case graphics_operation::DrawRect:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_rect&>(op);
+                    draw_rect(args.rect, args.pen, args.fill);
+                }
+                break;
+            case graphics_operation::DrawRoundedRect:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_rounded_rect&>(op);
+                    draw_rounded_rect(args.rect, args.radius, args.radius, args.pen, args.fill);
+                }
+                break;
+            case graphics_operation::DrawEllipseRect:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_ellipse_rect&>(op);
+                    draw_rounded_rect(args.rect, args.radiusX, args.radiusY, args.pen, args.fill);
+                }
+                break;
+            case graphics_operation::DrawCheckerboard:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_checkerboard&>(op);
+                    draw_checkerboard(args.rect, args.squareSize, args.pen, args.fill1, args.fill2);
+                }
+                break;
+            case graphics_operation::DrawCircle:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_circle&>(op);
+                    draw_ellipse(args.center, args.radius, args.radius, args.pen, args.fill);
+                }
+                break;
+            case graphics_operation::DrawEllipse:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_ellipse&>(op);
+                    draw_ellipse(args.center, args.radiusA, args.radiusB, args.pen, args.fill);
+                }
+                break;
+            case graphics_operation::DrawPie:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_pie&>(op);
+                    draw_arc(args.center, args.radius, args.startAngle, args.endAngle, true, args.pen, args.fill);
+                }
+                break;
+            case graphics_operation::DrawArc:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_arc&>(op);
+                    draw_arc(args.center, args.radius, args.startAngle, args.endAngle, false, args.pen, args.fill);
+                }
+                break;
+            case graphics_operation::DrawCubicBezier:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_cubic_bezier&>(op);
+                    draw_cubic_bezier(args.p0, args.p1, args.p2, args.p3, args.pen);
+                }
+                break;
+            case graphics_operation::DrawShape:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_shape&>(op);
+                    draw_shape(args.mesh, args.position, args.pen, args.fill);
+                }
+                break;
+            case graphics_operation::DrawGlyph:
+                draw_glyphs(static_variant_cast<const graphics_operation::draw_glyphs&>(op));
+                break;
+            case graphics_operation::DrawMesh:
+                {
+                    auto const& args = static_variant_cast<const graphics_operation::draw_mesh&>(op);
+                    draw_mesh(args.mesh, args.material, args.transformation);
+                }
+                break;
+            case graphics_operation::DrawPath:
+                report_unsupported(unsupported_operation::DrawPath);
+                break;
+            case graphics_operation::DrawEntities:
+                report_unsupported(unsupported_operation::DrawEntities);
+                break;
+            default:
+                break;
+            }
+        }
+
+        iTarget.raster().render(iDisplayList);
+        iDisplayList.clear();
+        iTexels.clear();
+
+        (void)queue();
+    }
+
+    void software_rendering_context::add_filter(i_rendering_context_filter& aFilter)
+    {
+        iFilters.push_back(&aFilter);
+    }
+
+    void software_rendering_context::remove_filter(i_rendering_context_filter& aFilter)
+    {
+        auto existing = std::find(iFilters.begin(), iFilters.end(), &aFilter);
+        if (existing != iFilters.end())
+            iFilters.erase(existing);
+    }
+
+    bool software_rendering_context::redirecting() const
+    {
+        throw std::logic_error("not yet implemented");
+    }
+
+    point software_rendering_context::redirect_origin() const
+    {
+        throw std::logic_error("not yet implemented");
+    }
+
+    void software_rendering_context::begin_redirect(i_rendering_context& aRcBase, point const& aOrigin)
+    {
+        throw std::logic_error("not yet implemented");
+    }
+
+    void software_rendering_context::end_redirect()
+    {
+        throw std::logic_error("not yet implemented");
+    }
+
+    neogfx::logical_coordinate_system software_rendering_context::logical_coordinate_system() const
+    {
+        if (iSlowState.logicalCoordinateSystem != std::nullopt)
+            return *iSlowState.logicalCoordinateSystem;
+        return render_target().logical_coordinate_system();
+    }
+
+    void software_rendering_context::set_logical_coordinate_system(neogfx::logical_coordinate_system aSystem)
+    {
+        iSlowState.logicalCoordinateSystem = aSystem;
+        render_target().set_logical_coordinate_system(aSystem);
+    }
+
+    logical_coordinates software_rendering_context::logical_coordinates() const
+    {
+        if (iSlowState.logicalCoordinates != std::nullopt)
+            return *iSlowState.logicalCoordinates;
+        return render_target().logical_coordinates();
+    }
+
+    void software_rendering_context::set_logical_coordinates(const neogfx::logical_coordinates& aCoordinates)
+    {
+        iSlowState.logicalCoordinates = aCoordinates;
+        render_target().set_logical_coordinates(aCoordinates);
+    }
+
+    point software_rendering_context::origin() const
+    {
+        return iFastState.origin;
+    }
+
+    void software_rendering_context::set_origin(const point& aOrigin)
+    {
+        iFastState.origin = aOrigin;
+    }
+
+    vec2 software_rendering_context::offset() const
+    {
+        return iOffset.value_or(vec2{});
+    }
+
+    void software_rendering_context::set_offset(const optional_vec2& aOffset)
+    {
+        iOffset = aOffset;
+    }
+
+    vec4 software_rendering_context::gain() const
+    {
+        return *iSlowState.gain;
+    }
+
+    void software_rendering_context::set_gain(vec4 const& aGain)
+    {
+        iSlowState.gain = aGain;
+    }
+
+    void software_rendering_context::blit(const rect& aDestinationRect, const i_texture& aTexture, const rect& aSourceRect, neogfx::blending_mode aBlendingMode)
+    {
+        auto const destination = to_device(aDestinationRect + origin());
+        if (destination.empty() || aSourceRect.cx <= 0.0 || aSourceRect.cy <= 0.0)
+            return;
+        // Render target textures are stored bottom row first.
+        auto const source = texels(aTexture, aSourceRect, aTexture.is_render_target());
+        software_paint::texture paint{ source };
+        paint.scale = software_point{
+            static_cast<float>(source->width) / static_cast<float>(destination.x1 - destination.x0),
+            static_cast<float>(source->height) / static_cast<float>(destination.y1 - destination.y0) };
+        paint.offset = software_point{ -destination.x0 * paint.scale.x, -destination.y0 * paint.scale.y };
+        bool const copy = (aBlendingMode == neogfx::blending_mode::None || aBlendingMode == neogfx::blending_mode::Blit);
+        iDisplayList.fill_rect(destination, clip_box(), paint, opacity(), copy ? software_blend::Copy : software_blend::SourceOver);
+    }
+
+    bool software_rendering_context::gradient_set() const
+    {
+        return !!iGradient;
+    }
+
+    void software_rendering_context::apply_gradient(i_gradient_shader&)
+    {
+        // Gradients are evaluated by the rasterizer's paint, not by a shader.
+    }
+
+    neogfx::subpixel_format software_rendering_context::subpixel_format() const
+    {
+        return neogfx::subpixel_format::None;
+    }
+
+    neogfx::blending_mode software_rendering_context::blending_mode() const
+    {
+        return *iSlowState.blendingMode;
+    }
+
+    void software_rendering_context::set_blending_mode(neogfx::blending_mode aBlendingMode)
+    {
+        iSlowState.blendingMode = aBlendingMode;
+    }
+
+    neogfx::smoothing_mode software_rendering_context::smoothing_mode() const
+    {
+        return *iSlowState.smoothingMode;
+    }
+
+    void software_rendering_context::set_smoothing_mode(neogfx::smoothing_mode aSmoothingMode)
+    {
+        iSlowState.smoothingMode = aSmoothingMode;
+    }
+
+    void software_rendering_context::clear(const color& aColor)
+    {
+        iDisplayList.fill_rect(iTarget.raster().bounds(), clip_box(), software_paint{ to_software_rgba(aColor) }, 1.0f, software_blend::Copy);
+    }
+
+    void software_rendering_context::set_pixel(const point& aPoint, const color& aColor)
+    {
+        auto const p = to_device((aPoint + origin()).to_vec2());
+        auto const x = static_cast<std::int32_t>(std::floor(p.x));
+        auto const y = static_cast<std::int32_t>(std::floor(logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGame ? p.y - 1.0f : p.y));
+        iDisplayList.fill_rect(software_box{ x, y, x + 1, y + 1 }, clip_box(), software_paint{ to_software_rgba(aColor.with_alpha(1.0)) }, 1.0f, software_blend::Copy);
+    }
+
+    void software_rendering_context::draw_pixel(const point& aPoint, const color& aColor)
+    {
+        auto const p = to_device((aPoint + origin()).to_vec2());
+        auto const x = static_cast<std::int32_t>(std::floor(p.x));
+        auto const y = static_cast<std::int32_t>(std::floor(logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGame ? p.y - 1.0f : p.y));
+        iDisplayList.fill_rect(software_box{ x, y, x + 1, y + 1 }, clip_box(), software_paint{ to_software_rgba(aColor) }, opacity(), blend());
+    }
+
+    void software_rendering_context::draw_line(const point& aFrom, const point& aTo, const pen& aPen)
+    {
+        if (aPen.width() == 0.0)
+            return;
+        auto const& adjust = (aPen.anti_aliased() || static_cast<std::int32_t>(aPen.width()) % 2 == 0 ? point{} : point{ 0.5, 0.5 });
+        stroke_polyline(contour{ to_device((aFrom + origin() + adjust).to_vec2()), to_device((aTo + origin() + adjust).to_vec2()) }, aPen);
+    }
+
+    void software_rendering_context::draw_triangle(const point& aP0, const point& aP1, const point& aP2, const pen& aPen, const brush& aFill)
+    {
+        contour triangle{ to_device((aP0 + origin()).to_vec2()), to_device((aP1 + origin()).to_vec2()), to_device((aP2 + origin()).to_vec2()) };
+        orient(triangle);
+        fill(contours{ triangle }, aFill);
+        stroke_outline(triangle, aPen);
+    }
+
+    void software_rendering_context::draw_rect(const rect& aRect, const pen& aPen, const brush& aFill)
+    {
+        auto const rc = aRect + origin();
+        contour outline{
+            to_device(rc.top_left().to_vec2()),
+            to_device(rc.top_right().to_vec2()),
+            to_device(rc.bottom_right().to_vec2()),
+            to_device(rc.bottom_left().to_vec2()) };
+        orient(outline);
+        fill(contours{ outline }, aFill);
+        stroke_outline(outline, aPen);
+    }
+
+    void software_rendering_context::draw_rounded_rect(const rect& aRect, const vec4& aRadiusX, const vec4& aRadiusY, const pen& aPen, const brush& aFill)
+    {
+        auto const rc = aRect + origin();
+        // Corner order matches the shape shader: top-left, top-right, bottom-right, bottom-left; opposing radii are
+        // scaled down together when they would overlap.
+        std::array<scalar, 4> rx = { aRadiusX[0], aRadiusX[1], aRadiusX[2], aRadiusX[3] };
+        std::array<scalar, 4> ry = { aRadiusY[0], aRadiusY[1], aRadiusY[2], aRadiusY[3] };
+        auto const fit = [](scalar& aFirst, scalar& aSecond, scalar aExtent)
+        {
+            if (aFirst + aSecond > aExtent && aFirst + aSecond > 0.0)
+            {
+                auto const scale = aExtent / (aFirst + aSecond);
+                aFirst *= scale;
+                aSecond *= scale;
+            }
+        };
+        fit(rx[0], rx[1], rc.cx);
+        fit(rx[3], rx[2], rc.cx);
+        fit(ry[0], ry[3], rc.cy);
+        fit(ry[1], ry[2], rc.cy);
+        angle constexpr pi = boost::math::constants::pi<angle>();
+        angle constexpr halfPi = boost::math::constants::half_pi<angle>();
+        std::array<point, 4> const centers = {
+            point{ rc.left() + rx[0], rc.top() + ry[0] },
+            point{ rc.right() - rx[1], rc.top() + ry[1] },
+            point{ rc.right() - rx[2], rc.bottom() - ry[2] },
+            point{ rc.left() + rx[3], rc.bottom() - ry[3] } };
+        std::array<angle, 4> const startAngles = { pi, pi + halfPi, 0.0, halfPi };
+        contour outline;
+        for (std::size_t corner = 0u; corner < 4u; ++corner)
+        {
+            if (rx[corner] <= 0.0 || ry[corner] <= 0.0)
+            {
+                outline.push_back(to_device(centers[corner].to_vec2()));
+                continue;
+            }
+            for (auto const& p : unit_arc(arc_segments(std::max(rx[corner], ry[corner]), halfPi, DEFAULT_MAX_CHORD_ERROR, dpi_scale_factor()), startAngles[corner], halfPi))
+                outline.push_back(to_device(vec2{ centers[corner].x + p.x * rx[corner], centers[corner].y + p.y * ry[corner] }));
+        }
+        outline = without_duplicates(outline, true);
+        orient(outline);
+        fill(contours{ outline }, aFill);
+        stroke_outline(outline, aPen);
+    }
+
+    void software_rendering_context::draw_checkerboard(const rect& aRect, const size& aSquareSize, const pen& aPen, const brush& aFill1, const brush& aFill2)
+    {
+        auto const rc = aRect + origin();
+        if (aSquareSize.cx > 0.0 && aSquareSize.cy > 0.0)
+        {
+            for (std::uint32_t pass = 0u; pass <= 1u; ++pass)
+            {
+                contours squares;
+                for (scalar y = rc.top(); y < rc.bottom(); y += aSquareSize.cy)
+                    for (scalar x = rc.left(); x < rc.right(); x += aSquareSize.cx)
+                    {
+                        auto const column = static_cast<std::uint32_t>(std::floor((x - rc.left()) / aSquareSize.cx + 0.5));
+                        auto const row = static_cast<std::uint32_t>(std::floor((y - rc.top()) / aSquareSize.cy + 0.5));
+                        if ((column + row) % 2u != pass)
+                            continue;
+                        rect const square{ point{ x, y }, point{ std::min(x + aSquareSize.cx, rc.right()), std::min(y + aSquareSize.cy, rc.bottom()) } };
+                        contour c{
+                            to_device(square.top_left().to_vec2()),
+                            to_device(square.top_right().to_vec2()),
+                            to_device(square.bottom_right().to_vec2()),
+                            to_device(square.bottom_left().to_vec2()) };
+                        orient(c);
+                        squares.push_back(std::move(c));
+                    }
+                fill(squares, pass == 0u ? aFill1 : aFill2);
+            }
+        }
+        contour outline{
+            to_device(rc.top_left().to_vec2()),
+            to_device(rc.top_right().to_vec2()),
+            to_device(rc.bottom_right().to_vec2()),
+            to_device(rc.bottom_left().to_vec2()) };
+        orient(outline);
+        stroke_outline(outline, aPen);
+    }
+
+    void software_rendering_context::draw_ellipse(const point& aCenter, dimension aRadiusA, dimension aRadiusB, const pen& aPen, const brush& aFill)
+    {
+        auto const center = aCenter + origin();
+        angle constexpr twoPi = boost::math::constants::two_pi<angle>();
+        contour outline;
+        for (auto const& p : unit_arc(arc_segments(std::max(aRadiusA, aRadiusB), twoPi, DEFAULT_MAX_CHORD_ERROR, dpi_scale_factor()), twoPi))
+            outline.push_back(to_device(vec2{ center.x + p.x * aRadiusA, center.y + p.y * aRadiusB }));
+        outline = without_duplicates(outline, true);
+        if (outline.size() < 3u)
+            return;
+        orient(outline);
+        fill(contours{ outline }, aFill);
+        stroke_outline(outline, aPen);
+    }
+
+    void software_rendering_context::draw_arc(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, bool aPie, const pen& aPen, const brush& aFill)
+    {
+        // Angles are anticlockwise with y up, as in the shape shader.
+        auto const center = to_device((aCenter + origin()).to_vec2());
+        bool const flip = (logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGame);
+        angle const arc = (aEndAngle != aStartAngle ? aEndAngle - aStartAngle : boost::math::constants::two_pi<angle>());
+        contour outline;
+        for (auto const& p : unit_arc(arc_segments(aRadius, arc, DEFAULT_MAX_CHORD_ERROR, dpi_scale_factor()), aStartAngle, arc))
+            outline.push_back(software_point{
+                center.x + static_cast<float>(p.x * aRadius),
+                center.y + static_cast<float>((flip ? p.y : -p.y) * aRadius) });
+        if (aPie)
+            outline.push_back(center);
+        outline = without_duplicates(outline, aPie);
+        if (outline.size() < 2u)
+            return;
+        if (outline.size() >= 3u)
+        {
+            contour filled = outline;
+            orient(filled);
+            fill(contours{ filled }, aFill);
+        }
+        if (aPie)
+        {
+            orient(outline);
+            stroke_outline(outline, aPen);
+        }
+        else
+            stroke_polyline(outline, aPen);
+    }
+
+    void software_rendering_context::draw_cubic_bezier(const point& aP0, const point& aP1, const point& aP2, const point& aP3, const pen& aPen)
+    {
+        auto const p0 = to_device((aP0 + origin()).to_vec2());
+        auto const p1 = to_device((aP1 + origin()).to_vec2());
+        auto const p2 = to_device((aP2 + origin()).to_vec2());
+        auto const p3 = to_device((aP3 + origin()).to_vec2());
+        auto const distance = [](software_point const& a, software_point const& b) { return std::sqrt((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y)); };
+        // The control polygon bounds the curve length; a segment every few pixels keeps chord error sub-pixel.
+        auto const segments = std::clamp(static_cast<std::int32_t>(std::ceil((distance(p0, p1) + distance(p1, p2) + distance(p2, p3)) / 4.0f)), 8, 256);
+        contour polyline;
+        polyline.reserve(static_cast<std::size_t>(segments) + 1u);
+        for (std::int32_t i = 0; i <= segments; ++i)
+        {
+            float const t = static_cast<float>(i) / static_cast<float>(segments);
+            float const u = 1.0f - t;
+            float const b0 = u * u * u;
+            float const b1 = 3.0f * u * u * t;
+            float const b2 = 3.0f * u * t * t;
+            float const b3 = t * t * t;
+            polyline.push_back(software_point{
+                b0 * p0.x + b1 * p1.x + b2 * p2.x + b3 * p3.x,
+                b0 * p0.y + b1 * p1.y + b2 * p2.y + b3 * p3.y });
+        }
+        stroke_polyline(polyline, aPen);
+    }
+
+    void software_rendering_context::draw_shape(const game::mesh& aMesh, const vec3& aPosition, const pen& aPen, const brush& aFill)
+    {
+        auto const position = aPosition + origin().to_vec3();
+        auto const vertex = [&](std::size_t aIndex)
+        {
+            auto const& v = aMesh.vertices[aIndex];
+            return to_device(vec2{ v.x + position.x, v.y + position.y });
+        };
+        contours triangles;
+        triangles.reserve(aMesh.faces.size());
+        for (auto const& f : aMesh.faces)
+        {
+            contour triangle{ vertex(f[0]), vertex(f[1]), vertex(f[2]) };
+            orient(triangle);
+            triangles.push_back(std::move(triangle));
+        }
+        fill(triangles, aFill);
+        if (aPen.width() == 0.0 || aMesh.vertices.size() < 2u)
+            return;
+        contour outline;
+        for (std::size_t i = 0u; i < aMesh.vertices.size(); ++i)
+            outline.push_back(vertex(i));
+        outline.push_back(outline.front());
+        stroke_polyline(outline, aPen);
+    }
+
+    void software_rendering_context::draw_glyphs(const graphics_operation::draw_glyphs& aDrawGlyphs)
+    {
+        auto& glyphText = aDrawGlyphs.glyphText.content();
+        auto const& point = aDrawGlyphs.point + origin().to_vec3();
+
+        auto const glyph_box = [&](glyph_char const& aGlyphChar)
+        {
+            float minX = std::numeric_limits<float>::max();
+            float minY = minX;
+            float maxX = std::numeric_limits<float>::lowest();
+            float maxY = maxX;
+            for (auto const& corner : aGlyphChar.shape)
+            {
+                auto const p = to_device(vec2{
+                    std::round(aGlyphChar.cell[0].x + corner.x) + point.x,
+                    std::round(aGlyphChar.cell[0].y + corner.y) + point.y });
+                minX = std::min(minX, p.x);
+                minY = std::min(minY, p.y);
+                maxX = std::max(maxX, p.x);
+                maxY = std::max(maxY, p.y);
+            }
+            return software_box{
+                static_cast<std::int32_t>(std::round(minX)), static_cast<std::int32_t>(std::round(minY)),
+                static_cast<std::int32_t>(std::round(maxX)), static_cast<std::int32_t>(std::round(maxY)) };
+        };
+
+        auto const ink_of = [](text_format const& aAppearance) -> color_or_gradient
+        {
+            if (filtered_content_ink_is_effect_color(aAppearance.being_filtered()))
+                return aAppearance.being_filtered()->color();
+            return aAppearance.ink();
+        };
+
+        auto const for_each_glyph = [&](auto aVisitor)
+        {
+            auto a = aDrawGlyphs.attributes.begin();
+            for (auto g = aDrawGlyphs.begin; g != aDrawGlyphs.end; ++g)
+            {
+                while (a != aDrawGlyphs.attributes.end() && (g - aDrawGlyphs.begin) >= a->end)
+                    ++a;
+                auto const appearance = (a != aDrawGlyphs.attributes.end() && (g - aDrawGlyphs.begin) >= a->start ? &a->attributes : nullptr);
+                if (appearance != nullptr)
+                    aVisitor(*g, *appearance);
+            }
+        };
+
+        for_each_glyph([&](glyph_char const& aGlyphChar, text_format const& aAppearance)
+            {
+                if (aAppearance.paper() == std::nullopt)
+                    return;
+                contour cell;
+                for (auto const& corner : aGlyphChar.cell)
+                    cell.push_back(to_device(vec2{ corner.x + point.x, corner.y + point.y }));
+                orient(cell);
+                fill(contours{ cell }, static_cast<color_or_gradient const&>(*aAppearance.paper()), false);
+            });
+
+        for_each_glyph([&](glyph_char const& aGlyphChar, text_format const& aAppearance)
+            {
+                if (is_whitespace(aGlyphChar))
+                    return;
+                auto const box = glyph_box(aGlyphChar);
+                if (box.empty())
+                    return;
+                if (is_emoji(aGlyphChar))
+                {
+                    auto const& emojiTexture = service<i_font_manager>().emoji_atlas().emoji_texture(aGlyphChar.value);
+                    auto const source = texels(emojiTexture, rect{ neogfx::point{}, emojiTexture.extents() }, false);
+                    software_paint::texture paint{ source };
+                    paint.scale = software_point{
+                        static_cast<float>(source->width) / static_cast<float>(box.x1 - box.x0),
+                        static_cast<float>(source->height) / static_cast<float>(box.y1 - box.y0) };
+                    paint.offset = software_point{ -box.x0 * paint.scale.x, -box.y0 * paint.scale.y };
+                    iDisplayList.fill_rect(box, clip_box(), paint, opacity());
+                    return;
+                }
+                auto const mask = iTarget.glyph_cache().mask(glyphText.glyph_font(aGlyphChar).native_font_face(), aGlyphChar.value, box.x1 - box.x0, box.y1 - box.y0);
+                auto const paint = to_paint(ink_of(aAppearance), box);
+                if (paint)
+                    iDisplayList.fill_mask(mask, box.x0, box.y0, clip_box(), *paint, opacity());
+            });
+
+        for_each_glyph([&](glyph_char const& aGlyphChar, text_format const& aAppearance)
+            {
+                if (!underline(aGlyphChar) && !(aDrawGlyphs.showMnemonics && mnemonic(aGlyphChar)))
+                    return;
+                auto const baseline = glyphText.baseline();
+                auto const& majorFont = glyphText.major_font();
+                auto const yUnderline = std::floor(majorFont.native_font_face().underline_position());
+                auto const cyUnderline = std::round(majorFont.native_font_face().underline_thickness());
+                draw_line(
+                    neogfx::point{ point.x + aGlyphChar.cell[0].x, point.y + aGlyphChar.cell[0].y + baseline - yUnderline } - origin(),
+                    neogfx::point{ point.x + aGlyphChar.cell[1].x, point.y + aGlyphChar.cell[1].y + baseline - yUnderline } - origin(),
+                    pen{ ink_of(aAppearance), cyUnderline, false });
+            });
+    }
+
+    void software_rendering_context::draw_mesh(const game::mesh& aMesh, const game::material& aMaterial, const mat44& aTransformation)
+    {
+        // Untextured meshes only; vertex positions are transformed on the CPU.
+        if (aMaterial.texture || aMaterial.sharedTexture)
+        {
+            report_unsupported(unsupported_operation::TexturedMesh);
+            return;
+        }
+        auto const& rgba = aMaterial.color ? aMaterial.color->rgba : vec4f{ 1.0f, 1.0f, 1.0f, 1.0f };
+        auto const& o = origin();
+        auto const vertex = [&](std::size_t aIndex)
+        {
+            auto const& v = aMesh.vertices[aIndex];
+            auto const x = aTransformation[0][0] * v.x + aTransformation[1][0] * v.y + aTransformation[2][0] * v.z + aTransformation[3][0];
+            auto const y = aTransformation[0][1] * v.x + aTransformation[1][1] * v.y + aTransformation[2][1] * v.z + aTransformation[3][1];
+            return to_device(vec2{ x + o.x, y + o.y });
+        };
+        contours triangles;
+        triangles.reserve(aMesh.faces.size());
+        for (auto const& f : aMesh.faces)
+        {
+            contour triangle{ vertex(f[0]), vertex(f[1]), vertex(f[2]) };
+            orient(triangle);
+            triangles.push_back(std::move(triangle));
+        }
+        fill(triangles, color_or_gradient{ color{ rgba[0], rgba[1], rgba[2], rgba[3] } }, anti_aliased());
+    }
+
+    void software_rendering_context::update_state(queue_batch_item const& aQbi)
+    {
+        if (iFastState.generation != aQbi.fastState->generation)
+            iFastState = *aQbi.fastState;
+
+        if (iSlowState.generation != aQbi.slowState->generation)
+        {
+            iSlowState.generation = aQbi.slowState->generation;
+            if (aQbi.slowState->logicalCoordinateSystem) iSlowState.logicalCoordinateSystem = aQbi.slowState->logicalCoordinateSystem;
+            if (aQbi.slowState->logicalCoordinates) iSlowState.logicalCoordinates = aQbi.slowState->logicalCoordinates;
+            if (aQbi.slowState->blendingMode) iSlowState.blendingMode = aQbi.slowState->blendingMode;
+            if (aQbi.slowState->smoothingMode) iSlowState.smoothingMode = aQbi.slowState->smoothingMode;
+            if (aQbi.slowState->gain) iSlowState.gain = aQbi.slowState->gain;
+        }
+    }
+
+    software_point software_rendering_context::to_device(vec2 const& aPoint) const
+    {
+        auto const& o = offset();
+        auto const x = aPoint.x + o.x;
+        auto const y = aPoint.y + o.y;
+        if (logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGame)
+            return software_point{ static_cast<float>(x), static_cast<float>(iTarget.extents().cy - y) };
+        return software_point{ static_cast<float>(x), static_cast<float>(y) };
+    }
+
+    dimension software_rendering_context::dpi_scale_factor() const
+    {
+        return dpi_scale_type_for_thread() == dpi_scale_type::X2 ?
+            x2_dpi_scale_factor(iTarget.ppi()) : xn_dpi_scale_factor(iTarget.ppi());
+    }
+
+    software_box software_rendering_context::to_device(rect const& aRect) const
+    {
+        auto const p0 = to_device(aRect.top_left().to_vec2());
+        auto const p1 = to_device(aRect.bottom_right().to_vec2());
+        return software_box{
+            static_cast<std::int32_t>(std::round(std::min(p0.x, p1.x))), static_cast<std::int32_t>(std::round(std::min(p0.y, p1.y))),
+            static_cast<std::int32_t>(std::round(std::max(p0.x, p1.x))), static_cast<std::int32_t>(std::round(std::max(p0.y, p1.y))) };
+    }
+
+    software_box software_rendering_context::clip_box() const
+    {
+        auto const bounds = iTarget.raster().bounds();
+        if (!iFastState.clipRegion || iFastState.scissorCounter < 0)
+            return bounds;
+        // Clip regions are held bottom-up, as for glScissor.
+        auto const& cr = *iFastState.clipRegion;
+        auto const x = static_cast<std::int32_t>(std::ceil(cr.x));
+        auto const y = static_cast<std::int32_t>(std::ceil(cr.y));
+        auto const cx = static_cast<std::int32_t>(std::ceil(cr.cx));
+        auto const cy = static_cast<std::int32_t>(std::ceil(cr.cy));
+        auto const top = bounds.y1 - (y + cy);
+        return software_box{ x, top, x + cx, top + cy }.intersection(bounds);
+    }
+
+    software_blend software_rendering_context::blend() const
+    {
+        switch (blending_mode())
+        {
+        case neogfx::blending_mode::None:
+        case neogfx::blending_mode::Blit:
+            return software_blend::Copy;
+        default:
+            return software_blend::SourceOver;
+        }
+    }
+
+    bool software_rendering_context::anti_aliased() const
+    {
+        return smoothing_mode() == neogfx::smoothing_mode::AntiAlias;
+    }
+
+    float software_rendering_context::opacity() const
+    {
+        return static_cast<float>(iFastState.opacity);
+    }
+
+    std::optional<software_paint> software_rendering_context::to_paint(color_or_gradient const& aColor, software_box const& aBoundingBox) const
+    {
+        if (std::holds_alternative<color>(aColor))
+            return software_paint{ to_software_rgba(static_variant_cast<color const&>(aColor)) };
+        else if (std::holds_alternative<gradient>(aColor))
+            return to_paint(static_variant_cast<gradient const&>(aColor), aBoundingBox);
+        return std::nullopt;
+    }
+
+    std::optional<software_paint> software_rendering_context::to_paint(brush const& aBrush, software_box const& aBoundingBox)
+    {
+        if (std::holds_alternative<color>(aBrush))
+            return software_paint{ to_software_rgba(static_variant_cast<color const&>(aBrush)) };
+        else if (std::holds_alternative<gradient>(aBrush))
+            return to_paint(static_variant_cast<gradient const&>(aBrush), aBoundingBox);
+        else if (std::holds_alternative<texture>(aBrush))
+        {
+            auto const& brushTexture = static_variant_cast<texture const&>(aBrush);
+            return to_paint(brushTexture, rect{ point{}, brushTexture.extents() }, aBoundingBox);
+        }
+        else if (std::holds_alternative<neolib::pair<texture, rect>>(aBrush))
+        {
+            auto const& brushTexture = static_variant_cast<neolib::pair<texture, rect> const&>(aBrush);
+            return to_paint(brushTexture.first(), brushTexture.second(), aBoundingBox);
+        }
+        else if (std::holds_alternative<sub_texture>(aBrush))
+        {
+            auto const& brushTexture = static_variant_cast<sub_texture const&>(aBrush);
+            return to_paint(brushTexture, rect{ point{}, brushTexture.extents() }, aBoundingBox);
+        }
+        else if (std::holds_alternative<neolib::pair<sub_texture, rect>>(aBrush))
+        {
+            auto const& brushTexture = static_variant_cast<neolib::pair<sub_texture, rect> const&>(aBrush);
+            return to_paint(brushTexture.first(), brushTexture.second(), aBoundingBox);
+        }
+        return std::nullopt;
+    }
+
+    std::optional<software_paint> software_rendering_context::to_paint(i_texture const& aTexture, rect const& aPart, software_box const& aBoundingBox)
+    {
+        // The texture (part) is stretched over the filled shape's bounding box.
+        if (aTexture.is_empty() || aPart.cx <= 0.0 || aPart.cy <= 0.0 || aBoundingBox.empty())
+            return std::nullopt;
+        software_paint::texture paint{ texels(aTexture, aPart, aTexture.is_render_target()) };
+        paint.scale = software_point{
+            static_cast<float>(paint.texels->width) / static_cast<float>(aBoundingBox.x1 - aBoundingBox.x0),
+            static_cast<float>(paint.texels->height) / static_cast<float>(aBoundingBox.y1 - aBoundingBox.y0) };
+        paint.offset = software_point{ -aBoundingBox.x0 * paint.scale.x, -aBoundingBox.y0 * paint.scale.y };
+        return software_paint{ paint };
+    }
+
+    software_paint software_rendering_context::to_paint(gradient const& aGradient, software_box const& aBoundingBox) const
+    {
+        auto lut = std::make_shared<software_gradient_lut>();
+        for (std::size_t i = 0u; i < SOFTWARE_GRADIENT_LUT_SIZE; ++i)
+        {
+            auto const c = aGradient.at(static_cast<scalar>(i) / static_cast<scalar>(SOFTWARE_GRADIENT_LUT_SIZE - 1u));
+            (*lut)[i] = premultiplied(c.red<float>(), c.green<float>(), c.blue<float>(), c.alpha<float>());
+        }
+
+        auto box = aBoundingBox;
+        if (aGradient.bounding_box())
+            box = to_device(*aGradient.bounding_box());
+        float const x = static_cast<float>(box.x0);
+        float const y = static_cast<float>(box.y0);
+        float const cx = static_cast<float>(std::max(box.x1 - box.x0, 1));
+        float const cy = static_cast<float>(std::max(box.y1 - box.y0, 1));
+
+        software_paint::gradient result{ lut, software_paint::gradient_kind::Linear, software_point{ x, y }, software_point{ 0.0f, 1.0f / cy } };
+        switch (aGradient.direction())
+        {
+        case gradient_direction::Vertical:
+            break;
+        case gradient_direction::Horizontal:
+            result.axis = software_point{ 1.0f / cx, 0.0f };
+            break;
+        case gradient_direction::Diagonal:
+            {
+                // Same rotation as the gradient shader: position = 0.5 + (sin(a) * dx - cos(a) * dy) / height about the centre.
+                float const hx = cx / 2.0f;
+                float const hy = cy / 2.0f;
+                float angle = 0.0f;
+                if (std::holds_alternative<corner>(aGradient.orientation()))
+                {
+                    switch (static_variant_cast<corner>(aGradient.orientation()))
+                    {
+                    case corner::TopLeft:
+                        angle = std::atan2(hy, -hx);
+                        break;
+                    case corner::TopRight:
+                        angle = std::atan2(-hy, -hx);
+                        break;
+                    case corner::BottomRight:
+                        angle = std::atan2(-hy, hx);
+                        break;
+                    case corner::BottomLeft:
+                        angle = std::atan2(hy, hx);
+                        break;
+                    }
+                }
+                else
+                    angle = static_cast<float>(static_variant_cast<scalar>(aGradient.orientation()));
+                float const s = std::sin(angle);
+                float const c = std::cos(angle);
+                result.origin = software_point{ x + hx - hy * s, y + hy + hy * c };
+                result.axis = software_point{ s / cy, -c / cy };
+            }
+            break;
+        case gradient_direction::Rectangular:
+            result.kind = software_paint::gradient_kind::Rectangular;
+            result.origin = software_point{ x + cx / 2.0f, y + cy / 2.0f };
+            result.axis = software_point{ 2.0f / cx, 2.0f / cy };
+            break;
+        case gradient_direction::Radial:
+            {
+                result.kind = software_paint::gradient_kind::Radial;
+                float const ax = cx / 2.0f;
+                float const ay = cy / 2.0f;
+                auto const center = aGradient.center().value_or(neogfx::point{});
+                float const ox = ax * static_cast<float>(center.x);
+                float const oy = ay * static_cast<float>(center.y);
+                result.origin = software_point{ x + ax + ox, y + ay + oy };
+                float const nearX = std::min(std::abs(-ax - ox), std::abs(ax - ox));
+                float const nearY = std::min(std::abs(-ay - oy), std::abs(ay - oy));
+                float const farX = std::max(std::abs(-ax - ox), std::abs(ax - ox));
+                float const farY = std::max(std::abs(-ay - oy), std::abs(ay - oy));
+                float rx = nearX;
+                float ry = nearY;
+                switch (aGradient.size())
+                {
+                case gradient_size::ClosestSide:
+                    break;
+                case gradient_size::FarthestSide:
+                    rx = farX;
+                    ry = farY;
+                    break;
+                case gradient_size::ClosestCorner:
+                    rx = nearX * std::sqrt(2.0f);
+                    ry = nearY * std::sqrt(2.0f);
+                    break;
+                case gradient_size::FarthestCorner:
+                    rx = farX * std::sqrt(2.0f);
+                    ry = farY * std::sqrt(2.0f);
+                    break;
+                }
+                if (aGradient.shape() == gradient_shape::Circle)
+                {
+                    switch (aGradient.size())
+                    {
+                    case gradient_size::ClosestSide:
+                        rx = ry = std::min(nearX, nearY);
+                        break;
+                    case gradient_size::FarthestSide:
+                        rx = ry = std::max(farX, farY);
+                        break;
+                    case gradient_size::ClosestCorner:
+                        rx = ry = std::sqrt(nearX * nearX + nearY * nearY);
+                        break;
+                    case gradient_size::FarthestCorner:
+                        rx = ry = std::sqrt(farX * farX + farY * farY);
+                        break;
+                    }
+                }
+                result.axis = software_point{ 1.0f / std::max(rx, 1.0f), 1.0f / std::max(ry, 1.0f) };
+            }
+            break;
+        }
+        return software_paint{ result };
+    }
+
+    void software_rendering_context::fill(contours const& aContours, brush const& aFill)
+    {
+        if (aContours.empty())
+            return;
+        auto const paint = to_paint(aFill, contour_bounds(aContours));
+        if (paint)
+            iDisplayList.fill(aContours, clip_box(), *paint, opacity(), blend(), anti_aliased());
+    }
+
+    void software_rendering_context::fill(contours const& aContours, color_or_gradient const& aFill, bool aAntiAliased)
+    {
+        if (aContours.empty())
+            return;
+        auto const paint = to_paint(aFill, contour_bounds(aContours));
+        if (paint)
+            iDisplayList.fill(aContours, clip_box(), *paint, opacity(), blend(), aAntiAliased);
+    }
+
+    void software_rendering_context::stroke_outline(contour const& aOutline, const pen& aPen)
+    {
+        // Strokes are centred on the outline: the outer offset and the reversed inner offset form a non-zero ring.
+        if (aPen.width() == 0.0 || aOutline.size() < 3u)
+            return;
+        float const halfWidth = static_cast<float>(aPen.width() / 2.0);
+        auto inner = offset_contour(aOutline, -halfWidth);
+        std::reverse(inner.begin(), inner.end());
+        fill(contours{ offset_contour(aOutline, halfWidth), inner }, aPen.color(), anti_aliased() && aPen.anti_aliased());
+    }
+
+    void software_rendering_context::stroke_polyline(contour const& aPolyline, const pen& aPen)
+    {
+        // Per-segment quads with round joins, all positively oriented so overlaps union under the non-zero rule.
+        if (aPen.width() == 0.0)
+            return;
+        auto const polyline = without_duplicates(aPolyline, false);
+        if (polyline.size() < 2u)
+            return;
+        float const halfWidth = static_cast<float>(aPen.width() / 2.0);
+        contours parts;
+        for (std::size_t i = 0u; i + 1u < polyline.size(); ++i)
+        {
+            parts.push_back(segment_quad(polyline[i], polyline[i + 1u], halfWidth));
+            if (i > 0u && halfWidth > 0.5f)
+                parts.push_back(disc(polyline[i], halfWidth, dpi_scale_factor()));
+        }
+        fill(parts, aPen.color(), anti_aliased() && aPen.anti_aliased());
+    }
+
+    std::shared_ptr<software_texels const> software_rendering_context::texels(const i_texture& aTexture, const rect& aPart, bool aFlip)
+    {
+        auto const key = std::make_tuple(static_cast<void const*>(&aTexture), aPart.x, aPart.y, aPart.cx, aPart.cy, aFlip);
+        auto existing = iTexels.find(key);
+        if (existing != iTexels.end())
+            return existing->second;
+        auto result = std::make_shared<software_texels>();
+        result->width = std::max(static_cast<std::int32_t>(std::round(aPart.cx)), 1);
+        result->height = std::max(static_cast<std::int32_t>(std::round(aPart.cy)), 1);
+        result->texels.resize(static_cast<std::size_t>(result->width) * static_cast<std::size_t>(result->height));
+        for (std::int32_t y = 0; y < result->height; ++y)
+        {
+            auto const sourceY = aPart.y + (aFlip ? result->height - 1 - y : y);
+            for (std::int32_t x = 0; x < result->width; ++x)
+                result->texels[static_cast<std::size_t>(y) * static_cast<std::size_t>(result->width) + static_cast<std::size_t>(x)] =
+                    to_texel(aTexture.get_pixel(point{ aPart.x + x, sourceY }));
+        }
+        return iTexels[key] = result;
+    }
+}
@@ -0,0 +1,127 @@
+// software_rendering_context.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+#include <map>
+#include <unordered_map>
+
+#include <neogfx/gfx/i_rendering_engine.hpp>
+#include <neogfx/gfx/software_render_target.hpp>
+#include "software_raster.hpp"
+
+namespace neogfx
+{
+    // Translates the optimised rendering queue into a software_display_list which is rasterized, in tiles,
+    // into the target's buffer at the end of each flush.
+    class software_rendering_context : public i_rendering_context
+    {
+    private:
+        typedef software_display_list::contour contour;
+        typedef std::vector<contour> contours;
+    public:
+        software_rendering_context(const software_render_target& aTarget, blending_mode aBlendingMode = blending_mode::Default);
+        software_rendering_context(const software_rendering_context& aOther);
+        ~software_rendering_context();
+    public:
+        std::unique_ptr<i_rendering_context> clone() const final;
+    public:
+        i_rendering_engine& rendering_engine() const final;
+        const i_render_target& render_target() const final;
+        rect rendering_area(bool aConsiderScissor = true) const final;
+    public:
+        i_rendering_queue& queue() const final;
+        i_optimised_rendering_queue const& optimised_queue() const;
+        void enqueue(const graphics_operation::operation& aOperation) final;
+        void flush() final;
+        void add_filter(i_rendering_context_filter& aFilter) final;
+        void remove_filter(i_rendering_context_filter& aFilter) final;
+    public:
+        bool redirecting() const final;
+        point redirect_origin() const final;
+        void begin_redirect(i_rendering_context& aRcBase, point const& aOrigin) final;
+        void end_redirect() final;
+    public:
+        neogfx::logical_coordinate_system logical_coordinate_system() const final;
+        void set_logical_coordinate_system(neogfx::logical_coordinate_system aSystem) final;
+        neogfx::logical_coordinates logical_coordinates() const final;
+        void set_logical_coordinates(const neogfx::logical_coordinates& aCoordinates) final;
+        point origin() const final;
+        void set_origin(const point& aOrigin) final;
+        vec2 offset() const final;
+        void set_offset(const optional_vec2& aOffset) final;
+        vec4 gain() const final;
+        void set_gain(vec4 const& aGain) final;
+        void blit(const rect& aDestinationRect, const i_texture& aTexture, const rect& aSourceRect, neogfx::blending_mode aBlendingMode) final;
+        bool gradient_set() const final;
+        void apply_gradient(i_gradient_shader& aShader) final;
+    public:
+        neogfx::subpixel_format subpixel_format() const final;
+    public:
+        neogfx::blending_mode blending_mode() const;
+        void set_blending_mode(neogfx::blending_mode aBlendingMode);
+        neogfx::smoothing_mode smoothing_mode() const;
+        void set_smoothing_mode(neogfx::smoothing_mode aSmoothingMode);
+        void clear(const color& aColor);
+        void set_pixel(const point& aPoint, const color& aColor);
+        void draw_pixel(const point& aPoint, const color& aColor);
+        void draw_line(const point& aFrom, const point& aTo, const pen& aPen);
+        void draw_triangle(const point& aP0, const point& aP1, const point& aP2, const pen& aPen, const brush& aFill);
+        void draw_rect(const rect& aRect, const pen& aPen, const brush& aFill);
+        void draw_rounded_rect(const rect& aRect, const vec4& aRadiusX, const vec4& aRadiusY, const pen& aPen, const brush& aFill);
+        void draw_checkerboard(const rect& aRect, const size& aSquareSize, const pen& aPen, const brush& aFill1, const brush& aFill2);
+        void draw_ellipse(const point& aCenter, dimension aRadiusA, dimension aRadiusB, const pen& aPen, const brush& aFill);
+        void draw_arc(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, bool aPie, const pen& aPen, const brush& aFill);
+        void draw_cubic_bezier(const point& aP0, const point& aP1, const point& aP2, const point& aP3, const pen& aPen);
+        void draw_shape(const game::mesh& aMesh, const vec3& aPosition, const pen& aPen, const brush& aFill);
+        void draw_glyphs(const graphics_operation::draw_glyphs& aDrawGlyphs);
+        void draw_mesh(const game::mesh& aMesh, const game::material& aMaterial, const mat44& aTransformation);
+    private:
+        void update_state(queue_batch_item const& aQbi);
+        software_point to_device(vec2 const& aPoint) const;
+        software_box to_device(rect const& aRect) const;
+        dimension dpi_scale_factor() const;
+        software_box clip_box() const;
+        software_blend blend() const;
+        bool anti_aliased() const;
+        float opacity() const;
+        std::optional<software_paint> to_paint(color_or_gradient const& aColor, software_box const& aBoundingBox) const;
+        std::optional<software_paint> to_paint(brush const& aBrush, software_box const& aBoundingBox);
+        std::optional<software_paint> to_paint(i_texture const& aTexture, rect const& aPart, software_box const& aBoundingBox);
+        software_paint to_paint(gradient const& aGradient, software_box const& aBoundingBox) const;
+        void fill(contours const& aContours, brush const& aFill);
+        void fill(contours const& aContours, color_or_gradient const& aFill, bool aAntiAliased);
+        void stroke_outline(contour const& aOutline, const pen& aPen);
+        void stroke_polyline(contour const& aPolyline, const pen& aPen);
+        std::shared_ptr<software_texels const> texels(const i_texture& aTexture, const rect& aPart, bool aFlip);
+    private:
+        const software_render_target& iTarget;
+        bool iInFlush;
+        std::vector<i_rendering_context_filter*> iFilters;
+        rendering_context_fast_state iFastState;
+        rendering_context_slow_state iSlowState;
+        optional_vec2 iOffset;
+        std::optional<gradient> iGradient;
+        software_display_list iDisplayList;
+        std::map<std::tuple<void const*, scalar, scalar, scalar, scalar, bool>, std::shared_ptr<software_texels const>> iTexels;
+        sink iSink;
+    };
+}
@@ -43,6 +43,11 @@ void standard_glyph_shader(inout vec4 color, inout vec4 function0, inout vec4 fu
         else
         {
             a = texture(tex, TexCoord).r;
+            if (uGlyphDistanceField)
+            {
+                float w = fwidth(a) * 0.5;
+                a = smoothstep(uGlyphDistanceFieldEdge - w, uGlyphDistanceFieldEdge + w, a);
+            }
             if (a == 0)
                 discard;
             if (uTextureEffect != SHADER_EFFECT_MultiplyAlpha)
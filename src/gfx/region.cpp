@@ -0,0 +1,132 @@
+// region.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+
+#include <neogfx/gfx/region.hpp>
+
+namespace neogfx
+{
+    region::region(dimension aRectCost, std::size_t aMaxRects) :
+        iRectCost{ aRectCost }, iMaxRects{ std::max<std::size_t>(aMaxRects, 1u) }
+    {
+    }
+
+    bool region::empty() const
+    {
+        return iRects.empty();
+    }
+
+    vector<rect> const& region::rects() const
+    {
+        return iRects;
+    }
+
+    rect region::bounding_rect() const
+    {
+        if (iRects.empty())
+            return rect{};
+        rect result = iRects.as_std_vector().front();
+        for (auto const& r : iRects.as_std_vector())
+            result.combine(r);
+        return result;
+    }
+
+    dimension region::area() const
+    {
+        dimension result = 0.0;
+        for (auto const& r : iRects.as_std_vector())
+            result += area(r);
+        return result;
+    }
+
+    bool region::intersects(rect const& aRect) const
+    {
+        for (auto const& r : iRects.as_std_vector())
+            if (!r.intersection(aRect).empty())
+                return true;
+        return false;
+    }
+
+    void region::add(rect const& aRect)
+    {
+        if (aRect.cx <= 0.0 || aRect.cy <= 0.0)
+            return;
+        auto& rects = iRects.as_std_vector();
+        for (auto const& r : rects)
+            if (r.contains(aRect))
+                return;
+        // Absorb existing rects into the candidate until it is disjoint from, and not worth merging with, all of them.
+        rect candidate = aRect;
+        bool merged = true;
+        while (merged)
+        {
+            merged = false;
+            for (auto r = rects.begin(); r != rects.end(); ++r)
+                if (!r->intersection(candidate).empty() || merge_waste(*r, candidate) <= iRectCost)
+                {
+                    candidate.combine(*r);
+                    rects.erase(r);
+                    merged = true;
+                    break;
+                }
+        }
+        rects.push_back(candidate);
+        while (rects.size() > iMaxRects)
+            merge_cheapest_pair();
+    }
+
+    void region::clear()
+    {
+        iRects.clear();
+    }
+
+    dimension region::area(rect const& aRect)
+    {
+        return aRect.cx * aRect.cy;
+    }
+
+    dimension region::merge_waste(rect const& aFirst, rect const& aSecond) const
+    {
+        return area(aFirst.combined(aSecond)) - area(aFirst) - area(aSecond);
+    }
+
+    void region::merge_cheapest_pair()
+    {
+        auto& rects = iRects.as_std_vector();
+        std::size_t bestFirst = 0u;
+        std::size_t bestSecond = 1u;
+        dimension bestWaste = std::numeric_limits<dimension>::max();
+        for (std::size_t first = 0u; first < rects.size(); ++first)
+            for (std::size_t second = first + 1u; second < rects.size(); ++second)
+            {
+                auto const waste = merge_waste(rects[first], rects[second]);
+                if (waste < bestWaste)
+                {
+                    bestWaste = waste;
+                    bestFirst = first;
+                    bestSecond = second;
+                }
+            }
+        rect const merged = rects[bestFirst].combined(rects[bestSecond]);
+        rects.erase(rects.begin() + bestSecond);
+        rects.erase(rects.begin() + bestFirst);
+        add(merged);
+    }
+}
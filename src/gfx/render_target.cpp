@@ -19,6 +19,7 @@
 
 #include <neogfx/neogfx.hpp>
 
+#include <neogfx/app/profiler.hpp>
 #include <neogfx/gfx/i_rendering_engine.hpp>
 #include <neogfx/gfx/i_rendering_context.hpp>
 #include <neogfx/gfx/render_target.hpp>
@@ -27,6 +28,8 @@ namespace neogfx
 {
     void optimise_rendering_queue(rendering_queue_context& aContext, rendering_queue const& aInput, optimised_rendering_queue& aOutput)
     {
+        scoped_profiler_zone optimiseZone{ "optimise_rendering_queue", "flush" };
+
         bool const optimiseQueue = service<i_rendering_engine>().is_rendering_queue_optimization_on();
 
         auto fastState = aContext.intern_state(aContext.lastFastState.value_or(rendering_context_fast_state{}));
@@ -25,89 +25,121 @@
 
 namespace neogfx
 {
-    template <typename Vertex>
-    std::vector<Vertex> arc_vertices(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const point& aOrigin, mesh_type aType, std::uint32_t aArcSegments)
+    namespace
     {
-        std::vector<Vertex> result;
-        angle arc = (aEndAngle != aStartAngle ? aEndAngle - aStartAngle : boost::math::constants::two_pi<angle>());
-        std::uint32_t arcSegments = aArcSegments;
-        if (arcSegments == 0)
-            arcSegments = static_cast<std::uint32_t>(std::ceil(std::sqrt(aRadius) * 10.0) * arc / boost::math::constants::two_pi<angle>());
-        angle theta = arc / static_cast<angle>(arcSegments);
-        if (aType == mesh_type::TriangleFan)
-        {
-            result.reserve(arcSegments + 2);
-            result.push_back(xyz{ aOrigin.x, aOrigin.y });
-        }
-        else if (aType == mesh_type::Triangles)
-            result.reserve(arcSegments * 3);
-        else if (aType == mesh_type::Outline)
-            result.reserve(arcSegments + 1);
-        auto c = std::cos(theta);
-        auto s = std::sin(theta);
-        auto startCoordinate = mat22{ { std::cos(aStartAngle), std::sin(aStartAngle) },{ -std::sin(aStartAngle), std::cos(aStartAngle) } } *
-            vec2{ aRadius, 0.0 };
-        coordinate x = startCoordinate.x;
-        coordinate y = startCoordinate.y;
-        for (std::uint32_t i = 0; i < arcSegments; ++i)
-        {
-            if (aType == mesh_type::Triangles)
-                result.push_back(xyz{ aOrigin.x, aOrigin.y });
-            result.push_back(xyz{ x + aCenter.x, y + aCenter.y });
-            coordinate t = x;
-            x = c * x - s * y;
-            y = s * t + c * y;
-            if (aType == mesh_type::Triangles)
-                result.push_back(xyz{ x + aCenter.x, y + aCenter.y });
-        }
-        if (aStartAngle == aEndAngle)
+        std::size_t constexpr UNIT_ARC_CACHE_CAPACITY = 1024u;
+
+        template <typename Vertex>
+        inline void append_arc_vertices(std::vector<Vertex>& aResult, std::vector<vec2> const& aUnitArc, angle aStartAngle, const point& aCenter, dimension aRadius, const point& aOrigin, mesh_type aType, bool aClosed)
         {
+            scalar const cosStart = std::cos(aStartAngle);
+            scalar const sinStart = std::sin(aStartAngle);
+            std::uint32_t const arcSegments = static_cast<std::uint32_t>(aUnitArc.size() - 1u);
+            std::size_t const first = aResult.size();
             if (aType == mesh_type::TriangleFan)
-                result.push_back(result[1]);
+            {
+                aResult.reserve(first + arcSegments + 2);
+                aResult.push_back(xyz{ aOrigin.x, aOrigin.y });
+            }
+            else if (aType == mesh_type::Triangles)
+                aResult.reserve(first + arcSegments * 3);
             else if (aType == mesh_type::Outline)
-                result.push_back(result[0]);
+                aResult.reserve(first + arcSegments + 1);
+            auto const vertex = [&](std::uint32_t aIndex)
+            {
+                auto const& u = aUnitArc[aIndex];
+                return xyz{ (u.x * cosStart - u.y * sinStart) * aRadius + aCenter.x, (u.x * sinStart + u.y * cosStart) * aRadius + aCenter.y };
+            };
+            for (std::uint32_t i = 0; i < arcSegments; ++i)
+            {
+                if (aType == mesh_type::Triangles)
+                    aResult.push_back(xyz{ aOrigin.x, aOrigin.y });
+                aResult.push_back(vertex(i));
+                if (aType == mesh_type::Triangles)
+                    aResult.push_back(vertex(i + 1u));
+            }
+            if (aClosed)
+            {
+                if (aType == mesh_type::TriangleFan)
+                    aResult.push_back(aResult[first + 1]);
+                else if (aType == mesh_type::Outline)
+                    aResult.push_back(aResult[first]);
+            }
+        }
+    }
+
+    std::uint32_t arc_segments(dimension aRadius, angle aArc, dimension aMaxChordError, dimension aDpiScaleFactor)
+    {
+        // Sagitta of a chord subtending angle theta is r(1 - cos(theta / 2)); solve for the
+        // largest theta that keeps it within the maximum chord error at device resolution.
+        dimension const radius = std::abs(aRadius) * aDpiScaleFactor;
+        angle const arc = std::abs(aArc);
+        auto const minimumSegments = std::max<std::uint32_t>(1u, static_cast<std::uint32_t>(std::ceil(arc / boost::math::constants::half_pi<angle>())));
+        if (radius <= aMaxChordError || arc == 0.0)
+            return minimumSegments;
+        angle const theta = 2.0 * std::acos(1.0 - aMaxChordError / radius);
+        return std::max(minimumSegments, static_cast<std::uint32_t>(std::ceil(arc / theta)));
+    }
+
+    std::vector<vec2> const& unit_arc(std::uint32_t aArcSegments, angle aArc)
+    {
+        // The returned reference is only valid until the next call (the cache is flushed when full).
+        thread_local std::map<std::pair<std::uint32_t, angle>, std::vector<vec2>> tCache;
+        auto const key = std::make_pair(aArcSegments, aArc);
+        auto existing = tCache.find(key);
+        if (existing != tCache.end())
+            return existing->second;
+        if (tCache.size() >= UNIT_ARC_CACHE_CAPACITY)
+            tCache.clear();
+        auto& result = tCache[key];
+        result.reserve(aArcSegments + 1u);
+        angle const theta = aArc / static_cast<angle>(aArcSegments);
+        for (std::uint32_t i = 0; i <= aArcSegments; ++i)
+        {
+            angle const a = theta * static_cast<angle>(i);
+            result.push_back(vec2{ std::cos(a), std::sin(a) });
         }
         return result;
     }
 
+    std::vector<vec2> const& unit_arc(std::uint32_t aArcSegments, angle aStartAngle, angle aArc)
+    {
+        auto const& unrotated = unit_arc(aArcSegments, aArc);
+        if (aStartAngle == 0.0)
+            return unrotated;
+        thread_local std::vector<vec2> tRotated;
+        scalar const cosStart = std::cos(aStartAngle);
+        scalar const sinStart = std::sin(aStartAngle);
+        tRotated.clear();
+        tRotated.reserve(unrotated.size());
+        for (auto const& u : unrotated)
+            tRotated.push_back(vec2{ u.x * cosStart - u.y * sinStart, u.x * sinStart + u.y * cosStart });
+        return tRotated;
+    }
+
     template <typename Vertex>
-    std::vector<Vertex> circle_vertices(const point& aCenter, dimension aRadius, angle aStartAngle, mesh_type aType, std::uint32_t aArcSegments)
+    void calc_arc_vertices(std::vector<Vertex>& aResult, const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const point& aOrigin, mesh_type aType, std::uint32_t aArcSegments, dimension aDpiScaleFactor)
     {
-        return arc_vertices<Vertex>(aCenter, aRadius, aStartAngle, aStartAngle, aCenter, aType, aArcSegments);
+        angle arc = (aEndAngle != aStartAngle ? aEndAngle - aStartAngle : boost::math::constants::two_pi<angle>());
+        std::uint32_t arcSegments = aArcSegments;
+        if (arcSegments == 0)
+            arcSegments = arc_segments(aRadius, arc, DEFAULT_MAX_CHORD_ERROR, aDpiScaleFactor);
+        append_arc_vertices(aResult, unit_arc(arcSegments, arc), aStartAngle, aCenter, aRadius, aOrigin, aType, aStartAngle == aEndAngle);
     }
 
     template <typename Vertex>
-    std::vector<Vertex> rounded_rect_vertices(const rect& aRect, dimension aRadius, mesh_type aType, std::uint32_t aArcSegments)
+    void calc_circle_vertices(std::vector<Vertex>& aResult, const point& aCenter, dimension aRadius, angle aStartAngle, mesh_type aType, std::uint32_t aArcSegments, dimension aDpiScaleFactor)
     {
-        std::vector<Vertex> result;
-        auto const topLeft = arc_vertices<Vertex>(
-            aRect.top_left() + point{ aRadius, aRadius },
-            aRadius,
-            boost::math::constants::pi<coordinate>(),
-            boost::math::constants::pi<coordinate>() * 1.5,
-            aRect.center(),
-            aType, aArcSegments);
-        auto const topRight = arc_vertices<Vertex>(
-            aRect.top_right() + point{ -aRadius, aRadius },
-            aRadius,
-            boost::math::constants::pi<coordinate>() * 1.5,
-            boost::math::constants::pi<coordinate>() * 2.0,
-            aRect.center(),
-            aType, aArcSegments);
-        auto const bottomRight = arc_vertices<Vertex>(
-            aRect.bottom_right() + point{ -aRadius, -aRadius },
-            aRadius,
-            0.0,
-            boost::math::constants::pi<coordinate>() * 0.5,
-            aRect.center(),
-            aType, aArcSegments);
-        auto const bottomLeft = arc_vertices<Vertex>(
-            aRect.bottom_left() + point{ aRadius, -aRadius },
-            aRadius,
-            boost::math::constants::pi<coordinate>() * 0.5,
-            boost::math::constants::pi<coordinate>(),
-            aRect.center(),
-            aType, aArcSegments);
+        calc_arc_vertices<Vertex>(aResult, aCenter, aRadius, aStartAngle, aStartAngle, aCenter, aType, aArcSegments, aDpiScaleFactor);
+    }
+
+    template <typename Vertex>
+    void calc_rounded_rect_vertices(std::vector<Vertex>& aResult, const rect& aRect, dimension aRadius, mesh_type aType, std::uint32_t aArcSegments, dimension aDpiScaleFactor)
+    {
+        angle constexpr pi = boost::math::constants::pi<angle>();
+        std::uint32_t const arcSegments = (aArcSegments != 0 ? aArcSegments : arc_segments(aRadius, pi * 0.5, DEFAULT_MAX_CHORD_ERROR, aDpiScaleFactor));
+        auto const& quadrant = unit_arc(arcSegments, pi * 0.5);
+        auto const center = aRect.center();
         std::array<xyz, 8> const remainingCoordinates =
         {
             xyz{ (aRect.top_left() + point{ 0.0, aRadius }).x, (aRect.top_left() + point{ 0.0, aRadius }).y },
@@ -119,50 +151,80 @@ namespace neogfx
             xyz{ (aRect.bottom_left() + point{ aRadius, 0.0 }).x, (aRect.bottom_left() + point{ aRadius, 0.0 }).y },
             xyz{ (aRect.bottom_left() + point{ 0.0, -aRadius }).x, (aRect.bottom_left() + point{ 0.0, -aRadius }).y }
         };
+        auto const first = aResult.size();
         if (aType == mesh_type::TriangleFan || aType == mesh_type::Outline)
         {
-            result.reserve(topLeft.size() + topRight.size() + bottomRight.size() + bottomLeft.size() + (aType == mesh_type::TriangleFan ? 10 : 9));
+            aResult.reserve(first + (arcSegments + 1u) * 4u + (aType == mesh_type::TriangleFan ? 10 : 9));
             if (aType == mesh_type::TriangleFan)
-                result.push_back(xyz{ aRect.center().x, aRect.center().y });
-            result.insert(result.end(), remainingCoordinates[0]);
-            result.insert(result.end(), topLeft.begin(), topLeft.end());
-            result.insert(result.end(), remainingCoordinates[1]);
-            result.insert(result.end(), remainingCoordinates[2]);
-            result.insert(result.end(), topRight.begin(), topRight.end());
-            result.insert(result.end(), remainingCoordinates[3]);
-            result.insert(result.end(), remainingCoordinates[4]);
-            result.insert(result.end(), bottomRight.begin(), bottomRight.end());
-            result.insert(result.end(), remainingCoordinates[5]);
-            result.insert(result.end(), remainingCoordinates[6]);
-            result.insert(result.end(), bottomLeft.begin(), bottomLeft.end());
-            result.insert(result.end(), remainingCoordinates[7]);
-            result.push_back(result[aType == mesh_type::TriangleFan ? 1 : 0]);
+                aResult.push_back(xyz{ center.x, center.y });
+            aResult.push_back(remainingCoordinates[0]);
+            append_arc_vertices(aResult, quadrant, pi, aRect.top_left() + point{ aRadius, aRadius }, aRadius, center, aType, false);
+            aResult.push_back(remainingCoordinates[1]);
+            aResult.push_back(remainingCoordinates[2]);
+            append_arc_vertices(aResult, quadrant, pi * 1.5, aRect.top_right() + point{ -aRadius, aRadius }, aRadius, center, aType, false);
+            aResult.push_back(remainingCoordinates[3]);
+            aResult.push_back(remainingCoordinates[4]);
+            append_arc_vertices(aResult, quadrant, 0.0, aRect.bottom_right() + point{ -aRadius, -aRadius }, aRadius, center, aType, false);
+            aResult.push_back(remainingCoordinates[5]);
+            aResult.push_back(remainingCoordinates[6]);
+            append_arc_vertices(aResult, quadrant, pi * 0.5, aRect.bottom_left() + point{ aRadius, -aRadius }, aRadius, center, aType, false);
+            aResult.push_back(remainingCoordinates[7]);
+            aResult.push_back(aResult[first + (aType == mesh_type::TriangleFan ? 1 : 0)]);
         }
         else if (aType == mesh_type::Triangles)
         {
-            result.reserve(topLeft.size() + topRight.size() + bottomRight.size() + bottomLeft.size() + (remainingCoordinates.size() - 1) * 3 + 3);
-            result.insert(result.end(), topLeft.begin(), topLeft.end());
-            result.insert(result.end(), topRight.begin(), topRight.end());
-            result.insert(result.end(), bottomRight.begin(), bottomRight.end());
-            result.insert(result.end(), bottomLeft.begin(), bottomLeft.end());
+            aResult.reserve(first + arcSegments * 3u * 4u + (remainingCoordinates.size() - 1) * 3 + 3);
+            append_arc_vertices(aResult, quadrant, pi, aRect.top_left() + point{ aRadius, aRadius }, aRadius, center, aType, false);
+            append_arc_vertices(aResult, quadrant, pi * 1.5, aRect.top_right() + point{ -aRadius, aRadius }, aRadius, center, aType, false);
+            append_arc_vertices(aResult, quadrant, 0.0, aRect.bottom_right() + point{ -aRadius, -aRadius }, aRadius, center, aType, false);
+            append_arc_vertices(aResult, quadrant, pi * 0.5, aRect.bottom_left() + point{ aRadius, -aRadius }, aRadius, center, aType, false);
             for (std::size_t i = 0u; i < remainingCoordinates.size() - 1; ++i)
             {
-                result.insert(result.end(), xyz{ aRect.center().x, aRect.center().y });
-                result.insert(result.end(), remainingCoordinates[i]);
-                result.insert(result.end(), remainingCoordinates[i + 1u]);
+                aResult.push_back(xyz{ center.x, center.y });
+                aResult.push_back(remainingCoordinates[i]);
+                aResult.push_back(remainingCoordinates[i + 1u]);
             }
-            result.insert(result.end(), xyz{ aRect.center().x, aRect.center().y });
-            result.insert(result.end(), remainingCoordinates[7]);
-            result.insert(result.end(), remainingCoordinates[0]);
+            aResult.push_back(xyz{ center.x, center.y });
+            aResult.push_back(remainingCoordinates[7]);
+            aResult.push_back(remainingCoordinates[0]);
         }
+    }
+
+    template <typename Vertex>
+    std::vector<Vertex> arc_vertices(const point& aCenter, dimension aRadius, angle aStartAngle, angle aEndAngle, const point& aOrigin, mesh_type aType, std::uint32_t aArcSegments, dimension aDpiScaleFactor)
+    {
+        std::vector<Vertex> result;
+        calc_arc_vertices(result, aCenter, aRadius, aStartAngle, aEndAngle, aOrigin, aType, aArcSegments, aDpiScaleFactor);
+        return result;
+    }
+
+    template <typename Vertex>
+    std::vector<Vertex> circle_vertices(const point& aCenter, dimension aRadius, angle aStartAngle, mesh_type aType, std::uint32_t aArcSegments, dimension aDpiScaleFactor)
+    {
+        std::vector<Vertex> result;
+        calc_circle_vertices(result, aCenter, aRadius, aStartAngle, aType, aArcSegments, aDpiScaleFactor);
+        return result;
+    }
+
+    template <typename Vertex>
+    std::vector<Vertex> rounded_rect_vertices(const rect& aRect, dimension aRadius, mesh_type aType, std::uint32_t aArcSegments, dimension aDpiScaleFactor)
+    {
+        std::vector<Vertex> result;
+        calc_rounded_rect_vertices(result, aRect, aRadius, aType, aArcSegments, aDpiScaleFactor);
         return result;
     }
 
-    template std::vector<vec3> arc_vertices<vec3>(const point&, dimension, angle, angle, const point&, mesh_type, std::uint32_t);
-    template std::vector<vec3> circle_vertices<vec3>(const point&, dimension, angle, mesh_type, std::uint32_t);
-    template std::vector<vec3> rounded_rect_vertices<vec3>(const rect&, dimension, mesh_type, std::uint32_t);
+    template void calc_arc_vertices<vec3>(std::vector<vec3>&, const point&, dimension, angle, angle, const point&, mesh_type, std::uint32_t, dimension);
+    template void calc_circle_vertices<vec3>(std::vector<vec3>&, const point&, dimension, angle, mesh_type, std::uint32_t, dimension);
+    template void calc_rounded_rect_vertices<vec3>(std::vector<vec3>&, const rect&, dimension, mesh_type, std::uint32_t, dimension);
+    template std::vector<vec3> arc_vertices<vec3>(const point&, dimension, angle, angle, const point&, mesh_type, std::uint32_t, dimension);
+    template std::vector<vec3> circle_vertices<vec3>(const point&, dimension, angle, mesh_type, std::uint32_t, dimension);
+    template std::vector<vec3> rounded_rect_vertices<vec3>(const rect&, dimension, mesh_type, std::uint32_t, dimension);
 
-    template std::vector<vec3f> arc_vertices<vec3f>(const point&, dimension, angle, angle, const point&, mesh_type, std::uint32_t);
-    template std::vector<vec3f> circle_vertices<vec3f>(const point&, dimension, angle, mesh_type, std::uint32_t);
-    template std::vector<vec3f> rounded_rect_vertices<vec3f>(const rect&, dimension, mesh_type, std::uint32_t);
+    template void calc_arc_vertices<vec3f>(std::vector<vec3f>&, const point&, dimension, angle, angle, const point&, mesh_type, std::uint32_t, dimension);
+    template void calc_circle_vertices<vec3f>(std::vector<vec3f>&, const point&, dimension, angle, mesh_type, std::uint32_t, dimension);
+    template void calc_rounded_rect_vertices<vec3f>(std::vector<vec3f>&, const rect&, dimension, mesh_type, std::uint32_t, dimension);
+    template std::vector<vec3f> arc_vertices<vec3f>(const point&, dimension, angle, angle, const point&, mesh_type, std::uint32_t, dimension);
+    template std::vector<vec3f> circle_vertices<vec3f>(const point&, dimension, angle, mesh_type, std::uint32_t, dimension);
+    template std::vector<vec3f> rounded_rect_vertices<vec3f>(const rect&, dimension, mesh_type, std::uint32_t, dimension);
 }
\ No newline at end of file
@@ -19,96 +19,143 @@
 
 #include <neogfx/neogfx.hpp>
 
-#include <sstream>
+#include <charconv>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <sstream>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
-#include <neolib/core/string_utils.hpp>
 #include <neolib/file/file.hpp>
 #include <neolib/file/zip.hpp>
 
+#include <neogfx/core/mapped_file.hpp>
 #include <neogfx/gfx/image.hpp>
 #include <neogfx/gfx/text/emoji_atlas.hpp>
 
 namespace neogfx
 {
+    namespace
+    {
+        constexpr char INDEX_MAGIC[8] = { 'N', 'G', 'F', 'X', 'E', 'M', 'J', 'I' };
+
+        std::filesystem::path to_path(std::string const& aPath)
+        {
+            return std::filesystem::path{ std::u8string{ aPath.begin(), aPath.end() } };
+        }
+
+        std::pair<std::uint64_t, std::int64_t> zip_signature(std::string const& aZipPath)
+        {
+            auto const path = to_path(aZipPath);
+            return { static_cast<std::uint64_t>(std::filesystem::file_size(path)),
+                static_cast<std::int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count()) };
+        }
+
+        bool write_index(std::string const& aIndexPath, std::vector<char> const& aIndex)
+        {
+            auto const path = to_path(aIndexPath);
+            auto const temporaryPath = to_path(aIndexPath + ".tmp");
+            {
+                std::ofstream file{ temporaryPath, std::ios::out | std::ios::binary | std::ios::trunc };
+                file.write(aIndex.data(), static_cast<std::streamsize>(aIndex.size()));
+                if (!file.good())
+                {
+                    file.close();
+                    std::error_code ignored;
+                    std::filesystem::remove(temporaryPath, ignored);
+                    return false;
+                }
+            }
+            std::error_code error;
+            std::filesystem::rename(temporaryPath, path, error);
+            if (error)
+            {
+                std::filesystem::remove(temporaryPath, error);
+                return false;
+            }
+            return true;
+        }
+    }
+
     emoji_atlas::emoji_atlas() : 
         kFilePath{ neolib::program_directory() + "/emoji.zip" },
         iTextureAtlas{ service<i_texture_manager>().create_texture_atlas(size{ 1024.0, 1024.0}) }
     {
+        static_assert(sizeof(index_header) == 48u && sizeof(index_node) == 16u && sizeof(index_edge) == 8u && sizeof(index_file) == 16u,
+            "emoji index file layout changed");
         try
         {
             if (std::filesystem::exists(kFilePath))
             {
-                neolib::zip zipFile(kFilePath);
-                std::istringstream metaDataFile{ zipFile.extract_to_string(zipFile.index_of("meta.json")) };
-                boost::property_tree::ptree metaData;
-                boost::property_tree::read_json(metaDataFile, metaData);
-                for (auto const& set : metaData.get_child("sets"))
+                auto const indexPath = neolib::program_directory() + "/emoji.idx";
+                try
                 {
-                    dimension size = set.second.get<dimension>("size");
-                    std::string location = set.second.get<std::string>("location");
-                    std::string prefix = set.second.get<std::string>("prefix", "");
-                    std::string separator = set.second.get<std::string>("separator", "-");
-                    for (std::size_t i = 0; i < zipFile.file_count(); ++i)
+                    if (std::filesystem::exists(to_path(indexPath)))
                     {
-                        auto const& filePath = zipFile.file_path(i);
-                        if (filePath.find(location) == 0)
-                        {
-                            std::u32string codePoints;
-                            std::vector<std::string> hexCodePoints;
-                            auto filename = std::filesystem::path(filePath).stem().string();
-                            if (filename.size() <= prefix.size() || (!prefix.empty() && filename.find(prefix) != 0))
-                                continue;
-                            neolib::tokens(filename.substr(prefix.size()), separator, hexCodePoints);
-                            for (auto const& hexCodePoint : hexCodePoints)
-                            {
-                                std::stringstream ss;
-                                ss << std::hex << hexCodePoint;
-                                std::uint32_t x;
-                                ss >> x;
-                                if (x < 256)
-                                    break;
-                                codePoints.push_back(x);
-                            }
-                            if (!codePoints.empty())
-                            {
-                                iEmojis[codePoints][size] = filePath;
-                                iEmojiMap[codePoints] = std::optional<emoji_id>{};
-                            }
-                        }
+                        iIndexFile = std::make_unique<mapped_file>(indexPath);
+                        if (!use_index(iIndexFile->data(), static_cast<std::size_t>(iIndexFile->size())))
+                            iIndexFile.reset();
                     }
                 }
+                catch (...)
+                {
+                    iIndexFile.reset();
+                }
+                if (!iIndexFile)
+                {
+                    // Missing or out of date so generate it, keeping it in memory if it can't be saved (e.g. the
+                    // program directory is read-only).
+                    iIndexData = generate_index(kFilePath);
+                    write_index(indexPath, iIndexData);
+                    if (!use_index(iIndexData.data(), iIndexData.size()))
+                        iIndexData.clear();
+                }
             }
         }
         catch (...)
         {
         }
+        index_single_code_point_emojis();
+    }
+
+    emoji_atlas::~emoji_atlas()
+    {
     }
 
     bool emoji_atlas::is_emoji(char32_t aCodePoint) const
     {
-        thread_local std::u32string str;
-        str = aCodePoint;
-        return is_emoji(str);
+        auto const block = static_cast<std::size_t>(aCodePoint >> 8u);
+        if (block >= iSingleEmojiBlocks.size())
+            return false;
+        auto const& bits = iSingleEmojiBits[iSingleEmojiBlocks[block]];
+        return ((bits[(aCodePoint >> 6u) & 3u] >> (aCodePoint & 63u)) & 1u) != 0u;
     }
 
     bool emoji_atlas::is_emoji(const std::u32string& aCodePoints) const
     {
-        return iEmojiMap.find(aCodePoints) != iEmojiMap.end();
+        auto const node = find(aCodePoints.data(), aCodePoints.data() + aCodePoints.size());
+        return node && iNodes[*node].fileCount != 0u;
     }
 
     bool emoji_atlas::is_emoji(const std::u32string& aCodePoints, std::u32string& aPartial) const
     {
         aPartial.clear();
-        auto existing = iEmojiMap.lower_bound(aCodePoints);
-        if (existing == iEmojiMap.end())
+        auto const node = find(aCodePoints.data(), aCodePoints.data() + aCodePoints.size());
+        if (!node)
             return false;
-        if (existing->first == aCodePoints)
+        if (iNodes[*node].fileCount != 0u)
             return true;
-        if (existing->first.find(aCodePoints) == 0)
-            aPartial = existing->first;
+        // The partial match is the first emoji in sequence order beginning with the code points: the first emoji
+        // reached following each node's lowest edge.
+        auto next = *node;
+        while (iNodes[next].fileCount == 0u && iNodes[next].edgeCount != 0u)
+            next = iEdges[iNodes[next].firstEdge].child;
+        if (iNodes[next].fileCount == 0u)
+            return false;
+        aPartial = aCodePoints;
+        for (next = *node; iNodes[next].fileCount == 0u; next = iEdges[iNodes[next].firstEdge].child)
+            aPartial.push_back(static_cast<char32_t>(iEdges[iNodes[next].firstEdge].codePoint));
         return false;
     }
 
@@ -121,22 +168,236 @@ namespace neogfx
 
     emoji_atlas::emoji_id emoji_atlas::emoji(const std::u32string& aCodePoints, dimension aDesiredSize) const
     {
-        auto iterEmoji = iEmojiMap.find(aCodePoints);
-        if (iterEmoji == iEmojiMap.end())
+        auto const node = find(aCodePoints.data(), aCodePoints.data() + aCodePoints.size());
+        if (!node || iNodes[*node].fileCount == 0u)
             throw emoji_not_found();
-        if (iterEmoji->second == std::nullopt)
+        auto& id = iEmojiIds[*node];
+        if (id == std::nullopt)
         {
-            auto emojiFiles = iEmojis.find(aCodePoints);
-            auto emojiFile = emojiFiles->second.lower_bound(aDesiredSize);
-            if (emojiFile == emojiFiles->second.end())
+            auto const firstFile = iFiles + iNodes[*node].firstFile;
+            auto const lastFile = firstFile + iNodes[*node].fileCount;
+            auto emojiFile = std::lower_bound(firstFile, lastFile, aDesiredSize,
+                [](index_file const& aFile, dimension aSize) { return aFile.size < aSize; });
+            if (emojiFile == lastFile)
                 --emojiFile;
-            iterEmoji->second = iTextureAtlas->create_sub_texture(neogfx::image{ "file:///" + kFilePath + "#" + emojiFile->second }).atlas_id();
+            id = iTextureAtlas->create_sub_texture(neogfx::image{ "file:///" + kFilePath + "#" + std::string{ file_path(*emojiFile) } }).atlas_id();
         }
-        return *iterEmoji->second;
+        return *id;
     }
 
     const i_texture& emoji_atlas::emoji_texture(emoji_id aId) const
     {
         return iTextureAtlas->sub_texture(aId);
     }
+
+    bool emoji_atlas::build_index(std::string const& aZipPath, std::string const& aIndexPath)
+    {
+        try
+        {
+            return write_index(aIndexPath, generate_index(aZipPath));
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+
+    std::vector<char> emoji_atlas::generate_index(std::string const& aZipPath)
+    {
+        struct node
+        {
+            std::map<char32_t, node_index> children;
+            std::map<dimension, std::string> files;
+        };
+        std::vector<node> nodes(1u);
+
+        neolib::zip zipFile(aZipPath);
+        std::istringstream metaDataFile{ zipFile.extract_to_string(zipFile.index_of("meta.json")) };
+        boost::property_tree::ptree metaData;
+        boost::property_tree::read_json(metaDataFile, metaData);
+        for (auto const& set : metaData.get_child("sets"))
+        {
+            dimension size = set.second.get<dimension>("size");
+            std::string location = set.second.get<std::string>("location");
+            std::string prefix = set.second.get<std::string>("prefix", "");
+            std::string separator = set.second.get<std::string>("separator", "-");
+            for (std::size_t i = 0; i < zipFile.file_count(); ++i)
+            {
+                auto const& filePath = zipFile.file_path(i);
+                if (filePath.find(location) != 0)
+                    continue;
+                auto const filename = std::filesystem::path(filePath).stem().string();
+                if (filename.size() <= prefix.size() || (!prefix.empty() && filename.find(prefix) != 0))
+                    continue;
+                // Walk (adding) the trie node of each hex code point in turn; the sequence ends at the first that
+                // isn't an atlas emoji code point.
+                node_index current = 0u;
+                std::string_view hexCodePoints{ filename };
+                hexCodePoints.remove_prefix(prefix.size());
+                while (!hexCodePoints.empty())
+                {
+                    auto const end = separator.empty() ? std::string_view::npos : hexCodePoints.find(separator);
+                    auto const hexCodePoint = hexCodePoints.substr(0u, end);
+                    hexCodePoints.remove_prefix(end == std::string_view::npos ? hexCodePoints.size() : end + separator.size());
+                    if (hexCodePoint.empty())
+                        continue;
+                    std::uint32_t x = 0u;
+                    std::from_chars(hexCodePoint.data(), hexCodePoint.data() + hexCodePoint.size(), x, 16);
+                    if (x < 256)
+                        break;
+                    auto existing = nodes[current].children.find(x);
+                    if (existing == nodes[current].children.end())
+                    {
+                        auto const child = static_cast<node_index>(nodes.size());
+                        nodes[current].children.emplace(x, child);
+                        nodes.emplace_back();
+                        current = child;
+                    }
+                    else
+                        current = existing->second;
+                }
+                if (current != 0u)
+                    nodes[current].files[size] = filePath;
+            }
+        }
+
+        // Nodes are numbered in creation order so children always follow their parent.
+        std::vector<index_node> indexNodes;
+        std::vector<index_edge> indexEdges;
+        std::vector<index_file> indexFiles;
+        std::string paths;
+        indexNodes.reserve(nodes.size());
+        indexEdges.reserve(nodes.size() - 1u);
+        for (auto const& n : nodes)
+        {
+            indexNodes.push_back(index_node{
+                static_cast<std::uint32_t>(indexEdges.size()), static_cast<std::uint32_t>(n.children.size()),
+                static_cast<std::uint32_t>(indexFiles.size()), static_cast<std::uint32_t>(n.files.size()) });
+            for (auto const& child : n.children)
+                indexEdges.push_back(index_edge{ static_cast<std::uint32_t>(child.first), child.second });
+            for (auto const& file : n.files)
+            {
+                indexFiles.push_back(index_file{ file.first, static_cast<std::uint32_t>(paths.size()), static_cast<std::uint32_t>(file.second.size()) });
+                paths += file.second;
+            }
+        }
+
+        index_header header = {};
+        std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        header.version = INDEX_VERSION;
+        header.byteOrderMark = INDEX_BYTE_ORDER_MARK;
+        std::tie(header.zipSize, header.zipWriteTime) = zip_signature(aZipPath);
+        header.nodeCount = static_cast<std::uint32_t>(indexNodes.size());
+        header.edgeCount = static_cast<std::uint32_t>(indexEdges.size());
+        header.fileCount = static_cast<std::uint32_t>(indexFiles.size());
+        header.pathBytes = static_cast<std::uint32_t>(paths.size());
+        std::vector<char> result;
+        auto const append = [&](void const* aData, std::size_t aSize)
+        {
+            auto const bytes = static_cast<char const*>(aData);
+            result.insert(result.end(), bytes, bytes + aSize);
+        };
+        append(&header, sizeof(header));
+        append(indexNodes.data(), indexNodes.size() * sizeof(index_node));
+        append(indexEdges.data(), indexEdges.size() * sizeof(index_edge));
+        append(indexFiles.data(), indexFiles.size() * sizeof(index_file));
+        append(paths.data(), paths.size());
+        return result;
+    }
+
+    bool emoji_atlas::use_index(char const* aData, std::size_t aSize)
+    {
+        if (aSize < sizeof(index_header))
+            return false;
+        auto const& header = *reinterpret_cast<index_header const*>(aData);
+        if (std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || header.version != INDEX_VERSION ||
+            header.byteOrderMark != INDEX_BYTE_ORDER_MARK || header.nodeCount == 0u || !current_index(header))
+            return false;
+        auto const nodesStart = sizeof(index_header);
+        auto const edgesStart = nodesStart + std::uint64_t{ header.nodeCount } * sizeof(index_node);
+        auto const filesStart = edgesStart + std::uint64_t{ header.edgeCount } * sizeof(index_edge);
+        auto const pathsStart = filesStart + std::uint64_t{ header.fileCount } * sizeof(index_file);
+        if (pathsStart + header.pathBytes != aSize)
+            return false;
+        auto const nodes = reinterpret_cast<index_node const*>(aData + nodesStart);
+        auto const edges = reinterpret_cast<index_edge const*>(aData + edgesStart);
+        auto const files = reinterpret_cast<index_file const*>(aData + filesStart);
+        // Lookups trust the index so check it is well formed: ranges in bounds, edges sorted and leading to later
+        // nodes (no cycles), leaves being emoji and each emoji's files sorted by size.
+        for (std::uint32_t n = 0u; n < header.nodeCount; ++n)
+        {
+            auto const& node = nodes[n];
+            if (std::uint64_t{ node.firstEdge } + node.edgeCount > header.edgeCount ||
+                std::uint64_t{ node.firstFile } + node.fileCount > header.fileCount)
+                return false;
+            if (n != 0u && node.edgeCount == 0u && node.fileCount == 0u)
+                return false;
+            for (auto e = node.firstEdge; e < node.firstEdge + node.edgeCount; ++e)
+                if (edges[e].child <= n || edges[e].child >= header.nodeCount || (e > node.firstEdge && edges[e - 1u].codePoint >= edges[e].codePoint))
+                    return false;
+            for (auto f = node.firstFile; f < node.firstFile + node.fileCount; ++f)
+                if (std::uint64_t{ files[f].pathOffset } + files[f].pathLength > header.pathBytes || (f > node.firstFile && !(files[f - 1u].size < files[f].size)))
+                    return false;
+        }
+        iNodes = nodes;
+        iEdges = edges;
+        iFiles = files;
+        iPaths = aData + pathsStart;
+        iNodeCount = header.nodeCount;
+        iEmojiIds.assign(iNodeCount, std::nullopt);
+        return true;
+    }
+
+    bool emoji_atlas::current_index(index_header const& aHeader) const
+    {
+        auto const signature = zip_signature(kFilePath);
+        return aHeader.zipSize == signature.first && aHeader.zipWriteTime == signature.second;
+    }
+
+    std::optional<emoji_atlas::node_index> emoji_atlas::find(char32_t const* aFirst, char32_t const* aLast) const
+    {
+        if (iNodeCount == 0u)
+            return {};
+        node_index current = 0u;
+        for (; aFirst != aLast; ++aFirst)
+        {
+            auto const& node = iNodes[current];
+            auto const firstEdge = iEdges + node.firstEdge;
+            auto const lastEdge = firstEdge + node.edgeCount;
+            auto const edge = std::lower_bound(firstEdge, lastEdge, static_cast<std::uint32_t>(*aFirst),
+                [](index_edge const& aEdge, std::uint32_t aCodePoint) { return aEdge.codePoint < aCodePoint; });
+            if (edge == lastEdge || edge->codePoint != static_cast<std::uint32_t>(*aFirst))
+                return {};
+            current = edge->child;
+        }
+        return current;
+    }
+
+    std::string_view emoji_atlas::file_path(index_file const& aFile) const
+    {
+        return std::string_view{ iPaths + aFile.pathOffset, aFile.pathLength };
+    }
+
+    void emoji_atlas::index_single_code_point_emojis()
+    {
+        iSingleEmojiBlocks.clear();
+        iSingleEmojiBits.assign(1u, code_point_bits{});
+        if (iNodeCount == 0u)
+            return;
+        for (auto e = iNodes[0].firstEdge; e < iNodes[0].firstEdge + iNodes[0].edgeCount; ++e)
+        {
+            if (iNodes[iEdges[e].child].fileCount == 0u)
+                continue;
+            auto const codePoint = iEdges[e].codePoint;
+            auto const block = static_cast<std::size_t>(codePoint >> 8u);
+            if (block >= iSingleEmojiBlocks.size())
+                iSingleEmojiBlocks.resize(block + 1u, 0u);
+            if (iSingleEmojiBlocks[block] == 0u)
+            {
+                iSingleEmojiBlocks[block] = static_cast<std::uint16_t>(iSingleEmojiBits.size());
+                iSingleEmojiBits.emplace_back();
+            }
+            iSingleEmojiBits[iSingleEmojiBlocks[block]][(codePoint >> 6u) & 3u] |= (std::uint64_t{ 1u } << (codePoint & 63u));
+        }
+    }
 }
\ No newline at end of file
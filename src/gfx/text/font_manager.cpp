@@ -20,6 +20,9 @@
 #include <neogfx/neogfx.hpp>
 
 #include <filesystem>
+#include <list>
+#include <mutex>
+#include <boost/functional/hash.hpp>
 #include <neolib/core/string_utils.hpp>
 #include <neolib/core/string_utf.hpp>
 #include <ft2build.h>
@@ -28,6 +31,7 @@
 #include FT_GLYPH_H
 #include FT_OUTLINE_H
 #include FT_BITMAP_H
+#include FT_MODULE_H
 #ifdef u8
 #undef u8
 #include <harfbuzz\hb.h>
@@ -53,6 +57,8 @@
 #include <neogfx/gfx/text/glyph_text.ipp>
 #include "../../gfx/text/native/native_font_face.hpp"
 #include "../../gfx/text/native/native_font.hpp"
+#include "../../gfx/text/native/glyph_rasterizer.hpp"
+#include "../../gfx/text/native/persistent_glyph_cache.hpp"
 
 template <>
 neogfx::i_font_manager& services::start_service<neogfx::i_font_manager>()
@@ -171,6 +177,9 @@ namespace neogfx
         return *f;
     }
 
+    class glyph_shapes;
+    class shaped_run_cache;
+
     class glyph_text_factory : public i_glyph_text_factory
     {
     public:
@@ -190,11 +199,25 @@ namespace neogfx
             hb_script_t script;
         };
         typedef std::vector<glyph_run> run_list;
+    public:
+        glyph_text_factory();
+        ~glyph_text_factory();
     public:
         glyph_text create_glyph_text() override;
         glyph_text create_glyph_text(font const& aFont) override;
         glyph_text to_glyph_text(i_graphics_context const& aGc, char const* aUtf8Begin, char const* aUtf8End, i_font_selector const& aFontSelector, bool aAlignBaselines = true) override;
         glyph_text to_glyph_text(i_graphics_context const& aGc, char32_t const* aUtf32Begin, char32_t const* aUtf32End, i_font_selector const& aFontSelector, bool aAlignBaselines = true) override;
+        void preshape(i_graphics_context const& aGc, char32_t const* aUtf32Begin, char32_t const* aUtf32End, i_font_selector const& aFontSelector) override;
+    public:
+        shaping_cache_statistics cache_statistics() const override;
+        void set_cache_memory_limit(std::size_t aMemoryLimit) override;
+        void clear_cache() override;
+    private:
+        void segment(i_graphics_context const& aGc, char32_t const* aCodePoints, std::u32string::size_type aCodePointCount, i_font_selector const& aFontSelector,
+            run_list& aRuns, std::vector<character_type>& aTextDirections, bool& aHasEmojis) const;
+        glyph_shapes shape(i_graphics_context const& aGc, font const& aFont, glyph_run const& aGlyphRun);
+    private:
+        std::unique_ptr<shaped_run_cache> iShapedRunCache;
     };
 
     class glyph_shapes
@@ -206,17 +229,26 @@ namespace neogfx
         {
         public:
             glyphs(i_graphics_context const& aParent, const font& aFont, const glyph_text_factory::glyph_run& aGlyphRun) :
+                glyphs{ aParent, aFont, aGlyphRun, aGlyphRun.start, aGlyphRun.end }
+            {
+            }
+            // Shapes [aItemStart, aItemEnd) of aGlyphRun, the rest of the run being context; clusters are relative
+            // to the start of the run.
+            glyphs(i_graphics_context const& aParent, const font& aFont, const glyph_text_factory::glyph_run& aGlyphRun, const char32_t* aItemStart, const char32_t* aItemEnd) :
                 iParent{ aParent },
                 iFont{ static_cast<font_face_handle*>(aFont.native_font_face().handle())->harfbuzzFont },
                 iGlyphRun{ aGlyphRun },
-                iBuf{ static_cast<font_face_handle*>(aFont.native_font_face().handle())->harfbuzzBuf },
+                iBuf{ thread_buffer() },
                 iGlyphCount{ 0u }
             {
+                scoped_kerning sk{ aFont.kerning() };
+                if (position_simple(aFont, aGlyphRun, aItemStart, aItemEnd))
+                    return;
                 hb_buffer_set_direction(iBuf, aGlyphRun.direction == text_direction::RTL ? HB_DIRECTION_RTL : HB_DIRECTION_LTR);
                 hb_buffer_set_script(iBuf, aGlyphRun.script);
                 hb_buffer_set_cluster_level(iBuf, HB_BUFFER_CLUSTER_LEVEL_CHARACTERS);
-                hb_buffer_add_utf32(iBuf, reinterpret_cast<const std::uint32_t*>(aGlyphRun.start), static_cast<int>(aGlyphRun.end - aGlyphRun.start), 0, static_cast<int>(aGlyphRun.end - aGlyphRun.start));
-                scoped_kerning sk{ aFont.kerning() };
+                hb_buffer_add_utf32(iBuf, reinterpret_cast<const std::uint32_t*>(aGlyphRun.start), static_cast<int>(aGlyphRun.end - aGlyphRun.start),
+                    static_cast<unsigned int>(aItemStart - aGlyphRun.start), static_cast<int>(aItemEnd - aItemStart));
                 /// @todo add ligature support to neogfx::font...
                 static hb_feature_t features[2];
                 static bool init = [](hb_feature_t* features) {
@@ -236,6 +268,49 @@ namespace neogfx
             {
                 hb_buffer_clear_contents(iBuf);
             }
+        private:
+            // LTR runs of printable ASCII that the font doesn't shape (see native_font_face::simple_glyphs) are given
+            // the glyphs and positions HarfBuzz would give them without calling hb_shape.
+            bool position_simple(const font& aFont, const glyph_text_factory::glyph_run& aGlyphRun, const char32_t* aItemStart, const char32_t* aItemEnd)
+            {
+                if (aGlyphRun.direction == text_direction::RTL || (aGlyphRun.script != HB_SCRIPT_LATIN && aGlyphRun.script != HB_SCRIPT_COMMON))
+                    return false;
+                auto const& table = static_cast<font_face_handle*>(aFont.native_font_face().handle())->owner.simple_glyphs();
+                typedef native_font_face::simple_glyph_table simple_glyph_table;
+                for (auto ch = aItemStart; ch != aItemEnd; ++ch)
+                    if (*ch < simple_glyph_table::FIRST || *ch > simple_glyph_table::LAST || table.entries[*ch - simple_glyph_table::FIRST].glyph == 0u)
+                        return false;
+                auto const glyphCount = static_cast<std::uint32_t>(aItemEnd - aItemStart);
+                auto const firstCluster = static_cast<std::uint32_t>(aItemStart - aGlyphRun.start);
+                iGlyphInfo.assign(glyphCount, hb_glyph_info_t{});
+                iGlyphPos.assign(glyphCount, hb_glyph_position_t{});
+                for (std::uint32_t i = 0; i < glyphCount; ++i)
+                {
+                    auto const& entry = table.entries[aItemStart[i] - simple_glyph_table::FIRST];
+                    iGlyphInfo[i].codepoint = entry.glyph;
+                    iGlyphInfo[i].cluster = firstCluster + i;
+                    iGlyphPos[i].x_advance = entry.advance;
+                }
+                // As HarfBuzz's fallback kerning: each pair's kerning is split between the two glyphs.
+                if (table.fallbackKerning)
+                    for (std::uint32_t i = 1; i < glyphCount; ++i)
+                    {
+                        auto const kern = hb_font_get_glyph_h_kerning(iFont, iGlyphInfo[i - 1].codepoint, iGlyphInfo[i].codepoint);
+                        auto const kern1 = kern >> 1;
+                        auto const kern2 = kern - kern1;
+                        iGlyphPos[i - 1].x_advance += kern1;
+                        iGlyphPos[i].x_advance += kern2;
+                        iGlyphPos[i].x_offset += kern2;
+                    }
+                iGlyphCount = glyphCount;
+                return true;
+            }
+            // Each thread shapes into its own buffer so that runs can be shaped concurrently.
+            static hb_buffer_t* thread_buffer()
+            {
+                thread_local std::unique_ptr<hb_buffer_t, decltype(&hb_buffer_destroy)> tBuffer{ hb_buffer_create(), &hb_buffer_destroy };
+                return tBuffer.get();
+            }
         public:
             std::uint32_t glyph_count() const
             {
@@ -249,16 +324,6 @@ namespace neogfx
             {
                 return iGlyphPos[aIndex];
             }
-            bool needs_fallback_font() const
-            {
-                for (std::uint32_t i = 0; i < glyph_count(); ++i)
-                {
-                    auto const tc = get_text_category(service<i_font_manager>().emoji_atlas(), std::next(iGlyphRun.start, i), iGlyphRun.end);
-                    if (glyph_info(i).codepoint == 0 && tc != text_category::Whitespace && tc != text_category::Emoji)
-                        return true;
-                }
-                return false;
-            }
         private:
             i_graphics_context const& iParent;
             hb_font_t* iFont;
@@ -268,99 +333,302 @@ namespace neogfx
             std::vector<hb_glyph_info_t> iGlyphInfo;
             std::vector<hb_glyph_position_t> iGlyphPos;
         };
-        typedef std::list<glyphs> glyphs_list;
-        typedef std::vector<std::pair<glyphs_list::const_iterator, std::uint32_t>> result_type;
+        struct shaped_glyph
+        {
+            hb_glyph_info_t info;
+            hb_glyph_position_t position;
+            std::uint32_t font; // 0 = the run's font, n = its nth fallback font
+        };
+        typedef std::vector<shaped_glyph> result_type;
+    private:
+        static constexpr std::uint32_t ADJACENT_FACE = ~0u;
     public:
-        glyph_shapes(i_graphics_context const& aParent, const font& aFont, const glyph_text_factory::glyph_run& aGlyphRun)
+        // Each code point of the run is given to the first face of the font's fallback chain whose character map
+        // covers it (code points that no face covers are replaced with the replacement character and given to the
+        // font itself) and each sub-run of code points given to the same face is shaped once, by that face.
+        glyph_shapes(i_graphics_context const& aParent, const font& aFont, const glyph_text_factory::glyph_run& aGlyphRun, bool aUseFallbackFonts = true)
         {
-            thread_local std::vector<font> fontsTried;
-            auto tryFont = aFont;
-            fontsTried.push_back(aFont);
-            iGlyphsList.emplace_back(glyphs{ aParent, tryFont, aGlyphRun });
-            while (iGlyphsList.back().needs_fallback_font())
+            thread_local std::vector<std::uint32_t> tFaces;
+            thread_local std::u32string tText;
+            auto results = std::make_shared<result_type>();
+            if (!assign_faces(aFont, aGlyphRun, aUseFallbackFonts, tFaces, tText))
             {
-                if (tryFont.has_fallback() && std::find(fontsTried.begin(), fontsTried.end(), tryFont.fallback()) == fontsTried.end())
-                {
-                    tryFont = tryFont.fallback();
-                    fontsTried.push_back(tryFont);
-                    iGlyphsList.emplace_back(glyphs{ aParent, tryFont, aGlyphRun });
-                }
-                else
-                {
-                    std::u32string lastResort{ aGlyphRun.start, aGlyphRun.end };
-                    for (std::uint32_t i = 0; i < iGlyphsList.back().glyph_count(); ++i)
-                        if (iGlyphsList.back().glyph_info(i).codepoint == 0)
-                            lastResort[iGlyphsList.back().glyph_info(i).cluster] = neolib::INVALID_CHAR32; // replacement character
-                    iGlyphsList.emplace_back(glyphs{ aParent, aFont, glyph_text_factory::glyph_run{
-                        &lastResort[0], &lastResort[0] + lastResort.size(), 
-                        aGlyphRun.currentLineDirection, aGlyphRun.direction, 
-                        aGlyphRun.mnemonic, aGlyphRun.script } });
-                    break;
-                }
+                add_results(glyphs{ aParent, aFont, aGlyphRun }, 0u, *results);
+                iResults = std::move(results);
+                return;
             }
-            fontsTried.clear();
-            auto const g = iGlyphsList.begin();
-            iResults.reserve(g->glyph_count());
-            for (std::uint32_t i = 0; i < g->glyph_count(); ++i)
+            if (!aUseFallbackFonts)
+                return;
+            glyph_text_factory::glyph_run const run{ tText.data(), tText.data() + tText.size(),
+                aGlyphRun.currentLineDirection, aGlyphRun.direction, aGlyphRun.mnemonic, aGlyphRun.script };
+            thread_local std::vector<std::pair<std::size_t, std::size_t>> tSubRuns;
+            tSubRuns.clear();
+            for (std::size_t start = 0u; start < tFaces.size();)
             {
-                auto const& gi = g->glyph_info(i);
-                auto glyph_match = [&](glyphs const& aGlyphs, std::uint32_t aIndex) -> bool
-                {
-                    auto const& hgi = aGlyphs.glyph_info(aIndex);
-                    if (hgi.cluster != gi.cluster)
-                        return false;
-                    auto tc = get_text_category(service<i_font_manager>().emoji_atlas(), aGlyphRun.start + hgi.cluster, aGlyphRun.end);
-                    return hgi.codepoint != 0 || tc == text_category::Whitespace || tc == text_category::Emoji;
-                };
-                if (glyph_match(*g, i))
-                    iResults.push_back(std::make_pair(g, i));
-                else
-                {
-                    auto next = std::next(g);
-                    bool found = false;
-                    while (!found && next != iGlyphsList.end())
-                    {
-                        for (std::uint32_t j = 0; j < next->glyph_count(); ++j)
-                        {
-                            if (glyph_match(*next, j))
-                            {
-                                iResults.push_back(std::make_pair(next, j));
-                                found = true;
-                            }
-                        }
-                        ++next;
-                    }
-                }
+                auto end = start + 1u;
+                while (end < tFaces.size() && tFaces[end] == tFaces[start])
+                    ++end;
+                tSubRuns.emplace_back(start, end);
+                start = end;
             }
+            // HarfBuzz orders the glyphs of a right-to-left run from right to left; so too its sub-runs.
+            if (aGlyphRun.direction == text_direction::RTL)
+                std::reverse(tSubRuns.begin(), tSubRuns.end());
+            std::vector<font> fonts{ aFont };
+            for (auto const& subRun : tSubRuns)
+            {
+                auto const face = tFaces[subRun.first];
+                while (fonts.size() <= face)
+                    fonts.push_back(fonts.back().fallback());
+                add_results(glyphs{ aParent, fonts[face], run, run.start + subRun.first, run.start + subRun.second }, face, *results);
+            }
+            iResults = std::move(results);
         }
     public:
+        bool complete() const
+        {
+            return iResults != nullptr;
+        }
         std::uint32_t glyph_count() const
         {
-            return static_cast<std::uint32_t>(iResults.size());
+            return static_cast<std::uint32_t>(iResults->size());
         }
         const hb_glyph_info_t& glyph_info(std::uint32_t aIndex) const
         {
-            return iResults[aIndex].first->glyph_info(iResults[aIndex].second);
+            return (*iResults)[aIndex].info;
         }
         const hb_glyph_position_t& glyph_position(std::uint32_t aIndex) const
         {
-            return iResults[aIndex].first->glyph_position(iResults[aIndex].second);
+            return (*iResults)[aIndex].position;
         }
         bool using_fallback(std::uint32_t aIndex) const
         {
-            return iResults[aIndex].first != iGlyphsList.begin();
+            return (*iResults)[aIndex].font != 0u;
         }
         std::uint32_t fallback_index(std::uint32_t aIndex) const
         {
             if (!using_fallback(aIndex))
                 throw not_using_fallback();
-            return static_cast<std::uint32_t>(std::distance(iGlyphsList.begin(), iResults[aIndex].first) - 1);
+            return (*iResults)[aIndex].font - 1u;
+        }
+        std::size_t memory_usage() const
+        {
+            return sizeof(result_type) + iResults->capacity() * sizeof(shaped_glyph);
+        }
+    private:
+        // Assigns each code point of the run the position, in the font's fallback chain, of the face that is to
+        // shape it; returns true if any code point needs a fallback face or the replacement character. Fallback
+        // fonts are only looked at (and so created) if aUseFallbackFonts is true.
+        static bool assign_faces(const font& aFont, const glyph_text_factory::glyph_run& aGlyphRun, bool aUseFallbackFonts, std::vector<std::uint32_t>& aFaces, std::u32string& aText)
+        {
+            auto const& face = static_cast<font_face_handle*>(aFont.native_font_face().handle())->owner;
+            auto const& simpleGlyphs = face.simple_glyphs();
+            typedef native_font_face::simple_glyph_table simple_glyph_table;
+            auto const length = static_cast<std::size_t>(aGlyphRun.end - aGlyphRun.start);
+            thread_local std::vector<text_category> tCategories;
+            tCategories.resize(length);
+            get_text_categories(service<i_font_manager>().emoji_atlas(), aGlyphRun.start, aGlyphRun.end, tCategories.data());
+            aFaces.assign(length, ADJACENT_FACE);
+            aText.assign(aGlyphRun.start, aGlyphRun.end);
+            bool fallback = false;
+            for (std::size_t i = 0u; i < length; ++i)
+            {
+                auto const ch = aText[i];
+                // Whitespace and emoji (drawn from the emoji atlas) are never given to a fallback font; marks and
+                // invisible code points are shaped with the text they belong to.
+                if (tCategories[i] == text_category::Whitespace || tCategories[i] == text_category::Emoji)
+                    aFaces[i] = 0u;
+                else if (tCategories[i] == text_category::Mark || tCategories[i] == text_category::Control || default_ignorable(ch))
+                    continue;
+                else if (ch >= simple_glyph_table::FIRST && ch <= simple_glyph_table::LAST && simpleGlyphs.entries[ch - simple_glyph_table::FIRST].glyph != 0u)
+                    aFaces[i] = 0u;
+                else if (!aUseFallbackFonts)
+                {
+                    if (!face.has_glyph(ch))
+                        return true;
+                    aFaces[i] = 0u;
+                }
+                else if (auto const covering = face.covering_face(ch))
+                {
+                    aFaces[i] = *covering;
+                    fallback = fallback || *covering != 0u;
+                }
+                else
+                {
+                    aText[i] = neolib::INVALID_CHAR32; // replacement character
+                    aFaces[i] = 0u;
+                    fallback = true;
+                }
+            }
+            if (!fallback)
+                return false;
+            auto const firstAssigned = std::find_if(aFaces.begin(), aFaces.end(), [](std::uint32_t aFace) { return aFace != ADJACENT_FACE; });
+            auto previous = firstAssigned != aFaces.end() ? *firstAssigned : 0u;
+            for (auto& assigned : aFaces)
+                if (assigned == ADJACENT_FACE)
+                    assigned = previous;
+                else
+                    previous = assigned;
+            return true;
+        }
+        // Unicode's Default_Ignorable_Code_Point property (less unassigned code points).
+        static bool default_ignorable(char32_t aCodePoint)
+        {
+            return aCodePoint == U'\x00AD' || aCodePoint == U'\x034F' || aCodePoint == U'\x061C' ||
+                (aCodePoint >= U'\x115F' && aCodePoint <= U'\x1160') || (aCodePoint >= U'\x17B4' && aCodePoint <= U'\x17B5') ||
+                (aCodePoint >= U'\x180B' && aCodePoint <= U'\x180F') || (aCodePoint >= U'\x200B' && aCodePoint <= U'\x200F') ||
+                (aCodePoint >= U'\x202A' && aCodePoint <= U'\x202E') || (aCodePoint >= U'\x2060' && aCodePoint <= U'\x206F') ||
+                aCodePoint == U'\x3164' || (aCodePoint >= U'\xFE00' && aCodePoint <= U'\xFE0F') || aCodePoint == U'\xFEFF' ||
+                aCodePoint == U'\xFFA0' || (aCodePoint >= U'\x1BCA0' && aCodePoint <= U'\x1BCA3') ||
+                (aCodePoint >= U'\x1D173' && aCodePoint <= U'\x1D17A') || (aCodePoint >= U'\xE0000' && aCodePoint <= U'\xE0FFF');
+        }
+        static void add_results(glyphs const& aGlyphs, std::uint32_t aFont, result_type& aResults)
+        {
+            aResults.reserve(aResults.size() + aGlyphs.glyph_count());
+            for (std::uint32_t i = 0; i < aGlyphs.glyph_count(); ++i)
+                aResults.push_back(shaped_glyph{ aGlyphs.glyph_info(i), aGlyphs.glyph_position(i), aFont });
         }
     private:
-        glyphs_list iGlyphsList;
-        result_type iResults;
+        std::shared_ptr<result_type const> iResults;
     };
 
+    // LRU cache of shaped runs keyed by (font, script, direction, kerning, text). Shaping a run is a pure function of
+    // its key so the (immutable, shared) result of a previous shaping is reused as is. Entries hold a reference to
+    // their font so that the font's id cannot be reused while the entry exists.
+    class shaped_run_cache
+    {
+    public:
+        static constexpr std::size_t DEFAULT_MEMORY_LIMIT = 4u * 1024u * 1024u;
+    private:
+        struct key
+        {
+            font_id font;
+            hb_script_t script;
+            text_direction direction;
+            bool kerning;
+            std::u32string_view text;
+
+            bool operator==(key const& aOther) const
+            {
+                return font == aOther.font && script == aOther.script && direction == aOther.direction &&
+                    kerning == aOther.kerning && text == aOther.text;
+            }
+        };
+        struct key_hash
+        {
+            std::size_t operator()(key const& aKey) const
+            {
+                std::size_t seed = std::hash<std::u32string_view>{}(aKey.text);
+                boost::hash_combine(seed, aKey.font);
+                boost::hash_combine(seed, static_cast<int>(aKey.script));
+                boost::hash_combine(seed, static_cast<int>(aKey.direction));
+                boost::hash_combine(seed, aKey.kerning);
+                return seed;
+            }
+        };
+        struct entry
+        {
+            neogfx::font font;
+            hb_script_t script;
+            text_direction direction;
+            std::u32string text;
+            glyph_shapes shapes;
+            std::size_t size;
+        };
+        typedef std::list<entry> entry_list;
+    public:
+        shaped_run_cache() :
+            iStatistics{ 0u, 0u, 0u, 0u, 0u, DEFAULT_MEMORY_LIMIT }
+        {
+        }
+    public:
+        std::optional<glyph_shapes> find(font const& aFont, glyph_text_factory::glyph_run const& aGlyphRun)
+        {
+            std::scoped_lock lock{ iMutex };
+            auto existing = iIndex.find(to_key(aFont, aGlyphRun, std::u32string_view{ aGlyphRun.start, aGlyphRun.end }));
+            if (existing == iIndex.end())
+            {
+                ++iStatistics.misses;
+                return {};
+            }
+            ++iStatistics.hits;
+            iEntries.splice(iEntries.end(), iEntries, existing->second);
+            return existing->second->shapes;
+        }
+        bool contains(font const& aFont, glyph_text_factory::glyph_run const& aGlyphRun) const
+        {
+            std::scoped_lock lock{ iMutex };
+            return iIndex.find(to_key(aFont, aGlyphRun, std::u32string_view{ aGlyphRun.start, aGlyphRun.end })) != iIndex.end();
+        }
+        void insert(font const& aFont, glyph_text_factory::glyph_run const& aGlyphRun, glyph_shapes const& aShapes)
+        {
+            std::scoped_lock lock{ iMutex };
+            std::u32string_view const text{ aGlyphRun.start, aGlyphRun.end };
+            std::size_t const size = sizeof(entry) + text.size() * sizeof(char32_t) + aShapes.memory_usage();
+            if (size > iStatistics.memoryLimit || iIndex.find(to_key(aFont, aGlyphRun, text)) != iIndex.end())
+                return;
+            auto newEntry = iEntries.insert(iEntries.end(), entry{ aFont, aGlyphRun.script, aGlyphRun.direction, std::u32string{ text }, aShapes, size });
+            iIndex.emplace(to_key(*newEntry), newEntry);
+            iStatistics.memoryUsage += size;
+            ++iStatistics.entries;
+            trim();
+        }
+        shaping_cache_statistics statistics() const
+        {
+            std::scoped_lock lock{ iMutex };
+            return iStatistics;
+        }
+        void set_memory_limit(std::size_t aMemoryLimit)
+        {
+            std::scoped_lock lock{ iMutex };
+            iStatistics.memoryLimit = aMemoryLimit;
+            trim();
+        }
+        void clear()
+        {
+            std::scoped_lock lock{ iMutex };
+            iIndex.clear();
+            iEntries.clear();
+            iStatistics.entries = 0u;
+            iStatistics.memoryUsage = 0u;
+        }
+    private:
+        static key to_key(font const& aFont, glyph_text_factory::glyph_run const& aGlyphRun, std::u32string_view const& aText)
+        {
+            return key{ aFont.id(), aGlyphRun.script, aGlyphRun.direction, aFont.kerning(), aText };
+        }
+        static key to_key(entry const& aEntry)
+        {
+            return key{ aEntry.font.id(), aEntry.script, aEntry.direction, aEntry.font.kerning(), aEntry.text };
+        }
+        void trim()
+        {
+            while (iStatistics.memoryUsage > iStatistics.memoryLimit && !iEntries.empty())
+            {
+                auto const& oldest = iEntries.front();
+                iIndex.erase(to_key(oldest));
+                iStatistics.memoryUsage -= oldest.size;
+                --iStatistics.entries;
+                ++iStatistics.evictions;
+                iEntries.pop_front();
+            }
+        }
+    private:
+        mutable std::mutex iMutex;
+        entry_list iEntries;
+        std::unordered_map<key, entry_list::iterator, key_hash> iIndex;
+        shaping_cache_statistics iStatistics;
+    };
+
+    glyph_text_factory::glyph_text_factory() :
+        iShapedRunCache{ std::make_unique<shaped_run_cache>() }
+    {
+    }
+
+    glyph_text_factory::~glyph_text_factory()
+    {
+    }
+
     glyph_text glyph_text_factory::create_glyph_text()
     {
         return *make_ref<glyph_text_content>();
@@ -429,134 +697,7 @@ namespace neogfx
         thread_local run_list runs;
         runs.clear();
 
-        text_category previousCategory = get_text_category(emojiAtlas, codePoints, codePoints + codePointCount);
-        if (aGc.mnemonic_set() && codePoints[0] == static_cast<char32_t>(aGc.mnemonic()) && 
-            (codePointCount == 1 || codePoints[1] != static_cast<char32_t>(aGc.mnemonic())))
-            previousCategory = text_category::Mnemonic;
-        bool newLine = false;
-        bool previousNewLine = false;
-        text_direction currentLineDirection = get_text_direction(emojiAtlas, codePoints, codePoints + codePointCount);
-        text_direction previousLineDirection = currentLineDirection;
-        text_direction previousDirection = currentLineDirection;
-        const char32_t* runStart = &codePoints[0];
-        std::u32string::size_type lastCodePointIndex = codePointCount - 1;
-        font previousFont = aFontSelector.select_font(0);
-        hb_script_t previousScript = hb_unicode_script(static_cast<font_face_handle*>(previousFont.native_font_face().handle())->harfbuzzUnicodeFuncs, codePoints[0]);
-
-        std::deque<std::pair<text_direction, bool>> directionStack;
-        const char32_t LRE = U'\u202A';
-        const char32_t RLE = U'\u202B';
-        const char32_t LRO = U'\u202D';
-        const char32_t RLO = U'\u202E';
-        const char32_t PDF = U'\u202C';
-
-        for (std::size_t codePointIndex = 0; codePointIndex <= lastCodePointIndex; ++codePointIndex)
-        {
-            font const currentFont = aFontSelector.select_font(codePointIndex);
-            switch (codePoints[codePointIndex])
-            {
-            case PDF:
-                if (!directionStack.empty())
-                    directionStack.pop_back();
-                break;
-            case LRE:
-                directionStack.push_back(std::make_pair(text_direction::LTR, false));
-                break;
-            case RLE:
-                directionStack.push_back(std::make_pair(text_direction::RTL, false));
-                break;
-            case LRO:
-                directionStack.push_back(std::make_pair(text_direction::LTR, true));
-                break;
-            case RLO:
-                directionStack.push_back(std::make_pair(text_direction::RTL, true));
-                break;
-            default:
-                break;
-            }
-
-            hb_unicode_funcs_t* unicodeFuncs = static_cast<font_face_handle*>(currentFont.native_font_face().handle())->harfbuzzUnicodeFuncs;
-            
-            text_category currentCategory = get_text_category(emojiAtlas, codePoints + codePointIndex, codePoints + codePointCount);
-            
-            if (aGc.mnemonic_set() && codePoints[codePointIndex] == static_cast<char32_t>(aGc.mnemonic()) &&
-                (codePointCount - 1 == codePointIndex || codePoints[codePointIndex + 1] != static_cast<char32_t>(aGc.mnemonic())))
-                currentCategory = text_category::Mnemonic;
-            
-            previousNewLine = newLine;
-            newLine = (codePoints[codePointIndex] == U'\r' || codePoints[codePointIndex] == U'\n');
-            if (newLine || previousNewLine)
-            {
-                if (newLine)
-                    currentLineDirection = text_direction::LTR;
-                else
-                    currentLineDirection = get_text_direction(emojiAtlas, codePoints + codePointIndex, codePoints + codePointCount, currentLineDirection);
-            }
-
-            text_direction currentDirection = get_text_direction(emojiAtlas, codePoints + codePointIndex, codePoints + codePointCount, currentLineDirection, previousDirection);
-            if (currentDirection == text_direction::RTL && currentCategory == text_category::Digit)
-                currentDirection = text_direction::LTR;
-            
-            auto bidi_check = [&directionStack](text_category aCategory, text_direction aDirection)
-            {
-                if (!directionStack.empty())
-                {
-                    switch (aCategory)
-                    {
-                    case text_category::LTR:
-                    case text_category::RTL:
-                    case text_category::Digit:
-                    case text_category::Emoji:
-                        if (directionStack.back().second == true)
-                            return directionStack.back().first;
-                        break;
-                    case text_category::Mark:
-                    case text_category::None:
-                    case text_category::Whitespace:
-                    case text_category::Mnemonic:
-                        return directionStack.back().first;
-                    default:
-                        break;
-                    }
-                }
-                return aDirection;
-            };
-            
-            if (!newLine)
-                currentDirection = bidi_check(currentCategory, currentDirection);
-            else
-                currentDirection = currentLineDirection;
-            
-            textDirections.push_back(character_type{ currentCategory, currentDirection });
-
-            hb_script_t currentScript = hb_unicode_script(unicodeFuncs, codePoints[codePointIndex]);
-            if (currentScript == HB_SCRIPT_COMMON || currentScript == HB_SCRIPT_INHERITED)
-                currentScript = previousScript;
-
-            bool newRun =
-                previousFont != currentFont ||
-                currentCategory == text_category::Mnemonic ||
-                previousCategory == text_category::Mnemonic ||
-                previousLineDirection != currentLineDirection ||
-                previousDirection != currentDirection;
-
-            if (currentCategory == text_category::Emoji)
-                hasEmojis = true;
-            
-            if (newRun && codePointIndex > 0)
-            {
-                runs.emplace_back(runStart, &codePoints[codePointIndex], previousLineDirection, previousDirection, previousCategory == text_category::Mnemonic, previousScript);
-                runStart = &codePoints[codePointIndex];
-            }
-
-            previousLineDirection = currentLineDirection;
-            previousDirection = currentDirection;
-            previousCategory = currentCategory;
-            previousScript = currentScript;
-            previousFont = currentFont;
-        }
-
-        runs.emplace_back(runStart, &codePoints[lastCodePointIndex + 1], previousLineDirection, previousDirection, previousCategory == text_category::Mnemonic, previousScript);
+        segment(aGc, codePoints, codePointCount, aFontSelector, runs, textDirections, hasEmojis);
 
         float lineStart = 0.0f;
         vec2f previousAdvance = {};
@@ -582,7 +723,7 @@ namespace neogfx
             
             bool drawMnemonic = (i > 0 && runs[i - 1].mnemonic);
             std::string::size_type sourceClusterRunStart = runs[i].start - &codePoints[0];
-            glyph_shapes shapes{ aGc, aFontSelector.select_font(sourceClusterRunStart), runs[i] };
+            glyph_shapes const shapes = shape(aGc, aFontSelector.select_font(sourceClusterRunStart), runs[i]);
 
             for (std::uint32_t j = 0; j < shapes.glyph_count(); ++j)
             {
@@ -671,7 +812,7 @@ namespace neogfx
                 if (category(newGlyph) != text_category::Emoji)
                 {
                     auto const& fontGlyph = font.glyph(newGlyph);
-                    auto const& fontGlyphExtents = fontGlyph.texture().extents().as<float>();
+                    auto const& fontGlyphExtents = fontGlyph.extents().as<float>();
                     float const cellWidth = (category(newGlyph) != text_category::Whitespace ? std::max(advance.x, fontGlyphExtents.cx) : advance.x);
                     auto const& glyphMetrics = fontGlyph.metrics();
 
@@ -691,8 +832,10 @@ namespace neogfx
 
                     if (fontGlyph.has_outline_texture())
                     {
-                        auto const& fontOutlineGlyphExtents = fontGlyph.outline_texture().extents().as<float>();
-                        auto const adjustedOffset = offset - vec2f{ 
+                        // A distance field glyph's outline is drawn from its own (padded) texture.
+                        auto const& fontOutlineGlyphExtents = fontGlyph.distance_field() ?
+                            fontGlyphExtents : fontGlyph.outline_texture().extents().as<float>();
+                        auto const adjustedOffset = fontGlyph.distance_field() ? offset : offset - vec2f{
                             static_cast<float>(font.info().outline().radius), static_cast<float>(font.info().outline().radius) };
                         newGlyph.outlineShape = category(newGlyph) != text_category::Whitespace ?
                             quadf_2d{
@@ -821,6 +964,214 @@ namespace neogfx
             return result;
     }
 
+    void glyph_text_factory::segment(i_graphics_context const& aGc, char32_t const* aCodePoints, std::u32string::size_type aCodePointCount, i_font_selector const& aFontSelector,
+        run_list& aRuns, std::vector<character_type>& aTextDirections, bool& aHasEmojis) const
+    {
+        auto const& emojiAtlas = service<i_font_manager>().emoji_atlas();
+
+        thread_local std::vector<text_category> tCategories;
+        tCategories.resize(aCodePointCount);
+        get_text_categories(emojiAtlas, aCodePoints, aCodePoints + aCodePointCount, tCategories.data());
+
+        text_category previousCategory = tCategories[0];
+        if (aGc.mnemonic_set() && aCodePoints[0] == static_cast<char32_t>(aGc.mnemonic()) && 
+            (aCodePointCount == 1 || aCodePoints[1] != static_cast<char32_t>(aGc.mnemonic())))
+            previousCategory = text_category::Mnemonic;
+        bool newLine = false;
+        bool previousNewLine = false;
+        text_direction currentLineDirection = get_text_direction(emojiAtlas, aCodePoints, aCodePoints + aCodePointCount);
+        text_direction previousLineDirection = currentLineDirection;
+        text_direction previousDirection = currentLineDirection;
+        const char32_t* runStart = &aCodePoints[0];
+        std::u32string::size_type lastCodePointIndex = aCodePointCount - 1;
+        font previousFont = aFontSelector.select_font(0);
+        hb_script_t previousScript = hb_unicode_script(static_cast<font_face_handle*>(previousFont.native_font_face().handle())->harfbuzzUnicodeFuncs, aCodePoints[0]);
+
+        std::deque<std::pair<text_direction, bool>> directionStack;
+        const char32_t LRE = U'\u202A';
+        const char32_t RLE = U'\u202B';
+        const char32_t LRO = U'\u202D';
+        const char32_t RLO = U'\u202E';
+        const char32_t PDF = U'\u202C';
+
+        for (std::size_t codePointIndex = 0; codePointIndex <= lastCodePointIndex; ++codePointIndex)
+        {
+            font const currentFont = aFontSelector.select_font(codePointIndex);
+            switch (aCodePoints[codePointIndex])
+            {
+            case PDF:
+                if (!directionStack.empty())
+                    directionStack.pop_back();
+                break;
+            case LRE:
+                directionStack.push_back(std::make_pair(text_direction::LTR, false));
+                break;
+            case RLE:
+                directionStack.push_back(std::make_pair(text_direction::RTL, false));
+                break;
+            case LRO:
+                directionStack.push_back(std::make_pair(text_direction::LTR, true));
+                break;
+            case RLO:
+                directionStack.push_back(std::make_pair(text_direction::RTL, true));
+                break;
+            default:
+                break;
+            }
+
+            hb_unicode_funcs_t* unicodeFuncs = static_cast<font_face_handle*>(currentFont.native_font_face().handle())->harfbuzzUnicodeFuncs;
+            
+            text_category currentCategory = tCategories[codePointIndex];
+            
+            if (aGc.mnemonic_set() && aCodePoints[codePointIndex] == static_cast<char32_t>(aGc.mnemonic()) &&
+                (aCodePointCount - 1 == codePointIndex || aCodePoints[codePointIndex + 1] != static_cast<char32_t>(aGc.mnemonic())))
+                currentCategory = text_category::Mnemonic;
+            
+            previousNewLine = newLine;
+            newLine = (aCodePoints[codePointIndex] == U'\r' || aCodePoints[codePointIndex] == U'\n');
+            if (newLine || previousNewLine)
+            {
+                if (newLine)
+                    currentLineDirection = text_direction::LTR;
+                else
+                    currentLineDirection = get_text_direction(emojiAtlas, aCodePoints + codePointIndex, aCodePoints + aCodePointCount, currentLineDirection);
+            }
+
+            text_direction currentDirection = get_text_direction(emojiAtlas, aCodePoints + codePointIndex, aCodePoints + aCodePointCount, currentLineDirection, previousDirection);
+            if (currentDirection == text_direction::RTL && currentCategory == text_category::Digit)
+                currentDirection = text_direction::LTR;
+            
+            auto bidi_check = [&directionStack](text_category aCategory, text_direction aDirection)
+            {
+                if (!directionStack.empty())
+                {
+                    switch (aCategory)
+                    {
+                    case text_category::LTR:
+                    case text_category::RTL:
+                    case text_category::Digit:
+                    case text_category::Emoji:
+                        if (directionStack.back().second == true)
+                            return directionStack.back().first;
+                        break;
+                    case text_category::Mark:
+                    case text_category::None:
+                    case text_category::Whitespace:
+                    case text_category::Mnemonic:
+                        return directionStack.back().first;
+                    default:
+                        break;
+                    }
+                }
+                return aDirection;
+            };
+            
+            if (!newLine)
+                currentDirection = bidi_check(currentCategory, currentDirection);
+            else
+                currentDirection = currentLineDirection;
+            
+            aTextDirections.push_back(character_type{ currentCategory, currentDirection });
+
+            hb_script_t currentScript = hb_unicode_script(unicodeFuncs, aCodePoints[codePointIndex]);
+            if (currentScript == HB_SCRIPT_COMMON || currentScript == HB_SCRIPT_INHERITED)
+                currentScript = previousScript;
+
+            bool newRun =
+                previousFont != currentFont ||
+                currentCategory == text_category::Mnemonic ||
+                previousCategory == text_category::Mnemonic ||
+                previousLineDirection != currentLineDirection ||
+                previousDirection != currentDirection;
+
+            if (currentCategory == text_category::Emoji)
+                aHasEmojis = true;
+            
+            if (newRun && codePointIndex > 0)
+            {
+                aRuns.emplace_back(runStart, &aCodePoints[codePointIndex], previousLineDirection, previousDirection, previousCategory == text_category::Mnemonic, previousScript);
+                runStart = &aCodePoints[codePointIndex];
+            }
+
+            previousLineDirection = currentLineDirection;
+            previousDirection = currentDirection;
+            previousCategory = currentCategory;
+            previousScript = currentScript;
+            previousFont = currentFont;
+        }
+
+        aRuns.emplace_back(runStart, &aCodePoints[lastCodePointIndex + 1], previousLineDirection, previousDirection, previousCategory == text_category::Mnemonic, previousScript);
+    }
+
+    void glyph_text_factory::preshape(i_graphics_context const& aGc, char32_t const* aUtf32Begin, char32_t const* aUtf32End, i_font_selector const& aFontSelector)
+    {
+        if (aUtf32End == aUtf32Begin)
+            return;
+
+        std::u32string::size_type const codePointCount = aUtf32End - aUtf32Begin;
+
+        thread_local std::u32string adjustedCodepoints;
+        adjustedCodepoints.clear();
+
+        if (!aGc.password())
+            adjustedCodepoints.assign(aUtf32Begin, aUtf32End);
+        else
+            adjustedCodepoints.assign(codePointCount, neolib::utf8_to_utf32(aGc.password_mask())[0]);
+
+        thread_local std::vector<character_type> textDirections;
+        textDirections.clear();
+        thread_local run_list runs;
+        runs.clear();
+        bool hasEmojis = false;
+
+        segment(aGc, adjustedCodepoints.data(), codePointCount, aFontSelector, runs, textDirections, hasEmojis);
+
+        for (auto const& run : runs)
+        {
+            if (run.mnemonic)
+                continue;
+            font const runFont = aFontSelector.select_font(run.start - adjustedCodepoints.data());
+            if (iShapedRunCache->contains(runFont, run))
+                continue;
+            // Runs needing fallback fonts are left to to_glyph_text() as creating fallback fonts isn't thread safe.
+            glyph_shapes const shapes{ aGc, runFont, run, false };
+            if (!shapes.complete())
+                continue;
+            iShapedRunCache->insert(runFont, run, shapes);
+            // Rasterize the run's glyphs in the background so that they are ready when the text is drawn.
+            thread_local std::vector<native_font_face::glyph_index_t> tGlyphs;
+            tGlyphs.clear();
+            for (std::uint32_t i = 0; i < shapes.glyph_count(); ++i)
+                tGlyphs.push_back(shapes.glyph_info(i).codepoint);
+            static_cast<font_face_handle*>(runFont.native_font_face().handle())->owner.prerasterize(tGlyphs);
+        }
+    }
+
+    shaping_cache_statistics glyph_text_factory::cache_statistics() const
+    {
+        return iShapedRunCache->statistics();
+    }
+
+    void glyph_text_factory::set_cache_memory_limit(std::size_t aMemoryLimit)
+    {
+        iShapedRunCache->set_memory_limit(aMemoryLimit);
+    }
+
+    void glyph_text_factory::clear_cache()
+    {
+        iShapedRunCache->clear();
+    }
+
+    glyph_shapes glyph_text_factory::shape(i_graphics_context const& aGc, font const& aFont, glyph_run const& aGlyphRun)
+    {
+        auto cached = iShapedRunCache->find(aFont, aGlyphRun);
+        if (cached)
+            return *cached;
+        glyph_shapes shapes{ aGc, aFont, aGlyphRun };
+        iShapedRunCache->insert(aFont, aGlyphRun, shapes);
+        return shapes;
+    }
+
     namespace
     {
         enum class sfnt_kind { none, truetype, cff, collection, woff, woff2 };
@@ -872,7 +1223,9 @@ namespace neogfx
     font_manager::font_manager() :
         iGlyphTextFactory{ std::make_unique<neogfx::glyph_text_factory>() },
         iGlyphAtlas{ size{1024.0, 1024.0} },
-        iEmojiAtlas{}
+        iDistanceFieldAtlas{ size{1024.0, 1024.0} },
+        iEmojiAtlas{},
+        iGlyphRasterizer{ std::make_shared<glyph_rasterizer>() }
     {
         FT_Error error = FT_Init_FreeType(&iFontLib);
         if (error)
@@ -880,6 +1233,11 @@ namespace neogfx
         error = FT_Library_SetLcdFilter(iFontLib, FT_LCD_FILTER_NONE);
         if (error)
             throw error_initializing_font_library();
+#ifdef NEOGFX_FREETYPE_SDF
+        FT_Int const spread = static_cast<FT_Int>(i_glyph::DISTANCE_FIELD_SPREAD);
+        FT_Property_Set(iFontLib, "sdf", "spread", &spread);
+        FT_Property_Set(iFontLib, "bsdf", "spread", &spread);
+#endif
         auto enumerate = [this](const std::string fontsDirectory)
         {
             if (std::filesystem::exists(fontsDirectory))
@@ -947,6 +1305,20 @@ namespace neogfx
 
     font_manager::~font_manager()
     {
+        // Font faces may outlive us; stopping the rasterizer first means a face that finds its (weak) reference to
+        // it expired knows that none of its glyphs are being rasterized.
+        iGlyphRasterizer->stop();
+        if (iPersistentGlyphCache)
+        {
+            try
+            {
+                iPersistentGlyphCache->save();
+            }
+            catch (...)
+            {
+                // The cache is only an optimization; failing to update it is not an error.
+            }
+        }
         iIdCache.clear();
         iFontFamilies.clear();
         iNativeFonts.clear();
@@ -1147,6 +1519,16 @@ namespace neogfx
         return iGlyphAtlas;
     }
 
+    const i_texture_atlas& font_manager::distance_field_atlas() const
+    {
+        return iDistanceFieldAtlas;
+    }
+
+    i_texture_atlas& font_manager::distance_field_atlas()
+    {
+        return iDistanceFieldAtlas;
+    }
+
     const i_emoji_atlas& font_manager::emoji_atlas() const
     {
         return iEmojiAtlas;
@@ -1157,6 +1539,40 @@ namespace neogfx
         return iEmojiAtlas;
     }
 
+    void font_manager::upload_rasterized_glyphs()
+    {
+        iGlyphRasterizer->upload_completed();
+    }
+
+    void font_manager::enable_persistent_glyph_cache(i_string const& aPath)
+    {
+        if (iPersistentGlyphCache)
+            throw persistent_glyph_cache_already_enabled();
+        iPersistentGlyphCache = std::make_unique<persistent_glyph_cache>(aPath.to_std_string());
+        iActivePersistentGlyphCache.store(iPersistentGlyphCache.get(), std::memory_order_release);
+    }
+
+    bool font_manager::persistent_glyph_cache_enabled() const
+    {
+        return persistent_cache() != nullptr;
+    }
+
+    void font_manager::save_persistent_glyph_cache()
+    {
+        if (iPersistentGlyphCache)
+            iPersistentGlyphCache->save();
+    }
+
+    std::shared_ptr<glyph_rasterizer> font_manager::rasterizer()
+    {
+        return iGlyphRasterizer;
+    }
+
+    persistent_glyph_cache* font_manager::persistent_cache() const
+    {
+        return iActivePersistentGlyphCache.load(std::memory_order_acquire);
+    }
+
     void font_manager::add_ref(font_id aId, long aCount)
     {
         font_from_id(aId).native_font_face().add_ref(aCount);
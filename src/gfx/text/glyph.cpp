@@ -24,7 +24,14 @@
 namespace neogfx
 {
     glyph::glyph(const i_sub_texture& aTexture, bool aSubpixel, const glyph_metrics& aMetrics, glyph_pixel_mode aPixelMode) :
-        iTexture(aTexture), iOutlineTexture{ nullptr }, iSubpixel{ aSubpixel }, iMetrics{ aMetrics }, iPixelMode{ aPixelMode }
+        iTexture(aTexture), iOutlineTexture{ nullptr }, iSubpixel{ aSubpixel }, iMetrics{ aMetrics }, iPixelMode{ aPixelMode },
+        iDistanceField{ false }, iScale{ 1.0 }
+    {
+    }
+
+    glyph::glyph(const i_sub_texture& aDistanceFieldTexture, const glyph_metrics& aMetrics, scalar aScale) :
+        iTexture(aDistanceFieldTexture), iOutlineTexture{ nullptr }, iSubpixel{ false }, iMetrics{ aMetrics }, iPixelMode{ glyph_pixel_mode::Gray },
+        iDistanceField{ true }, iScale{ aScale }
     {
     }
 
@@ -37,6 +44,16 @@ namespace neogfx
         return iTexture;
     }
 
+    neogfx::size glyph::extents() const
+    {
+        return iTexture.extents() * iScale;
+    }
+
+    bool glyph::distance_field() const
+    {
+        return iDistanceField;
+    }
+
     bool glyph::has_outline_texture() const
     {
         return iOutlineTexture != nullptr;
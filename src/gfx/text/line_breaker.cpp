@@ -0,0 +1,208 @@
+// line_breaker.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+
+#include <array>
+#include <limits>
+
+#include <neolib/core/string_utils.hpp>
+
+#include <neogfx/gfx/text/line_breaker.hpp>
+
+namespace neogfx
+{
+    line_breaker::line_breaker(glyph_text const& aText) :
+        iAdvances(aText.size() + 1u, 0.0), iBreaks(aText.size()), iWhitespace(aText.size(), false)
+    {
+        using token_t = std::pair<glyph_text::const_iterator, glyph_text::const_iterator>;
+        thread_local std::vector<token_t> paragraphTokens;
+        paragraphTokens.clear();
+        std::array<glyph_char, 2> delimeters = { glyph_char{ '\r', {}, text_category::Whitespace }, glyph_char{ '\n', {}, text_category::Whitespace } };
+        neolib::tokens(aText.begin(), aText.end(), delimeters.begin(), delimeters.end(), paragraphTokens, 0, false);
+        iParagraphs.reserve(paragraphTokens.size());
+        for (auto const& token : paragraphTokens)
+            iParagraphs.push_back(paragraph{
+                static_cast<size_type>(std::distance(aText.begin(), token.first)), static_cast<size_type>(std::distance(aText.begin(), token.second)) });
+
+        size_type const glyphCount = aText.size();
+        size_type wordStart = 0u;
+        for (size_type index = 0u; index < glyphCount; ++index)
+        {
+            auto const& glyph = aText[index];
+            iAdvances[index + 1u] = iAdvances[index] + (glyph.cell[1].x - glyph.cell[0].x);
+            iWhitespace[index] = is_whitespace(glyph);
+            if (iWhitespace[index])
+            {
+                wordStart = index + 1u;
+                auto const consume = index + 1u == glyphCount || !is_whitespace(aText[index + 1u]);
+                iBreaks[index] = { index, consume ? index + 1u : index };
+            }
+            else
+            {
+                auto first = wordStart;
+                while (first != 0u && aText[first - 1u].clusters == glyph.clusters)
+                    --first;
+                iBreaks[index] = { first, first };
+            }
+        }
+    }
+
+    line_breaker::paragraphs_t const& line_breaker::paragraphs() const
+    {
+        return iParagraphs;
+    }
+
+    void line_breaker::break_lines(paragraph const& aParagraph, dimension aMaxWidth, line_breaking aLineBreaking, lines_t& aLines) const
+    {
+        if (aParagraph.begin == aParagraph.end)
+            return;
+        if (aMaxWidth == 0.0)
+            aLines.push_back(line{ aParagraph.begin, aParagraph.end });
+        else if (aLineBreaking == line_breaking::Optimal)
+            break_optimal(aParagraph, aMaxWidth, aLines);
+        else
+            break_greedy(aParagraph.begin, aParagraph.end, aMaxWidth, aLines);
+    }
+
+    dimension line_breaker::width(size_type aBegin, size_type aEnd) const
+    {
+        return iAdvances[aEnd] - iAdvances[aBegin];
+    }
+
+    void line_breaker::break_greedy(size_type aBegin, size_type aEnd, dimension aMaxWidth, lines_t& aLines) const
+    {
+        auto lineStart = aBegin;
+        while (lineStart != aEnd)
+        {
+            // The first glyph taking the line past the maximum width (searched for exponentially then by bisection
+            // so the cost depends on the length of the line rather than of the paragraph)...
+            auto const limit = iAdvances[lineStart] + aMaxWidth;
+            size_type low = lineStart + 1u;
+            size_type high = low;
+            for (size_type step = 1u; high <= aEnd && iAdvances[high] <= limit; step *= 2u)
+            {
+                low = high + 1u;
+                high = std::min(lineStart + step * 2u, aEnd + 1u);
+            }
+            auto const overflow = static_cast<size_type>(std::distance(iAdvances.begin(),
+                std::upper_bound(std::next(iAdvances.begin(), low), std::next(iAdvances.begin(), high), limit))) - 1u;
+            if (overflow == aEnd)
+            {
+                aLines.push_back(line{ lineStart, aEnd });
+                break;
+            }
+            // ... so break before its word, mid-word if the word began the line or on its own if the glyph is wider
+            // than the line.
+            auto const& wordBreak = iBreaks[overflow];
+            if (overflow == lineStart)
+            {
+                aLines.push_back(line{ lineStart, lineStart + 1u });
+                lineStart = lineStart + 1u;
+            }
+            else if (wordBreak.first > lineStart)
+            {
+                aLines.push_back(line{ lineStart, wordBreak.first });
+                lineStart = wordBreak.second;
+            }
+            else
+            {
+                aLines.push_back(line{ lineStart, overflow });
+                lineStart = overflow;
+            }
+        }
+    }
+
+    void line_breaker::break_optimal(paragraph const& aParagraph, dimension aMaxWidth, lines_t& aLines) const
+    {
+        // Total fit over the breaks between words (whitespace runs, which are consumed): minimizes the sum of the
+        // squared space left at the end of every line but the last. A word wider than a line is given a line of its
+        // own (penalized so that as few lines as possible overflow) which is then broken greedily.
+        struct candidate
+        {
+            size_type lineEnd;
+            size_type nextLineStart;
+            double cost;
+            std::size_t previous;
+        };
+        thread_local std::vector<candidate> candidates;
+        candidates.clear();
+        candidates.push_back(candidate{ aParagraph.begin, aParagraph.begin, 0.0, 0u });
+        for (auto index = aParagraph.begin; index != aParagraph.end;)
+        {
+            if (!iWhitespace[index])
+            {
+                ++index;
+                continue;
+            }
+            auto const runStart = index;
+            while (index != aParagraph.end && iWhitespace[index])
+                ++index;
+            if (runStart != aParagraph.begin && index != aParagraph.end)
+                candidates.push_back(candidate{ runStart, index, 0.0, 0u });
+        }
+        candidates.push_back(candidate{ aParagraph.end, aParagraph.end, 0.0, 0u });
+
+        auto const last = candidates.size() - 1u;
+        auto const overflowPenalty = aMaxWidth * aMaxWidth * static_cast<double>(candidates.size());
+        for (std::size_t next = 1u; next <= last; ++next)
+        {
+            auto& nextCandidate = candidates[next];
+            nextCandidate.cost = std::numeric_limits<double>::infinity();
+            for (auto previous = next; previous-- > 0u;)
+            {
+                auto const& previousCandidate = candidates[previous];
+                auto const lineWidth = width(previousCandidate.nextLineStart, nextCandidate.lineEnd);
+                double cost;
+                if (lineWidth > aMaxWidth)
+                {
+                    if (previous != next - 1u)
+                        break;
+                    cost = previousCandidate.cost + overflowPenalty;
+                }
+                else if (next == last)
+                    cost = previousCandidate.cost;
+                else
+                    cost = previousCandidate.cost + (aMaxWidth - lineWidth) * (aMaxWidth - lineWidth);
+                if (cost < nextCandidate.cost)
+                {
+                    nextCandidate.cost = cost;
+                    nextCandidate.previous = previous;
+                }
+            }
+        }
+
+        auto const firstLine = aLines.size();
+        for (auto next = last; next != 0u; next = candidates[next].previous)
+            aLines.push_back(line{ candidates[candidates[next].previous].nextLineStart, candidates[next].lineEnd });
+        std::reverse(std::next(aLines.begin(), firstLine), aLines.end());
+        thread_local lines_t split;
+        for (auto l = firstLine; l < aLines.size(); ++l)
+        {
+            auto const overflowing = aLines[l];
+            if (width(overflowing.begin, overflowing.end) <= aMaxWidth)
+                continue;
+            split.clear();
+            break_greedy(overflowing.begin, overflowing.end, aMaxWidth, split);
+            aLines.erase(std::next(aLines.begin(), l));
+            aLines.insert(std::next(aLines.begin(), l), split.begin(), split.end());
+            l += split.size() - 1u;
+        }
+    }
+}
@@ -0,0 +1,137 @@
+// glyph_bitmap_kernels.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+
+#include <array>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NEOGFX_GLYPH_KERNELS_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define NEOGFX_GLYPH_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+#include "glyph_bitmap_kernels.hpp"
+
+namespace neogfx
+{
+    namespace
+    {
+        // Filter taps in 32nds; the sum of the truncated products never exceeds 255.
+        constexpr std::uint32_t LCD_TAPS[5] = { 3u, 7u, 12u, 7u, 3u };
+        // Sub-pixels processed per SIMD step.
+        constexpr std::uint32_t LCD_STEP = 8u;
+
+        // Expansion of each possible source byte to its pixels, as stored in the destination.
+        template <std::uint32_t BitsPerPixel>
+        struct expansion_table
+        {
+            static constexpr std::uint32_t PIXELS_PER_BYTE = 8u / BitsPerPixel;
+            std::array<std::array<std::uint8_t, PIXELS_PER_BYTE>, 256u> entries;
+
+            expansion_table()
+            {
+                std::uint32_t const mask = (1u << BitsPerPixel) - 1u;
+                for (std::uint32_t byte = 0u; byte < 256u; ++byte)
+                    for (std::uint32_t pixel = 0u; pixel < PIXELS_PER_BYTE; ++pixel)
+                        entries[byte][pixel] = static_cast<std::uint8_t>(((byte >> (8u - BitsPerPixel * (pixel + 1u))) & mask) * 255u / mask);
+            }
+        };
+
+        template <std::uint32_t BitsPerPixel>
+        void expand_row(std::uint8_t const* aSource, std::uint32_t aWidth, std::uint8_t* aPixels)
+        {
+            static expansion_table<BitsPerPixel> const sTable;
+            constexpr std::uint32_t pixelsPerByte = expansion_table<BitsPerPixel>::PIXELS_PER_BYTE;
+            std::uint32_t const wholeBytes = aWidth / pixelsPerByte;
+            for (std::uint32_t byte = 0u; byte < wholeBytes; ++byte, aPixels += pixelsPerByte)
+                std::memcpy(aPixels, sTable.entries[aSource[byte]].data(), pixelsPerByte);
+            if (aWidth % pixelsPerByte != 0u)
+                std::memcpy(aPixels, sTable.entries[aSource[wholeBytes]].data(), aWidth % pixelsPerByte);
+        }
+    }
+
+    void lcd_filter_row(std::uint8_t const* aSource, std::uint32_t aWidth, std::uint8_t* aTexels)
+    {
+        // The row is padded with two zero sub-pixels either side (the filter's taps beyond the row) and enough zeros
+        // after for the last SIMD step.
+        thread_local std::vector<std::uint8_t> tPadded;
+        thread_local std::vector<std::uint8_t> tFiltered;
+        tPadded.assign(aWidth + 4u + LCD_STEP, 0u);
+        std::memcpy(tPadded.data() + 2u, aSource, aWidth);
+        tFiltered.resize(aWidth + LCD_STEP);
+        auto const padded = tPadded.data();
+        auto const filtered = tFiltered.data();
+        std::uint32_t x = 0u;
+#if defined(NEOGFX_GLYPH_KERNELS_SSE2)
+        __m128i const zero = _mm_setzero_si128();
+        __m128i const taps[5] = {
+            _mm_set1_epi16(LCD_TAPS[0]), _mm_set1_epi16(LCD_TAPS[1]), _mm_set1_epi16(LCD_TAPS[2]), _mm_set1_epi16(LCD_TAPS[3]), _mm_set1_epi16(LCD_TAPS[4]) };
+        for (; x < aWidth; x += LCD_STEP)
+        {
+            __m128i sum = zero;
+            for (std::uint32_t tap = 0u; tap < 5u; ++tap)
+            {
+                __m128i const subpixels = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(padded + x + tap)), zero);
+                sum = _mm_add_epi16(sum, _mm_srli_epi16(_mm_mullo_epi16(subpixels, taps[tap]), 5));
+            }
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(filtered + x), _mm_packus_epi16(sum, zero));
+        }
+#elif defined(NEOGFX_GLYPH_KERNELS_NEON)
+        uint8x8_t const taps[5] = {
+            vdup_n_u8(LCD_TAPS[0]), vdup_n_u8(LCD_TAPS[1]), vdup_n_u8(LCD_TAPS[2]), vdup_n_u8(LCD_TAPS[3]), vdup_n_u8(LCD_TAPS[4]) };
+        for (; x < aWidth; x += LCD_STEP)
+        {
+            uint16x8_t sum = vdupq_n_u16(0u);
+            for (std::uint32_t tap = 0u; tap < 5u; ++tap)
+                sum = vaddq_u16(sum, vshrq_n_u16(vmull_u8(vld1_u8(padded + x + tap), taps[tap]), 5));
+            vst1_u8(filtered + x, vmovn_u16(sum));
+        }
+#endif
+        for (; x < aWidth; ++x)
+        {
+            std::uint32_t sum = 0u;
+            for (std::uint32_t tap = 0u; tap < 5u; ++tap)
+                sum += (padded[x + tap] * LCD_TAPS[tap]) >> 5u;
+            filtered[x] = static_cast<std::uint8_t>(sum);
+        }
+        for (std::uint32_t texel = 0u; texel < aWidth / 3u; ++texel)
+        {
+            std::uint8_t const rgbx[4] = { filtered[texel * 3u], filtered[texel * 3u + 1u], filtered[texel * 3u + 2u], 0u };
+            std::memcpy(aTexels + texel * 4u, rgbx, sizeof(rgbx));
+        }
+    }
+
+    void expand_mono_row(std::uint8_t const* aSource, std::uint32_t aWidth, std::uint8_t* aPixels)
+    {
+        expand_row<1u>(aSource, aWidth, aPixels);
+    }
+
+    void expand_gray2_row(std::uint8_t const* aSource, std::uint32_t aWidth, std::uint8_t* aPixels)
+    {
+        expand_row<2u>(aSource, aWidth, aPixels);
+    }
+
+    void expand_gray4_row(std::uint8_t const* aSource, std::uint32_t aWidth, std::uint8_t* aPixels)
+    {
+        expand_row<4u>(aSource, aWidth, aPixels);
+    }
+}
@@ -0,0 +1,38 @@
+// glyph_bitmap_kernels.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+namespace neogfx
+{
+    // Row kernels converting FreeType glyph bitmaps to glyph texture data. Each converts one row; glyph textures are
+    // flipped vertically by the caller passing the destination row for each source row.
+
+    // Applies the sub-pixel FIR filter (taps of 3/32, 7/32, 12/32, 7/32 and 3/32, each product truncated) to a row of
+    // aWidth LCD sub-pixels, writing aWidth / 3 four byte texels (red, green, blue and zero).
+    void lcd_filter_row(std::uint8_t const* aSource, std::uint32_t aWidth, std::uint8_t* aTexels);
+    // Expands a row of aWidth 1 bit per pixel monochrome pixels (most significant bit first) to 0x00 or 0xFF bytes.
+    void expand_mono_row(std::uint8_t const* aSource, std::uint32_t aWidth, std::uint8_t* aPixels);
+    // Expands a row of aWidth 2 bit per pixel gray pixels (most significant first) to 8 bit gray.
+    void expand_gray2_row(std::uint8_t const* aSource, std::uint32_t aWidth, std::uint8_t* aPixels);
+    // Expands a row of aWidth 4 bit per pixel gray pixels (most significant first) to 8 bit gray.
+    void expand_gray4_row(std::uint8_t const* aSource, std::uint32_t aWidth, std::uint8_t* aPixels);
+}
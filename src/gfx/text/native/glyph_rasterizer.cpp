@@ -0,0 +1,126 @@
+// glyph_rasterizer.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+
+#include "native_font_face.hpp"
+#include "glyph_rasterizer.hpp"
+
+namespace neogfx
+{
+    glyph_rasterizer::~glyph_rasterizer()
+    {
+        stop();
+    }
+
+    void glyph_rasterizer::rasterize(native_font_face const& aFace, std::vector<glyph_index_t> const& aGlyphs)
+    {
+        if (aGlyphs.empty())
+            return;
+        {
+            std::scoped_lock lock{ iMutex };
+            if (iStopped)
+                return;
+            // Workers are started on first use so that applications that never prerasterize don't pay for them.
+            if (iWorkers.empty())
+            {
+                auto const threads = std::clamp<std::size_t>(std::thread::hardware_concurrency() / 2u, 1u, MAX_THREADS);
+                for (std::size_t i = 0u; i < threads; ++i)
+                    iWorkers.emplace_back([this](std::stop_token aStopToken) { work(aStopToken); });
+            }
+            for (std::size_t first = 0u; first < aGlyphs.size(); first += JOB_SIZE)
+                iJobs.push_back(job{ &aFace, std::vector<glyph_index_t>{
+                    std::next(aGlyphs.begin(), first), std::next(aGlyphs.begin(), std::min(first + JOB_SIZE, aGlyphs.size())) } });
+        }
+        iJobQueued.notify_all();
+    }
+
+    void glyph_rasterizer::cancel(native_font_face const& aFace)
+    {
+        std::unique_lock lock{ iMutex };
+        std::erase_if(iJobs, [&](job const& aJob) { return aJob.face == &aFace; });
+        iJobDone.wait(lock, [&]() { return std::find(iBusy.begin(), iBusy.end(), &aFace) == iBusy.end(); });
+        std::erase(iCompleted, &aFace);
+    }
+
+    void glyph_rasterizer::stop()
+    {
+        std::vector<std::jthread> workers;
+        {
+            std::scoped_lock lock{ iMutex };
+            iStopped = true;
+            iJobs.clear();
+            iCompleted.clear();
+            workers.swap(iWorkers);
+        }
+        for (auto& worker : workers)
+            worker.request_stop();
+        workers.clear();
+    }
+
+    void glyph_rasterizer::upload_completed()
+    {
+        thread_local std::vector<native_font_face const*> tCompleted;
+        {
+            std::scoped_lock lock{ iMutex };
+            tCompleted.swap(iCompleted);
+        }
+        for (auto face : tCompleted)
+            face->upload_rasterized();
+        tCompleted.clear();
+    }
+
+    void glyph_rasterizer::work(std::stop_token aStopToken)
+    {
+        while (!aStopToken.stop_requested())
+        {
+            job next;
+            {
+                std::unique_lock lock{ iMutex };
+                if (!iJobQueued.wait(lock, aStopToken, [&]() { return !iJobs.empty(); }))
+                    return;
+                next = std::move(iJobs.front());
+                iJobs.pop_front();
+                iBusy.push_back(next.face);
+            }
+            try
+            {
+                for (auto glyph : next.glyphs)
+                {
+                    if (aStopToken.stop_requested())
+                        break;
+                    auto rasterized = next.face->rasterize(glyph);
+                    if (rasterized)
+                        next.face->add_rasterized(glyph, std::move(*rasterized));
+                }
+            }
+            catch (...)
+            {
+                // The glyphs not rasterized will be rasterized synchronously on first use.
+            }
+            {
+                std::scoped_lock lock{ iMutex };
+                iBusy.erase(std::find(iBusy.begin(), iBusy.end(), next.face));
+                if (std::find(iCompleted.begin(), iCompleted.end(), next.face) == iCompleted.end())
+                    iCompleted.push_back(next.face);
+            }
+            iJobDone.notify_all();
+        }
+    }
+}
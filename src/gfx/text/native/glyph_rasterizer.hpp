@@ -0,0 +1,73 @@
+// glyph_rasterizer.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace neogfx
+{
+    class native_font_face;
+
+    // Pool of worker threads rasterizing glyphs (FreeType loading and rendering plus sub-pixel filtering) ahead of
+    // their first use. Completed bitmaps are held by their font face until upload_completed(), called on the main
+    // thread once per frame, adds them to the glyph atlas in one batch. A glyph needed before its bitmap has been
+    // uploaded is rasterized synchronously by its font face as before. The font manager owns the rasterizer but font
+    // faces can outlive it so faces only hold a weak reference; the font manager stops it (joining the workers)
+    // before releasing it.
+    class glyph_rasterizer
+    {
+    public:
+        typedef std::uint32_t glyph_index_t;
+    public:
+        static constexpr std::size_t MAX_THREADS = 4u;
+        static constexpr std::size_t JOB_SIZE = 32u;
+    private:
+        struct job
+        {
+            native_font_face const* face;
+            std::vector<glyph_index_t> glyphs;
+        };
+    public:
+        ~glyph_rasterizer();
+    public:
+        void rasterize(native_font_face const& aFace, std::vector<glyph_index_t> const& aGlyphs);
+        // Discards the face's queued glyphs and waits for any of its glyphs being rasterized.
+        void cancel(native_font_face const& aFace);
+        void upload_completed();
+        // Discards all queued work and joins the workers; later requests are ignored.
+        void stop();
+    private:
+        void work(std::stop_token aStopToken);
+    private:
+        std::mutex iMutex;
+        std::condition_variable_any iJobQueued;
+        std::condition_variable iJobDone;
+        std::deque<job> iJobs;
+        std::vector<native_font_face const*> iBusy;
+        std::vector<native_font_face const*> iCompleted;
+        std::vector<std::jthread> iWorkers;
+        bool iStopped = false;
+    };
+}
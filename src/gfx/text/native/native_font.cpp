@@ -26,6 +26,7 @@
 #include <neogfx/gfx/text/i_font_manager.hpp>
 #include "native_font.hpp"
 #include "native_font_face.hpp"
+#include "persistent_glyph_cache.hpp"
 
 namespace neogfx
 {
@@ -116,9 +117,9 @@ namespace neogfx
             matches.insert(std::make_pair(matching_bits(static_cast<std::uint32_t>(s.first.first), static_cast<std::uint32_t>(aStyle)), &s));
         if (matches.empty())
             throw no_matching_style_found();
-        font_style const faceStyle = (matches.rbegin()->second->first.first | (aStyle & (font_style::Superscript | font_style::Subscript | font_style::BelowAscenderLine | font_style::AboveBaseline | font_style::Emulated)));
+        font_style const faceStyle = (matches.rbegin()->second->first.first | (aStyle & (font_style::Superscript | font_style::Subscript | font_style::BelowAscenderLine | font_style::AboveBaseline | font_style::DistanceField | font_style::Emulated)));
         FT_Long const faceIndex = matches.rbegin()->second->second;
-        aResult = create_face(faceIndex, faceStyle, aSize, aOutline, aHinting, aDevice);
+        aResult = create_face(faceIndex, faceStyle, aSize, aOutline, aHinting, size{ aDevice.horizontal_dpi(), aDevice.vertical_dpi() });
     }
 
     void native_font::create_face(font_style aStyle, i_string const& aStyleName, font::point_size aSize, stroke aOutline, bool aHinting, i_device_resolution const& aDevice, i_ref_ptr<i_native_font_face>& aResult)
@@ -135,14 +136,14 @@ namespace neogfx
             create_face(aStyle, aSize, aOutline, aHinting, aDevice, aResult);
             return;
         }
-        font_style const faceStyle = foundStyle->first.first | (aStyle & (font_style::Superscript | font_style::Subscript | font_style::BelowAscenderLine | font_style::AboveBaseline));
+        font_style const faceStyle = foundStyle->first.first | (aStyle & (font_style::Superscript | font_style::Subscript | font_style::BelowAscenderLine | font_style::AboveBaseline | font_style::DistanceField));
         if ((aStyle & font_style::BoldItalic) != font_style::Invalid && (aStyle & font_style::BoldItalic) != (faceStyle & font_style::BoldItalic))
         {
             create_face(aStyle, aSize, aOutline, aHinting, aDevice, aResult);
             return;
         }
         FT_Long const faceIndex = foundStyle->second;
-        aResult = create_face(faceIndex, faceStyle, aSize, aOutline, aHinting, aDevice);
+        aResult = create_face(faceIndex, faceStyle, aSize, aOutline, aHinting, size{ aDevice.horizontal_dpi(), aDevice.vertical_dpi() });
     }
 
     void native_font::create_face(font_info const& aFontInfo, i_device_resolution const& aDevice, i_ref_ptr<i_native_font_face>& aResult)
@@ -153,6 +154,19 @@ namespace neogfx
             return create_face(aFontInfo.style(), aFontInfo.size(), aFontInfo.outline(), aFontInfo.hinting(), aDevice, aResult);
     }
 
+    std::uint64_t native_font::hash() const
+    {
+        std::call_once(iHashComputed, [&]()
+        {
+            // The file contents are held in memory (by iCache) for as long as any of the font's faces exist.
+            if (std::holds_alternative<filename_type>(iSource))
+                iHash = persistent_glyph_cache::hash(iCache.data(), iCache.size());
+            else
+                iHash = persistent_glyph_cache::hash(std::get<memory_block_type>(iSource).first, std::get<memory_block_type>(iSource).second);
+        });
+        return iHash;
+    }
+
     native_font::style_map::const_iterator native_font::find_style(font_style aStyle) const
     {
         return std::find_if(iStyleMap.begin(), iStyleMap.end(), [aStyle](auto const& s) { return s.first.first == aStyle; });
@@ -264,17 +278,27 @@ namespace neogfx
         FT_Done_Face(aFace);
     }
 
-    ref_ptr<i_native_font_face> native_font::create_face(FT_Long aFaceIndex, font_style aStyle, font::point_size aSize, stroke aOutline, bool aHinting, i_device_resolution const& aDevice)
+    ref_ptr<i_native_font_face> native_font::create_face(FT_Long aFaceIndex, font_style aStyle, font::point_size aSize, stroke aOutline, bool aHinting, neogfx::size const& aDpiResolution)
     {
-        auto existingFace = iFaces.find(std::make_tuple(aFaceIndex, aStyle, aSize, aOutline, aHinting, size{ aDevice.horizontal_dpi(), aDevice.vertical_dpi() }));
+        auto existingFace = iFaces.find(std::make_tuple(aFaceIndex, aStyle, aSize, aOutline, aHinting, aDpiResolution));
         if (existingFace != iFaces.end())
             return existingFace->second;
+        ref_ptr<i_native_font_face> distanceFieldReference;
+        if ((aStyle & font_style::DistanceField) == font_style::DistanceField)
+        {
+            // Outlines are drawn from the distance field and distance fields aren't hinted so the reference face
+            // has neither; nor is it scaled for superscript or subscript.
+            auto const referenceStyle = aStyle & ~(font_style::Superscript | font_style::Subscript | font_style::BelowAscenderLine | font_style::AboveBaseline);
+            size const referenceDpi{ DISTANCE_FIELD_REFERENCE_DPI, DISTANCE_FIELD_REFERENCE_DPI };
+            if (referenceStyle != aStyle || aSize != DISTANCE_FIELD_REFERENCE_SIZE || aOutline != stroke{} || aHinting || aDpiResolution != referenceDpi)
+                distanceFieldReference = create_face(aFaceIndex, referenceStyle, DISTANCE_FIELD_REFERENCE_SIZE, stroke{}, false, referenceDpi);
+        }
         auto const& newFaceHandles = open_face(aFaceIndex);
         try
         {
             auto newFontId = service<i_font_manager>().allocate_font_id();
-            auto newFace = make_ref<native_font_face>(iFontLib, newFontId, *this, aStyle, aSize, aOutline, aHinting, size(aDevice.horizontal_dpi(), aDevice.vertical_dpi()), newFaceHandles.first, newFaceHandles.second);
-            iFaces.insert(std::make_pair(std::make_tuple(aFaceIndex, aStyle, aSize, aOutline, aHinting, size{ aDevice.horizontal_dpi(), aDevice.vertical_dpi() }), newFace)).first;
+            auto newFace = make_ref<native_font_face>(iFontLib, newFontId, *this, aStyle, aSize, aOutline, aHinting, aDpiResolution, newFaceHandles.first, newFaceHandles.second, distanceFieldReference);
+            iFaces.insert(std::make_pair(std::make_tuple(aFaceIndex, aStyle, aSize, aOutline, aHinting, aDpiResolution), newFace)).first;
             return newFace;
         }
         catch (...)
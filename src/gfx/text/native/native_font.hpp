@@ -21,6 +21,7 @@
 
 #include <neogfx/neogfx.hpp>
 
+#include <mutex>
 #include <unordered_map>
 #include <tuple>
 #include <ft2build.h>
@@ -46,6 +47,10 @@ namespace neogfx
     public:
         struct failed_to_load_font : std::runtime_error { failed_to_load_font() : std::runtime_error("neogfx::native_font::failed_to_load_font") {} };
         struct no_matching_style_found : std::runtime_error { no_matching_style_found() : std::runtime_error("neogfx::native_font::no_matching_style_found") {} };
+    public:
+        // Distance field glyphs for all sizes of a face are rendered once, by a face of this size and resolution.
+        static constexpr font::point_size DISTANCE_FIELD_REFERENCE_SIZE = 64.0;
+        static constexpr dimension DISTANCE_FIELD_REFERENCE_DPI = 72.0;
     public:
         native_font(FT_Library aFontLib, const std::string aFileName);
         native_font(FT_Library aFontLib, const void* aData, std::size_t aSizeInBytes);
@@ -61,13 +66,16 @@ namespace neogfx
         void create_face(font_style aStyle, font::point_size aSize, stroke aOutline, bool aHinting, i_device_resolution const& aDevice, i_ref_ptr<i_native_font_face>& aResult) final;
         void create_face(font_style aStyle, i_string const& aStyleName, font::point_size aSize, stroke aOutline, bool aHinting, i_device_resolution const& aDevice, i_ref_ptr<i_native_font_face>& aResult) final;
         void create_face(font_info const& aFontIinfo, i_device_resolution const& aDevice, i_ref_ptr<i_native_font_face>& aResult) final;
+    public:
+        // Hash of the font file's contents (computed on first use); identifies the font in the persistent glyph cache.
+        std::uint64_t hash() const;
     private:
         style_map::const_iterator find_style(font_style aStyle) const;
         void register_faces();
         void register_face(FT_Long aFaceIndex);
         std::pair<FT_Face, hb_face_t*> open_face(FT_Long aFaceIndex);
         void close_face(FT_Face aFace);
-        ref_ptr<i_native_font_face> create_face(FT_Long aFaceIndex, font_style aStyle, font::point_size aSize, stroke aOutline, bool aHinting, i_device_resolution const& aDevice);
+        ref_ptr<i_native_font_face> create_face(FT_Long aFaceIndex, font_style aStyle, font::point_size aSize, stroke aOutline, bool aHinting, neogfx::size const& aDpiResolution);
     private:
         FT_Library iFontLib;
         source_type iSource;
@@ -77,5 +85,7 @@ namespace neogfx
         FT_Long iFaceCount;
         style_map iStyleMap;
         face_map iFaces;
+        mutable std::once_flag iHashComputed;
+        mutable std::uint64_t iHash = 0u;
     };
 }
\ No newline at end of file
@@ -19,6 +19,7 @@
 
 #include <neogfx/neogfx.hpp>
 
+#include <cstring>
 #include <unordered_map>
 #include <boost/functional/hash.hpp>
 #include <ft2build.h>
@@ -31,8 +32,20 @@
 #include FT_STROKER_H
 
 #include "../../native/i_native_texture.hpp"
+#include "native_font.hpp"
 #include "native_font_face.hpp"
-#include <neogfx/gfx/text/i_font_manager.hpp>
+#include "glyph_rasterizer.hpp"
+#include "glyph_bitmap_kernels.hpp"
+#include "persistent_glyph_cache.hpp"
+#ifdef u8
+#undef u8
+#include <harfbuzz\hb-aat.h>
+#define u8
+#else
+#include <harfbuzz\hb-aat.h>
+#endif
+#include <neogfx/app/profiler.hpp>
+#include <neogfx/gfx/text/font_manager.hpp>
 #include <neogfx/gfx/i_texture_atlas.hpp>
 #include <neogfx/gfx/i_rendering_engine.hpp>
 #include <neogfx/gfx/graphics_context.hpp>
@@ -69,10 +82,11 @@ namespace neogfx
 
     native_font_face::native_font_face(
         FT_Library aFontLib, font_id aId, i_native_font& aFont, font_style aStyle, font::point_size aSize, stroke aOutline, bool aHinting,
-        neogfx::size aDpiResolution, FT_Face aFreetypeFace, hb_face_t* aHarfbuzzFace) :
+        neogfx::size aDpiResolution, FT_Face aFreetypeFace, hb_face_t* aHarfbuzzFace, ref_ptr<i_native_font_face> aDistanceFieldReference) :
         iFontLib{ aFontLib }, iId{ aId }, iFont{ aFont }, iStyle{ aStyle }, iStyleName{ aFreetypeFace->style_name }, iSize{ aSize }, 
         iOutline{ aOutline }, iHinting{ aHinting }, iPixelDensityDpi { aDpiResolution }, iHandle{ *this, aFreetypeFace, aHarfbuzzFace },
-        iHasKerning{ !!FT_HAS_KERNING(iHandle.freetypeFace) }
+        iDistanceFieldReference{ aDistanceFieldReference }, iHasKerning{ !!FT_HAS_KERNING(iHandle.freetypeFace) },
+        iRasterizer{ static_cast<font_manager&>(service<i_font_manager>()).rasterizer() }
     {
         switch (aStyle)
         {
@@ -88,10 +102,18 @@ namespace neogfx
         }
         set_metrics();
         sGetAdvanceCache[aFreetypeFace] = get_advance_cache_face{};
+        // Speculatively rasterize printable ASCII as most text will need some of it.
+        std::vector<glyph_index_t> speculative;
+        for (auto ch = SPECULATIVE_FIRST; ch <= SPECULATIVE_LAST; ++ch)
+            if (auto const glyph = glyph_index(ch); glyph != 0)
+                speculative.push_back(glyph);
+        prerasterize(std::move(speculative));
     }
 
     native_font_face::~native_font_face()
     {
+        if (auto const rasterizer = iRasterizer.lock())
+            rasterizer->cancel(*this);
         if (iHandle.freetypeFace != nullptr)
             sGetAdvanceCache.erase(sGetAdvanceCache.find(iHandle.freetypeFace));
         FT_Done_Face(iHandle.freetypeFace);
@@ -217,6 +239,7 @@ namespace neogfx
 
     void native_font_face::set_kerning_method(neogfx::kerning_method aKerningMethod)
     {
+        std::scoped_lock lock{ iKerningMutex };
         iKerningMethod = aKerningMethod;
         iKerningTable.clear();
     }
@@ -225,6 +248,8 @@ namespace neogfx
     {
         if (!iHasKerning)
             return 0.0;
+        // Called back from HarfBuzz so may be called by more than one shaping thread.
+        std::scoped_lock lock{ iKerningMutex };
         auto existing = iKerningTable.find(std::make_pair(aLeftGlyphIndex, aRightGlyphIndex));
         if (existing != iKerningTable.end())
             return existing->second;
@@ -234,7 +259,10 @@ namespace neogfx
         case neogfx::kerning_method::Harfbuzz:
             {
                 FT_Vector delta;
-                freetypeCheck(FT_Get_Kerning(iHandle.freetypeFace, aLeftGlyphIndex, aRightGlyphIndex, FT_KERNING_UNFITTED, &delta));
+                {
+                    std::scoped_lock faceLock{ iFaceMutex };
+                    freetypeCheck(FT_Get_Kerning(iHandle.freetypeFace, aLeftGlyphIndex, aRightGlyphIndex, FT_KERNING_UNFITTED, &delta));
+                }
                 return (iKerningTable[std::make_pair(aLeftGlyphIndex, aRightGlyphIndex)] = delta.x / 64.0);
             }
         case neogfx::kerning_method::Disabled:
@@ -288,9 +316,105 @@ namespace neogfx
 
     native_font_face::glyph_index_t native_font_face::glyph_index(char32_t aCodePoint) const
     {
+        std::scoped_lock lock{ iFaceMutex };
         return FT_Get_Char_Index(iHandle.freetypeFace, aCodePoint);
     }
 
+    native_font_face::simple_glyph_table const& native_font_face::simple_glyphs() const
+    {
+        std::call_once(iSimpleGlyphsBuilt, [&]()
+        {
+            auto const face = iHandle.harfbuzzFace;
+            auto const font = iHandle.harfbuzzFont;
+            // HarfBuzz applies 'kern' and AAT tables in ways not reproduced by the fast path.
+            std::unique_ptr<hb_blob_t, decltype(&hb_blob_destroy)> kernTable{ hb_face_reference_table(face, HB_TAG('k','e','r','n')), &hb_blob_destroy };
+            if (hb_blob_get_length(kernTable.get()) != 0u || hb_aat_layout_has_substitution(face) ||
+                hb_aat_layout_has_positioning(face) || hb_aat_layout_has_tracking(face))
+                return;
+            // Features HarfBuzz applies by default to horizontal LTR text of the default shaper (ligatures are
+            // disabled when shaping).
+            static hb_tag_t const sDefaultFeatures[] =
+            {
+                HB_TAG('a','b','v','m'), HB_TAG('b','l','w','m'), HB_TAG('c','c','m','p'), HB_TAG('l','o','c','l'),
+                HB_TAG('m','a','r','k'), HB_TAG('m','k','m','k'), HB_TAG('r','l','i','g'), HB_TAG('c','a','l','t'),
+                HB_TAG('c','l','i','g'), HB_TAG('c','u','r','s'), HB_TAG('d','i','s','t'), HB_TAG('k','e','r','n'),
+                HB_TAG('r','c','l','t'), HB_TAG('r','v','r','n'), HB_TAG('l','t','r','a'), HB_TAG('l','t','r','m'),
+                HB_TAG_NONE
+            };
+            std::unique_ptr<hb_set_t, decltype(&hb_set_destroy)> lookups{ hb_set_create(), &hb_set_destroy };
+            std::unique_ptr<hb_set_t, decltype(&hb_set_destroy)> affected{ hb_set_create(), &hb_set_destroy };
+            for (auto const table : { HB_OT_TAG_GSUB, HB_OT_TAG_GPOS })
+            {
+                hb_set_clear(lookups.get());
+                hb_ot_layout_collect_lookups(face, table, nullptr, nullptr, sDefaultFeatures, lookups.get());
+                for (hb_codepoint_t lookup = HB_SET_VALUE_INVALID; hb_set_next(lookups.get(), &lookup);)
+                    hb_ot_layout_lookup_collect_glyphs(face, table, lookup, affected.get(), affected.get(), affected.get(), nullptr);
+            }
+            bool const glyphClasses = hb_ot_layout_has_glyph_classes(face);
+            for (auto codePoint = simple_glyph_table::FIRST; codePoint <= simple_glyph_table::LAST; ++codePoint)
+            {
+                hb_codepoint_t glyph = 0u;
+                if (!hb_font_get_nominal_glyph(font, codePoint, &glyph) || glyph == 0u || hb_set_has(affected.get(), glyph))
+                    continue;
+                // GDEF marks have their advances zeroed.
+                if (glyphClasses && hb_ot_layout_get_glyph_class(face, glyph) == HB_OT_LAYOUT_GLYPH_CLASS_MARK)
+                    continue;
+                auto& entry = iSimpleGlyphs.entries[codePoint - simple_glyph_table::FIRST];
+                entry.glyph = glyph;
+                entry.advance = hb_font_get_glyph_h_advance(font, glyph);
+            }
+            // Without GPOS HarfBuzz kerns using the font's kerning function.
+            iSimpleGlyphs.fallbackKerning = !hb_ot_layout_has_positioning(face);
+        });
+        return iSimpleGlyphs;
+    }
+
+    bool native_font_face::has_glyph(char32_t aCodePoint) const
+    {
+        auto const pageIndex = aCodePoint / COVERAGE_PAGE_SIZE;
+        std::scoped_lock lock{ iCoverageMutex };
+        auto page = iCoverage.find(pageIndex);
+        if (page == iCoverage.end())
+        {
+            // The character map is queried through HarfBuzz, as used for shaping, which needn't lock the face.
+            coverage_page coverage;
+            for (char32_t offset = 0u; offset < COVERAGE_PAGE_SIZE; ++offset)
+            {
+                hb_codepoint_t glyph = 0u;
+                coverage[offset] = hb_font_get_nominal_glyph(iHandle.harfbuzzFont, pageIndex * COVERAGE_PAGE_SIZE + offset, &glyph) && glyph != 0u;
+            }
+            page = iCoverage.emplace(pageIndex, coverage).first;
+        }
+        return page->second[aCodePoint % COVERAGE_PAGE_SIZE];
+    }
+
+    std::optional<std::uint32_t> native_font_face::covering_face(char32_t aCodePoint) const
+    {
+        {
+            std::scoped_lock lock{ iCoverageMutex };
+            auto const existing = iCoveringFaces.find(aCodePoint);
+            if (existing != iCoveringFaces.end())
+                return existing->second;
+        }
+        // Not searched with the lock held as a fallback chain may lead back to this face.
+        std::optional<std::uint32_t> result;
+        native_font_face const* face = this;
+        for (std::uint32_t depth = 0u; depth < MAX_FALLBACK_DEPTH; ++depth)
+        {
+            if (face->has_glyph(aCodePoint))
+            {
+                result = depth;
+                break;
+            }
+            if (!face->has_fallback())
+                break;
+            face = &static_cast<native_font_face const&>(face->fallback());
+        }
+        std::scoped_lock lock{ iCoverageMutex };
+        iCoveringFaces.emplace(aCodePoint, result);
+        return result;
+    }
+
     namespace
     {
         inline glyph_pixel_mode to_glyph_pixel_mode(unsigned char aFreeTypePixelMode)
@@ -350,24 +474,161 @@ namespace neogfx
          
     i_glyph& native_font_face::glyph(const glyph_char& aGlyphChar) const
     {
-        // todo: investigate why turning off sub-pixel doesn't produce same grayscale bitmap as Windows with ClearType disabled
-        bool useSubpixelFiltering = true;
-
-        thread_local bool tRenderOutlineGlyph = false;
-
         auto existingGlyph = iGlyphs.find(aGlyphChar.value);
         if (existingGlyph != iGlyphs.end())
+            return existingGlyph->second;
+
+        if (iDistanceFieldReference != nullptr && distance_field())
+            return scaled_distance_field_glyph(aGlyphChar);
+
+        std::optional<rasterized_glyph> rasterized;
+        {
+            std::scoped_lock lock{ iRasterizedMutex };
+            iRequestedGlyphs.insert(aGlyphChar.value);
+            auto prerasterized = iRasterizedGlyphs.find(aGlyphChar.value);
+            if (prerasterized != iRasterizedGlyphs.end())
+            {
+                rasterized = std::move(prerasterized->second);
+                iRasterizedGlyphs.erase(prerasterized);
+            }
+        }
+        // Glyphs not (yet) rasterized by the workers are rasterized synchronously; a worker's bitmap for a glyph
+        // already in the atlas is discarded when uploaded.
+        if (!rasterized)
+            rasterized = rasterize(aGlyphChar.value);
+        if (!rasterized)
+        {
+            thread_local bool inHere = false;
+            if (!inHere)
+            {
+                neolib::scoped_flag sf{ inHere };
+                glyph_char invalid = aGlyphChar;
+                auto const replacementGlyph = glyph_index(0xFFFD);
+                if (replacementGlyph != 0)
+                {
+                    invalid.value = replacementGlyph;
+                    return glyph(invalid);
+                }
+            }
+            return invalid_glyph();
+        }
+        return add_glyph(aGlyphChar.value, *rasterized);
+    }
+
+    void native_font_face::prerasterize(std::vector<glyph_index_t> aGlyphs) const
+    {
+        if (iDistanceFieldReference != nullptr && distance_field())
+        {
+            static_cast<native_font_face&>(*iDistanceFieldReference).prerasterize(std::move(aGlyphs));
+            return;
+        }
+        {
+            std::scoped_lock lock{ iRasterizedMutex };
+            std::erase_if(aGlyphs, [&](glyph_index_t aGlyph) { return !iRequestedGlyphs.insert(aGlyph).second; });
+        }
+        if (auto const rasterizer = iRasterizer.lock())
+            rasterizer->rasterize(*this, aGlyphs);
+    }
+
+    std::optional<native_font_face::rasterized_glyph> native_font_face::rasterize(glyph_index_t aGlyphIndex) const
+    {
+        scoped_profiler_zone rasterizeZone{ "glyph_rasterize", "text" };
+
+        auto const persistentCache = static_cast<font_manager&>(service<i_font_manager>()).persistent_cache();
+        if (persistentCache != nullptr)
+            if (auto cached = persistentCache->find(persistent_key(), aGlyphIndex))
+                return cached;
+
+        std::scoped_lock lock{ iFaceMutex };
+        rasterized_glyph result;
+        if (distance_field())
         {
-            if (!tRenderOutlineGlyph)
-                return existingGlyph->second;
+            // Outlines are drawn from the distance field so there is no outline bitmap.
+            auto bitmap = render_distance_field(aGlyphIndex, result.metrics);
+            if (!bitmap)
+                return {};
+            result.bitmap = std::move(*bitmap);
         }
         else
         {
-            if (tRenderOutlineGlyph)
-                throw std::logic_error( "neogfx::native_font_face::glyph" );
+            auto bitmap = render(aGlyphIndex, false, &result.metrics);
+            if (!bitmap)
+                return {};
+            result.bitmap = std::move(*bitmap);
+            if (outline().radius != 0.0)
+                result.outline = render(aGlyphIndex, true, nullptr);
         }
+        if (persistentCache != nullptr)
+            persistentCache->add(persistent_key(), aGlyphIndex, result);
+        return result;
+    }
+
+    void native_font_face::add_rasterized(glyph_index_t aGlyphIndex, rasterized_glyph&& aGlyph) const
+    {
+        std::scoped_lock lock{ iRasterizedMutex };
+        iRasterizedGlyphs.emplace(aGlyphIndex, std::move(aGlyph));
+    }
+
+    void native_font_face::upload_rasterized() const
+    {
+        thread_local std::unordered_map<glyph_index_t, rasterized_glyph> tRasterized;
+        {
+            std::scoped_lock lock{ iRasterizedMutex };
+            tRasterized.swap(iRasterizedGlyphs);
+        }
+        for (auto const& rasterized : tRasterized)
+            if (iGlyphs.find(rasterized.first) == iGlyphs.end())
+                add_glyph(rasterized.first, rasterized.second);
+        tRasterized.clear();
+    }
+
+    std::uint64_t native_font_face::persistent_key() const
+    {
+        std::call_once(iPersistentKeyComputed, [&]()
+        {
+            // Glyphs rendered by a different version of FreeType may differ so its version is part of the key.
+            auto key = static_cast<neogfx::native_font const&>(iFont).hash();
+            key = persistent_glyph_cache::hash_value(persistent_glyph_cache::VERSION, key);
+            key = persistent_glyph_cache::hash_value(FREETYPE_MAJOR * 10000 + FREETYPE_MINOR * 100 + FREETYPE_PATCH, key);
+            key = persistent_glyph_cache::hash_value(iHandle.freetypeFace->face_index, key);
+            key = persistent_glyph_cache::hash_value(iStyle, key);
+            key = persistent_glyph_cache::hash_value(iSize, key);
+            key = persistent_glyph_cache::hash_value(iOutline.radius, key);
+            key = persistent_glyph_cache::hash_value(iOutline.lineCap, key);
+            key = persistent_glyph_cache::hash_value(iOutline.lineJoin, key);
+            key = persistent_glyph_cache::hash_value(iOutline.miterLimit, key);
+            key = persistent_glyph_cache::hash_value(iHinting, key);
+            key = persistent_glyph_cache::hash_value(iPixelDensityDpi.cx, key);
+            key = persistent_glyph_cache::hash_value(iPixelDensityDpi.cy, key);
+            key = persistent_glyph_cache::hash_value(i_glyph::DISTANCE_FIELD_SPREAD, key);
+            iPersistentKey = key;
+        });
+        return iPersistentKey;
+    }
+
+    bool native_font_face::distance_field() const
+    {
+#ifdef NEOGFX_FREETYPE_SDF
+        return (style() & font_style::DistanceField) == font_style::DistanceField && !is_bitmap_font();
+#else
+        return false;
+#endif
+    }
+
+    native_font_face const& native_font_face::rasterizing_face() const
+    {
+        if (iDistanceFieldReference != nullptr && distance_field())
+            return static_cast<native_font_face const&>(*iDistanceFieldReference);
+        return *this;
+    }
+
+    std::optional<native_font_face::glyph_bitmap> native_font_face::render(glyph_index_t aGlyphIndex, bool aOutline, glyph_metrics* aMetrics) const
+    {
+        // todo: investigate why turning off sub-pixel doesn't produce same grayscale bitmap as Windows with ClearType disabled
+        bool useSubpixelFiltering = true;
 
         FT_Bitmap* bitmap = nullptr;
+        FT_Glyph glyphDescStroke = nullptr;
 
         try
         {
@@ -375,12 +636,12 @@ namespace neogfx
             {
                 if (useSubpixelFiltering)
                 {
-                    freetypeCheck(FT_Load_Glyph(iHandle.freetypeFace, aGlyphChar.value, 
+                    freetypeCheck(FT_Load_Glyph(iHandle.freetypeFace, aGlyphIndex, 
                         (hinting() ? FT_LOAD_FORCE_AUTOHINT : FT_LOAD_NO_HINTING) | FT_LOAD_TARGET_LCD | FT_LOAD_NO_BITMAP));
                 }
                 else
                 {
-                    freetypeCheck(FT_Load_Glyph(iHandle.freetypeFace, aGlyphChar.value, 
+                    freetypeCheck(FT_Load_Glyph(iHandle.freetypeFace, aGlyphIndex, 
                         (hinting() ? FT_LOAD_FORCE_AUTOHINT : FT_LOAD_NO_HINTING) | FT_LOAD_TARGET_NORMAL | FT_LOAD_NO_BITMAP));
                 }
             }
@@ -389,7 +650,7 @@ namespace neogfx
                 service<debug::logger>() << neolib::logger::severity::Debug << "neogfx: warning: Cannot load font glyph" << std::endl;
                 throw freetype_load_glyph_error(fe.what());
             }
-            if (!tRenderOutlineGlyph)
+            if (!aOutline)
             {
                 try
                 {
@@ -413,7 +674,6 @@ namespace neogfx
             {
                 try
                 {
-                    FT_Glyph glyphDescStroke;
                     freetypeCheck(FT_Get_Glyph(iHandle.freetypeFace->glyph, &glyphDescStroke));
                     FT_Stroker stroker;
                     freetypeCheck(FT_Stroker_New(iFontLib, &stroker));
@@ -442,19 +702,9 @@ namespace neogfx
         }
         catch (...)
         {
-            thread_local bool inHere = false;
-            if (!inHere)
-            {
-                neolib::scoped_flag sf{ inHere };
-                glyph_char invalid = aGlyphChar;
-                auto const replacementGlyph = FT_Get_Char_Index(iHandle.freetypeFace, 0xFFFD);
-                if (replacementGlyph != 0)
-                {
-                    invalid.value = replacementGlyph;
-                    return glyph(invalid);
-                }
-            }
-            return invalid_glyph();
+            if (glyphDescStroke != nullptr)
+                FT_Done_Glyph(glyphDescStroke);
+            return {};
         }
 
         if ((style() & (font_style::EmulatedBold)) == font_style::EmulatedBold)
@@ -467,87 +717,140 @@ namespace neogfx
 
         auto subTextureWidth = bitmap->width / (useSubpixelFiltering ? 3 : 1);
 
-        auto& subTexture = service<i_font_manager>().glyph_atlas().create_sub_texture(
-            neogfx::size{ static_cast<dimension>(subTextureWidth), static_cast<dimension>(bitmap->rows) }.ceil(),
-            1.0, texture_sampling::Normal, pixelMode == glyph_pixel_mode::LCD ? texture_data_format::SubPixel : texture_data_format::Red);
-
-        rect glyphRect{ subTexture.atlas_location() };
-        i_glyph& theGlyph = (!tRenderOutlineGlyph ?
-            iGlyphs.insert(std::make_pair(aGlyphChar.value,
-                neogfx::glyph{
-                    subTexture,
-                    useSubpixelFiltering,
-                    glyph_metrics{
-                        vec2{ iHandle.freetypeFace->glyph->metrics.width / 64.0, iHandle.freetypeFace->glyph->metrics.height / 64.0 }.round(),
-                        vec2{ iHandle.freetypeFace->glyph->metrics.horiBearingX / 64.0, iHandle.freetypeFace->glyph->metrics.horiBearingY / 64.0 }.round() },
-                    pixelMode })).first->second :
-            existingGlyph->second);
-
-        if (tRenderOutlineGlyph)
-            theGlyph.set_outline_texture(subTexture);
-
-        thread_local std::vector<std::uint8_t> glyphTextureData;
-        thread_local std::vector<std::array<std::uint8_t, 4>> subpixelGlyphData;
-        glyphTextureData.clear();
-        subpixelGlyphData.clear();
-
-        const std::uint8_t* textureData = 0;
-        
+        if (aMetrics != nullptr)
+            *aMetrics = glyph_metrics{
+                vec2{ iHandle.freetypeFace->glyph->metrics.width / 64.0, iHandle.freetypeFace->glyph->metrics.height / 64.0 }.round(),
+                vec2{ iHandle.freetypeFace->glyph->metrics.horiBearingX / 64.0, iHandle.freetypeFace->glyph->metrics.horiBearingY / 64.0 }.round() };
+
+        glyph_bitmap result{ useSubpixelFiltering, pixelMode,
+            neogfx::size{ static_cast<dimension>(subTextureWidth), static_cast<dimension>(bitmap->rows) }.ceil() };
+        auto const textureWidth = static_cast<std::size_t>(result.extents.cx);
+        auto const textureHeight = static_cast<std::size_t>(result.extents.cy);
+
         if (subTextureWidth != 0)
         {
+            // Texture rows are bottom up so each bitmap row is converted into the texture row mirroring it.
             if (useSubpixelFiltering)
             {
-                subpixelGlyphData.resize(static_cast<std::size_t>(glyphRect.cx * glyphRect.cy));
-                // sub-pixel FIR filter.
-                static double coefficients[] = { 1.5 / 16.0, 3.5 / 16.0, 6.0 / 16.0, 3.5 / 16.0, 1.5 / 16.0 };
+                result.data.resize(textureWidth * textureHeight * 4u);
                 for (std::uint32_t y = 0; y < bitmap->rows; y++)
-                {
-                    for (std::uint32_t x = 0; x < bitmap->width; x++)
-                    {
-                        std::uint8_t alpha = 0;
-                        for (std::int32_t z = -2; z <= 2; ++z)
-                        {
-                            std::int32_t const s = x + z;
-                            if (s >= 0 && s <= static_cast<std::int32_t>(bitmap->width) - 1)
-                                alpha += static_cast<std::uint8_t>(bitmap->buffer[s + bitmap->pitch * y] * coefficients[z + 2]);
-                        }
-                        subpixelGlyphData[(x / 3) + (bitmap->rows - 1 - y) * static_cast<std::size_t>(glyphRect.cx)][x % 3] = alpha;
-                    }
-                }
-                textureData = &subpixelGlyphData[0][0];
+                    lcd_filter_row(bitmap->buffer + bitmap->pitch * y, static_cast<std::uint32_t>(textureWidth * 3u),
+                        result.data.data() + (bitmap->rows - 1 - y) * textureWidth * 4u);
             }
             else
             {
-                glyphTextureData.resize(static_cast<std::size_t>(glyphRect.cx * glyphRect.cy));
+                result.data.resize(textureWidth * textureHeight);
                 for (std::uint32_t y = 0; y < bitmap->rows; y++)
+                {
+                    auto const source = bitmap->buffer + bitmap->pitch * y;
+                    auto const destination = result.data.data() + (bitmap->rows - 1 - y) * textureWidth;
                     switch (bitmap->pixel_mode)
                     {
                     case FT_PIXEL_MODE_MONO: // 1 bit per pixel monochrome
-                        for (std::uint32_t x = 0; x < bitmap->width; x += 8)
-                            for (std::uint32_t b = 0; b < std::min(bitmap->width - x, 8u); ++b)
-                                glyphTextureData[(x + b) + (bitmap->rows - 1 - y) * static_cast<std::size_t>(glyphRect.cx)] =
-                                    (x >= bitmap->width || y >= bitmap->rows) ? 0x00 : ((bitmap->buffer[x / 8 + bitmap->pitch * y] & (1 << (7 - b))) != 0 ? 0xFF : 0x00);
+                        expand_mono_row(source, bitmap->width, destination);
+                        break;
+                    case FT_PIXEL_MODE_GRAY2:
+                        expand_gray2_row(source, bitmap->width, destination);
+                        break;
+                    case FT_PIXEL_MODE_GRAY4:
+                        expand_gray4_row(source, bitmap->width, destination);
                         break;
                     case FT_PIXEL_MODE_GRAY:
                     default:
-                        for (std::uint32_t x = 0; x < bitmap->width; x++)
-                            glyphTextureData[x + (bitmap->rows - 1 - y) * static_cast<std::size_t>(glyphRect.cx)] =
-                                (x >= bitmap->width || y >= bitmap->rows) ? 0x00 : bitmap->buffer[x + bitmap->pitch * y];
+                        std::memcpy(destination, source, bitmap->width);
                         break;
                     }
-                textureData = &glyphTextureData[0];
+                }
             }
-            static_cast<i_native_texture&>((!tRenderOutlineGlyph ? 
-                theGlyph.texture() : theGlyph.outline_texture()).native_texture()).set_pixels(glyphRect, &textureData[0], 0u, 1u);
         }
 
-        if (outline().radius != 0.0 && !tRenderOutlineGlyph)
+        if (glyphDescStroke != nullptr)
+            FT_Done_Glyph(glyphDescStroke);
+
+        return result;
+    }
+
+    std::optional<native_font_face::glyph_bitmap> native_font_face::render_distance_field(glyph_index_t aGlyphIndex, glyph_metrics& aMetrics) const
+    {
+#ifdef NEOGFX_FREETYPE_SDF
+        auto const slot = iHandle.freetypeFace->glyph;
+        try
         {
-            neolib::scoped_flag sf{ tRenderOutlineGlyph };
-            (void) glyph(aGlyphChar);
+            freetypeCheck(FT_Load_Glyph(iHandle.freetypeFace, aGlyphIndex, FT_LOAD_NO_HINTING | FT_LOAD_TARGET_NORMAL | FT_LOAD_NO_BITMAP));
+            if (slot->format == FT_GLYPH_FORMAT_OUTLINE && slot->outline.n_points == 0)
+            {
+                aMetrics = glyph_metrics{};
+                return glyph_bitmap{ false, glyph_pixel_mode::Gray };
+            }
+            if ((style() & (font_style::EmulatedBold)) == font_style::EmulatedBold && slot->format == FT_GLYPH_FORMAT_OUTLINE)
+                FT_Outline_Embolden(&slot->outline, static_cast<FT_Pos>(xn_dpi_scale_factor(iPixelDensityDpi.cx) * 64));
+            freetypeCheck(FT_Render_Glyph(slot, FT_RENDER_MODE_SDF));
+        }
+        catch (freetype_error)
+        {
+            service<debug::logger>() << neolib::logger::severity::Debug << "neogfx: warning: Cannot render font distance field glyph" << std::endl;
+            return {};
         }
 
-        return theGlyph;
+        auto const& bitmap = slot->bitmap;
+        // The distance field extends DISTANCE_FIELD_SPREAD pixels beyond the outline so the glyph's metrics are those
+        // of the bitmap rather than of the outline.
+        aMetrics = glyph_metrics{
+            vec2{ static_cast<scalar>(bitmap.width), static_cast<scalar>(bitmap.rows) },
+            vec2{ static_cast<scalar>(slot->bitmap_left), static_cast<scalar>(slot->bitmap_top) } };
+        glyph_bitmap result{ false, glyph_pixel_mode::Gray, neogfx::size{ static_cast<dimension>(bitmap.width), static_cast<dimension>(bitmap.rows) } };
+        result.data.resize(static_cast<std::size_t>(bitmap.width) * bitmap.rows);
+        for (std::uint32_t y = 0; y < bitmap.rows; y++)
+            std::copy(bitmap.buffer + bitmap.pitch * static_cast<std::int32_t>(y), bitmap.buffer + bitmap.pitch * static_cast<std::int32_t>(y) + bitmap.width,
+                result.data.begin() + (bitmap.rows - 1 - y) * bitmap.width);
+        return result;
+#else
+        return {};
+#endif
+    }
+
+    i_glyph& native_font_face::scaled_distance_field_glyph(const glyph_char& aGlyphChar) const
+    {
+        auto const& reference = static_cast<native_font_face const&>(*iDistanceFieldReference);
+        auto const& referenceGlyph = reference.glyph(aGlyphChar);
+        if (!referenceGlyph.distance_field())
+            return invalid_glyph();
+        scalar const scale = static_cast<scalar>(iMetrics->y_scale) / reference.iMetrics->y_scale;
+        i_glyph& newGlyph = iGlyphs.insert(std::make_pair(aGlyphChar.value,
+            neogfx::glyph{
+                referenceGlyph.texture(),
+                glyph_metrics{ referenceGlyph.metrics().extents * scale, referenceGlyph.metrics().bearing * scale },
+                scale })).first->second;
+        // The outline is drawn from the same distance field at a lower threshold.
+        if (outline().radius != 0.0)
+            newGlyph.set_outline_texture(referenceGlyph.texture());
+        return newGlyph;
+    }
+
+    i_glyph& native_font_face::add_glyph(glyph_index_t aGlyphIndex, rasterized_glyph const& aGlyph) const
+    {
+        if (distance_field())
+            return iGlyphs.insert(std::make_pair(aGlyphIndex,
+                neogfx::glyph{ add_glyph_texture(aGlyph.bitmap), aGlyph.metrics, 1.0 })).first->second;
+        i_glyph& newGlyph = iGlyphs.insert(std::make_pair(aGlyphIndex,
+            neogfx::glyph{
+                add_glyph_texture(aGlyph.bitmap),
+                aGlyph.bitmap.subpixel,
+                aGlyph.metrics,
+                aGlyph.bitmap.pixelMode })).first->second;
+        if (aGlyph.outline)
+            newGlyph.set_outline_texture(add_glyph_texture(*aGlyph.outline));
+        return newGlyph;
+    }
+
+    i_sub_texture& native_font_face::add_glyph_texture(glyph_bitmap const& aBitmap) const
+    {
+        auto& atlas = distance_field() ? service<i_font_manager>().distance_field_atlas() : service<i_font_manager>().glyph_atlas();
+        auto& subTexture = atlas.create_sub_texture(aBitmap.extents,
+            1.0, texture_sampling::Normal, aBitmap.pixelMode == glyph_pixel_mode::LCD ? texture_data_format::SubPixel : texture_data_format::Red);
+        if (!aBitmap.data.empty())
+            static_cast<i_native_texture&>(subTexture.native_texture()).set_pixels(rect{ subTexture.atlas_location() }, aBitmap.data.data(), 0u, 1u);
+        return subTexture;
     }
 
     i_glyph& native_font_face::invalid_glyph() const
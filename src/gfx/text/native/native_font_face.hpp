@@ -21,11 +21,18 @@
 
 #include <neogfx/neogfx.hpp>
 
+#include <array>
+#include <bitset>
 #include <unordered_map>
+#include <unordered_set>
+#include <mutex>
 #include <boost/functional/hash.hpp>
 #include <boost/pool/pool_alloc.hpp>
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#if FREETYPE_MAJOR > 2 || (FREETYPE_MAJOR == 2 && FREETYPE_MINOR >= 11)
+#define NEOGFX_FREETYPE_SDF
+#endif
 #ifdef u8
 #undef u8
 #include <harfbuzz\hb.h>
@@ -70,6 +77,7 @@ namespace neogfx
 namespace neogfx
 {
     class i_rendering_engine;
+    class glyph_rasterizer;
 
     hb_position_t hb_kerning_func(hb_font_t* font, void* font_data, hb_codepoint_t first_glyph, hb_codepoint_t second_glyph, void* user_data);
 
@@ -111,11 +119,52 @@ namespace neogfx
         typedef std::pair<glyph_index_t, glyph_index_t> kerning_pair;
         typedef std::unordered_map<kerning_pair, dimension, boost::hash<kerning_pair>, std::equal_to<kerning_pair>,
             boost::fast_pool_allocator<std::pair<const kerning_pair, dimension>>> kerning_table;
+    public:
+        // Printable ASCII glyphs of this face that HarfBuzz shapes as no more than their nominal glyph, horizontal
+        // advance and (fallback) kerning; runs made up of these glyphs are positioned from this table without being
+        // shaped. A glyph of 0 means the code point must be shaped.
+        struct simple_glyph_table
+        {
+            static constexpr char32_t FIRST = U'\x20';
+            static constexpr char32_t LAST = U'\x7E';
+            struct entry
+            {
+                hb_codepoint_t glyph = 0u;
+                hb_position_t advance = 0;
+            };
+            std::array<entry, LAST - FIRST + 1u> entries;
+            bool fallbackKerning = false;
+        };
+        // Texture data of a rendered glyph, or glyph outline, not yet added to the glyph atlas.
+        struct glyph_bitmap
+        {
+            bool subpixel;
+            glyph_pixel_mode pixelMode;
+            neogfx::size extents;
+            std::vector<std::uint8_t> data;
+        };
+        struct rasterized_glyph
+        {
+            glyph_bitmap bitmap;
+            glyph_metrics metrics;
+            std::optional<glyph_bitmap> outline;
+        };
+    public:
+        // Character map coverage is recorded a page of code points at a time.
+        static constexpr char32_t COVERAGE_PAGE_SIZE = 256u;
+        typedef std::bitset<COVERAGE_PAGE_SIZE> coverage_page;
+        // Fallback chains are searched no deeper than this for a face with a glyph for a code point.
+        static constexpr std::uint32_t MAX_FALLBACK_DEPTH = 16u;
+    public:
+        // Printable ASCII is rasterized in the background as soon as a face is created.
+        static constexpr char32_t SPECULATIVE_FIRST = U'\x20';
+        static constexpr char32_t SPECULATIVE_LAST = U'\x7E';
     public:
         struct freetype_load_glyph_error : freetype_error { freetype_load_glyph_error(std::string const& aError) : freetype_error(aError) {} };
         struct freetype_render_glyph_error : freetype_error { freetype_render_glyph_error(std::string const& aError) : freetype_error(aError) {} };
     public:
-        native_font_face(FT_Library aFontLib, font_id aId, i_native_font& aFont, font_style aStyle, font::point_size aSize, stroke aOutline, bool aHinting, neogfx::size aDpiResolution, FT_Face aFreetypeFace, hb_face_t* aHarfbuzzFace);
+        native_font_face(FT_Library aFontLib, font_id aId, i_native_font& aFont, font_style aStyle, font::point_size aSize, stroke aOutline, bool aHinting, neogfx::size aDpiResolution, FT_Face aFreetypeFace, hb_face_t* aHarfbuzzFace,
+            ref_ptr<i_native_font_face> aDistanceFieldReference = {});
         ~native_font_face();
     public:
         font_id id() const final;
@@ -148,7 +197,35 @@ namespace neogfx
         void* handle() const final;
         glyph_index_t glyph_index(char32_t aCodePoint) const final;
         i_glyph& glyph(const glyph_char& aGlyphChar) const final;
+    public:
+        simple_glyph_table const& simple_glyphs() const;
+        // Whether the face's character map has a glyph for aCodePoint; may be called from any thread.
+        bool has_glyph(char32_t aCodePoint) const;
+        // Position in this face's fallback chain (0 being this face) of the first face with a glyph for aCodePoint,
+        // if any; results are cached. May be called from any thread.
+        std::optional<std::uint32_t> covering_face(char32_t aCodePoint) const;
+    public:
+        // Queues those of aGlyphs not already requested for rasterization by the glyph rasterizer's workers; may be
+        // called from any thread.
+        void prerasterize(std::vector<glyph_index_t> aGlyphs) const;
+        // Renders a glyph (without adding it to the glyph atlas); may be called from any thread.
+        std::optional<rasterized_glyph> rasterize(glyph_index_t aGlyphIndex) const;
+        void add_rasterized(glyph_index_t aGlyphIndex, rasterized_glyph&& aGlyph) const;
+        // Adds the glyphs rasterized by the workers to the glyph atlas; main thread only.
+        void upload_rasterized() const;
+        // Whether this face's glyphs are distance fields; if so they are rasterized by the rasterizing face (the
+        // reference face, if any) at its size and scaled to this face's size when drawn.
+        bool distance_field() const;
+        native_font_face const& rasterizing_face() const;
     private:
+        // Identifies this face's glyphs in the persistent glyph cache: font file contents, face index, style, size,
+        // outline, hinting and resolution.
+        std::uint64_t persistent_key() const;
+        std::optional<glyph_bitmap> render(glyph_index_t aGlyphIndex, bool aOutline, glyph_metrics* aMetrics) const;
+        std::optional<glyph_bitmap> render_distance_field(glyph_index_t aGlyphIndex, glyph_metrics& aMetrics) const;
+        i_glyph& scaled_distance_field_glyph(const glyph_char& aGlyphChar) const;
+        i_glyph& add_glyph(glyph_index_t aGlyphIndex, rasterized_glyph const& aGlyph) const;
+        i_sub_texture& add_glyph_texture(glyph_bitmap const& aBitmap) const;
         i_glyph& invalid_glyph() const;
         void set_metrics();
     private:
@@ -162,14 +239,31 @@ namespace neogfx
         bool iHinting;
         neogfx::size iPixelDensityDpi;
         mutable font_face_handle iHandle;
+        // FreeType faces can only be used by one thread at a time.
+        mutable std::mutex iFaceMutex;
         std::optional<FT_Size_Metrics> iMetrics;
         mutable ref_ptr<i_native_font_face> iFallbackFont;
+        // The face whose (reference size) distance field glyphs this face's glyphs scale; null if this face is the
+        // reference face or doesn't render distance fields.
+        ref_ptr<i_native_font_face> iDistanceFieldReference;
         mutable glyph_map iGlyphs;
         bool iHasKerning = false;
         neogfx::kerning_method iKerningMethod = neogfx::kerning_method::Harfbuzz;
+        mutable std::mutex iKerningMutex;
         mutable kerning_table iKerningTable;
         mutable std::optional<bool> iHasFallback;
         mutable std::optional<neogfx::glyph> iInvalidGlyph;
+        mutable std::once_flag iSimpleGlyphsBuilt;
+        mutable simple_glyph_table iSimpleGlyphs;
+        mutable std::mutex iCoverageMutex;
+        mutable std::unordered_map<char32_t, coverage_page> iCoverage;
+        mutable std::unordered_map<char32_t, std::optional<std::uint32_t>> iCoveringFaces;
+        mutable std::mutex iRasterizedMutex;
+        mutable std::unordered_set<glyph_index_t> iRequestedGlyphs;
+        mutable std::unordered_map<glyph_index_t, rasterized_glyph> iRasterizedGlyphs;
+        mutable std::once_flag iPersistentKeyComputed;
+        mutable std::uint64_t iPersistentKey = 0u;
+        std::weak_ptr<glyph_rasterizer> iRasterizer;
     };
 
     bool kerning_enabled();
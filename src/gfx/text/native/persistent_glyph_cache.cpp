@@ -0,0 +1,302 @@
+// persistent_glyph_cache.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "persistent_glyph_cache.hpp"
+
+namespace neogfx
+{
+    namespace
+    {
+        constexpr char MAGIC[8] = { 'N', 'G', 'F', 'X', 'G', 'L', 'Y', 'C' };
+
+        std::filesystem::path to_path(std::string const& aPath)
+        {
+            return std::filesystem::path{ std::u8string{ aPath.begin(), aPath.end() } };
+        }
+
+        std::uint64_t bitmap_size(std::uint32_t aWidth, std::uint32_t aHeight, bool aSubpixel)
+        {
+            return static_cast<std::uint64_t>(aWidth) * aHeight * (aSubpixel ? 4u : 1u);
+        }
+
+        bool valid_pixel_mode(std::uint8_t aPixelMode)
+        {
+            return aPixelMode <= static_cast<std::uint8_t>(glyph_pixel_mode::BGRA);
+        }
+    }
+
+    persistent_glyph_cache::persistent_glyph_cache(std::string const& aPath) :
+        iPath{ aPath }
+    {
+        static_assert(sizeof(header) == 32u && sizeof(entry) == 96u, "persistent glyph cache file layout changed");
+        load();
+    }
+
+    persistent_glyph_cache::~persistent_glyph_cache()
+    {
+    }
+
+    std::string const& persistent_glyph_cache::path() const
+    {
+        return iPath;
+    }
+
+    bool persistent_glyph_cache::dirty() const
+    {
+        std::scoped_lock lock{ iMutex };
+        return !iAdded.empty();
+    }
+
+    std::optional<persistent_glyph_cache::rasterized_glyph> persistent_glyph_cache::find(face_key aFace, glyph_index_t aGlyph) const
+    {
+        std::scoped_lock lock{ iMutex };
+        auto const added = iAdded.find(std::make_pair(aFace, aGlyph));
+        if (added != iAdded.end())
+            return added->second;
+        auto const last = iEntries + iEntryCount;
+        auto const existing = std::lower_bound(iEntries, last, std::make_pair(aFace, aGlyph),
+            [](entry const& aEntry, std::pair<face_key, glyph_index_t> const& aKey) { return std::make_pair(aEntry.face, aEntry.glyph) < aKey; });
+        if (existing == last || existing->face != aFace || existing->glyph != aGlyph)
+            return {};
+        iUsed[static_cast<std::size_t>(existing - iEntries)] = true;
+        return to_rasterized_glyph(*existing);
+    }
+
+    void persistent_glyph_cache::add(face_key aFace, glyph_index_t aGlyph, rasterized_glyph const& aRasterizedGlyph)
+    {
+        // Bitmaps whose data isn't laid out as the cache file expects (none currently) are simply not cached.
+        auto const& bitmap = aRasterizedGlyph.bitmap;
+        if (bitmap.data.size() != bitmap_size(static_cast<std::uint32_t>(bitmap.extents.cx), static_cast<std::uint32_t>(bitmap.extents.cy), bitmap.subpixel))
+            return;
+        if (aRasterizedGlyph.outline)
+        {
+            auto const& outline = *aRasterizedGlyph.outline;
+            if (outline.data.size() != bitmap_size(static_cast<std::uint32_t>(outline.extents.cx), static_cast<std::uint32_t>(outline.extents.cy), outline.subpixel))
+                return;
+        }
+        std::scoped_lock lock{ iMutex };
+        iAdded.emplace(std::make_pair(aFace, aGlyph), aRasterizedGlyph);
+    }
+
+    void persistent_glyph_cache::save()
+    {
+        std::scoped_lock lock{ iMutex };
+        if (iAdded.empty())
+            return;
+
+        struct pending
+        {
+            entry record;
+            std::uint8_t const* bitmap;
+            std::uint8_t const* outline;
+        };
+        std::vector<pending> entries;
+        std::uint64_t fileSize = sizeof(header);
+        auto const keep = [&](pending const& aEntry)
+        {
+            auto const entrySize = sizeof(entry) + aEntry.record.bitmap.size + aEntry.record.outline.size;
+            if (fileSize + entrySize > MAX_FILE_SIZE)
+                return;
+            fileSize += entrySize;
+            entries.push_back(aEntry);
+        };
+        // Glyphs rasterized during this run first, then mapped glyphs used during this run and then the rest.
+        for (auto const& added : iAdded)
+        {
+            auto const& glyph = added.second;
+            pending next{};
+            next.record.face = added.first.first;
+            next.record.glyph = added.first.second;
+            next.record.pixelMode = static_cast<std::uint8_t>(glyph.bitmap.pixelMode);
+            next.record.flags = glyph.bitmap.subpixel ? ENTRY_SUBPIXEL : 0u;
+            next.record.metrics[0] = glyph.metrics.extents.x;
+            next.record.metrics[1] = glyph.metrics.extents.y;
+            next.record.metrics[2] = glyph.metrics.bearing.x;
+            next.record.metrics[3] = glyph.metrics.bearing.y;
+            next.record.bitmap = bitmap_record{ static_cast<std::uint32_t>(glyph.bitmap.extents.cx), static_cast<std::uint32_t>(glyph.bitmap.extents.cy), 0u, glyph.bitmap.data.size() };
+            next.bitmap = glyph.bitmap.data.data();
+            if (glyph.outline)
+            {
+                next.record.outlinePixelMode = static_cast<std::uint8_t>(glyph.outline->pixelMode);
+                next.record.flags |= ENTRY_HAS_OUTLINE | (glyph.outline->subpixel ? ENTRY_OUTLINE_SUBPIXEL : 0u);
+                next.record.outline = bitmap_record{ static_cast<std::uint32_t>(glyph.outline->extents.cx), static_cast<std::uint32_t>(glyph.outline->extents.cy), 0u, glyph.outline->data.size() };
+                next.outline = glyph.outline->data.data();
+            }
+            keep(next);
+        }
+        auto const base = reinterpret_cast<std::uint8_t const*>(iFile ? iFile->data() : nullptr);
+        for (bool used : { true, false })
+            for (std::size_t index = 0u; index < iEntryCount; ++index)
+                if (iUsed[index] == used && iAdded.find(std::make_pair(iEntries[index].face, iEntries[index].glyph)) == iAdded.end())
+                    keep(pending{ iEntries[index], base + iEntries[index].bitmap.offset, base + iEntries[index].outline.offset });
+        std::sort(entries.begin(), entries.end(), [](pending const& aLeft, pending const& aRight)
+            { return std::make_pair(aLeft.record.face, aLeft.record.glyph) < std::make_pair(aRight.record.face, aRight.record.glyph); });
+
+        header fileHeader{};
+        std::memcpy(fileHeader.magic, MAGIC, sizeof(MAGIC));
+        fileHeader.version = VERSION;
+        fileHeader.byteOrderMark = BYTE_ORDER_MARK;
+        fileHeader.entryCount = entries.size();
+        fileHeader.fileSize = fileSize;
+        std::uint64_t offset = sizeof(header) + entries.size() * sizeof(entry);
+        for (auto& e : entries)
+        {
+            e.record.bitmap.offset = offset;
+            offset += e.record.bitmap.size;
+            e.record.outline.offset = offset;
+            offset += e.record.outline.size;
+        }
+
+        auto const path = to_path(iPath);
+        auto const temporaryPath = to_path(iPath + ".tmp");
+        {
+            std::ofstream file{ temporaryPath, std::ios::out | std::ios::binary | std::ios::trunc };
+            file.write(reinterpret_cast<char const*>(&fileHeader), sizeof(fileHeader));
+            for (auto const& e : entries)
+                file.write(reinterpret_cast<char const*>(&e.record), sizeof(e.record));
+            for (auto const& e : entries)
+            {
+                file.write(reinterpret_cast<char const*>(e.bitmap), static_cast<std::streamsize>(e.record.bitmap.size));
+                file.write(reinterpret_cast<char const*>(e.outline), static_cast<std::streamsize>(e.record.outline.size));
+            }
+            if (!file.good())
+            {
+                file.close();
+                std::error_code ignored;
+                std::filesystem::remove(temporaryPath, ignored);
+                return;
+            }
+        }
+        // The old file can't be replaced while it is mapped.
+        iFile.reset();
+        iEntries = nullptr;
+        iEntryCount = 0u;
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, path, error);
+        if (error)
+            std::filesystem::remove(temporaryPath, error);
+        else
+            iAdded.clear();
+        load();
+    }
+
+    std::uint64_t persistent_glyph_cache::hash(void const* aData, std::size_t aSize, std::uint64_t aSeed)
+    {
+        // Fast non-cryptographic hash, a word at a time, with a final avalanche; identifies font files and faces.
+        std::uint64_t result = aSeed ^ (0xCBF29CE484222325ull + aSize);
+        auto const bytes = static_cast<std::uint8_t const*>(aData);
+        std::size_t index = 0u;
+        for (; index + sizeof(std::uint64_t) <= aSize; index += sizeof(std::uint64_t))
+        {
+            std::uint64_t word;
+            std::memcpy(&word, bytes + index, sizeof(word));
+            result = (result ^ (word * 0x9E3779B97F4A7C15ull)) * 0x100000001B3ull;
+            result ^= result >> 31u;
+        }
+        for (; index < aSize; ++index)
+            result = (result ^ bytes[index]) * 0x100000001B3ull;
+        result ^= result >> 33u;
+        result *= 0xFF51AFD7ED558CCDull;
+        result ^= result >> 33u;
+        return result;
+    }
+
+    void persistent_glyph_cache::load()
+    {
+        iFile.reset();
+        iEntries = nullptr;
+        iEntryCount = 0u;
+        std::error_code error;
+        if (!std::filesystem::exists(to_path(iPath), error))
+            return;
+        try
+        {
+            iFile = std::make_unique<mapped_file>(iPath);
+        }
+        catch (...)
+        {
+            return;
+        }
+        if (iFile->size() >= sizeof(header))
+        {
+            auto const& fileHeader = *reinterpret_cast<header const*>(iFile->data());
+            iEntries = reinterpret_cast<entry const*>(iFile->data() + sizeof(header));
+            iEntryCount = static_cast<std::size_t>(std::min<std::uint64_t>(fileHeader.entryCount, (iFile->size() - sizeof(header)) / sizeof(entry)));
+        }
+        if (!valid())
+        {
+            iFile.reset();
+            iEntries = nullptr;
+            iEntryCount = 0u;
+        }
+        iUsed.assign(iEntryCount, false);
+    }
+
+    bool persistent_glyph_cache::valid() const
+    {
+        if (!iFile || iFile->size() < sizeof(header))
+            return false;
+        auto const& fileHeader = *reinterpret_cast<header const*>(iFile->data());
+        if (std::memcmp(fileHeader.magic, MAGIC, sizeof(MAGIC)) != 0 || fileHeader.version != VERSION ||
+            fileHeader.byteOrderMark != BYTE_ORDER_MARK || fileHeader.fileSize != iFile->size() || fileHeader.entryCount != iEntryCount)
+            return false;
+        auto const dataStart = sizeof(header) + iEntryCount * sizeof(entry);
+        auto const contained = [&](bitmap_record const& aRecord, bool aSubpixel)
+        {
+            return aRecord.size == bitmap_size(aRecord.width, aRecord.height, aSubpixel) &&
+                aRecord.offset >= dataStart && aRecord.offset <= fileHeader.fileSize && aRecord.size <= fileHeader.fileSize - aRecord.offset;
+        };
+        for (std::size_t index = 0u; index < iEntryCount; ++index)
+        {
+            auto const& e = iEntries[index];
+            if (index > 0u && !(std::make_pair(iEntries[index - 1u].face, iEntries[index - 1u].glyph) < std::make_pair(e.face, e.glyph)))
+                return false;
+            if (!valid_pixel_mode(e.pixelMode) || !contained(e.bitmap, (e.flags & ENTRY_SUBPIXEL) != 0u))
+                return false;
+            if ((e.flags & ENTRY_HAS_OUTLINE) != 0u && (!valid_pixel_mode(e.outlinePixelMode) || !contained(e.outline, (e.flags & ENTRY_OUTLINE_SUBPIXEL) != 0u)))
+                return false;
+            if ((e.flags & ENTRY_HAS_OUTLINE) == 0u && e.outline.size != 0u)
+                return false;
+        }
+        return true;
+    }
+
+    persistent_glyph_cache::rasterized_glyph persistent_glyph_cache::to_rasterized_glyph(entry const& aEntry) const
+    {
+        auto const base = reinterpret_cast<std::uint8_t const*>(iFile->data());
+        auto const to_bitmap = [&](bitmap_record const& aRecord, std::uint8_t aPixelMode, bool aSubpixel)
+        {
+            return glyph_bitmap{ aSubpixel, static_cast<glyph_pixel_mode>(aPixelMode),
+                neogfx::size{ static_cast<dimension>(aRecord.width), static_cast<dimension>(aRecord.height) },
+                std::vector<std::uint8_t>{ base + aRecord.offset, base + aRecord.offset + aRecord.size } };
+        };
+        rasterized_glyph result;
+        result.bitmap = to_bitmap(aEntry.bitmap, aEntry.pixelMode, (aEntry.flags & ENTRY_SUBPIXEL) != 0u);
+        result.metrics = glyph_metrics{ vec2{ aEntry.metrics[0], aEntry.metrics[1] }, vec2{ aEntry.metrics[2], aEntry.metrics[3] } };
+        if ((aEntry.flags & ENTRY_HAS_OUTLINE) != 0u)
+            result.outline = to_bitmap(aEntry.outline, aEntry.outlinePixelMode, (aEntry.flags & ENTRY_OUTLINE_SUBPIXEL) != 0u);
+        return result;
+    }
+}
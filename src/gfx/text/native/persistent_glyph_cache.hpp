@@ -0,0 +1,110 @@
+// persistent_glyph_cache.hpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+
+#include <map>
+#include <mutex>
+#include <optional>
+
+#include <neogfx/core/mapped_file.hpp>
+#include "native_font_face.hpp"
+
+namespace neogfx
+{
+    // On-disk cache of rasterized glyphs (bitmaps and metrics) shared by application runs so that the glyphs of
+    // standard UI text needn't be rendered by FreeType again at startup. The file is memory mapped: a header, an
+    // array of fixed size entries sorted by (face key, glyph index) for binary search and the bitmap data. A file
+    // that fails validation is ignored (and replaced on the next save). Glyphs rasterized during a run are held in
+    // memory until save() writes them, together with those mapped, to a new file that replaces the old one.
+    class persistent_glyph_cache
+    {
+    public:
+        typedef std::uint64_t face_key;
+        typedef std::uint32_t glyph_index_t;
+        typedef native_font_face::glyph_bitmap glyph_bitmap;
+        typedef native_font_face::rasterized_glyph rasterized_glyph;
+    public:
+        static constexpr std::uint32_t VERSION = 1u;
+        static constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304u;
+        // Glyphs not used during a run are the first to be dropped from a file that would exceed this size.
+        static constexpr std::uint64_t MAX_FILE_SIZE = 64u * 1024u * 1024u;
+    private:
+        struct header
+        {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t byteOrderMark;
+            std::uint64_t entryCount;
+            std::uint64_t fileSize;
+        };
+        struct bitmap_record
+        {
+            std::uint32_t width;
+            std::uint32_t height;
+            std::uint64_t offset;
+            std::uint64_t size;
+        };
+        struct entry
+        {
+            face_key face;
+            glyph_index_t glyph;
+            std::uint8_t pixelMode;
+            std::uint8_t outlinePixelMode;
+            std::uint16_t flags;
+            double metrics[4];
+            bitmap_record bitmap;
+            bitmap_record outline;
+        };
+        static constexpr std::uint16_t ENTRY_SUBPIXEL = 0x0001u;
+        static constexpr std::uint16_t ENTRY_HAS_OUTLINE = 0x0002u;
+        static constexpr std::uint16_t ENTRY_OUTLINE_SUBPIXEL = 0x0004u;
+    public:
+        persistent_glyph_cache(std::string const& aPath);
+        ~persistent_glyph_cache();
+    public:
+        std::string const& path() const;
+        bool dirty() const;
+        std::optional<rasterized_glyph> find(face_key aFace, glyph_index_t aGlyph) const;
+        void add(face_key aFace, glyph_index_t aGlyph, rasterized_glyph const& aRasterizedGlyph);
+        void save();
+    public:
+        static std::uint64_t hash(void const* aData, std::size_t aSize, std::uint64_t aSeed = 0u);
+        template <typename T>
+        static std::uint64_t hash_value(T const& aValue, std::uint64_t aSeed)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            return hash(&aValue, sizeof(T), aSeed);
+        }
+    private:
+        void load();
+        bool valid() const;
+        rasterized_glyph to_rasterized_glyph(entry const& aEntry) const;
+    private:
+        std::string iPath;
+        mutable std::mutex iMutex;
+        std::unique_ptr<mapped_file> iFile;
+        entry const* iEntries = nullptr;
+        std::size_t iEntryCount = 0u;
+        mutable std::vector<bool> iUsed;
+        std::map<std::pair<face_key, glyph_index_t>, rasterized_glyph> iAdded;
+    };
+}
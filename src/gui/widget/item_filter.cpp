@@ -0,0 +1,237 @@
+// item_filter.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+
+#include <neogfx/gui/widget/item_filter.hpp>
+
+namespace neogfx
+{
+    item_filter::item_filter(std::string_view const& aKey, filter_search_type aSearchType, case_sensitivity aCaseSensitivity) :
+        iSearchType{ aSearchType },
+        iCaseSensitivity{ aCaseSensitivity },
+        iCtype{ &std::use_facet<std::ctype<char>>(iLocale) },
+        iKey{ aKey }
+    {
+        if (iKey.empty())
+            return;
+        switch (iSearchType)
+        {
+        case filter_search_type::Prefix:
+            // Folded as boost::to_upper_copy does (a character at a time with the global locale).
+            if (iCaseSensitivity == case_sensitivity::CaseInsensitive)
+                iCtype->toupper(iKey.data(), iKey.data() + iKey.size());
+            break;
+        case filter_search_type::Glob:
+            compile_glob(iKey);
+            break;
+        case filter_search_type::Regex:
+            try
+            {
+                auto flags = std::regex::ECMAScript | std::regex::optimize;
+                if (iCaseSensitivity == case_sensitivity::CaseInsensitive)
+                    flags |= std::regex::icase;
+                iRegex.emplace(iKey, flags);
+            }
+            catch (std::regex_error const&)
+            {
+                // Not (yet) a regular expression, e.g. whilst one is being typed.
+                iKey.clear();
+            }
+            break;
+        }
+    }
+
+    bool item_filter::empty() const
+    {
+        return iKey.empty();
+    }
+
+    bool item_filter::matches(std::string_view const& aValue) const
+    {
+        if (empty())
+            return true;
+        switch (iSearchType)
+        {
+        case filter_search_type::Prefix:
+            if (aValue.size() < iKey.size())
+                return false;
+            if (iCaseSensitivity == case_sensitivity::CaseSensitive)
+                return aValue.compare(0u, iKey.size(), iKey) == 0;
+            for (std::size_t index = 0u; index < iKey.size(); ++index)
+                if (iCtype->toupper(aValue[index]) != iKey[index])
+                    return false;
+            return true;
+        case filter_search_type::Glob:
+            return matches_glob(aValue);
+        case filter_search_type::Regex:
+            return std::regex_search(aValue.begin(), aValue.end(), *iRegex);
+        default:
+            return true;
+        }
+    }
+
+    bool item_filter::narrows(item_filter const& aPrevious) const
+    {
+        if (aPrevious.empty())
+            return true;
+        if (empty() || iSearchType != aPrevious.iSearchType || iCaseSensitivity != aPrevious.iCaseSensitivity)
+            return false;
+        if (iKey == aPrevious.iKey)
+            return true;
+        switch (iSearchType)
+        {
+        case filter_search_type::Prefix:
+            return iKey.size() > aPrevious.iKey.size() && iKey.compare(0u, aPrevious.iKey.size(), aPrevious.iKey) == 0;
+        case filter_search_type::Glob:
+            // Extending a pattern ending with '*' only constrains what that '*' matched.
+            return aPrevious.iGlob.back().kind == glob_token::AnyRun && iGlob.size() >= aPrevious.iGlob.size() &&
+                std::equal(aPrevious.iGlob.begin(), aPrevious.iGlob.end(), iGlob.begin());
+        default:
+            return false;
+        }
+    }
+
+    void item_filter::compile_glob(std::string_view const& aKey)
+    {
+        for (auto next = aKey.begin(); next != aKey.end();)
+        {
+            glob_token token{ glob_token::Set };
+            auto const ch = *next++;
+            if (ch == '*')
+            {
+                // Consecutive '*' are one run.
+                if (iGlob.empty() || iGlob.back().kind != glob_token::AnyRun)
+                    iGlob.push_back(glob_token{ glob_token::AnyRun });
+                continue;
+            }
+            else if (ch == '?')
+                token.kind = glob_token::AnyCharacter;
+            else if (ch == '\\' && next != aKey.end())
+                token.set.set(static_cast<unsigned char>(*next++));
+            else if (ch != '[' || !compile_glob_set(next, aKey.end(), token.set))
+                token.set.set(static_cast<unsigned char>(ch));
+            if (token.kind == glob_token::Set)
+                fold_glob_set(token.set);
+            iGlob.push_back(token);
+        }
+    }
+
+    bool item_filter::compile_glob_set(std::string_view::const_iterator& aNext, std::string_view::const_iterator aEnd, std::bitset<256>& aSet) const
+    {
+        auto next = aNext;
+        auto const member = [&]()
+        {
+            auto const ch = *next++;
+            if (ch == '\\' && next != aEnd)
+                return static_cast<unsigned char>(*next++);
+            return static_cast<unsigned char>(ch);
+        };
+        bool const negate = (next != aEnd && (*next == '!' || *next == '^'));
+        if (negate)
+            ++next;
+        // A ']' first is a member rather than the end of the set.
+        for (bool first = true; next != aEnd; first = false)
+        {
+            if (*next == ']' && !first)
+            {
+                // Folded before negating so that a negated set excludes both cases.
+                if (negate)
+                {
+                    fold_glob_set(aSet);
+                    aSet.flip();
+                }
+                aNext = std::next(next);
+                return true;
+            }
+            auto const from = member();
+            if (next != aEnd && *next == '-' && std::next(next) != aEnd && *std::next(next) != ']')
+            {
+                ++next;
+                auto const to = member();
+                for (std::size_t byte = from; byte <= to; ++byte)
+                    aSet.set(byte);
+            }
+            else
+                aSet.set(from);
+        }
+        // Unterminated so the '[' is just a character.
+        aSet.reset();
+        return false;
+    }
+
+    void item_filter::fold_glob_set(std::bitset<256>& aSet) const
+    {
+        if (iCaseSensitivity == case_sensitivity::CaseSensitive)
+            return;
+        // Any byte which folds to the same as a member is a member.
+        std::bitset<256> folded;
+        for (std::size_t byte = 0u; byte < 256u; ++byte)
+            if (aSet.test(byte))
+                folded.set(static_cast<unsigned char>(iCtype->toupper(static_cast<char>(byte))));
+        for (std::size_t byte = 0u; byte < 256u; ++byte)
+            if (folded.test(static_cast<unsigned char>(iCtype->toupper(static_cast<char>(byte)))))
+                aSet.set(byte);
+    }
+
+    bool item_filter::matches_glob(std::string_view const& aValue) const
+    {
+        // Each '*' extends what it matches one character at a time only when what follows it fails to match.
+        std::size_t token = 0u;
+        std::size_t position = 0u;
+        std::optional<std::size_t> runToken;
+        std::size_t runPosition = 0u;
+        auto const character_end = [&](std::size_t aPosition)
+        {
+            // A UTF-8 sequence's continuation bytes are part of its character.
+            ++aPosition;
+            while (aPosition < aValue.size() && (static_cast<unsigned char>(aValue[aPosition]) & 0xC0u) == 0x80u)
+                ++aPosition;
+            return aPosition;
+        };
+        while (position < aValue.size())
+        {
+            if (token < iGlob.size() && iGlob[token].kind == glob_token::AnyRun)
+            {
+                runToken = token++;
+                runPosition = position;
+            }
+            else if (token < iGlob.size() && iGlob[token].kind == glob_token::AnyCharacter)
+            {
+                position = character_end(position);
+                ++token;
+            }
+            else if (token < iGlob.size() && iGlob[token].set.test(static_cast<unsigned char>(aValue[position])))
+            {
+                ++position;
+                ++token;
+            }
+            else if (runToken)
+            {
+                token = *runToken + 1u;
+                position = runPosition = character_end(runPosition);
+            }
+            else
+                return false;
+        }
+        while (token < iGlob.size() && iGlob[token].kind == glob_token::AnyRun)
+            ++token;
+        return token == iGlob.size();
+    }
+}
@@ -0,0 +1,151 @@
+// item_prefix_index.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+
+#include <neogfx/gui/widget/item_prefix_index.hpp>
+
+namespace neogfx
+{
+    item_prefix_index::item_prefix_index() :
+        iCtype{ &std::use_facet<std::ctype<char>>(iLocale) }
+    {
+    }
+
+    bool item_prefix_index::indexed(column_type aColumn) const
+    {
+        return aColumn < iColumns.size() && iColumns[aColumn] != std::nullopt;
+    }
+
+    void item_prefix_index::index(i_item_model const& aModel, column_type aColumn)
+    {
+        if (aColumn >= iColumns.size())
+            iColumns.resize(aColumn + 1u);
+        auto& column = iColumns[aColumn].emplace();
+        column.keys.reserve(aModel.rows());
+        for (row_type row = 0u; row < aModel.rows(); ++row)
+            column.keys.push_back(make_key(aModel, item_model_index{ row, aColumn }));
+        sort(column);
+    }
+
+    void item_prefix_index::clear()
+    {
+        iColumns.clear();
+    }
+
+    void item_prefix_index::row_inserted(i_item_model const& aModel, row_type aRow)
+    {
+        for (column_type columnIndex = 0u; columnIndex < iColumns.size(); ++columnIndex)
+        {
+            auto& column = iColumns[columnIndex];
+            if (!column)
+                continue;
+            if (aRow > column->keys.size())
+            {
+                column = std::nullopt;
+                continue;
+            }
+            column->keys.insert(std::next(column->keys.begin(), aRow), make_key(aModel, item_model_index{ aRow, columnIndex }));
+            column->stale = true;
+        }
+    }
+
+    void item_prefix_index::row_removed(row_type aRow)
+    {
+        for (auto& column : iColumns)
+        {
+            if (!column)
+                continue;
+            if (aRow >= column->keys.size())
+            {
+                column = std::nullopt;
+                continue;
+            }
+            column->keys.erase(std::next(column->keys.begin(), aRow));
+            column->stale = true;
+        }
+    }
+
+    void item_prefix_index::cell_changed(i_item_model const& aModel, item_model_index const& aIndex)
+    {
+        if (!indexed(aIndex.column()))
+            return;
+        auto& column = *iColumns[aIndex.column()];
+        if (aIndex.row() >= column.keys.size())
+        {
+            iColumns[aIndex.column()] = std::nullopt;
+            return;
+        }
+        auto& key = column.keys[aIndex.row()];
+        auto changedKey = make_key(aModel, aIndex);
+        if (changedKey == key)
+            return;
+        if (!column.stale)
+        {
+            // The old key finds the entry to move.
+            auto const existing = std::lower_bound(column.entries.begin(), column.entries.end(), entry{ key, aIndex.row() });
+            auto const pos = std::lower_bound(column.entries.begin(), column.entries.end(), entry{ changedKey, aIndex.row() });
+            if (existing == column.entries.end() || existing->row != aIndex.row())
+                column.stale = true;
+            else if (pos <= existing)
+            {
+                std::rotate(pos, existing, std::next(existing));
+                pos->key = changedKey;
+            }
+            else
+            {
+                std::rotate(existing, std::next(existing), pos);
+                std::prev(pos)->key = changedKey;
+            }
+        }
+        key = std::move(changedKey);
+    }
+
+    void item_prefix_index::find(column_type aColumn, std::string_view const& aPrefix, std::vector<row_type>& aRows)
+    {
+        if (!indexed(aColumn))
+            return;
+        auto& column = *iColumns[aColumn];
+        if (column.stale)
+            sort(column);
+        std::string prefix{ aPrefix };
+        iCtype->toupper(prefix.data(), prefix.data() + prefix.size());
+        auto const first = std::lower_bound(column.entries.begin(), column.entries.end(), prefix, [](entry const& aEntry, std::string const& aPrefix) { return aEntry.key < aPrefix; });
+        for (auto e = first; e != column.entries.end() && e->key.compare(0u, prefix.size(), prefix) == 0; ++e)
+            aRows.push_back(e->row);
+    }
+
+    std::string item_prefix_index::make_key(i_item_model const& aModel, item_model_index const& aIndex) const
+    {
+        // Folded as boost::to_upper_copy does (a character at a time with the global locale).
+        auto result = aModel.cell_data(aIndex).to_std_string();
+        iCtype->toupper(result.data(), result.data() + result.size());
+        return result;
+    }
+
+    void item_prefix_index::sort(column_index& aColumn)
+    {
+        aColumn.entries.clear();
+        aColumn.entries.reserve(aColumn.keys.size());
+        for (row_type row = 0u; row < aColumn.keys.size(); ++row)
+            aColumn.entries.push_back(entry{ aColumn.keys[row], row });
+        std::sort(aColumn.entries.begin(), aColumn.entries.end());
+        aColumn.stale = false;
+    }
+}
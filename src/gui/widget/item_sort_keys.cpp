@@ -0,0 +1,169 @@
+// item_sort_keys.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+
+#include <string_view>
+
+#include <neogfx/gui/widget/item_sort_keys.hpp>
+
+namespace neogfx
+{
+    void item_sort_keys::clear()
+    {
+        iColumns.clear();
+    }
+
+    void item_sort_keys::row_inserted(row_type aRow)
+    {
+        for (auto& column : iColumns)
+            if (column.extracted)
+            {
+                if (aRow <= column.keys.size())
+                    column.keys.insert(std::next(column.keys.begin(), aRow), key{ UNEXTRACTED, NOT_TEXT, 0u });
+                else
+                    column.extracted = false;
+            }
+    }
+
+    void item_sort_keys::row_removed(row_type aRow)
+    {
+        for (auto& column : iColumns)
+            if (column.extracted)
+            {
+                if (aRow < column.keys.size())
+                {
+                    auto const& removed = column.keys[aRow];
+                    if (removed.alternative != UNEXTRACTED)
+                        column.staleBytes += (removed.length != NOT_TEXT ? removed.length * 2u : sizeof(item_cell_data));
+                    column.keys.erase(std::next(column.keys.begin(), aRow));
+                }
+                else
+                    column.extracted = false;
+            }
+    }
+
+    void item_sort_keys::cell_changed(item_model_index const& aIndex)
+    {
+        if (aIndex.column() >= iColumns.size())
+            return;
+        auto& column = iColumns[aIndex.column()];
+        if (!column.extracted)
+            return;
+        if (aIndex.row() >= column.keys.size())
+        {
+            column.extracted = false;
+            return;
+        }
+        auto& changed = column.keys[aIndex.row()];
+        if (changed.alternative != UNEXTRACTED)
+            column.staleBytes += (changed.length != NOT_TEXT ? changed.length * 2u : sizeof(item_cell_data));
+        changed = key{ UNEXTRACTED, NOT_TEXT, 0u };
+    }
+
+    void item_sort_keys::prepare(i_item_model const& aModel, sort_columns const& aSortColumns)
+    {
+        // Strings are folded as boost::to_upper_copy does (a character at a time with the global locale).
+        std::locale const locale;
+        auto const& ctype = std::use_facet<std::ctype<char>>(locale);
+        for (auto const& sortColumn : aSortColumns)
+        {
+            if (sortColumn.first >= iColumns.size())
+                iColumns.resize(sortColumn.first + 1u);
+            auto& column = iColumns[sortColumn.first];
+            auto const rows = aModel.rows();
+            // Re-extract the whole column rather than append to it if most of what it holds is for cells since changed.
+            auto const held = column.text.size() + column.values.size() * sizeof(item_cell_data);
+            if (column.extracted && (column.keys.size() != rows || column.staleBytes > held / 2u))
+                column.extracted = false;
+            if (!column.extracted)
+            {
+                column.keys.assign(rows, key{ UNEXTRACTED, NOT_TEXT, 0u });
+                column.text.clear();
+                column.values.clear();
+                column.staleBytes = 0u;
+                column.extracted = true;
+            }
+            for (row_type row = 0u; row < rows; ++row)
+                if (column.keys[row].alternative == UNEXTRACTED)
+                    extract(aModel, sortColumn.first, row, ctype, column);
+        }
+    }
+
+    bool item_sort_keys::less(row_type aLhs, row_type aRhs, sort_columns const& aSortColumns) const
+    {
+        for (auto const& sortColumn : aSortColumns)
+        {
+            auto const result = compare(iColumns[sortColumn.first], aLhs, aRhs);
+            if (result < 0)
+                return sortColumn.second == sort_direction::Ascending;
+            else if (result > 0)
+                return sortColumn.second == sort_direction::Descending;
+        }
+        return false;
+    }
+
+    void item_sort_keys::extract(i_item_model const& aModel, column_type aColumn, row_type aRow, std::ctype<char> const& aCtype, column_keys& aKeys)
+    {
+        auto const& value = aModel.cell_data(item_model_index{ aRow, aColumn });
+        auto& rowKey = aKeys.keys[aRow];
+        rowKey.alternative = static_cast<std::uint32_t>(value.index());
+        if (std::holds_alternative<string>(value))
+        {
+            auto const text = std::get<string>(value).to_std_string_view();
+            rowKey.length = static_cast<std::uint32_t>(text.size());
+            rowKey.offset = aKeys.text.size();
+            aKeys.text.append(text);
+            aKeys.text.append(text);
+            auto const folded = aKeys.text.data() + rowKey.offset;
+            aCtype.toupper(folded, folded + text.size());
+        }
+        else
+        {
+            rowKey.length = NOT_TEXT;
+            rowKey.offset = aKeys.values.size();
+            aKeys.values.push_back(value);
+        }
+    }
+
+    int item_sort_keys::compare(column_keys const& aKeys, row_type aLhs, row_type aRhs) const
+    {
+        auto const& lhs = aKeys.keys[aLhs];
+        auto const& rhs = aKeys.keys[aRhs];
+        if (lhs.length != NOT_TEXT && rhs.length != NOT_TEXT)
+        {
+            std::string_view const lhsText{ aKeys.text.data() + lhs.offset, lhs.length };
+            std::string_view const rhsText{ aKeys.text.data() + rhs.offset, rhs.length };
+            auto const folded = lhsText.compare(rhsText);
+            if (folded != 0)
+                return folded;
+            return std::string_view{ lhsText.data() + lhs.length, lhs.length }.compare(
+                std::string_view{ rhsText.data() + rhs.length, rhs.length });
+        }
+        if (lhs.alternative != rhs.alternative)
+            return lhs.alternative < rhs.alternative ? -1 : 1;
+        auto const& lhsValue = aKeys.values[lhs.offset];
+        auto const& rhsValue = aKeys.values[rhs.offset];
+        if (lhsValue < rhsValue)
+            return -1;
+        else if (rhsValue < lhsValue)
+            return 1;
+        return 0;
+    }
+}
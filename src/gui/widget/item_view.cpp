@@ -628,6 +628,12 @@ namespace neogfx
 
     bool item_view::key_pressed(scan_code_e aScanCode, key_code_e aKeyCode, key_modifier aKeyModifier)
     {
+        if (aScanCode == ScanCode_A && (aKeyModifier & key_modifier::CTRL) != key_modifier::None && editing() == std::nullopt &&
+            selection_model().mode() == item_selection_mode::ExtendedSelection)
+        {
+            selection_model().select_all();
+            return true;
+        }
         bool handled = true;
         if (selection_model().has_current_index())
         {
@@ -858,6 +864,8 @@ namespace neogfx
 
     void item_view::item_added(item_presentation_model_index const& aItemIndex)
     {
+        if (iSelectionAnchor != std::nullopt && iSelectionAnchor->row() >= aItemIndex.row())
+            iSelectionAnchor->set_row(iSelectionAnchor->row() + 1u);
         invalidate_item(aItemIndex);
     }
 
@@ -868,6 +876,10 @@ namespace neogfx
 
     void item_view::item_removed(item_presentation_model_index const& aItemIndex)
     {
+        if (iSelectionAnchor != std::nullopt && iSelectionAnchor->row() == aItemIndex.row())
+            iSelectionAnchor = std::nullopt;
+        else if (iSelectionAnchor != std::nullopt && iSelectionAnchor->row() > aItemIndex.row())
+            iSelectionAnchor->set_row(iSelectionAnchor->row() - 1u);
         invalidate_item(aItemIndex);
     }
 
@@ -881,6 +893,7 @@ namespace neogfx
     {
         if (selection_model().has_current_index())
             iSavedModelIndex = presentation_model().to_item_model_index(selection_model().current_index());
+        save_selection_anchor();
         end_edit(true);
     }
 
@@ -889,16 +902,19 @@ namespace neogfx
         if (iSavedModelIndex != std::nullopt && presentation_model().has_item_model_index(*iSavedModelIndex))
             select(presentation_model().from_item_model_index(*iSavedModelIndex));
         iSavedModelIndex = std::nullopt;
+        restore_selection_anchor();
         update();
     }
 
     void item_view::items_filtering()
     {
+        save_selection_anchor();
         end_edit(true);
     }
 
     void item_view::items_filtered()
     {
+        restore_selection_anchor();
         if (presentation_model().rows() != 0)
             select(item_presentation_model_index{});
         items_updated();
@@ -1505,6 +1521,16 @@ namespace neogfx
 
     void item_view::select(item_presentation_model_index const& aItemIndex, key_modifier aKeyModifier)
     {
+        if (selection_model().mode() == item_selection_mode::ExtendedSelection && (aKeyModifier & key_modifier::SHIFT) != key_modifier::None &&
+            iSelectionAnchor != std::nullopt && iSelectionAnchor->row() < presentation_model().rows())
+        {
+            // Select the rows from the anchor (the item last clicked without shift) to the item.
+            selection_model().set_current_index(aItemIndex);
+            selection_model().select(*iSelectionAnchor, aItemIndex, (aKeyModifier & key_modifier::CTRL) != key_modifier::None ?
+                item_selection_operation::Select : item_selection_operation::ClearAndSelect);
+            return;
+        }
+        iSelectionAnchor = aItemIndex;
         auto const selectionOperation = to_selection_operation(aKeyModifier);
         select(aItemIndex, selectionOperation);
     }
@@ -1514,4 +1540,19 @@ namespace neogfx
         selection_model().set_current_index(aItemIndex);
         selection_model().select(aItemIndex, aSelectionOperation);
     }
+
+    void item_view::save_selection_anchor()
+    {
+        // Kept by item model index across a sort or filter (a sort at the end of a filter finds it already saved).
+        if (iSelectionAnchor != std::nullopt && iSelectionAnchor->row() < presentation_model().rows())
+            iSavedSelectionAnchor = presentation_model().to_item_model_index(*iSelectionAnchor);
+        iSelectionAnchor = std::nullopt;
+    }
+
+    void item_view::restore_selection_anchor()
+    {
+        if (iSavedSelectionAnchor != std::nullopt && presentation_model().has_item_model_index(*iSavedSelectionAnchor))
+            iSelectionAnchor = presentation_model().from_item_model_index(*iSavedSelectionAnchor);
+        iSavedSelectionAnchor = std::nullopt;
+    }
 }
\ No newline at end of file
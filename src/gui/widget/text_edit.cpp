@@ -19,6 +19,8 @@
 
 #include <neogfx/neogfx.hpp>
 
+#include <execution>
+#include <future>
 #include <boost/algorithm/string/find.hpp>
 
 #include <neolib/core/scoped.hpp>
@@ -521,28 +523,30 @@ namespace neogfx
 
     dimension text_edit::glyph_paragraph::height(document_glyphs::iterator aStart, document_glyphs::iterator aEnd) const
     {
+        auto const glyphsFirst = glyph_begin_index();
         if (heightMap.empty())
         {
             dimension previousHeight = 0.0;
-            auto iterGlyph = std::next(owner->glyphs().begin(), span.glyphsFirst);
-            for (auto i = span.glyphsFirst; i != span.glyphsLast; ++i)
+            auto const glyphCount = owner->iParagraphIndex[index].glyphs;
+            auto iterGlyph = std::next(owner->glyphs().begin(), glyphsFirst);
+            for (document_glyphs::difference_type i = 0; i != glyphCount; ++i)
             {
                 auto const& glyph = *(iterGlyph++);
                 dimension cy = owner->glyphs().extents(glyph).cy;
-                if (i == span.glyphsFirst || cy != previousHeight)
+                if (i == 0 || cy != previousHeight)
                 {
                     heightMap.emplace_back(i, cy);
                     previousHeight = cy;
                 }
             }
-            heightMap.emplace_back(span.glyphsLast, 0.0);
+            heightMap.emplace_back(glyphCount, 0.0);
         }
         dimension result = 0.0;
-        auto start = std::lower_bound(heightMap.begin(), heightMap.end(), height_map_entry{ aStart - owner->glyphs().begin() },
+        auto start = std::lower_bound(heightMap.begin(), heightMap.end(), height_map_entry{ aStart - owner->glyphs().begin() - glyphsFirst },
             [](auto const& lhs, auto const& rhs) { return lhs.glyphIndex < rhs.glyphIndex; });
-        if (start != heightMap.begin() && aStart < owner->glyphs().begin() + start->glyphIndex)
+        if (start != heightMap.begin() && aStart < owner->glyphs().begin() + glyphsFirst + start->glyphIndex)
             --start;
-        auto stop = std::lower_bound(heightMap.begin(), heightMap.end(), height_map_entry{ aEnd - owner->glyphs().begin() },
+        auto stop = std::lower_bound(heightMap.begin(), heightMap.end(), height_map_entry{ aEnd - owner->glyphs().begin() - glyphsFirst },
             [](auto const& lhs, auto const& rhs) { return lhs.glyphIndex < rhs.glyphIndex; });
         if (start == stop && stop != heightMap.end())
             ++stop;
@@ -1221,7 +1225,10 @@ namespace neogfx
         auto const& internalPadding = padding();
         auto const& columnPadding = column(0).padding; ///< todo: other columns?
         auto const& totalPadding = internalPadding + columnPadding;
-        return rect{ point{}, iTextExtents.value_or(size{}) + totalPadding.size() };
+        auto extents = iTextExtents.value_or(size{});
+        if (iMappedText)
+            extents.cy = static_cast<dimension>(iMappedText->estimated_lines()) * font().height();
+        return rect{ point{}, extents + totalPadding.size() };
     }
 
     rect text_edit::scroll_page() const
@@ -1289,6 +1296,13 @@ namespace neogfx
         refresh_lines();
     }
 
+    void text_edit::scrollbar_updated(i_scrollbar const& aScrollbar, i_scrollbar::update_reason_e aReason)
+    {
+        framed_scrollable_widget::scrollbar_updated(aScrollbar, aReason);
+        if (iMappedText && &aScrollbar == &vertical_scrollbar())
+            update_mapped_window();
+    }
+
     color text_edit::frame_color() const
     {
         if (has_frame_color())
@@ -1652,6 +1666,16 @@ namespace neogfx
         }
     }
 
+    bool text_edit::parallel_shaping() const
+    {
+        return ParallelShaping;
+    }
+
+    void text_edit::set_parallel_shaping(bool aParallelShaping)
+    {
+        ParallelShaping = aParallelShaping;
+    }
+
     std::uint32_t text_edit::grow_lines() const
     {
         return GrowLines;
@@ -1830,13 +1854,7 @@ namespace neogfx
 
     text_edit::position_info text_edit::glyph_position(position_type aGlyphPosition, bool aForCursor) const
     {
-        auto paragraph = std::lower_bound(iGlyphParagraphs.begin(), iGlyphParagraphs.end(), document_span{ 0, 0, aGlyphPosition, aGlyphPosition },
-            [](auto const& p, auto const& s) { return p.glyph_begin_index() < s.glyphsFirst; });
-        if (paragraph != iGlyphParagraphs.begin())
-        {
-            if (paragraph == iGlyphParagraphs.end() || aGlyphPosition < paragraph->glyph_begin_index())
-                paragraph = std::prev(paragraph);
-        }
+        auto paragraph = glyph_to_paragraph(aGlyphPosition);
         if (paragraph == iGlyphParagraphs.end())
             return { paragraph };
         std::optional<glyph_lines::const_iterator> match;
@@ -1950,17 +1968,12 @@ namespace neogfx
         auto const& columnRectSansPadding = column_rect(columnIndex);
         point adjustedPosition = (aAdjustForScrollPosition ? aPosition + point{ horizontal_scrollbar().position(), vertical_scrollbar().position() } : aPosition) - columnRectSansPadding.top_left();
         adjustedPosition = adjustedPosition.max(point{});
-        auto paragraph = std::lower_bound(iGlyphParagraphs.begin(), iGlyphParagraphs.end(), adjustedPosition.y,
-            [](glyph_paragraph const& p, coordinate y)
-            {
-                return p.ypos < y;
-            });
-        if (paragraph == iGlyphParagraphs.end())
-            paragraph = std::prev(paragraph);
-        if (paragraph != iGlyphParagraphs.begin() && adjustedPosition.y < paragraph->ypos)
-            paragraph = std::prev(paragraph);
-        if (paragraph == iGlyphParagraphs.begin() && adjustedPosition.y < paragraph->ypos)
+        if (adjustedPosition.y < iParagraphYOffset)
             return std::make_pair(0, false);
+        auto const paragraphIndex = std::min(
+            iParagraphIndex.find(adjustedPosition.y - iParagraphYOffset, [](paragraph_extents const& e) { return e.height; }),
+            iGlyphParagraphs.size() - 1u);
+        auto paragraph = std::next(iGlyphParagraphs.begin(), paragraphIndex);
         auto const& column = iGlyphColumns.at(columnIndex);
         auto const& lines = column.lines;
         auto line = std::lower_bound(lines.begin(), lines.end(), adjustedPosition.y,
@@ -2073,6 +2086,7 @@ namespace neogfx
         iText.clear();
         glyphs().clear();
         iGlyphParagraphs.clear();
+        iParagraphIndex.clear();
         iUtf8TextCache = std::nullopt;
         iStyles.clear();
         iStyleMap.clear();
@@ -2188,14 +2202,12 @@ namespace neogfx
 
     text_edit::paragraph_span text_edit::character_to_paragraph(position_type aCharacterPos) const
     {
-        auto paragraph = std::lower_bound(iGlyphParagraphs.begin(), iGlyphParagraphs.end(), aCharacterPos,
-            [](glyph_paragraph const& p, position_type cp)
-            {
-                return p.text_begin_index() < cp;
-            });
-        if (paragraph != iGlyphParagraphs.begin() && (paragraph == iGlyphParagraphs.end() || aCharacterPos < paragraph->text_begin_index()))
-            paragraph = std::prev(paragraph);
-        return { static_cast<std::size_t>(std::distance(iGlyphParagraphs.begin(), paragraph)), paragraph->span };
+        if (iGlyphParagraphs.empty())
+            return {};
+        auto const paragraphIndex = std::min(
+            iParagraphIndex.find(aCharacterPos, [](paragraph_extents const& e) { return e.text; }),
+            iGlyphParagraphs.size() - 1u);
+        return { paragraphIndex, iGlyphParagraphs[paragraphIndex].span() };
     }
 
     text_edit::paragraph_line_span text_edit::character_to_line(position_type aCharacterPos) const
@@ -2223,12 +2235,12 @@ namespace neogfx
 
     text_edit::glyph_paragraphs::const_iterator text_edit::glyph_to_paragraph(position_type aGlyphPos) const
     {
-        auto paragraph = std::lower_bound(iGlyphParagraphs.begin(), iGlyphParagraphs.end(), aGlyphPos,
-            [](glyph_paragraph const& p, position_type gp) { return p.glyph_begin_index() < gp; });
-        if (paragraph != iGlyphParagraphs.begin() && 
-            (paragraph == iGlyphParagraphs.end() || aGlyphPos < paragraph->glyph_begin_index()))
-            paragraph = std::prev(paragraph);
-        return paragraph;
+        if (iGlyphParagraphs.empty())
+            return iGlyphParagraphs.end();
+        auto const paragraphIndex = std::min(
+            iParagraphIndex.find(aGlyphPos, [](paragraph_extents const& e) { return e.glyphs; }),
+            iGlyphParagraphs.size() - 1u);
+        return std::next(iGlyphParagraphs.begin(), paragraphIndex);
     }
 
     std::size_t text_edit::columns() const
@@ -2279,6 +2291,152 @@ namespace neogfx
         return default_style();
     }
 
+    void text_edit::open_mapped(std::string const& aPath)
+    {
+        auto mappedText = std::make_unique<neogfx::mapped_text>(aPath);
+        close_mapped();
+        iMappedText = std::move(mappedText);
+        iMappedLines = iMappedText->estimated_lines();
+        iMappedWindow = {};
+        set_read_only(true);
+        // Without word wrapping every line is the same height so a scroll position maps directly to a line.
+        set_word_wrap(false);
+        vertical_scrollbar().set_position(0.0);
+        update_mapped_window(true);
+    }
+
+    void text_edit::close_mapped()
+    {
+        if (!iMappedText)
+            return;
+        iMappedText.reset();
+        iMappedWindow = {};
+        iMappedLines = 0u;
+        clear();
+    }
+
+    bool text_edit::is_mapped() const
+    {
+        return iMappedText != nullptr;
+    }
+
+    mapped_text const& text_edit::mapped_document() const
+    {
+        if (!iMappedText)
+            throw not_mapped();
+        return *iMappedText;
+    }
+
+    bool text_edit::find_mapped(std::string const& aText)
+    {
+        if (!iMappedText || aText.empty())
+            return false;
+        auto const is_lead_byte = [](char aByte) { return (static_cast<unsigned char>(aByte) & 0xC0u) != 0x80u; };
+        // Search from the end of the selection; its column (in characters) is converted to a byte offset within its line.
+        auto const from = to_mapped(std::max(cursor().position(), cursor().anchor()));
+        auto const fromLineStart = iMappedText->line_start(from.first);
+        auto const fromLine = iMappedText->bytes(fromLineStart, iMappedText->line_end(from.first));
+        std::size_t fromIndex = 0u;
+        for (std::uint64_t column = 0u; column < from.second && fromIndex < fromLine.size(); ++column)
+            do
+                ++fromIndex;
+            while (fromIndex < fromLine.size() && !is_lead_byte(fromLine[fromIndex]));
+        auto const match = iMappedText->find(aText, fromLineStart + fromIndex);
+        if (!match)
+            return false;
+        auto const line = iMappedText->line_at(*match);
+        auto const prefix = iMappedText->bytes(iMappedText->line_start(line), *match);
+        auto const column = static_cast<std::uint64_t>(std::count_if(prefix.begin(), prefix.end(), is_lead_byte));
+        auto const length = static_cast<std::uint64_t>(std::count_if(aText.begin(), aText.end(), is_lead_byte));
+        vertical_scrollbar().set_position(static_cast<scalar>(line) * font().height() - std::floor(client_rect(false).cy / 2.0));
+        update_mapped_window();
+        if (line < iMappedWindow.first || line >= iMappedWindow.second)
+            return false;
+        cursor().set_position(from_mapped({ line, column }));
+        cursor().set_position(from_mapped({ line, column + length }), false);
+        make_cursor_visible();
+        return true;
+    }
+
+    void text_edit::update_mapped_window(bool aForce)
+    {
+        if (!iMappedText || iUpdatingMappedWindow)
+            return;
+        auto const lineHeight = font().height();
+        auto const position = std::max(vertical_scrollbar().position(), 0.0);
+        auto const firstVisible = static_cast<std::uint64_t>(position / lineHeight);
+        auto const lastVisible = static_cast<std::uint64_t>(std::ceil((position + client_rect(false).cy) / lineHeight)) + 1u;
+        if (!aForce && iMappedWindow.first <= firstVisible && lastVisible <= iMappedWindow.second)
+            return;
+        // A page of lines (or more) either side of the viewport so scrolling does not reload the window every step.
+        std::uint64_t constexpr MIN_MAPPED_WINDOW_MARGIN = 64u;
+        auto const margin = std::max(lastVisible - firstVisible, MIN_MAPPED_WINDOW_MARGIN);
+        auto const lines = std::max<std::uint64_t>(iMappedText->estimated_lines(), 1u);
+        auto const first = std::min(firstVisible - std::min(firstVisible, margin), lines - 1u);
+        auto const last = std::max(std::min(lastVisible + margin, lines), first + 1u);
+        load_mapped_window(first, last);
+    }
+
+    void text_edit::load_mapped_window(std::uint64_t aFirstLine, std::uint64_t aLastLine)
+    {
+        neolib::scoped_flag sf{ iUpdatingMappedWindow };
+        auto const horizontalPosition = horizontal_scrollbar().position();
+        auto const verticalPosition = vertical_scrollbar().position();
+        auto const position = to_mapped(cursor().position());
+        auto const anchor = to_mapped(cursor().anchor());
+        // The window is capped in bytes as well as lines so that a very long line isn't copied in full; it then ends
+        // part way through the line containing the cap (without splitting a UTF-8 sequence).
+        std::uint64_t constexpr MAX_MAPPED_WINDOW_BYTES = 4u * 1024u * 1024u;
+        auto const windowStart = iMappedText->line_start(aFirstLine);
+        auto windowEnd = iMappedText->line_end(aLastLine - 1u);
+        if (windowEnd > windowStart + MAX_MAPPED_WINDOW_BYTES)
+        {
+            windowEnd = windowStart + MAX_MAPPED_WINDOW_BYTES;
+            aLastLine = std::max(std::min(iMappedText->line_at(windowEnd) + 1u, aLastLine), aFirstLine + 1u);
+        }
+        auto window = iMappedText->copy(windowStart, windowEnd);
+        if (windowEnd != iMappedText->line_end(aLastLine - 1u))
+        {
+            while (!window.empty() && (static_cast<unsigned char>(window.back()) & 0xC0u) == 0x80u)
+                window.pop_back();
+            if (!window.empty() && (static_cast<unsigned char>(window.back()) & 0x80u) != 0u)
+                window.pop_back();
+        }
+        iMappedWindow = { aFirstLine, aLastLine };
+        // Changing the window of lines doesn't change the document.
+        auto const wantedToNotifyTextChanged = iWantedToNotifyTextChanged;
+        {
+            neolib::scoped_counter<std::uint32_t> sc{ iSuppressTextChangedNotification };
+            set_text(window);
+        }
+        iWantedToNotifyTextChanged = wantedToNotifyTextChanged;
+        cursor().set_position(from_mapped(anchor));
+        cursor().set_position(from_mapped(position), false);
+        horizontal_scrollbar().set_position(horizontalPosition);
+        vertical_scrollbar().set_position(verticalPosition);
+    }
+
+    std::pair<std::uint64_t, std::uint64_t> text_edit::to_mapped(position_type aPosition) const
+    {
+        if (iGlyphParagraphs.empty())
+            return { iMappedWindow.first, 0u };
+        auto const paragraph = character_to_paragraph(aPosition);
+        return { iMappedWindow.first + paragraph.paragraphIndex, static_cast<std::uint64_t>(aPosition - paragraph.paragraphSpan.textFirst) };
+    }
+
+    text_edit::position_type text_edit::from_mapped(std::pair<std::uint64_t, std::uint64_t> const& aLineColumn) const
+    {
+        if (iGlyphParagraphs.empty() || aLineColumn.first < iMappedWindow.first)
+            return 0;
+        if (aLineColumn.first - iMappedWindow.first >= iGlyphParagraphs.size())
+            return static_cast<position_type>(iText.size());
+        auto const span = iGlyphParagraphs[aLineColumn.first - iMappedWindow.first].span();
+        auto lineEnd = span.textLast;
+        if (lineEnd > span.textFirst && std::next(iText.begin(), lineEnd - 1)->character == U'\n')
+            --lineEnd;
+        return std::min(span.textFirst + static_cast<position_type>(aLineColumn.second), lineEnd);
+    }
+
     bool text_edit::has_page_rect() const
     {
         return iPageRect != std::nullopt;
@@ -2671,7 +2829,7 @@ namespace neogfx
         {
             if (paragraph->glyph_begin() > aWhere)
                 --paragraph;
-            auto const textStart = paragraph->span.textFirst;
+            auto const textStart = paragraph->text_begin_index();
             auto const& clusters = aWhere->clusters;
             return std::make_pair(textStart + clusters.first, textStart + clusters.second);
         }
@@ -2705,15 +2863,39 @@ namespace neogfx
         document_text::const_iterator last;
         document_glyphs::const_iterator glyphsInsertPos;
         glyph_paragraphs::const_iterator glyphParagraphsInsertPos;
+        std::size_t firstParagraphIndex = 0u;
+        std::size_t paragraphsErased = 0u;
+        std::size_t unlaidParagraphsErased = 0u;
+        auto count_unlaid = [&](std::size_t aFirst, std::size_t aLast)
+        {
+            return static_cast<std::size_t>(std::count_if(std::next(iGlyphParagraphs.begin(), aFirst), std::next(iGlyphParagraphs.begin(), aLast),
+                [](glyph_paragraph const& aParagraph) { return !aParagraph.laidOut; }));
+        };
 
-        std::ptrdiff_t charsInserted = 0;
-        std::ptrdiff_t glyphsInserted = 0;
-
-        if (aDelta == 0 || iGlyphParagraphs.empty())
+        bool const rebuild = (aDelta == 0 || iGlyphParagraphs.empty());
+        // Text offsets of the paragraphs visible before a rebuild (see parallel shaping below).
+        std::optional<std::pair<std::size_t, std::size_t>> previouslyVisible;
+        if (rebuild)
         {
             (void)aWhere;
+            if (!iGlyphParagraphs.empty() && parallel_shaping())
+            {
+                auto const top = std::max(vertical_scrollbar().position() - iParagraphYOffset, 0.0);
+                auto const bottom = top + vertical_scrollbar().page();
+                auto index = std::min(
+                    iParagraphIndex.find(top, [](paragraph_extents const& e) { return e.height; }),
+                    iGlyphParagraphs.size() - 1u);
+                auto const visibleFirst = static_cast<std::size_t>(iParagraphIndex.prefix_sum(index).text);
+                while (index < iGlyphParagraphs.size() && iParagraphIndex.prefix_sum(index).height < bottom)
+                    ++index;
+                auto const visibleLast = static_cast<std::size_t>(index < iGlyphParagraphs.size() ?
+                    iParagraphIndex.prefix_sum(index).text : iParagraphIndex.total().text);
+                if (visibleFirst > 0u && visibleFirst < visibleLast)
+                    previouslyVisible.emplace(visibleFirst, visibleLast);
+            }
             glyphs().clear();
             iGlyphParagraphs.clear();
+            iParagraphIndex.clear();
             first = iText.begin();
             last = iText.end();
             glyphsInsertPos = glyphs().end();
@@ -2727,9 +2909,10 @@ namespace neogfx
             glyphsInsertPos = glyphs().erase(
                 std::next(glyphs().begin(), fromParagraph.paragraphSpan.glyphsFirst), 
                 std::next(glyphs().begin(), fromParagraph.paragraphSpan.glyphsLast));
+            unlaidParagraphsErased = count_unlaid(fromParagraph.paragraphIndex, fromParagraph.paragraphIndex + 1);
             glyphParagraphsInsertPos = iGlyphParagraphs.erase(std::next(iGlyphParagraphs.begin(), fromParagraph.paragraphIndex));
-            charsInserted -= (fromParagraph.paragraphSpan.textLast - fromParagraph.paragraphSpan.textFirst);
-            glyphsInserted -= (fromParagraph.paragraphSpan.glyphsLast - fromParagraph.paragraphSpan.glyphsFirst);
+            firstParagraphIndex = fromParagraph.paragraphIndex;
+            paragraphsErased = 1u;
         }
         else // aDelta < 0
         {
@@ -2740,11 +2923,12 @@ namespace neogfx
             glyphsInsertPos = glyphs().erase(
                 std::next(glyphs().begin(), fromParagraph.paragraphSpan.glyphsFirst),
                 std::next(glyphs().begin(), toParagraph.paragraphSpan.glyphsLast));
+            unlaidParagraphsErased = count_unlaid(fromParagraph.paragraphIndex, toParagraph.paragraphIndex + 1);
             glyphParagraphsInsertPos = iGlyphParagraphs.erase(
                 std::next(iGlyphParagraphs.begin(), fromParagraph.paragraphIndex),
                 std::next(iGlyphParagraphs.begin(), toParagraph.paragraphIndex + 1));
-            charsInserted -= (toParagraph.paragraphSpan.textLast - fromParagraph.paragraphSpan.textFirst);
-            glyphsInserted -= (toParagraph.paragraphSpan.glyphsLast - fromParagraph.paragraphSpan.glyphsFirst);
+            firstParagraphIndex = fromParagraph.paragraphIndex;
+            paragraphsErased = toParagraph.paragraphIndex + 1 - fromParagraph.paragraphIndex;
         }
 
         graphics_context gc{ *this, graphics_context::type::Unattached };
@@ -2755,26 +2939,160 @@ namespace neogfx
         auto nextParagraph = first;
         thread_local std::vector<std::u32string::difference_type> cachedColumnDelimiters;
         auto& columnDelimiters = cachedColumnDelimiters;
+        auto const defaultFont = font();
  
-        auto fs = [this, &nextParagraph, &columnDelimiters](std::u32string::size_type aSourceIndex)
-        {
-            auto characterStyle = iStyleMap.find(std::next(nextParagraph, aSourceIndex)->style);
-            std::size_t indexColumn = std::lower_bound(columnDelimiters.begin(), columnDelimiters.end(), 
-                static_cast<std::u32string::difference_type>(aSourceIndex)) - columnDelimiters.begin();
-            if (indexColumn > columns() - 1)
-                indexColumn = columns() - 1;
-            auto const& columnStyle = column_style(indexColumn);
-            auto const& style =
-                characterStyle != iStyleMap.end() ? **characterStyle :
-                columnStyle.character().font() != std::nullopt ? columnStyle : iDefaultStyle;
-            return style.character().font() != std::nullopt ? style.character().font().value() : font();
+        auto fs = [this, &nextParagraph, &columnDelimiters, &defaultFont](std::u32string::size_type aSourceIndex)
+        {
+            return paragraph_font(nextParagraph, columnDelimiters, aSourceIndex, defaultFont);
         };
         
         columnDelimiters.clear();
         std::size_t columnCount = 0;
 
+        thread_local std::vector<paragraph_extents> newParagraphs;
+        newParagraphs.clear();
+
+        // When (re)building a large document, whole paragraphs are shaped ahead in parallel batches into the glyph
+        // text factory's shaping cache while the in-order loop below looks up the shaped runs, measures and splices
+        // the glyphs (which must happen on this thread as rasterizing glyphs touches the font atlas). Each batch is
+        // shaped in the background while the loop consumes the one before it. Fonts are selected on this thread as
+        // styles aren't safe to read from the workers; the first batch also holds the paragraphs that were visible
+        // before the rebuild so that their glyphs are rasterized first.
+        std::size_t constexpr PARALLEL_SHAPING_THRESHOLD = 16384u;
+        std::size_t constexpr PARALLEL_SHAPING_BATCH_PARAGRAPHS = 256u;
+        std::size_t constexpr PARALLEL_SHAPING_BATCH_CHARACTERS = 65536u;
+        struct preshape_paragraph
+        {
+            document_text::const_iterator first;
+            document_text::const_iterator last;
+            std::vector<std::pair<std::u32string::size_type, neogfx::font>> fonts; // runs of the same font by start index
+        };
+        using preshape_batch = std::vector<preshape_paragraph>;
+        auto& factory = service<i_font_manager>().glyph_text_factory();
+        std::optional<graphics_context> preshapeGc;
+        std::optional<document_text::const_iterator> preshapeWaitAt;
+        auto preshapeFrom = first;
+        if (aDelta == 0 && parallel_shaping() && static_cast<std::size_t>(std::distance(first, last)) >= PARALLEL_SHAPING_THRESHOLD)
+        {
+            // The workers get their own context as this thread changes the tab stops of gc while they run.
+            preshapeGc.emplace(*this, graphics_context::type::Unattached);
+            preshapeGc->set_password(gc.password(), gc.password_mask());
+        }
+        auto collect = [&](document_text::const_iterator aFrom, document_text::const_iterator aTo, preshape_batch& aBatch)
+        {
+            std::size_t batchCharacters = 0u;
+            std::size_t batchParagraphs = 0u;
+            auto paragraphStart = aFrom;
+            std::vector<std::u32string::difference_type> delimiters;
+            for (auto iterChar = aFrom; iterChar != aTo; ++iterChar)
+            {
+                auto const ch = iterChar->character;
+                auto const& column = iColumns[std::min(delimiters.size(), iColumns.size() - 1)];
+                if (ch == column.info.delimiter && delimiters.size() + 1 < iColumns.size())
+                    delimiters.push_back(std::distance(paragraphStart, iterChar));
+                if (ch == U'\n' || iterChar == std::prev(last))
+                {
+                    auto& paragraph = aBatch.emplace_back(preshape_paragraph{ paragraphStart, std::next(iterChar) });
+                    auto const length = static_cast<std::u32string::size_type>(std::distance(paragraph.first, paragraph.last));
+                    // A paragraph's font only changes with the character style or column.
+                    std::optional<std::pair<style_cookie, std::size_t>> previous;
+                    std::size_t columnIndex = 0u;
+                    for (std::u32string::size_type sourceIndex = 0u; sourceIndex < length; ++sourceIndex)
+                    {
+                        while (columnIndex < delimiters.size() && delimiters[columnIndex] < static_cast<std::u32string::difference_type>(sourceIndex))
+                            ++columnIndex;
+                        std::pair<style_cookie, std::size_t> const key{ std::next(paragraph.first, sourceIndex)->style, columnIndex };
+                        if (previous == key)
+                            continue;
+                        previous = key;
+                        auto runFont = paragraph_font(paragraph.first, delimiters, sourceIndex, defaultFont);
+                        if (paragraph.fonts.empty() || !(paragraph.fonts.back().second == runFont))
+                            paragraph.fonts.emplace_back(sourceIndex, std::move(runFont));
+                    }
+                    batchCharacters += length;
+                    delimiters.clear();
+                    paragraphStart = std::next(iterChar);
+                    if (++batchParagraphs >= PARALLEL_SHAPING_BATCH_PARAGRAPHS || batchCharacters >= PARALLEL_SHAPING_BATCH_CHARACTERS)
+                        return paragraphStart;
+                }
+            }
+            return aTo;
+        };
+        auto next_preshape_batch = [&](preshape_batch& aBatch)
+        {
+            if (previouslyVisible && std::distance(iText.cbegin(), preshapeFrom) == static_cast<std::ptrdiff_t>(previouslyVisible->first))
+                preshapeFrom = std::next(iText.cbegin(), previouslyVisible->second);
+            auto const to = previouslyVisible && std::distance(iText.cbegin(), preshapeFrom) < static_cast<std::ptrdiff_t>(previouslyVisible->first) ?
+                std::next(iText.cbegin(), previouslyVisible->first) : last;
+            preshapeFrom = collect(preshapeFrom, to, aBatch);
+        };
+        std::future<void> preshaping;
+        auto launch_preshape = [&](preshape_batch&& aBatch)
+        {
+            preshaping = std::async(std::launch::async, [&factory, &preshapeGc, batch = std::move(aBatch)]()
+            {
+                std::for_each(std::execution::par, batch.begin(), batch.end(), [&](preshape_paragraph const& aParagraph)
+                {
+                    // An exception escaping a parallel algorithm's element function terminates so a paragraph that
+                    // fails to shape is just left out of the cache; the in-order loop shapes it again (on this thread,
+                    // where any error is reported) as it does any other cache miss.
+                    try
+                    {
+                        std::u32string const paragraphText(aParagraph.first, aParagraph.last);
+                        font_selector const paragraphFonts{ [&](std::u32string::size_type aSourceIndex)
+                        {
+                            return std::prev(std::upper_bound(aParagraph.fonts.begin(), aParagraph.fonts.end(), aSourceIndex,
+                                [](std::u32string::size_type aIndex, auto const& aRun) { return aIndex < aRun.first; }))->second;
+                        } };
+                        factory.preshape(*preshapeGc, paragraphText.data(), paragraphText.data() + paragraphText.size(), paragraphFonts);
+                    }
+                    catch (...) {}
+                });
+            });
+        };
+        if (preshapeGc)
+        {
+            if (previouslyVisible)
+            {
+                // Snap to paragraph boundaries in the new text.
+                auto const size = static_cast<std::size_t>(iText.size());
+                auto& [visibleFirst, visibleLast] = *previouslyVisible;
+                visibleFirst = std::min(visibleFirst, size);
+                visibleLast = std::min(std::max(visibleLast, visibleFirst), size);
+                while (visibleFirst > 0u && iText[visibleFirst - 1u].character != U'\n')
+                    --visibleFirst;
+                while (visibleLast < size && (visibleLast == 0u || iText[visibleLast - 1u].character != U'\n'))
+                    ++visibleLast;
+                if (visibleFirst == 0u || visibleFirst == visibleLast)
+                    previouslyVisible = std::nullopt;
+            }
+            preshape_batch batch;
+            if (previouslyVisible)
+                collect(std::next(iText.cbegin(), previouslyVisible->first), std::next(iText.cbegin(), previouslyVisible->second), batch);
+            next_preshape_batch(batch);
+            launch_preshape(std::move(batch));
+            preshapeWaitAt = first;
+        }
+
         for (auto iterChar = first; iterChar != last; ++iterChar)
         {
+            if (preshapeWaitAt && iterChar == *preshapeWaitAt)
+            {
+                // Wait for the batch starting here and queue the next one while this one is consumed.
+                preshaping.get();
+                preshapeWaitAt = std::nullopt;
+                if (preshapeFrom != last)
+                {
+                    preshapeWaitAt = preshapeFrom;
+                    preshape_batch batch;
+                    next_preshape_batch(batch);
+                    if (!batch.empty())
+                        launch_preshape(std::move(batch));
+                    else
+                        preshapeWaitAt = std::nullopt;
+                }
+            }
+
             auto ch = iterChar->character;
 
             auto& column = iColumns[std::min(columnDelimiters.size(), iColumns.size() - 1)];
@@ -2790,54 +3108,87 @@ namespace neogfx
                 paragraphBuffer.assign(nextParagraph, std::next(iterChar));
                 scoped_tab_stops sts{ gc, tab_stops() };
                 auto gt = service<i_font_manager>().glyph_text_factory().to_glyph_text(gc, std::u32string_view{ paragraphBuffer.begin(), paragraphBuffer.end() }, fs, false);
-                if (gt.cbegin() != gt.cend())
-                {
-                    auto const paragraphGlyphs = glyphs().insert(glyphsInsertPos, gt.cbegin(), gt.cend());
-                    glyphsInsertPos = std::next(paragraphGlyphs, gt.size());
-                    for (auto& newGlyph : gt)
-                        glyphs().glyph_font(newGlyph);
-                    document_span const span{
-                        std::distance(iText.cbegin(), nextParagraph),
-                        std::distance(iText.cbegin(), std::next(iterChar)),
-                        std::distance(glyphs().begin(), paragraphGlyphs),
-                        std::distance(glyphs().begin(), std::next(paragraphGlyphs, gt.size())) };
-                    auto const paragraph = iGlyphParagraphs.emplace(glyphParagraphsInsertPos, this, span);
-                    paragraph->columnBreaks.assign(columnDelimiters.begin(), columnDelimiters.end());
-                    paragraph->lineBreaks.assign(gt.content().line_breaks().begin(), gt.content().line_breaks().end());
-                    glyphParagraphsInsertPos = std::next(paragraph);
-                    charsInserted += (paragraph->span.textLast - paragraph->span.textFirst);
-                    glyphsInserted += (paragraph->span.glyphsLast - paragraph->span.glyphsFirst);
-                }
+                // Every paragraph is kept (even one without glyphs) as paragraph offsets are the running totals of
+                // the extents of the paragraphs before it.
+                auto const paragraphGlyphs = glyphs().insert(glyphsInsertPos, gt.cbegin(), gt.cend());
+                glyphsInsertPos = std::next(paragraphGlyphs, gt.size());
+                for (auto& newGlyph : gt)
+                    glyphs().glyph_font(newGlyph);
+                auto const paragraph = iGlyphParagraphs.emplace(glyphParagraphsInsertPos, this, firstParagraphIndex + newParagraphs.size());
+                paragraph->columnBreaks.assign(columnDelimiters.begin(), columnDelimiters.end());
+                paragraph->lineBreaks.assign(gt.content().line_breaks().begin(), gt.content().line_breaks().end());
+                glyphParagraphsInsertPos = std::next(paragraph);
+                newParagraphs.push_back(paragraph_extents{
+                    std::distance(nextParagraph, std::next(iterChar)),
+                    static_cast<document_glyphs::difference_type>(gt.size()) });
                 nextParagraph = std::next(iterChar);
                 columnCount = std::max(columnCount, columnDelimiters.size() + 1);
                 columnDelimiters.clear();
             }
         }
 
-        for (auto paragraphToAdjust = std::next(iGlyphParagraphs.begin(), std::distance(iGlyphParagraphs.cbegin(), glyphParagraphsInsertPos)); 
-            paragraphToAdjust != iGlyphParagraphs.end(); ++paragraphToAdjust)
-        {
-            auto& p = *paragraphToAdjust;
-            p.span.textFirst += charsInserted;
-            p.span.textLast += charsInserted;
-            p.span.glyphsFirst += glyphsInserted;
-            p.span.glyphsLast += glyphsInserted;
-            p.heightMap.clear();
-            p.ypos = 0.0;
-        }
+        // Paragraphs after the edit move without being touched unless the number of paragraphs has changed (in
+        // which case they are renumbered); their offsets are running totals in the paragraph index.
+        iParagraphIndex.replace(firstParagraphIndex, paragraphsErased, newParagraphs.begin(), newParagraphs.end());
+        if (newParagraphs.size() != paragraphsErased)
+            for (auto paragraphToRenumber = std::next(iGlyphParagraphs.begin(), std::distance(iGlyphParagraphs.cbegin(), glyphParagraphsInsertPos));
+                paragraphToRenumber != iGlyphParagraphs.end(); ++paragraphToRenumber)
+                paragraphToRenumber->index = static_cast<std::size_t>(std::distance(iGlyphParagraphs.begin(), paragraphToRenumber));
 
+        auto const columnsBefore = iGlyphColumns.size();
         iGlyphColumns.resize(std::max(columnCount, iGlyphColumns.size()), { this });
-        for (auto& column : iGlyphColumns)
-            column.lines.clear();
 
         if (iPasswordBits)
             iPasswordBits.value().showPassword.show(!iText.empty());
 
-        refresh_columns();
+        if (rebuild || iGlyphColumns.size() != columnsBefore)
+        {
+            refresh_columns();
+            return;
+        }
+
+        // Only the new paragraphs need laying out: the lines of the paragraphs they replace are dropped and the
+        // lines after them renumbered.
+        auto const byParagraph = [](glyph_line const& aLine, std::size_t aParagraphIndex) { return aLine.paragraphIndex < aParagraphIndex; };
+        for (auto& column : iGlyphColumns)
+        {
+            auto& lines = column.lines;
+            auto const eraseFirst = std::lower_bound(lines.begin(), lines.end(), firstParagraphIndex, byParagraph);
+            auto const eraseLast = std::lower_bound(eraseFirst, lines.end(), firstParagraphIndex + paragraphsErased, byParagraph);
+            lines_removed(eraseFirst, eraseLast);
+            auto const renumberFrom = lines.erase(eraseFirst, eraseLast);
+            if (newParagraphs.size() != paragraphsErased)
+                for (auto line = renumberFrom; line != lines.end(); ++line)
+                    line->paragraphIndex = line->paragraphIndex + newParagraphs.size() - paragraphsErased;
+        }
+
+        auto const newParagraphsFirst = firstParagraphIndex;
+        auto const newParagraphsLast = firstParagraphIndex + newParagraphs.size();
+        auto const relocate = [&](std::size_t aIndex)
+        {
+            return aIndex >= firstParagraphIndex + paragraphsErased ? aIndex + newParagraphs.size() - paragraphsErased : std::min(aIndex, firstParagraphIndex);
+        };
+        iParagraphsAwaitingLayout -= unlaidParagraphsErased;
+        if (iParagraphsAwaitingLayout != 0u)
+        {
+            iLayoutPendingFirst = std::min(relocate(iLayoutPendingFirst), newParagraphsFirst);
+            iLayoutPendingLast = std::max(relocate(iLayoutPendingLast), newParagraphsLast);
+        }
+        else
+        {
+            iLayoutPendingFirst = newParagraphsFirst;
+            iLayoutPendingLast = newParagraphsLast;
+        }
+        iParagraphsAwaitingLayout += newParagraphs.size();
+        if (iParagraphHeightsEstimated && iLineLayoutWidth)
+            estimate_paragraph_heights(newParagraphsFirst, newParagraphsLast, *iLineLayoutWidth);
+
+        refresh_edited_lines();
     }
 
     void text_edit::refresh_columns()
     {
+        invalidate_lines();
         iTextExtents = std::nullopt;
         update_scrollbar_visibility();
         if ((iCaps & text_edit_caps::LINES_MASK) == text_edit_caps::GrowLines)
@@ -2845,6 +3196,34 @@ namespace neogfx
         update();
     }
 
+    void text_edit::refresh_edited_lines()
+    {
+        if (iLineLayoutWidth == std::nullopt)
+        {
+            refresh_columns();
+            return;
+        }
+        // Only the edited paragraphs need laying out; the full scrollbar visibility update (which can lay out
+        // every paragraph again at another width) is only needed if the edit changes which scrollbars are needed.
+        refresh_lines();
+        auto const area = scroll_area();
+        auto const page = scroll_page();
+        if ((area.cy > page.cy) != vertical_scrollbar().visible() || (area.cx > page.cx) != horizontal_scrollbar().visible())
+        {
+            iTextExtents = std::nullopt;
+            update_scrollbar_visibility();
+        }
+        else
+        {
+            framed_scrollable_widget::update_scrollbar_visibility(UsvStageDone);
+            if (has_focus() && !read_only())
+                make_cursor_visible();
+        }
+        if ((iCaps & text_edit_caps::LINES_MASK) == text_edit_caps::GrowLines)
+            update_layout();
+        update();
+    }
+
     void text_edit::refresh_lines()
     {
 #ifdef NEOGFX_DEBUG
@@ -2856,397 +3235,595 @@ namespace neogfx
         {
             iOutOfMemory = false;
 
-            /* simple (naive) implementation just to get things moving... */
-            for (auto& column : iGlyphColumns)
-                column.lines.clear();
-            
             dimension availableWidth = column_rect(0).width(); // todo: columns
             dimension availableHeight = column_rect(0).height();
+
+            // Lines stay valid until the width they were laid out at changes; until then only paragraphs that have
+            // been edited (or not yet laid out) need laying out.
+            if (iLineLayoutWidth != availableWidth)
+                invalidate_lines();
+
+            layout_lines(availableWidth, availableHeight);
+
             bool showVerticalScrollbar = false;
-            bool showHorizontalScrollbar = false;
+            if (!vertical_scrollbar().visible() && iTextExtents->cy > availableHeight)
+            {
+                showVerticalScrollbar = true;
+                availableWidth -= vertical_scrollbar().width();
+                invalidate_lines();
+                layout_lines(availableWidth, availableHeight);
+            }
+            if (!horizontal_scrollbar().visible() && iTextExtents->cx > availableWidth)
+            {
+                availableHeight -= horizontal_scrollbar().width();
+                if (!showVerticalScrollbar && !vertical_scrollbar().visible() && iTextExtents->cy > availableHeight)
+                {
+                    availableWidth -= vertical_scrollbar().width();
+                    invalidate_lines();
+                    layout_lines(availableWidth, availableHeight);
+                }
+            }
 
+            iLineLayoutWidth = availableWidth;
+
+            iParagraphYOffset = 0.0;
+            if (iMappedText)
+                iParagraphYOffset = static_cast<coordinate>(iMappedWindow.first) * font().height();
+            else if (iTextExtents->cy < client_rect(false).cy)
+            {
+                auto const space = client_rect(false).cy - iTextExtents->cy;
+                auto const defaultAlignment = default_style().paragraph().alignment().as_std_optional().value_or(alignment());
+                auto const adjust =
+                    ((defaultAlignment & neogfx::alignment::Vertical) == neogfx::alignment::Bottom) ? space :
+                    ((defaultAlignment & neogfx::alignment::Vertical) == neogfx::alignment::VCenter) ? std::floor(space / 2.0) : 0.0;
+                iParagraphYOffset = adjust;
+            }
+        }
+        catch (std::bad_alloc)
+        {
+            invalidate_lines();
+            for (auto const& paragraph : iGlyphParagraphs)
+            {
+                auto paragraphExtents = iParagraphIndex[paragraph.index];
+                paragraphExtents.height = 0.0;
+                iParagraphIndex.set(paragraph.index, paragraphExtents);
+            }
+            iParagraphYOffset = 0.0;
             iTextExtents = size{};
-            
-            std::uint32_t pass = 1;
-            dimension yposParagraph = 0.0;
+            iOutOfMemory = true;
+        }
+    }
 
-            for (auto iterParagraph = iGlyphParagraphs.begin(); iterParagraph != iGlyphParagraphs.end();)
+    void text_edit::invalidate_lines()
+    {
+        for (auto& column : iGlyphColumns)
+            column.lines.clear();
+        for (auto& paragraph : iGlyphParagraphs)
+            paragraph.laidOut = false;
+        iParagraphsAwaitingLayout = iGlyphParagraphs.size();
+        iLayoutPendingFirst = 0u;
+        iLayoutPendingLast = iGlyphParagraphs.size();
+        iLinesMaxWidth = 0.0;
+        iLinesAtMaxWidth = 0u;
+        iLineLayoutWidth = std::nullopt;
+        iParagraphHeightsEstimated = false;
+    }
+
+    void text_edit::estimate_paragraph_heights(std::size_t aFirst, std::size_t aLast, dimension aAvailableWidth)
+    {
+        // A paragraph that has not been laid out yet is given the height of its hard lines plus, if word wrapping,
+        // the number of lines its advance would wrap to at the available width; enough for plausible scrollbars.
+        auto const lineHeight = font().height();
+        auto glyphOffset = iParagraphIndex.prefix_sum(aFirst).glyphs;
+        for (auto index = aFirst; index < aLast; ++index)
+        {
+            auto const& paragraph = iGlyphParagraphs[index];
+            auto paragraphExtents = iParagraphIndex[index];
+            if (!paragraph.laidOut)
             {
-                auto& paragraph = *iterParagraph;
+                dimension lines = static_cast<dimension>(paragraph.lineBreaks.size() + 1u);
+                if (WordWrap && aAvailableWidth > 0.0 && paragraphExtents.glyphs > 0)
+                {
+                    auto const& firstGlyph = glyphs()[glyphOffset];
+                    auto const& lastGlyph = glyphs()[glyphOffset + paragraphExtents.glyphs - 1];
+                    lines = std::max(lines, std::ceil((lastGlyph.cell[1].x - firstGlyph.cell[0].x) / aAvailableWidth));
+                }
+                paragraphExtents.height = lines * lineHeight;
+                iParagraphIndex.set(index, paragraphExtents);
+            }
+            glyphOffset += paragraphExtents.glyphs;
+        }
+    }
 
-                paragraph.ypos = yposParagraph;
-                dimension yColumn = 0.0;
+    void text_edit::layout_lines(dimension aAvailableWidth, dimension aAvailableHeight)
+    {
+        // Small numbers of paragraphs are laid out there and then; otherwise (a resize or a large edit of a long
+        // document) just the paragraphs around the viewport and the cursor are, and the rest get estimated heights
+        // until they are laid out in the background by layout_deferred_lines().
+        std::size_t constexpr SYNCHRONOUS_LINE_LAYOUT_LIMIT = 512u;
+        if (iParagraphsAwaitingLayout <= SYNCHRONOUS_LINE_LAYOUT_LIMIT)
+        {
+            for (auto index = iLayoutPendingFirst; index < iLayoutPendingLast && iParagraphsAwaitingLayout != 0u; ++index)
+                if (!iGlyphParagraphs[index].laidOut)
+                    layout_paragraph(iGlyphParagraphs[index], aAvailableWidth);
+            iLayoutPendingFirst = iLayoutPendingLast = 0u;
+        }
+        else
+        {
+            if (!iParagraphHeightsEstimated)
+            {
+                estimate_paragraph_heights(0u, iGlyphParagraphs.size(), aAvailableWidth);
+                iParagraphHeightsEstimated = true;
+            }
+            layout_visible_paragraphs(aAvailableWidth, aAvailableHeight);
+            auto& cursorParagraph = iGlyphParagraphs[character_to_paragraph(cursor().position()).paragraphIndex];
+            if (!cursorParagraph.laidOut)
+                layout_paragraph(cursorParagraph, aAvailableWidth);
+        }
+        iTextExtents = size{ lines_max_width(), iParagraphIndex.total().height };
+    }
 
-                for (auto& column : iGlyphColumns)
-                {
-                    dimension yLine = 0.0;
+    void text_edit::layout_visible_paragraphs(dimension aAvailableWidth, dimension aAvailableHeight)
+    {
+        if (iGlyphParagraphs.empty())
+            return;
+        std::size_t constexpr VISIBLE_LINE_LAYOUT_MARGIN = 32u;
+        auto const top = std::max(vertical_scrollbar().position() - iParagraphYOffset, 0.0);
+        auto const bottom = top + aAvailableHeight * 2.0;
+        auto index = std::min(
+            iParagraphIndex.find(top, [](paragraph_extents const& e) { return e.height; }),
+            iGlyphParagraphs.size() - 1u);
+        index -= std::min(index, VISIBLE_LINE_LAYOUT_MARGIN);
+        for (; index < iGlyphParagraphs.size() && iParagraphIndex.prefix_sum(index).height < bottom; ++index)
+            if (!iGlyphParagraphs[index].laidOut)
+                layout_paragraph(iGlyphParagraphs[index], aAvailableWidth);
+    }
 
-                    auto const columnIndex = std::distance(&iGlyphColumns[0], &column);
-                    auto& lines = column.lines;
+    void text_edit::layout_deferred_lines()
+    {
+        if (iParagraphsAwaitingLayout == 0u || iLineLayoutWidth == std::nullopt)
+            return;
 
-                    thread_local std::vector<std::pair<document_glyphs::difference_type, document_glyphs::difference_type>> paragraphLines;
-                    paragraphLines.clear();
+        // A time slice per animation frame; as laying out a paragraph replaces its estimated height the top visible
+        // paragraph is kept where it is on screen.
+        auto const deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds{ 4 };
 
-                    // todo: line segments to correct column
+        try
+        {
+            auto const scrollPosition = vertical_scrollbar().position();
+            auto const anchor = std::min(
+                iParagraphIndex.find(scrollPosition - iParagraphYOffset, [](paragraph_extents const& e) { return e.height; }),
+                iGlyphParagraphs.size() - 1u);
+            auto const anchorOffset = scrollPosition - iGlyphParagraphs[anchor].ypos();
 
-                    glyph_text::size_type lastBreak = 0;
-                    for (auto lineBreak : paragraph.lineBreaks)
+            layout_visible_paragraphs(*iLineLayoutWidth, column_rect(0).height());
+            while (iParagraphsAwaitingLayout != 0u && std::chrono::steady_clock::now() < deadline)
+            {
+                auto const pendingLast = std::min(iLayoutPendingLast, iGlyphParagraphs.size());
+                while (iLayoutPendingFirst < pendingLast && iGlyphParagraphs[iLayoutPendingFirst].laidOut)
+                    ++iLayoutPendingFirst;
+                if (iLayoutPendingFirst == pendingLast)
+                {
+                    // The pending range and count disagree; rescan everything rather than run off the end.
+                    auto const unlaid = std::find_if(iGlyphParagraphs.begin(), iGlyphParagraphs.end(),
+                        [](glyph_paragraph const& aParagraph) { return !aParagraph.laidOut; });
+                    if (unlaid == iGlyphParagraphs.end())
                     {
-                        paragraphLines.emplace_back(lastBreak + paragraph.span.glyphsFirst, lineBreak + paragraph.span.glyphsFirst);
-                        lastBreak = lineBreak + 1;
+                        iParagraphsAwaitingLayout = 0u;
+                        break;
                     }
-                    paragraphLines.emplace_back(lastBreak + paragraph.span.glyphsFirst, paragraph.span.glyphsLast);
-                    if (paragraphLines.back().first != paragraphLines.back().second &&
-                        is_line_breaking_whitespace(glyphs().back()) && std::next(iterParagraph) == iGlyphParagraphs.end())
-                        paragraphLines.emplace_back(paragraph.span.glyphsLast, paragraph.span.glyphsLast);
+                    iLayoutPendingFirst = static_cast<std::size_t>(std::distance(iGlyphParagraphs.begin(), unlaid));
+                    iLayoutPendingLast = iGlyphParagraphs.size();
+                }
+                layout_paragraph(iGlyphParagraphs[iLayoutPendingFirst], *iLineLayoutWidth);
+            }
+            if (iParagraphsAwaitingLayout == 0u)
+                iLayoutPendingFirst = iLayoutPendingLast = 0u;
 
-                    auto const& paragraphStyle = glyph_style(paragraph.glyph_begin(), iColumns[columnIndex]);
+            iTextExtents = size{ lines_max_width(), iParagraphIndex.total().height };
+            auto const area = scroll_area();
+            auto const page = scroll_page();
+            if ((area.cy > page.cy) != vertical_scrollbar().visible() || (area.cx > page.cx) != horizontal_scrollbar().visible())
+            {
+                iTextExtents = std::nullopt;
+                update_scrollbar_visibility();
+            }
+            else
+            {
+                framed_scrollable_widget::update_scrollbar_visibility(UsvStageDone);
+                vertical_scrollbar().set_position(iGlyphParagraphs[anchor].ypos() + anchorOffset);
+            }
+            update();
+        }
+        catch (std::bad_alloc)
+        {
+            invalidate_lines();
+            iOutOfMemory = true;
+            update();
+        }
+    }
 
-                    if (paragraphStyle.paragraph().padding())
-                        yLine += paragraphStyle.paragraph().padding().value().top;
+    void text_edit::layout_paragraph(glyph_paragraph& aParagraph, dimension aAvailableWidth)
+    {
+        auto const paragraphSpan = aParagraph.span();
 
-                    bool first = true;
+        dimension yColumn = 0.0;
 
-                    for (auto const& paragraphLine : paragraphLines)
-                    {
-                        auto const paragraphLineStart = std::next(glyphs().begin(), paragraphLine.first);
-                        auto const paragraphLineEnd = std::next(glyphs().begin(), paragraphLine.second);
+        for (auto& column : iGlyphColumns)
+        {
+            dimension yLine = 0.0;
 
-                        if (!first)
-                        {
-                            if (paragraphStyle.paragraph().line_spacing())
-                                yLine += paragraphStyle.paragraph().line_spacing().value();
-                        }
-                        else
-                            first = false;
+            auto const columnIndex = std::distance(&iGlyphColumns[0], &column);
+            thread_local glyph_lines newLines;
+            newLines.clear();
+            auto& lines = newLines;
 
-                        if (paragraphLineStart == paragraphLineEnd || is_line_breaking_whitespace(*paragraphLineStart))
-                        {
-                            auto lineStart = paragraphLineStart;
-                            auto lineEnd = (paragraphLineStart == paragraphLineEnd || !is_line_breaking_whitespace(*paragraphLineStart)) ? 
-                                paragraphLineEnd : paragraphLineStart;
+            thread_local std::vector<std::pair<document_glyphs::difference_type, document_glyphs::difference_type>> paragraphLines;
+            paragraphLines.clear();
 
-                            auto const alignBaselinesResult = glyphs().align_baselines(lineStart, lineEnd, true);
+            // todo: line segments to correct column
 
-                            glyph_char::cluster_range clusters{
-                                static_cast<glyph_char::cluster_index>(from_glyph(lineStart).first),
-                                static_cast<glyph_char::cluster_index>(from_glyph(lineEnd).second) };
-                            if (alignBaselinesResult.clusters)
-                            {
-                                clusters.first = std::min(clusters.first, alignBaselinesResult.clusters.value().first + static_cast<glyph_char::cluster_index>(paragraph.span.textFirst));
-                                clusters.second = std::max(clusters.second, alignBaselinesResult.clusters.value().second + static_cast<glyph_char::cluster_index>(paragraph.span.textFirst));
-                            }
-                            auto textLineStart = static_cast<position_type>(clusters.first) - paragraph.span.textFirst;
-                            auto textLineEnd = static_cast<position_type>(clusters.second) - paragraph.span.textFirst;
-                            if (lineStart != lineEnd && std::prev(lineEnd)->clusters.first < lineStart->clusters.first) // RTL
-                                textLineStart = std::prev(lineEnd)->clusters.first;
-
-                            document_span const span{
-                                textLineStart,
-                                textLineEnd,
-                                lineStart - glyphs().begin() - paragraph.span.glyphsFirst,
-                                lineEnd - glyphs().begin() - paragraph.span.glyphsFirst };
-
-                            size const lineExtents{
-                                    lineEnd != lineStart ? (lineEnd - 1)->cell[1].x - (lineStart)->cell[0].x : 0.0f,
-                                    alignBaselinesResult.yExtent };
-
-                            dimension xLine = 0.0;
-
-                            auto textDirection = glyph_text_direction(lineStart, lineEnd);
-                            auto const paragraphAlignment = paragraphStyle.paragraph().alignment().as_std_optional().value_or(alignment());
-
-                            if (((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Left && textDirection == text_direction::RTL) ||
-                                ((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Right && textDirection == text_direction::LTR))
-                                xLine += (availableWidth - lineExtents.cx);
-                            else if ((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Center)
-                                xLine += std::ceil((availableWidth - lineExtents.cx, 0.0) / 2.0);
-
-                            lines.emplace_back(
-                                this,
-                                std::distance(iGlyphParagraphs.begin(), iterParagraph),
-                                column.index(),
-                                span,
-                                point{ xLine, yLine },
-                                lineExtents,
-                                alignBaselinesResult.majorFont,
-                                alignBaselinesResult.baseline);
-
-                            yLine += lines.back().extents.cy;
-                            iTextExtents->cx = std::max(iTextExtents->cx, lines.back().extents.cx);
-                        }
-                        else if (WordWrap && static_cast<coordinate>((paragraphLineEnd - 1)->cell[0].x) + static_cast<coordinate>((paragraphLineEnd - 1)->cell_extents().x) > availableWidth)
-                        {
-                            auto add_line = [&](auto first, auto last)
-                            {
-                                if (last != first && is_line_breaking_whitespace(*(last - 1)))
-                                    --last;
+            glyph_text::size_type lastBreak = 0;
+            for (auto lineBreak : aParagraph.lineBreaks)
+            {
+                paragraphLines.emplace_back(lastBreak + paragraphSpan.glyphsFirst, lineBreak + paragraphSpan.glyphsFirst);
+                lastBreak = lineBreak + 1;
+            }
+            paragraphLines.emplace_back(lastBreak + paragraphSpan.glyphsFirst, paragraphSpan.glyphsLast);
+            if (paragraphLines.back().first != paragraphLines.back().second &&
+                is_line_breaking_whitespace(glyphs().back()) && aParagraph.index + 1u == iGlyphParagraphs.size())
+                paragraphLines.emplace_back(paragraphSpan.glyphsLast, paragraphSpan.glyphsLast);
 
-                                auto const alignBaselinesResult = glyphs().align_baselines(first, last, true);
+            auto const& paragraphStyle = glyph_style(aParagraph.glyph_begin(), iColumns[columnIndex]);
 
-                                glyph_char::cluster_range clusters{
-                                    static_cast<glyph_char::cluster_index>(from_glyph(first).first),
-                                    static_cast<glyph_char::cluster_index>(from_glyph(last).second) };
-                                if (alignBaselinesResult.clusters)
-                                {
-                                    clusters.first = std::min(clusters.first, alignBaselinesResult.clusters.value().first + static_cast<glyph_char::cluster_index>(paragraph.span.textFirst));
-                                    clusters.second = std::max(clusters.second, alignBaselinesResult.clusters.value().second + static_cast<glyph_char::cluster_index>(paragraph.span.textFirst));
-                                }
-                                auto textLineStart = static_cast<position_type>(clusters.first) - paragraph.span.textFirst;
-                                auto textLineEnd = static_cast<position_type>(clusters.second) - paragraph.span.textFirst;
-                                if (first != last && std::prev(last)->clusters.first < first->clusters.first) // RTL
-                                    textLineStart = std::prev(last)->clusters.first;
-
-                                document_span const span{
-                                    textLineStart,
-                                    textLineEnd,
-                                    first - glyphs().begin() - paragraph.span.glyphsFirst,
-                                    last - glyphs().begin() - paragraph.span.glyphsFirst };
-
-                                size const lineExtents{
-                                    last != first ? (last - 1)->cell[1].x - (first)->cell[0].x : 0.0f,
-                                    alignBaselinesResult.yExtent };
-
-                                dimension xLine = 0.0;
-
-                                auto textDirection = glyph_text_direction(first, last);
-                                auto const paragraphAlignment = paragraphStyle.paragraph().alignment().as_std_optional().value_or(alignment());
-
-                                if (((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Left && textDirection == text_direction::RTL) ||
-                                    ((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Right && textDirection == text_direction::LTR))
-                                    xLine += (availableWidth - lineExtents.cx);
-                                else if ((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Center)
-                                    xLine += std::ceil((availableWidth - lineExtents.cx, 0.0) / 2.0);
-
-                                lines.emplace_back(
-                                    this,
-                                    std::distance(iGlyphParagraphs.begin(), iterParagraph),
-                                    column.index(),
-                                    span,
-                                    point{ xLine, yLine },
-                                    lineExtents,
-                                    alignBaselinesResult.majorFont,
-                                    alignBaselinesResult.baseline);
-
-                                yLine += lines.back().extents.cy;
-                                iTextExtents->cx = std::max(iTextExtents->cx, lines.back().extents.cx);
-                            };
-
-                            if (glyph_text_direction(paragraphLineStart, paragraphLineEnd) == text_direction::LTR)
+            if (paragraphStyle.paragraph().padding())
+                yLine += paragraphStyle.paragraph().padding().value().top;
+
+            bool first = true;
+
+            for (auto const& paragraphLine : paragraphLines)
+            {
+                auto const paragraphLineStart = std::next(glyphs().begin(), paragraphLine.first);
+                auto const paragraphLineEnd = std::next(glyphs().begin(), paragraphLine.second);
+
+                if (!first)
+                {
+                    if (paragraphStyle.paragraph().line_spacing())
+                        yLine += paragraphStyle.paragraph().line_spacing().value();
+                }
+                else
+                    first = false;
+
+                if (paragraphLineStart == paragraphLineEnd || is_line_breaking_whitespace(*paragraphLineStart))
+                {
+                    auto lineStart = paragraphLineStart;
+                    auto lineEnd = (paragraphLineStart == paragraphLineEnd || !is_line_breaking_whitespace(*paragraphLineStart)) ? 
+                        paragraphLineEnd : paragraphLineStart;
+
+                    auto const alignBaselinesResult = glyphs().align_baselines(lineStart, lineEnd, true);
+
+                    glyph_char::cluster_range clusters{
+                        static_cast<glyph_char::cluster_index>(from_glyph(lineStart).first),
+                        static_cast<glyph_char::cluster_index>(from_glyph(lineEnd).second) };
+                    if (alignBaselinesResult.clusters)
+                    {
+                        clusters.first = std::min(clusters.first, alignBaselinesResult.clusters.value().first + static_cast<glyph_char::cluster_index>(paragraphSpan.textFirst));
+                        clusters.second = std::max(clusters.second, alignBaselinesResult.clusters.value().second + static_cast<glyph_char::cluster_index>(paragraphSpan.textFirst));
+                    }
+                    auto textLineStart = static_cast<position_type>(clusters.first) - paragraphSpan.textFirst;
+                    auto textLineEnd = static_cast<position_type>(clusters.second) - paragraphSpan.textFirst;
+                    if (lineStart != lineEnd && std::prev(lineEnd)->clusters.first < lineStart->clusters.first) // RTL
+                        textLineStart = std::prev(lineEnd)->clusters.first;
+
+                    document_span const span{
+                        textLineStart,
+                        textLineEnd,
+                        lineStart - glyphs().begin() - paragraphSpan.glyphsFirst,
+                        lineEnd - glyphs().begin() - paragraphSpan.glyphsFirst };
+
+                    size const lineExtents{
+                            lineEnd != lineStart ? (lineEnd - 1)->cell[1].x - (lineStart)->cell[0].x : 0.0f,
+                            alignBaselinesResult.yExtent };
+
+                    dimension xLine = 0.0;
+
+                    auto textDirection = glyph_text_direction(lineStart, lineEnd);
+                    auto const paragraphAlignment = paragraphStyle.paragraph().alignment().as_std_optional().value_or(alignment());
+
+                    if (((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Left && textDirection == text_direction::RTL) ||
+                        ((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Right && textDirection == text_direction::LTR))
+                        xLine += (aAvailableWidth - lineExtents.cx);
+                    else if ((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Center)
+                        xLine += std::ceil((aAvailableWidth - lineExtents.cx, 0.0) / 2.0);
+
+                    lines.emplace_back(
+                        this,
+                        aParagraph.index,
+                        column.index(),
+                        span,
+                        point{ xLine, yLine },
+                        lineExtents,
+                        alignBaselinesResult.majorFont,
+                        alignBaselinesResult.baseline);
+
+                    yLine += lines.back().extents.cy;
+                    line_added(lines.back().extents.cx);
+                }
+                else if (WordWrap && static_cast<coordinate>((paragraphLineEnd - 1)->cell[0].x) + static_cast<coordinate>((paragraphLineEnd - 1)->cell_extents().x) > aAvailableWidth)
+                {
+                    auto add_line = [&](auto first, auto last)
+                    {
+                        if (last != first && is_line_breaking_whitespace(*(last - 1)))
+                            --last;
+
+                        auto const alignBaselinesResult = glyphs().align_baselines(first, last, true);
+
+                        glyph_char::cluster_range clusters{
+                            static_cast<glyph_char::cluster_index>(from_glyph(first).first),
+                            static_cast<glyph_char::cluster_index>(from_glyph(last).second) };
+                        if (alignBaselinesResult.clusters)
+                        {
+                            clusters.first = std::min(clusters.first, alignBaselinesResult.clusters.value().first + static_cast<glyph_char::cluster_index>(paragraphSpan.textFirst));
+                            clusters.second = std::max(clusters.second, alignBaselinesResult.clusters.value().second + static_cast<glyph_char::cluster_index>(paragraphSpan.textFirst));
+                        }
+                        auto textLineStart = static_cast<position_type>(clusters.first) - paragraphSpan.textFirst;
+                        auto textLineEnd = static_cast<position_type>(clusters.second) - paragraphSpan.textFirst;
+                        if (first != last && std::prev(last)->clusters.first < first->clusters.first) // RTL
+                            textLineStart = std::prev(last)->clusters.first;
+
+                        document_span const span{
+                            textLineStart,
+                            textLineEnd,
+                            first - glyphs().begin() - paragraphSpan.glyphsFirst,
+                            last - glyphs().begin() - paragraphSpan.glyphsFirst };
+
+                        size const lineExtents{
+                            last != first ? (last - 1)->cell[1].x - (first)->cell[0].x : 0.0f,
+                            alignBaselinesResult.yExtent };
+
+                        dimension xLine = 0.0;
+
+                        auto textDirection = glyph_text_direction(first, last);
+                        auto const paragraphAlignment = paragraphStyle.paragraph().alignment().as_std_optional().value_or(alignment());
+
+                        if (((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Left && textDirection == text_direction::RTL) ||
+                            ((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Right && textDirection == text_direction::LTR))
+                            xLine += (aAvailableWidth - lineExtents.cx);
+                        else if ((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Center)
+                            xLine += std::ceil((aAvailableWidth - lineExtents.cx, 0.0) / 2.0);
+
+                        lines.emplace_back(
+                            this,
+                            aParagraph.index,
+                            column.index(),
+                            span,
+                            point{ xLine, yLine },
+                            lineExtents,
+                            alignBaselinesResult.majorFont,
+                            alignBaselinesResult.baseline);
+
+                        yLine += lines.back().extents.cy;
+                        line_added(lines.back().extents.cx);
+                    };
+
+                    if (glyph_text_direction(paragraphLineStart, paragraphLineEnd) == text_direction::LTR)
+                    {
+                        auto next = paragraphLineStart;
+                        auto lineStart = next;
+                        auto lineEnd = paragraphLineEnd;
+                        coordinate offset = (lineEnd != lineStart ? lineStart->cell[0].x : 0.0);
+                        while (next != paragraphLineEnd)
+                        {
+                            glyph_char const key{ {}, {}, {}, {}, {}, quadf_2d{ vec2{ offset + aAvailableWidth, 0.0 }.as<float>(), vec2{offset + aAvailableWidth, 0.0}.as<float>()}, {}};
+                            auto split = std::lower_bound(next, paragraphLineEnd, key, [](auto const& lhs, auto const& rhs) { return lhs.cell[0].x < rhs.cell[0].x; });
+                            if (split != next)
                             {
-                                auto next = paragraphLineStart;
-                                auto lineStart = next;
-                                auto lineEnd = paragraphLineEnd;
-                                coordinate offset = (lineEnd != lineStart ? lineStart->cell[0].x : 0.0);
-                                while (next != paragraphLineEnd)
+                                if (split != paragraphLineEnd)
+                                    --split;
+                                else
                                 {
-                                    glyph_char const key{ {}, {}, {}, {}, {}, quadf_2d{ vec2{ offset + availableWidth, 0.0 }.as<float>(), vec2{offset + availableWidth, 0.0}.as<float>()}, {}};
-                                    auto split = std::lower_bound(next, paragraphLineEnd, key, [](auto const& lhs, auto const& rhs) { return lhs.cell[0].x < rhs.cell[0].x; });
-                                    if (split != next)
-                                    {
-                                        if (split != paragraphLineEnd)
-                                            --split;
-                                        else
-                                        {
-                                            auto const& previousChar = *(split - 1);
-                                            auto const xPrevious = static_cast<coordinate>(previousChar.cell[0].x);
-                                            auto const cxPrevious = static_cast<coordinate>(previousChar.cell_extents().x);
-                                            if (xPrevious + cxPrevious >= offset + availableWidth)
-                                                --split;
-                                        }
-                                    }
-                                    if (split == next)
-                                        ++split;
-                                    if (split != paragraphLineEnd)
-                                    {
-                                        auto wordBreak = word_break(lineStart, split, paragraphLineEnd);
-                                        if (wordBreak.first != lineStart)
-                                        {
-                                            lineEnd = wordBreak.first;
-                                            next = wordBreak.second;
-                                        }
-                                        else
-                                            next = lineEnd = split;
-                                    }
-                                    else
-                                        next = paragraphLineEnd;
-                                    add_line(lineStart, lineEnd);
-                                    lineStart = next;
-                                    if (lineStart != paragraphLineEnd)
-                                        offset = lineStart->cell[0].x;
-                                    lineEnd = paragraphLineEnd;
+                                    auto const& previousChar = *(split - 1);
+                                    auto const xPrevious = static_cast<coordinate>(previousChar.cell[0].x);
+                                    auto const cxPrevious = static_cast<coordinate>(previousChar.cell_extents().x);
+                                    if (xPrevious + cxPrevious >= offset + aAvailableWidth)
+                                        --split;
                                 }
                             }
-                            else // RTL
+                            if (split == next)
+                                ++split;
+                            if (split != paragraphLineEnd)
                             {
-                                auto next = std::reverse_iterator{ paragraphLineEnd };
-                                auto lineStart = next;
-                                auto lineEnd = std::reverse_iterator{ paragraphLineStart };
-                                coordinate const rightmost = (lineEnd != lineStart ? lineStart->cell[1].x : 0.0);
-                                coordinate offset = rightmost;
-                                while (next != std::reverse_iterator{ paragraphLineStart })
+                                auto wordBreak = word_break(lineStart, split, paragraphLineEnd);
+                                if (wordBreak.first != lineStart)
                                 {
-                                    glyph_char const key{ {}, {}, {}, {}, {}, quadf_2d{ vec2{ offset - availableWidth, 0.0 }.as<float>() }, {}};
-                                    auto split = std::lower_bound(next, std::reverse_iterator{ paragraphLineStart }, key, [=](auto const& lhs, auto const& rhs) { return offset - lhs.cell[0].x < offset - rhs.cell[0].x; });
-                                    if (split != next && (split != std::reverse_iterator{ paragraphLineStart } || static_cast<coordinate>((split - 1)->cell[0].x) + static_cast<coordinate>((split - 1)->cell_extents().x) >= rightmost - offset + availableWidth))
-                                        --split;
-                                    if (split == next)
-                                        ++split;
-                                    if (split != std::reverse_iterator{ paragraphLineStart })
-                                    {
-                                        auto wordBreak = word_break(lineStart, split, std::reverse_iterator{ paragraphLineStart });
-                                        if (wordBreak.first != lineStart)
-                                        {
-                                            lineEnd = wordBreak.first;
-                                            next = wordBreak.second;
-                                        }
-                                        else
-                                            next = lineEnd = split;
-                                    }
-                                    else
-                                        next = std::reverse_iterator{ paragraphLineStart };
-                                    add_line(lineEnd.base(), lineStart.base());
-                                    lineStart = next;
-                                    if (lineStart != std::reverse_iterator{ paragraphLineStart })
-                                        offset = lineStart->cell[1].x;
-                                    lineEnd = std::reverse_iterator{ paragraphLineStart };
+                                    lineEnd = wordBreak.first;
+                                    next = wordBreak.second;
                                 }
+                                else
+                                    next = lineEnd = split;
                             }
+                            else
+                                next = paragraphLineEnd;
+                            add_line(lineStart, lineEnd);
+                            lineStart = next;
+                            if (lineStart != paragraphLineEnd)
+                                offset = lineStart->cell[0].x;
+                            lineEnd = paragraphLineEnd;
                         }
-                        else
+                    }
+                    else // RTL
+                    {
+                        auto next = std::reverse_iterator{ paragraphLineEnd };
+                        auto lineStart = next;
+                        auto lineEnd = std::reverse_iterator{ paragraphLineStart };
+                        coordinate const rightmost = (lineEnd != lineStart ? lineStart->cell[1].x : 0.0);
+                        coordinate offset = rightmost;
+                        while (next != std::reverse_iterator{ paragraphLineStart })
                         {
-                            auto lineStart = paragraphLineStart;
-                            auto lineEnd = paragraphLineEnd;
-                            if (lineEnd != lineStart && is_line_breaking_whitespace(*(lineEnd - 1)))
-                                --lineEnd;
-
-                            auto const alignBaselinesResult = glyphs().align_baselines(lineStart, lineEnd, true);
-
-                            glyph_char::cluster_range clusters{
-                                static_cast<glyph_char::cluster_index>(from_glyph(lineStart).first),
-                                static_cast<glyph_char::cluster_index>(from_glyph(lineEnd).second) };
-                            if (alignBaselinesResult.clusters)
+                            glyph_char const key{ {}, {}, {}, {}, {}, quadf_2d{ vec2{ offset - aAvailableWidth, 0.0 }.as<float>() }, {}};
+                            auto split = std::lower_bound(next, std::reverse_iterator{ paragraphLineStart }, key, [=](auto const& lhs, auto const& rhs) { return offset - lhs.cell[0].x < offset - rhs.cell[0].x; });
+                            if (split != next && (split != std::reverse_iterator{ paragraphLineStart } || static_cast<coordinate>((split - 1)->cell[0].x) + static_cast<coordinate>((split - 1)->cell_extents().x) >= rightmost - offset + aAvailableWidth))
+                                --split;
+                            if (split == next)
+                                ++split;
+                            if (split != std::reverse_iterator{ paragraphLineStart })
                             {
-                                clusters.first = std::min(clusters.first, alignBaselinesResult.clusters.value().first + static_cast<glyph_char::cluster_index>(paragraph.span.textFirst));
-                                clusters.second = std::max(clusters.second, alignBaselinesResult.clusters.value().second + static_cast<glyph_char::cluster_index>(paragraph.span.textFirst));
+                                auto wordBreak = word_break(lineStart, split, std::reverse_iterator{ paragraphLineStart });
+                                if (wordBreak.first != lineStart)
+                                {
+                                    lineEnd = wordBreak.first;
+                                    next = wordBreak.second;
+                                }
+                                else
+                                    next = lineEnd = split;
                             }
-                            auto textLineStart = static_cast<position_type>(clusters.first) - paragraph.span.textFirst;
-                            auto textLineEnd = static_cast<position_type>(clusters.second) - paragraph.span.textFirst;
-                            if (lineEnd != lineStart && std::prev(lineEnd)->clusters.first < lineStart->clusters.first) // RTL
-                                textLineStart = std::prev(lineEnd)->clusters.first;
-                            
-                            document_span const span{
-                                textLineStart,
-                                textLineEnd,
-                                lineStart - glyphs().begin() - paragraph.span.glyphsFirst,
-                                lineEnd - glyphs().begin() - paragraph.span.glyphsFirst };
-
-                            size const lineExtents{
-                                    lineEnd != lineStart ? (lineEnd - 1)->cell[1].x - (lineStart)->cell[0].x : 0.0f,
-                                    alignBaselinesResult.yExtent };
-
-                            dimension xLine = 0.0;
-
-                            auto textDirection = glyph_text_direction(lineStart, lineEnd);
-                            auto const paragraphAlignment = paragraphStyle.paragraph().alignment().as_std_optional().value_or(alignment());
-
-                            if (((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Left && textDirection == text_direction::RTL) ||
-                                ((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Right && textDirection == text_direction::LTR))
-                                xLine += (availableWidth - lineExtents.cx);
-                            else if ((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Center)
-                                xLine += std::ceil((availableWidth - lineExtents.cx, 0.0) / 2.0);
-
-                            lines.emplace_back(
-                                this,
-                                std::distance(iGlyphParagraphs.begin(), iterParagraph),
-                                column.index(),
-                                span,
-                                point{ xLine, yLine },
-                                lineExtents,
-                                alignBaselinesResult.majorFont,
-                                alignBaselinesResult.baseline);
-                            
-                            yLine += lines.back().extents.cy;
-                            iTextExtents->cx = std::max(iTextExtents->cx, lines.back().extents.cx);
+                            else
+                                next = std::reverse_iterator{ paragraphLineStart };
+                            add_line(lineEnd.base(), lineStart.base());
+                            lineStart = next;
+                            if (lineStart != std::reverse_iterator{ paragraphLineStart })
+                                offset = lineStart->cell[1].x;
+                            lineEnd = std::reverse_iterator{ paragraphLineStart };
                         }
                     }
-
-                    if (paragraphStyle.paragraph().padding())
-                        yLine += paragraphStyle.paragraph().padding().value().bottom;
-
-                    yColumn = std::max(yColumn, yLine);
                 }
+                else
+                {
+                    auto lineStart = paragraphLineStart;
+                    auto lineEnd = paragraphLineEnd;
+                    if (lineEnd != lineStart && is_line_breaking_whitespace(*(lineEnd - 1)))
+                        --lineEnd;
 
-                yposParagraph += yColumn;
-                iTextExtents->cy = std::max(iTextExtents->cy, yposParagraph);
+                    auto const alignBaselinesResult = glyphs().align_baselines(lineStart, lineEnd, true);
 
-                auto next_pass = [&]()
-                    {
-                        if (pass <= 3)
-                        {
-                            for (auto& c : iGlyphColumns)
-                                c.lines.clear();
-                            yposParagraph = 0.0;
-                            iTextExtents = size{};
-                            iterParagraph = iGlyphParagraphs.begin();
-                            ++pass;
-                        }
-                    };
-                switch (pass)
-                {
-                case 1:
-                case 3:
-                    if (!vertical_scrollbar().visible() && !showVerticalScrollbar && iTextExtents->cy > availableHeight)
-                    {
-                        showVerticalScrollbar = true;
-                        availableWidth -= vertical_scrollbar().width();
-                        next_pass();
-                    }
-                    else if (++iterParagraph == iGlyphParagraphs.end() && pass == 1)
-                        next_pass();
-                    break;
-                case 2:
-                    if (!horizontal_scrollbar().visible() && !showHorizontalScrollbar && iTextExtents->cx > availableWidth)
+                    glyph_char::cluster_range clusters{
+                        static_cast<glyph_char::cluster_index>(from_glyph(lineStart).first),
+                        static_cast<glyph_char::cluster_index>(from_glyph(lineEnd).second) };
+                    if (alignBaselinesResult.clusters)
                     {
-                        showHorizontalScrollbar = true;
-                        availableHeight -= horizontal_scrollbar().width();
-                        next_pass();
+                        clusters.first = std::min(clusters.first, alignBaselinesResult.clusters.value().first + static_cast<glyph_char::cluster_index>(paragraphSpan.textFirst));
+                        clusters.second = std::max(clusters.second, alignBaselinesResult.clusters.value().second + static_cast<glyph_char::cluster_index>(paragraphSpan.textFirst));
                     }
-                    else if (++iterParagraph == iGlyphParagraphs.end())
-                        next_pass();
-                    break;
-                case 4:
-                    ++iterParagraph;
-                    break;
+                    auto textLineStart = static_cast<position_type>(clusters.first) - paragraphSpan.textFirst;
+                    auto textLineEnd = static_cast<position_type>(clusters.second) - paragraphSpan.textFirst;
+                    if (lineEnd != lineStart && std::prev(lineEnd)->clusters.first < lineStart->clusters.first) // RTL
+                        textLineStart = std::prev(lineEnd)->clusters.first;
+                    
+                    document_span const span{
+                        textLineStart,
+                        textLineEnd,
+                        lineStart - glyphs().begin() - paragraphSpan.glyphsFirst,
+                        lineEnd - glyphs().begin() - paragraphSpan.glyphsFirst };
+
+                    size const lineExtents{
+                            lineEnd != lineStart ? (lineEnd - 1)->cell[1].x - (lineStart)->cell[0].x : 0.0f,
+                            alignBaselinesResult.yExtent };
+
+                    dimension xLine = 0.0;
+
+                    auto textDirection = glyph_text_direction(lineStart, lineEnd);
+                    auto const paragraphAlignment = paragraphStyle.paragraph().alignment().as_std_optional().value_or(alignment());
+
+                    if (((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Left && textDirection == text_direction::RTL) ||
+                        ((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Right && textDirection == text_direction::LTR))
+                        xLine += (aAvailableWidth - lineExtents.cx);
+                    else if ((paragraphAlignment & neogfx::alignment::Horizontal) == neogfx::alignment::Center)
+                        xLine += std::ceil((aAvailableWidth - lineExtents.cx, 0.0) / 2.0);
+
+                    lines.emplace_back(
+                        this,
+                        aParagraph.index,
+                        column.index(),
+                        span,
+                        point{ xLine, yLine },
+                        lineExtents,
+                        alignBaselinesResult.majorFont,
+                        alignBaselinesResult.baseline);
+                    
+                    yLine += lines.back().extents.cy;
+                    line_added(lines.back().extents.cx);
                 }
             }
 
-            if (iTextExtents->cy < client_rect(false).cy)
-            {
-                auto const space = client_rect(false).cy - iTextExtents->cy;
-                auto const defaultAlignment = default_style().paragraph().alignment().as_std_optional().value_or(alignment());
-                auto const adjust =
-                    ((defaultAlignment & neogfx::alignment::Vertical) == neogfx::alignment::Bottom) ? space :
-                    ((defaultAlignment & neogfx::alignment::Vertical) == neogfx::alignment::VCenter) ? std::floor(space / 2.0) : 0.0;
-                if (adjust != 0.0)
-                    for (auto& paragraph : iGlyphParagraphs)
-                        paragraph.ypos += adjust;
-            }
+            if (paragraphStyle.paragraph().padding())
+                yLine += paragraphStyle.paragraph().padding().value().bottom;
+
+            auto const byParagraph = [](glyph_line const& aLine, std::size_t aParagraphIndex) { return aLine.paragraphIndex < aParagraphIndex; };
+            auto const replaceFirst = std::lower_bound(column.lines.begin(), column.lines.end(), aParagraph.index, byParagraph);
+            auto const replaceLast = std::lower_bound(replaceFirst, column.lines.end(), aParagraph.index + 1u, byParagraph);
+            lines_removed(replaceFirst, replaceLast);
+            // The paragraph's old lines are overwritten so the lines after them only move if the number of lines has
+            // changed.
+            auto const replaced = std::min<std::size_t>(std::distance(replaceFirst, replaceLast), lines.size());
+            auto const replacedLast = std::move(lines.begin(), std::next(lines.begin(), replaced), replaceFirst);
+            if (replacedLast != replaceLast)
+                column.lines.erase(replacedLast, replaceLast);
+            else
+                column.lines.insert(replacedLast, std::next(lines.begin(), replaced), lines.end());
+
+            yColumn = std::max(yColumn, yLine);
         }
-        catch (std::bad_alloc)
+
+        auto paragraphExtents = iParagraphIndex[aParagraph.index];
+        paragraphExtents.height = yColumn;
+        iParagraphIndex.set(aParagraph.index, paragraphExtents);
+        if (!aParagraph.laidOut)
         {
-            for (auto& paragraph : iGlyphParagraphs)
+            aParagraph.laidOut = true;
+            --iParagraphsAwaitingLayout;
+        }
+    }
+
+    void text_edit::line_added(dimension aWidth)
+    {
+        if (iLinesMaxWidth == std::nullopt)
+            return;
+        if (aWidth > *iLinesMaxWidth)
+        {
+            iLinesMaxWidth = aWidth;
+            iLinesAtMaxWidth = 1u;
+        }
+        else if (aWidth == *iLinesMaxWidth)
+            ++iLinesAtMaxWidth;
+    }
+
+    void text_edit::lines_removed(glyph_lines::const_iterator aFirst, glyph_lines::const_iterator aLast)
+    {
+        if (iLinesMaxWidth == std::nullopt)
+            return;
+        for (auto line = aFirst; line != aLast; ++line)
+            if (line->extents.cx == *iLinesMaxWidth && --iLinesAtMaxWidth == 0u)
             {
-                paragraph.ypos = 0.0;
-                for (auto& column : iGlyphColumns)
-                    column.lines.clear();
+                iLinesMaxWidth = std::nullopt;
+                return;
             }
-            iOutOfMemory = true;
+    }
+
+    dimension text_edit::lines_max_width()
+    {
+        if (iLinesMaxWidth == std::nullopt)
+        {
+            iLinesMaxWidth = 0.0;
+            iLinesAtMaxWidth = 0u;
+            for (auto const& column : iGlyphColumns)
+                for (auto const& line : column.lines)
+                    line_added(line.extents.cx);
         }
+        return *iLinesMaxWidth;
     }
 
     void text_edit::animate()
     {
+        layout_deferred_lines();
+        if (iMappedText && iMappedText->estimated_lines() != iMappedLines)
+        {
+            iMappedLines = iMappedText->estimated_lines();
+            if (!vertical_scrollbar().visible() && scroll_area().cy > scroll_page().cy)
+                update_scrollbar_visibility();
+            else
+                framed_scrollable_widget::update_scrollbar_visibility(UsvStageDone);
+            update_mapped_window();
+        }
         if (neolib::service<neolib::i_power>().green_mode_active() && !iHasAnimations)
             return;
         if (iHasAnimations)
@@ -3264,6 +3841,12 @@ namespace neogfx
     {
         scoped_units su{ *this, units::Pixels };
         auto const cgp = cursor_glyph_position();
+        if (iParagraphsAwaitingLayout != 0u && iLineLayoutWidth && !iGlyphParagraphs.empty())
+        {
+            auto& cursorParagraph = iGlyphParagraphs[glyph_to_paragraph(cgp)->index];
+            if (!cursorParagraph.laidOut)
+                layout_paragraph(cursorParagraph, *iLineLayoutWidth);
+        }
         auto const gp = glyph_position(cgp, true);
         make_visible(gp, aForcePreviewScroll ? 
             point{ std::ceil(std::min(client_rect(false).width() / 3.0, 200.0)), 0.0 } : 
@@ -3293,6 +3876,20 @@ namespace neogfx
             horizontal_scrollbar().set_position(position.x + extents.cx + aPreview.x - horizontal_scrollbar().page() + totalPadding.size().cx);
     }
 
+    neogfx::font text_edit::paragraph_font(document_text::const_iterator aParagraph, std::vector<std::u32string::difference_type> const& aColumnDelimiters, std::u32string::size_type aSourceIndex, neogfx::font const& aDefaultFont) const
+    {
+        auto characterStyle = iStyleMap.find(std::next(aParagraph, aSourceIndex)->style);
+        std::size_t indexColumn = std::lower_bound(aColumnDelimiters.begin(), aColumnDelimiters.end(), 
+            static_cast<std::u32string::difference_type>(aSourceIndex)) - aColumnDelimiters.begin();
+        if (indexColumn > columns() - 1)
+            indexColumn = columns() - 1;
+        auto const& columnStyle = column_style(indexColumn);
+        auto const& style =
+            characterStyle != iStyleMap.end() ? **characterStyle :
+            columnStyle.character().font() != std::nullopt ? columnStyle : iDefaultStyle;
+        return style.character().font() != std::nullopt ? style.character().font().value() : aDefaultFont;
+    }
+
     text_edit::style text_edit::glyph_style(document_glyphs::const_iterator aGlyph, const document_column& aColumn) const
     {
         style result = iDefaultStyle;
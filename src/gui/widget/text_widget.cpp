@@ -373,6 +373,8 @@ namespace neogfx
 
     size text_widget::text_extent() const
     {
+        if (multi_line() && has_surface())
+            glyph_text(); // re-wraps the text (resetting its extent) if its wrap width has changed
         if (iTextExtent != std::nullopt)
             return *iTextExtent;
         else if (!has_surface())
@@ -448,30 +450,53 @@ namespace neogfx
 
     const text_widget::glyph_text_t& text_widget::glyph_text() const
     {
-        if (std::holds_alternative<std::monostate>(iGlyphText))
+        if (multi_line())
         {
+            auto const wrapWidth = wrap_width();
+            if (std::holds_alternative<multiline_glyph_text>(iGlyphText) && iWrapWidth == wrapWidth)
+                return iGlyphText;
             graphics_context gc{ *this, graphics_context::type::Unattached };
             scoped_mnemonics sm(gc, service<i_keyboard>().is_key_pressed(ScanCode_LALT));
-            if (multi_line())
+            if (iShapedText == std::nullopt)
             {
-                if (widget::has_minimum_size() && widget::minimum_size().cx != 0 && widget::minimum_size().cy == 0)
-                    iGlyphText = gc.to_multiline_glyph_text(iText, font(), widget::minimum_size().cx - internal_spacing().size().cx, iAlignment & neogfx::alignment::Horizontal);
-                else if (widget::has_maximum_size() && widget::maximum_size().cx != size::max_dimension())
-                    iGlyphText = gc.to_multiline_glyph_text(iText, font(), widget::maximum_size().cx - internal_spacing().size().cx, iAlignment & neogfx::alignment::Horizontal);
-                else
-                    iGlyphText = gc.to_multiline_glyph_text(iText, font(), 0.0, iAlignment & neogfx::alignment::Horizontal);
+                iShapedText = gc.to_glyph_text(iText, font());
+                iLineBreaker.emplace(*iShapedText);
             }
             else
-                iGlyphText = gc.to_glyph_text(iText, font());
+            {
+                // Only the wrap width has changed.
+                iTextExtent = std::nullopt;
+                iCacheTexture = std::nullopt;
+            }
+            iGlyphText = gc.to_multiline_glyph_text(*iShapedText, *iLineBreaker, wrapWidth, iAlignment & neogfx::alignment::Horizontal);
+            iWrapWidth = wrapWidth;
+        }
+        else if (std::holds_alternative<std::monostate>(iGlyphText))
+        {
+            graphics_context gc{ *this, graphics_context::type::Unattached };
+            scoped_mnemonics sm(gc, service<i_keyboard>().is_key_pressed(ScanCode_LALT));
+            iGlyphText = gc.to_glyph_text(iText, font());
         }
         return iGlyphText;
     }
 
+    dimension text_widget::wrap_width() const
+    {
+        if (widget::has_minimum_size() && widget::minimum_size().cx != 0 && widget::minimum_size().cy == 0)
+            return widget::minimum_size().cx - internal_spacing().size().cx;
+        else if (widget::has_maximum_size() && widget::maximum_size().cx != size::max_dimension())
+            return widget::maximum_size().cx - internal_spacing().size().cx;
+        return 0.0;
+    }
+
     void text_widget::reset_cache()
     {
         iTextExtent = std::nullopt;
         iSizeHintExtent = std::nullopt;
         iGlyphText = std::monostate{};
+        iShapedText = std::nullopt;
+        iLineBreaker = std::nullopt;
+        iWrapWidth = std::nullopt;
         iCacheTexture = std::nullopt;
     }
 }
\ No newline at end of file
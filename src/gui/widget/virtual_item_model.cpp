@@ -0,0 +1,540 @@
+// virtual_item_model.cpp
+/*
+  neogfx C++ App/Game Engine
+  Copyright (c) 2026 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+
+#include <array>
+
+#include <neogfx/gui/widget/virtual_item_model.hpp>
+
+namespace neogfx
+{
+    namespace
+    {
+        std::uint64_t next_generation()
+        {
+            static std::atomic<std::uint64_t> sGeneration;
+            return ++sGeneration;
+        }
+    }
+
+    virtual_item_model::virtual_item_model(i_item_page_provider const& aProvider, row_type aPageRows, std::size_t aCachedPages) :
+        iProvider{ aProvider },
+        iPageRows{ std::max<row_type>(aPageRows, 1u) },
+        iCachedPages{ std::max<std::size_t>(aCachedPages, 2u) },
+        iRows{ aProvider.rows() },
+        iGeneration{ next_generation() }
+    {
+        iColumns.resize(aProvider.columns());
+        for (item_model_index::column_type col = 0u; col < iColumns.size(); ++col)
+            iColumns[col].name = string{ aProvider.column_name(col) };
+        base_type::set_alive();
+    }
+
+    virtual_item_model::~virtual_item_model()
+    {
+        base_type::set_destroying();
+        if (iPrefetcher.joinable())
+        {
+            iPrefetcher.request_stop();
+            iPrefetcher.join();
+        }
+    }
+
+    i_item_page_provider const& virtual_item_model::provider() const
+    {
+        return iProvider;
+    }
+
+    void virtual_item_model::invalidate(row_type aFirstRow, row_type aRowCount)
+    {
+        auto const lastRow = std::min<row_type>(aFirstRow + aRowCount, iRows);
+        if (aFirstRow >= lastRow)
+            return;
+        {
+            std::scoped_lock lock{ iMutex };
+            iGeneration = next_generation();
+            for (auto p = aFirstRow / iPageRows; p <= (lastRow - 1u) / iPageRows; ++p)
+            {
+                auto const existing = iPageIndex.find(p);
+                if (existing != iPageIndex.end())
+                {
+                    iPages.erase(existing->second);
+                    iPageIndex.erase(existing);
+                }
+            }
+        }
+        for (auto row = aFirstRow; row < lastRow; ++row)
+            for (item_model_index::column_type col = 0u; col < iColumns.size(); ++col)
+                ItemChanged(item_model_index{ row, col });
+    }
+
+    void virtual_item_model::reset()
+    {
+        {
+            std::scoped_lock lock{ iMutex };
+            iGeneration = next_generation();
+            iPages.clear();
+            iPageIndex.clear();
+            iPrefetchQueue.clear();
+            iPrefetchQueuePages.clear();
+            iRows = iProvider.rows();
+            iColumns.resize(iProvider.columns());
+        }
+        for (item_model_index::column_type col = 0u; col < iColumns.size(); ++col)
+        {
+            iColumns[col].name = string{ iProvider.column_name(col) };
+            ColumnInfoChanged(col);
+        }
+        Cleared();
+    }
+
+    void virtual_item_model::prefetch(row_type aFirstRow, row_type aRowCount) const
+    {
+        auto const lastRow = std::min<row_type>(aFirstRow + aRowCount, iRows);
+        if (aFirstRow < lastRow)
+            queue_prefetch(aFirstRow / iPageRows, (lastRow - 1u) / iPageRows);
+    }
+
+    bool virtual_item_model::is_tree() const
+    {
+        return false;
+    }
+
+    bool virtual_item_model::is_virtual() const
+    {
+        return true;
+    }
+
+    bool virtual_item_model::thread_safe_cell_data() const
+    {
+        // Pages are cached under a lock, the provider is required to be thread safe and each reading thread keeps
+        // the pages it has just read alive.
+        return true;
+    }
+
+    std::uint32_t virtual_item_model::rows() const
+    {
+        return iRows;
+    }
+
+    std::uint32_t virtual_item_model::columns() const
+    {
+        return static_cast<std::uint32_t>(iColumns.size());
+    }
+
+    std::uint32_t virtual_item_model::columns(item_model_index const&) const
+    {
+        return columns();
+    }
+
+    i_string const& virtual_item_model::column_name(item_model_index::column_type aColumnIndex) const
+    {
+        return column(aColumnIndex).name;
+    }
+
+    void virtual_item_model::set_column_name(item_model_index::column_type aColumnIndex, i_string const& aName)
+    {
+        column(aColumnIndex).name = aName;
+        ColumnInfoChanged(aColumnIndex);
+    }
+
+    item_data_type virtual_item_model::column_data_type(item_model_index::column_type aColumnIndex) const
+    {
+        return column(aColumnIndex).defaultDataInfo.dataType;
+    }
+
+    void virtual_item_model::set_column_data_type(item_model_index::column_type aColumnIndex, item_data_type aType)
+    {
+        column(aColumnIndex).defaultDataInfo.dataType = aType;
+        ColumnInfoChanged(aColumnIndex);
+    }
+
+    item_cell_data const& virtual_item_model::column_min_value(item_model_index::column_type aColumnIndex) const
+    {
+        return column(aColumnIndex).defaultDataInfo.dataMin;
+    }
+
+    void virtual_item_model::set_column_min_value(item_model_index::column_type aColumnIndex, item_cell_data const& aValue)
+    {
+        column(aColumnIndex).defaultDataInfo.dataMin = aValue;
+        ColumnInfoChanged(aColumnIndex);
+    }
+
+    item_cell_data const& virtual_item_model::column_max_value(item_model_index::column_type aColumnIndex) const
+    {
+        return column(aColumnIndex).defaultDataInfo.dataMax;
+    }
+
+    void virtual_item_model::set_column_max_value(item_model_index::column_type aColumnIndex, item_cell_data const& aValue)
+    {
+        column(aColumnIndex).defaultDataInfo.dataMax = aValue;
+        ColumnInfoChanged(aColumnIndex);
+    }
+
+    item_cell_data const& virtual_item_model::column_step_value(item_model_index::column_type aColumnIndex) const
+    {
+        return column(aColumnIndex).defaultDataInfo.dataStep;
+    }
+
+    void virtual_item_model::set_column_step_value(item_model_index::column_type aColumnIndex, item_cell_data const& aValue)
+    {
+        column(aColumnIndex).defaultDataInfo.dataStep = aValue;
+        ColumnInfoChanged(aColumnIndex);
+    }
+
+    // The rows of a virtual model are not held so cannot be iterated.
+
+    i_item_model::iterator virtual_item_model::index_to_iterator(item_model_index const&)
+    {
+        throw wrong_model_type();
+    }
+
+    i_item_model::const_iterator virtual_item_model::index_to_iterator(item_model_index const&) const
+    {
+        throw wrong_model_type();
+    }
+
+    item_model_index virtual_item_model::iterator_to_index(const_iterator) const
+    {
+        throw wrong_model_type();
+    }
+
+    i_item_model::iterator virtual_item_model::begin()
+    {
+        throw wrong_model_type();
+    }
+
+    i_item_model::const_iterator virtual_item_model::begin() const
+    {
+        throw wrong_model_type();
+    }
+
+    i_item_model::iterator virtual_item_model::end()
+    {
+        throw wrong_model_type();
+    }
+
+    i_item_model::const_iterator virtual_item_model::end() const
+    {
+        throw wrong_model_type();
+    }
+
+    i_item_model::iterator virtual_item_model::sbegin()
+    {
+        throw wrong_model_type();
+    }
+
+    i_item_model::const_iterator virtual_item_model::sbegin() const
+    {
+        throw wrong_model_type();
+    }
+
+    i_item_model::iterator virtual_item_model::send()
+    {
+        throw wrong_model_type();
+    }
+
+    i_item_model::const_iterator virtual_item_model::send() const
+    {
+        throw wrong_model_type();
+    }
+
+    bool virtual_item_model::has_children(const_iterator) const
+    {
+        throw wrong_model_type();
+    }
+
+    bool virtual_item_model::has_children(item_model_index const&) const
+    {
+        throw wrong_model_type();
+    }
+
+    bool virtual_item_model::has_parent(const_iterator) const
+    {
+        throw wrong_model_type();
+    }
+
+    bool virtual_item_model::has_parent(item_model_index const&) const
+    {
+        throw wrong_model_type();
+    }
+
+    i_item_model::iterator virtual_item_model::parent(const_iterator)
+    {
+        throw wrong_model_type();
+    }
+
+    i_item_model::const_iterator virtual_item_model::parent(const_iterator) const
+    {
+        throw wrong_model_type();
+    }
+
+    item_model_index virtual_item_model::parent(item_model_index const&) const
+    {
+        throw wrong_model_type();
+    }
+
+    i_item_model::iterator virtual_item_model::sbegin(const_iterator)
+    {
+        throw wrong_model_type();
+    }
+
+    i_item_model::const_iterator virtual_item_model::sbegin(const_iterator) const
+    {
+        throw wrong_model_type();
+    }
+
+    i_item_model::iterator virtual_item_model::send(const_iterator)
+    {
+        throw wrong_model_type();
+    }
+
+    i_item_model::const_iterator virtual_item_model::send(const_iterator) const
+    {
+        throw wrong_model_type();
+    }
+
+    bool virtual_item_model::empty() const
+    {
+        return iRows == 0u;
+    }
+
+    // The cells of a virtual model are changed by its provider (followed by a call to invalidate() or reset()).
+
+    void virtual_item_model::reserve(std::uint32_t)
+    {
+        throw read_only();
+    }
+
+    std::uint32_t virtual_item_model::capacity() const
+    {
+        return iRows;
+    }
+
+    i_item_model::iterator virtual_item_model::insert_item(const_iterator, item_cell_data const&)
+    {
+        throw read_only();
+    }
+
+    i_item_model::iterator virtual_item_model::insert_item(item_model_index const&, item_cell_data const&)
+    {
+        throw read_only();
+    }
+
+    i_item_model::iterator virtual_item_model::append_item(const_iterator, item_cell_data const&)
+    {
+        throw read_only();
+    }
+
+    i_item_model::iterator virtual_item_model::append_item(item_model_index const&, item_cell_data const&)
+    {
+        throw read_only();
+    }
+
+    void virtual_item_model::clear()
+    {
+        throw read_only();
+    }
+
+    i_item_model::iterator virtual_item_model::erase(const_iterator)
+    {
+        throw read_only();
+    }
+
+    i_item_model::iterator virtual_item_model::erase(item_model_index const&)
+    {
+        throw read_only();
+    }
+
+    void virtual_item_model::insert_cell_data(const_iterator, item_model_index::column_type, item_cell_data const&)
+    {
+        throw read_only();
+    }
+
+    void virtual_item_model::insert_cell_data(item_model_index const&, item_cell_data const&)
+    {
+        throw read_only();
+    }
+
+    void virtual_item_model::update_cell_data(const_iterator, item_model_index::column_type, item_cell_data const&)
+    {
+        throw read_only();
+    }
+
+    void virtual_item_model::update_cell_data(item_model_index const&, item_cell_data const&)
+    {
+        throw read_only();
+    }
+
+    item_cell_info const& virtual_item_model::cell_info(item_model_index const& aIndex) const
+    {
+        return column(aIndex.column()).defaultDataInfo;
+    }
+
+    item_cell_data const& virtual_item_model::cell_data(item_model_index const& aIndex) const
+    {
+        static item_cell_data const sEmpty;
+        if (aIndex.row() >= iRows || aIndex.column() >= iColumns.size())
+            return sEmpty;
+        auto const pageIndex = aIndex.row() / iPageRows;
+        // A page is kept (even if evicted from the cache) until this thread has read cells of two other pages so that
+        // the cell returned can be compared with another. Whilst the page last read is still current it is read
+        // without taking the lock (generations are unique to a model) and the neighbouring pages are only queued for
+        // prefetching when the thread moves to another page.
+        struct last_read
+        {
+            std::uint64_t generation = 0u;
+            page_index page = 0u;
+        };
+        thread_local last_read tLastRead;
+        thread_local std::array<page_ptr, 2> tPinned;
+        auto const generation = iGeneration.load(std::memory_order_acquire);
+        if (tLastRead.generation != generation || tLastRead.page != pageIndex)
+        {
+            auto cellPage = cached_page(pageIndex);
+            if (!cellPage)
+                cellPage = fetch_page(pageIndex);
+            if (tPinned[0] != cellPage)
+            {
+                tPinned[1] = std::move(tPinned[0]);
+                tPinned[0] = std::move(cellPage);
+            }
+            tLastRead = last_read{ generation, pageIndex };
+            queue_prefetch(pageIndex != 0u ? pageIndex - 1u : 0u, pageIndex + 1u);
+        }
+        auto const& cellPage = *tPinned[0];
+        auto const cell = (aIndex.row() - pageIndex * iPageRows) * iColumns.size() + aIndex.column();
+        return cell < cellPage.cells.size() ? cellPage.cells[cell] : sEmpty;
+    }
+
+    virtual_item_model::column_info const& virtual_item_model::column(item_model_index::column_type aColumnIndex) const
+    {
+        if (aColumnIndex >= iColumns.size())
+            throw bad_column_index();
+        return iColumns[aColumnIndex];
+    }
+
+    virtual_item_model::column_info& virtual_item_model::column(item_model_index::column_type aColumnIndex)
+    {
+        return const_cast<column_info&>(to_const(*this).column(aColumnIndex));
+    }
+
+    virtual_item_model::page_ptr virtual_item_model::cached_page(page_index aPage) const
+    {
+        std::scoped_lock lock{ iMutex };
+        auto const existing = iPageIndex.find(aPage);
+        if (existing == iPageIndex.end())
+            return nullptr;
+        iPages.splice(iPages.begin(), iPages, existing->second);
+        return existing->second->second;
+    }
+
+    virtual_item_model::page_ptr virtual_item_model::fetch_page(page_index aPage) const
+    {
+        std::uint64_t generation;
+        row_type rows;
+        std::size_t columns;
+        {
+            std::scoped_lock lock{ iMutex };
+            generation = iGeneration;
+            rows = iRows;
+            columns = iColumns.size();
+        }
+        auto const firstRow = aPage * iPageRows;
+        auto newPage = std::make_shared<page>();
+        if (firstRow < rows)
+        {
+            newPage->cells.reserve(static_cast<std::size_t>(std::min(iPageRows, rows - firstRow)) * columns);
+            iProvider.fetch(firstRow, std::min(iPageRows, rows - firstRow), newPage->cells);
+        }
+        std::scoped_lock lock{ iMutex };
+        // Not cached if the provider's data changed whilst fetching.
+        if (generation != iGeneration)
+            return newPage;
+        auto const existing = iPageIndex.find(aPage);
+        if (existing != iPageIndex.end())
+        {
+            iPages.splice(iPages.begin(), iPages, existing->second);
+            return existing->second->second;
+        }
+        iPages.emplace_front(aPage, newPage);
+        iPageIndex[aPage] = iPages.begin();
+        while (iPages.size() > iCachedPages)
+        {
+            iPageIndex.erase(iPages.back().first);
+            iPages.pop_back();
+        }
+        return newPage;
+    }
+
+    void virtual_item_model::queue_prefetch(page_index aFirstPage, page_index aLastPage) const
+    {
+        {
+            std::scoped_lock lock{ iMutex };
+            auto const pages = (iRows + iPageRows - 1u) / iPageRows;
+            bool queued = false;
+            for (auto p = aFirstPage; p <= aLastPage && p < pages; ++p)
+                if (!iPageIndex.contains(p) && iPrefetchQueuePages.insert(p).second)
+                {
+                    iPrefetchQueue.push_back(p);
+                    queued = true;
+                }
+            if (!queued)
+                return;
+            // Pages queued longest ago are for rows probably since scrolled past.
+            while (iPrefetchQueue.size() > iCachedPages / 2u)
+            {
+                iPrefetchQueuePages.erase(iPrefetchQueue.front());
+                iPrefetchQueue.pop_front();
+            }
+            // Started on first use so that models whose pages are all cached don't pay for it.
+            if (!iPrefetcher.joinable())
+                iPrefetcher = std::jthread{ [this](std::stop_token aStopToken) { work(aStopToken); } };
+        }
+        iPrefetchQueued.notify_one();
+    }
+
+    void virtual_item_model::work(std::stop_token aStopToken) const
+    {
+        while (!aStopToken.stop_requested())
+        {
+            page_index next;
+            {
+                std::unique_lock lock{ iMutex };
+                if (!iPrefetchQueued.wait(lock, aStopToken, [&]() { return !iPrefetchQueue.empty(); }))
+                    return;
+                // Most recently queued first.
+                next = iPrefetchQueue.back();
+                iPrefetchQueue.pop_back();
+                iPrefetchQueuePages.erase(next);
+                if (iPageIndex.contains(next))
+                    continue;
+            }
+            try
+            {
+                fetch_page(next);
+            }
+            catch (...)
+            {
+                // The page will be fetched synchronously when read.
+            }
+        }
+    }
+}
@@ -24,6 +24,7 @@
 #include <neolib/task/thread.hpp>
 
 #include <neogfx/app/i_app.hpp>
+#include <neogfx/app/profiler.hpp>
 #include <neogfx/hid/i_surface_manager.hpp>
 #include <neogfx/hid/i_surface_window.hpp>
 #include <neogfx/gfx/i_rendering_context.hpp>
@@ -231,40 +232,42 @@ namespace neogfx
         return 1.0 / averageDuration_s;
     }
 
+    std::uint64_t native_surface::pixels_repainted() const
+    {
+        if (iRepaintData.empty())
+            return 0u;
+        return iRepaintData.back();
+    }
+
+    double native_surface::average_pixels_repainted() const
+    {
+        if (iRepaintData.empty())
+            return 0.0;
+        return std::accumulate(iRepaintData.begin(), iRepaintData.end(), 0.0) / iRepaintData.size();
+    }
+
     void native_surface::invalidate(const rect& aInvalidatedRect)
     {
         if (aInvalidatedRect.cx != 0.0 && aInvalidatedRect.cy != 0.0)
         {
             iInvalidatedArea = std::nullopt;
-            if (iRenderingEngine.is_stencil_based_invalidation_on())
-            {
-                for (auto& area : iInvalidatedAreas)
-                    if (!area.intersection(aInvalidatedRect).empty())
-                    {
-                        area.combine(aInvalidatedRect);
-                        return;
-                    }
-                iInvalidatedAreas.push_back(aInvalidatedRect);
-            }
-            else
-            {
-                if (iInvalidatedAreas.empty())
-                    iInvalidatedAreas.push_back(aInvalidatedRect);
-                else
-                    iInvalidatedAreas.back().combine(aInvalidatedRect);
-            }
+            iInvalidatedRegion.add(aInvalidatedRect);
         }
     }
 
     bool native_surface::has_invalidated_areas() const
     {
-        return !iInvalidatedAreas.empty();
+        return !iInvalidatedRegion.empty();
     }
 
     vector<rect> const& native_surface::invalidated_areas() const
     {
         if (has_invalidated_areas())
-            return iInvalidatedAreas;
+        {
+            if (iSelectedInvalidatedArea)
+                return iSelectedInvalidatedAreas;
+            return iInvalidatedRegion.rects();
+        }
         throw no_invalidated_area();
     }
 
@@ -273,22 +276,27 @@ namespace neogfx
         if (has_invalidated_areas())
         {
             if (!iInvalidatedArea.has_value())
-            {
-                rect area = invalidated_areas().front();
-                for (auto a = std::next(invalidated_areas().as_std_vector().begin()); a != invalidated_areas().as_std_vector().end(); ++a)
-                    area.combine(*a);
-                iInvalidatedArea = area;
-            }
+                iInvalidatedArea = iSelectedInvalidatedArea ? iSelectedInvalidatedAreas[0] : iInvalidatedRegion.bounding_rect();
             return iInvalidatedArea.value();
         }
         throw no_invalidated_area();
     }
 
+    void native_surface::select_invalidated_area(std::optional<std::size_t> const& aIndex) const
+    {
+        iInvalidatedArea = std::nullopt;
+        iSelectedInvalidatedArea = aIndex;
+        iSelectedInvalidatedAreas.clear();
+        if (iSelectedInvalidatedArea)
+            iSelectedInvalidatedAreas.push_back(iInvalidatedRegion.rects()[*iSelectedInvalidatedArea]);
+    }
+
     void native_surface::validate()
     {
         if (has_invalidated_areas())
         {
-            iInvalidatedAreas.clear();
+            select_invalidated_area(std::nullopt);
+            iInvalidatedRegion.clear();
             iInvalidatedArea = std::nullopt;
             return;
         }
@@ -357,12 +365,25 @@ namespace neogfx
         if (iDebug)
         {
             std::ostringstream oss;
-            oss << "to render (frame " << iFrameCounter << "): " << invalidated_area();
+            oss << "to render (frame " << iFrameCounter << "): " << invalidated_area() <<
+                " (" << iInvalidatedRegion.rects().size() << " area(s), " << iInvalidatedRegion.area() << " pixels)";
             debug_message(oss.str());
         }
 
+        dimension pixelsRepainted = 0.0;
+        for (auto const& area : iInvalidatedRegion.rects())
+        {
+            auto const visibleArea = area.intersection(rect{ point{}, extents() });
+            pixelsRepainted += visibleArea.cx * visibleArea.cy;
+        }
+        iRepaintData.push_back(static_cast<std::uint64_t>(pixelsRepainted));
+        if (iRepaintData.size() > 100)
+            iRepaintData.pop_front();
+
         ++iFrameCounter;
 
+        scoped_profiler_zone frameZone{ "frame", "frame" };
+
         iRendering = true;
         iLastFrameTime = now;
 
@@ -29,6 +29,7 @@
 #include <neogfx/core/object.hpp>
 #include <neogfx/gfx/texture.hpp>
 #include <neogfx/gfx/render_target.hpp>
+#include <neogfx/gfx/region.hpp>
 #include <neogfx/hid/i_native_surface.hpp>
 #include <neogfx/gui/widget/timer.hpp>
 
@@ -80,11 +81,14 @@ namespace neogfx
         std::uint64_t frame_counter() const override;
         double fps() const override;
         double potential_fps() const override;
+        std::uint64_t pixels_repainted() const override;
+        double average_pixels_repainted() const override;
     public:
         void invalidate(const rect& aInvalidatedRect) override;
         bool has_invalidated_areas() const override;
         vector<rect> const& invalidated_areas() const override;
         rect const& invalidated_area() const override;
+        void select_invalidated_area(std::optional<std::size_t> const& aIndex) const override;
         void validate() override;
         bool can_render() const override;
         void pause() override;
@@ -107,13 +111,16 @@ namespace neogfx
         mutable std::optional<pixel_format_t> iPixelFormat;
         mutable neogfx::logical_coordinate_system iLogicalCoordinateSystem;
         mutable std::optional<neogfx::logical_coordinates> iLogicalCoordinates;
-        vector<rect> iInvalidatedAreas;
+        region iInvalidatedRegion;
         mutable std::optional<rect> iInvalidatedArea;
+        mutable std::optional<std::size_t> iSelectedInvalidatedArea;
+        mutable vector<rect> iSelectedInvalidatedAreas;
         std::uint64_t iFrameCounter;
         typedef std::chrono::time_point<std::chrono::high_resolution_clock> frame_time_point;
         typedef std::pair<frame_time_point, frame_time_point> frame_times;
         std::optional<frame_time_point> iLastFrameTime;
         std::deque<frame_times> iFpsData;
+        std::deque<std::uint64_t> iRepaintData;
         std::uint32_t iPaused;
         bool iRendering;
         bool iDebug;
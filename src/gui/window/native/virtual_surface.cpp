@@ -74,6 +74,11 @@ namespace neogfx
         return parent().pixel_format();
     }
 
+    bool virtual_surface::has_target_texture() const
+    {
+        return parent().has_target_texture();
+    }
+
     const i_texture& virtual_surface::target_texture() const
     {
         return parent().target_texture();
@@ -266,6 +271,16 @@ namespace neogfx
         return parent().potential_fps();
     }
 
+    std::uint64_t virtual_surface::pixels_repainted() const
+    {
+        return parent().pixels_repainted();
+    }
+
+    double virtual_surface::average_pixels_repainted() const
+    {
+        return parent().average_pixels_repainted();
+    }
+
     void virtual_surface::invalidate(const rect& aInvalidatedRect)
     {
         return parent().invalidate(aInvalidatedRect);
@@ -286,6 +301,11 @@ namespace neogfx
         return parent().invalidated_area();
     }
 
+    void virtual_surface::select_invalidated_area(std::optional<std::size_t> const& aIndex) const
+    {
+        parent().select_invalidated_area(aIndex);
+    }
+
     void virtual_surface::validate()
     {
         parent().validate();
@@ -54,6 +54,7 @@ namespace neogfx
         void* target_handle() const final;
         void* target_device_handle() const final;
         pixel_format_t pixel_format() const final;
+        bool has_target_texture() const final;
         const i_texture& target_texture() const final;
         point target_origin() const final;
         size target_extents() const final;
@@ -97,11 +98,14 @@ namespace neogfx
         std::uint64_t frame_counter() const final;
         double fps() const final;
         double potential_fps() const final;
+        std::uint64_t pixels_repainted() const final;
+        double average_pixels_repainted() const final;
     public:
         void invalidate(const rect& aInvalidatedRect) final;
         bool has_invalidated_areas() const final;
         i_vector<rect> const& invalidated_areas() const final;
         rect const& invalidated_area() const final;
+        void select_invalidated_area(std::optional<std::size_t> const& aIndex) const final;
         void validate() final;
         bool can_render() const final;
         void render(bool aOOBRequest = false) final;
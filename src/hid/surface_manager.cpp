@@ -27,6 +27,7 @@
 #include <neogfx/gui/widget/i_widget.hpp>
 #include <neogfx/hid/i_native_surface.hpp>
 #include <neogfx/gui/window/i_native_window.hpp>
+#include <neogfx/gfx/text/i_font_manager.hpp>
 
 template <> neogfx::i_surface_manager& services::start_service<neogfx::i_surface_manager>() 
 { 
@@ -254,6 +255,7 @@ namespace neogfx
         if (iRenderingSurfaces || iRenderingEngine.creating_window())
             return;
         iRenderingSurfaces = true;
+        service<i_font_manager>().upload_rasterized_glyphs();
         for (auto s = iSurfaces.rbegin(); s != iSurfaces.rend(); ++s)
         {
             auto& surface = **s;
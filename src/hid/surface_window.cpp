@@ -563,6 +563,19 @@ namespace neogfx
             for (auto const& area : aInvalidatedAreas)
                 gc.fill_rect(area, color::Black);
         }
+        else if (aInvalidatedAreas.size() > 1u)
+        {
+            // Without stencil based invalidation each disjoint invalidated area gets its own render pass so that
+            // widgets are clipped to it rather than to the bounding rect of all areas.
+            auto const areaCount = aInvalidatedAreas.size();
+            for (std::size_t areaIndex = 0u; areaIndex < areaCount; ++areaIndex)
+            {
+                native_surface().select_invalidated_area(areaIndex);
+                as_widget().render_ex(gc);
+            }
+            native_surface().select_invalidated_area(std::nullopt);
+            return;
+        }
 
         as_widget().render_ex(gc);
     }